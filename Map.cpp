@@ -0,0 +1,327 @@
+#include "Map.h"
+
+static bool validPoint(const Eigen::Vector4f& p)
+{
+	return !std::isnan(p(2)) && p(2) >= 1e-2 && p(2) <= 10;
+}
+
+//! copies the abort request into the plain flag g2o polls, on the optimizing thread before each iteration
+class AbortAction : public g2o::HyperGraphAction
+{
+public:
+	AbortAction(const std::atomic<bool>* request) : request(request), stop(false) {}
+	virtual g2o::HyperGraphAction* operator()(const g2o::HyperGraph*, Parameters* = 0)
+	{
+		stop = request && request->load();
+		return this;
+	}
+	const std::atomic<bool>* 	request;
+	bool 						stop;
+};
+
+static MapPointObs pointObs(int lmk, const Eigen::Vector4f& p)
+{
+	MapPointObs o;
+	o.lmk = lmk;
+	o.pos = p.head<3>().cast<double>();
+	o.info = compPt3dCov(Eigen::Vector3f(p.head<3>()), Frame::K.at<double>(0,0), Frame::K.at<double>(1,1),
+			     Frame::K.at<double>(0,2), Frame::K.at<double>(1,2)).cast<double>().inverse();
+	return o;
+}
+
+static MapLineObs lineObs(int lmk, const FrameLine& ln)
+{
+	MapLineObs o;
+	o.lmk = lmk;
+	const RandomLine3d& l = ln.line3d;
+	o.endpts << l.A.x, l.A.y, l.A.z, l.B.x, l.B.y, l.B.z;
+	o.endptCov = Eigen::Matrix6d::Identity();
+	for(int i=0; i<3; ++i)
+		for(int j=0; j<3; ++j) {
+			o.endptCov(i,j) = l.rndA.cov.at<double>(i,j);
+			o.endptCov(i+3,j+3) = l.rndB.cov.at<double>(i,j);
+		}
+	// whitening of each endpoint, as in getTransformFromHybridMatchesG2O
+	o.endpt_AffnMat = Eigen::Matrix6d::Zero();
+	for(int k=0; k<2; ++k) {
+		Eigen::JacobiSVD<Eigen::Matrix3d> svd(o.endptCov.block<3,3>(3*k,3*k), Eigen::ComputeFullU);
+		Eigen::Matrix3d D_invsqrt = Eigen::Matrix3d::Zero();
+		for(int i=0; i<3; ++i)
+			D_invsqrt(i,i) = sqrt(1/svd.singularValues()(i));
+		o.endpt_AffnMat.block<3,3>(3*k,3*k) = D_invsqrt * svd.matrixU().transpose();
+	}
+	return o;
+}
+
+void Map3d::addKeyFrame(const Frame& kf, const Eigen::Isometry3d& Twc, const Frame* prev,
+			const vector<cv::DMatch>& pt_matches, const vector<cv::DMatch>& ln_matches)
+{
+	std::lock_guard<std::mutex> lock(mapMutex);
+	MapKeyFrame mk;
+	mk.id = kf.id;
+	mk.timestamp = kf.timestamp;
+	mk.Twc = Twc;
+	mk.ptLmk.assign(kf.feature_locations_3d_.size(), -1);
+	mk.lnLmk.assign(kf.lines.size(), -1);
+
+	std::map<int,int>::iterator it = prev ? kfIndex.find(prev->id) : kfIndex.end();
+	if(it != kfIndex.end())
+	{
+		MapKeyFrame& mp = keyframes[it->second];
+		for(size_t i=0; i<pt_matches.size(); ++i)
+		{
+			const cv::DMatch& m = pt_matches[i];
+			const Eigen::Vector4f& pp = prev->feature_locations_3d_[m.queryIdx];
+			const Eigen::Vector4f& pk = kf.feature_locations_3d_[m.trainIdx];
+			if(!validPoint(pp) || !validPoint(pk) || mk.ptLmk[m.trainIdx] >= 0) continue;
+			int& lmk = mp.ptLmk[m.queryIdx];
+			if(lmk < 0)
+			{
+				lmk = points.size();
+				points.push_back(mp.Twc * pp.head<3>().cast<double>());
+				mp.pts.push_back(pointObs(lmk, pp));
+			}
+			mk.ptLmk[m.trainIdx] = lmk;
+			mk.pts.push_back(pointObs(lmk, pk));
+		}
+		for(size_t i=0; i<ln_matches.size(); ++i)
+		{
+			const cv::DMatch& m = ln_matches[i];
+			const FrameLine& lp = prev->lines[m.queryIdx];
+			const FrameLine& lk = kf.lines[m.trainIdx];
+			if(!lp.haveDepth || !lk.haveDepth || mk.lnLmk[m.trainIdx] >= 0) continue;
+			int& lmk = mp.lnLmk[m.queryIdx];
+			if(lmk < 0)
+			{
+				lmk = lines.size();
+				Vector6d lw;
+				lw << mp.Twc * Eigen::Vector3d(lp.line3d.A.x, lp.line3d.A.y, lp.line3d.A.z),
+				      mp.Twc * Eigen::Vector3d(lp.line3d.B.x, lp.line3d.B.y, lp.line3d.B.z);
+				lines.push_back(lw);
+				mp.lns.push_back(lineObs(lmk, lp));
+			}
+			mk.lnLmk[m.trainIdx] = lmk;
+			mk.lns.push_back(lineObs(lmk, lk));
+		}
+	}
+	kfIndex[mk.id] = keyframes.size();
+	keyframes.push_back(mk);
+}
+
+bool Map3d::pose(int id, Eigen::Isometry3d& Twc)
+{
+	std::lock_guard<std::mutex> lock(mapMutex);
+	std::map<int,int>::iterator it = kfIndex.find(id);
+	if(it == kfIndex.end()) return false;
+	Twc = keyframes[it->second].Twc;
+	return true;
+}
+
+int Map3d::keyFrameNum()
+{
+	std::lock_guard<std::mutex> lock(mapMutex);
+	return keyframes.size();
+}
+
+#ifdef SLAM_LBA
+bool Map3d::lba_g2o(int numPos, int numFrm, const std::atomic<bool>* abortFlag)
+{
+	const int POINT_VERTEX_ID_BASE = 10000000;  //above all frame ids
+	const int LINE_VERTEX_ID_BASE  = 20000000;
+
+	// snapshot of the window, the optimization runs without the lock
+	vector<MapKeyFrame, Eigen::aligned_allocator<MapKeyFrame> > window;
+	vector<bool> fixedKf;
+	std::map<int, Eigen::Vector3d> ptEst;
+	std::map<int, Vector6d, std::less<int>, Eigen::aligned_allocator<std::pair<const int, Vector6d> > > lnEst;
+	{
+		std::lock_guard<std::mutex> lock(mapMutex);
+		int n = keyframes.size();
+		int first = max(0, n-numPos);
+		if(n < 2) return true;
+		for(int k=first; k<n; ++k)
+		{
+			const MapKeyFrame& kf = keyframes[k];
+			for(size_t i=0; i<kf.pts.size(); ++i) ptEst[kf.pts[i].lmk] = points[kf.pts[i].lmk];
+			for(size_t i=0; i<kf.lns.size(); ++i) lnEst[kf.lns[i].lmk] = lines[kf.lns[i].lmk];
+			window.push_back(kf);
+			fixedKf.push_back(k == 0);
+		}
+		for(int k=max(0, n-numFrm); k<first; ++k)
+		{
+			const MapKeyFrame& kf = keyframes[k];
+			bool covisible = false;
+			for(size_t i=0; i<kf.pts.size() && !covisible; ++i) covisible = ptEst.count(kf.pts[i].lmk) > 0;
+			for(size_t i=0; i<kf.lns.size() && !covisible; ++i) covisible = lnEst.count(kf.lns[i].lmk) > 0;
+			if(!covisible) continue;
+			window.push_back(kf);
+			fixedKf.push_back(true);
+		}
+		// no older covisible keyframe anchors the window, hold its oldest keyframe instead
+		if(std::find(fixedKf.begin(), fixedKf.end(), true) == fixedKf.end()) fixedKf[0] = true;
+	}
+
+	// landmarks need two observations in the window
+	std::map<int,int> ptObsNum, lnObsNum;
+	for(size_t k=0; k<window.size(); ++k)
+	{
+		for(size_t i=0; i<window[k].pts.size(); ++i) if(ptEst.count(window[k].pts[i].lmk)) ptObsNum[window[k].pts[i].lmk]++;
+		for(size_t i=0; i<window[k].lns.size(); ++i) if(lnEst.count(window[k].lns[i].lmk)) lnObsNum[window[k].lns[i].lmk]++;
+	}
+
+	g2o::SparseOptimizer optimizer;
+	g2o::BlockSolverX::LinearSolverType* linearSolver = new g2o::LinearSolverCSparse<g2o::BlockSolverX::PoseMatrixType>();
+	g2o::BlockSolverX* blockSolver = new g2o::BlockSolverX(linearSolver);
+	optimizer.setAlgorithm(new g2o::OptimizationAlgorithmLevenberg(blockSolver));
+	g2o::ParameterSE3Offset* sensorOffset = new g2o::ParameterSE3Offset;
+	sensorOffset->setOffset(Eigen::Isometry3d::Identity());
+	sensorOffset->setId(0);
+	optimizer.addParameter(sensorOffset);
+
+	for(size_t k=0; k<window.size(); ++k)
+	{
+		g2o::VertexSE3* v = new g2o::VertexSE3();
+		v->setId(window[k].id);
+		v->setEstimate(window[k].Twc);
+		v->setFixed(fixedKf[k]);
+		optimizer.addVertex(v);
+	}
+	for(std::map<int,int>::iterator it=ptObsNum.begin(); it!=ptObsNum.end(); ++it)
+	{
+		if(it->second < 2) continue;
+		g2o::VertexPointXYZ* v = new g2o::VertexPointXYZ();
+		v->setId(POINT_VERTEX_ID_BASE + it->first);
+		v->setEstimate(ptEst[it->first]);
+		v->setMarginalized(true);
+		optimizer.addVertex(v);
+	}
+	for(std::map<int,int>::iterator it=lnObsNum.begin(); it!=lnObsNum.end(); ++it)
+	{
+		if(it->second < 2) continue;
+		g2o::VertexLineEndpts* v = new g2o::VertexLineEndpts();
+		v->setId(LINE_VERTEX_ID_BASE + it->first);
+		v->setEstimate(lnEst[it->first]);
+		v->setMarginalized(true);
+		optimizer.addVertex(v);
+	}
+
+	for(size_t k=0; k<window.size(); ++k)
+	{
+		g2o::OptimizableGraph::Vertex* cam = optimizer.vertex(window[k].id);
+		for(size_t i=0; i<window[k].pts.size(); ++i)
+		{
+			const MapPointObs& o = window[k].pts[i];
+			g2o::OptimizableGraph::Vertex* lmk = optimizer.vertex(POINT_VERTEX_ID_BASE + o.lmk);
+			if(!lmk) continue;
+			g2o::EdgeSE3PointXYZ* e = new g2o::EdgeSE3PointXYZ();
+			e->vertices()[0] = cam;
+			e->vertices()[1] = lmk;
+			e->setMeasurement(o.pos);
+			e->information() = o.info;
+			g2o::RobustKernelHuber* rk = new g2o::RobustKernelHuber;
+			rk->setDelta(5.99);
+			e->setRobustKernel(rk);
+			e->setParameterId(0,0);
+			optimizer.addEdge(e);
+		}
+		for(size_t i=0; i<window[k].lns.size(); ++i)
+		{
+			const MapLineObs& o = window[k].lns[i];
+			g2o::OptimizableGraph::Vertex* lmk = optimizer.vertex(LINE_VERTEX_ID_BASE + o.lmk);
+			if(!lmk) continue;
+			g2o::EdgeSE3LineEndpts* e = new g2o::EdgeSE3LineEndpts();
+			e->vertices()[0] = cam;
+			e->vertices()[1] = lmk;
+			e->setMeasurement(o.endpts);
+			e->information() = Eigen::Matrix6d::Identity();  // must be identity, see endpt_AffnMat
+			e->endptCov = o.endptCov;
+			e->endpt_AffnMat = o.endpt_AffnMat;
+			g2o::RobustKernelHuber* rk = new g2o::RobustKernelHuber;
+			rk->setDelta(5.99);
+			e->setRobustKernel(rk);
+			e->setParameterId(0,0);
+			optimizer.addEdge(e);
+		}
+	}
+	if(optimizer.edges().empty()) return true;
+
+	AbortAction abort(abortFlag);
+	optimizer.setForceStopFlag(&abort.stop);
+	optimizer.addPreIterationAction(&abort);
+	optimizer.initializeOptimization();
+	{
+		PROF_SCOPE(PROF_G2O);
+		optimizer.optimize(10);
+	}
+	optimizer.removePreIterationAction(&abort);
+	optimizer.setForceStopFlag(0);
+	if(abortFlag && abortFlag->load()) return false;
+
+	std::lock_guard<std::mutex> lock(mapMutex);
+	for(size_t k=0; k<window.size(); ++k)
+	{
+		if(fixedKf[k]) continue;
+		g2o::VertexSE3* v = static_cast<g2o::VertexSE3*>(optimizer.vertex(window[k].id));
+		keyframes[kfIndex[window[k].id]].Twc = v->estimate();
+	}
+	for(std::map<int,int>::iterator it=ptObsNum.begin(); it!=ptObsNum.end(); ++it)
+	{
+		g2o::VertexPointXYZ* v = static_cast<g2o::VertexPointXYZ*>(optimizer.vertex(POINT_VERTEX_ID_BASE + it->first));
+		if(v) points[it->first] = v->estimate();
+	}
+	for(std::map<int,int>::iterator it=lnObsNum.begin(); it!=lnObsNum.end(); ++it)
+	{
+		g2o::VertexLineEndpts* v = static_cast<g2o::VertexLineEndpts*>(optimizer.vertex(LINE_VERTEX_ID_BASE + it->first));
+		if(v) lines[it->first] = v->estimate();
+	}
+	return true;
+}
+
+LocalMapping::LocalMapping(Map3d* map_, const SystemParameters& sysPara)
+	: map(map_), numPos(sysPara.num_pos_lba), numFrm(sysPara.num_frm_lba),
+	  newKeyFrame(false), finishFlag(false), abortBA(false)
+{
+	lbaThread = std::thread(&LocalMapping::run, this);
+}
+
+LocalMapping::~LocalMapping()
+{
+	finish();
+}
+
+void LocalMapping::insertKeyFrame()
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	newKeyFrame = true;
+	abortBA = true;  // the running window is outdated
+	cv_newKeyFrame.notify_one();
+}
+
+void LocalMapping::finish()
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		finishFlag = true;
+	}
+	cv_newKeyFrame.notify_one();
+	if(lbaThread.joinable())
+		lbaThread.join();
+}
+
+void LocalMapping::run()
+{
+	while(1)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mtx);
+			while(!newKeyFrame && !finishFlag)
+				cv_newKeyFrame.wait(lock);
+			if(!newKeyFrame) break;
+			newKeyFrame = false;
+			abortBA = false;
+		}
+		if(!map->lba_g2o(numPos, numFrm, &abortBA))
+			cout<<"LBA aborted by a new keyframe"<<endl;
+	}
+}
+#endif
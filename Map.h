@@ -1,31 +1,96 @@
 #ifndef MAP_H
 #define MAP_H
 
+#include "utils.h"
+#include <map>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <atomic>
+#include <algorithm>
+
+//! point observed by a keyframe, in its CS
+struct MapPointObs
+{
+	int 				lmk;	// landmark id
+	Eigen::Vector3d 	pos;
+	Eigen::Matrix3d 	info;
+};
+
+//! line observed by a keyframe, endpoints in its CS
+struct MapLineObs
+{
+	int 				lmk;
+	Eigen::Vector6d 	endpts;
+	Eigen::Matrix6d 	endptCov;
+	Eigen::Matrix6d 	endpt_AffnMat;
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+class MapKeyFrame
+{
+public:
+	int 					id;			// frame id, also the pose vertex id
+	double 					timestamp;
+	Eigen::Isometry3d 		Twc;
+	vector<int> 			ptLmk;		// landmark of each keypoint, -1 if none
+	vector<int> 			lnLmk;		// landmark of each line, -1 if none
+	vector<MapPointObs> 	pts;
+	vector<MapLineObs, Eigen::aligned_allocator<MapLineObs> > lns;
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+
+//! keyframes with their point and line landmarks, shared by tracking and the local mapping thread
+//! every access goes through mapMutex
 class Map3d
 {
 public:
-	string			datapath;
-	vector<Frame>	frames;
-	vector<int>		keyframeIdx;
-	vector<LmkLine>	lmklines;
-	vector<string>  paths;
-	cv::Mat			vel, w;  // linear vol in world coord
-	int				lastLoopCloseFrame;
-	bool			useConstVel;
+	std::mutex 				mapMutex;
+	vector<MapKeyFrame, Eigen::aligned_allocator<MapKeyFrame> > keyframes;
+	std::map<int, int> 		kfIndex;	// frame id -> index in keyframes
+	vector<Eigen::Vector3d> points;		// point landmarks, world CS
+	LineEndptsVector 		lines;		// line landmarks, world CS
 
 	Map3d(){}
-	Map3d(string path):datapath(path){}
-	Map3d(vector<string> paths_):paths(paths_){}
-	void slam(){}	
-	void compGT();
-#ifdef SLAM_LBA	
-	void lba(int numPos=3, int numFrm=5);
-	void lba_g2o(int numPos=3, int numFrm=5, int mode = 0);
-	void loopclose(){}
-	void correctPose(vector<PoseConstraint> pcs);
-	void correctAll(vector<vector<int> > lmkGidMatches);
-#endif	
+	//! kf posed at Twc, matched to the keyframe prev (query) by pt_matches and ln_matches (train = kf)
+	//! landmarks of prev are extended, new ones are created from prev's observations
+	void addKeyFrame(const Frame& kf, const Eigen::Isometry3d& Twc, const Frame* prev = 0,
+			 const vector<cv::DMatch>& pt_matches = vector<cv::DMatch>(),
+			 const vector<cv::DMatch>& ln_matches = vector<cv::DMatch>());
+	bool pose(int id, Eigen::Isometry3d& Twc);
+	int keyFrameNum();
+#ifdef SLAM_LBA
+	//! windowed BA: the last numPos keyframes and their landmarks are optimized,
+	//! keyframes among the last numFrm that observe those landmarks are kept fixed
+	//! returns false if aborted by *abortFlag
+	bool lba_g2o(int numPos=3, int numFrm=5, const std::atomic<bool>* abortFlag = 0);
+#endif
 };
 
+#ifdef SLAM_LBA
+//! runs Map3d::lba_g2o on its own thread after each new keyframe
+//! a running BA is aborted when the next keyframe arrives, and restarted on the new window
+class LocalMapping
+{
+public:
+	LocalMapping(Map3d* map, const SystemParameters& sysPara);
+	~LocalMapping();
+	void insertKeyFrame();
+	//! stop the thread after the pending BA
+	void finish();
+
+private:
+	void run();
+
+	Map3d* 			map;
+	int 			numPos, numFrm;
+	std::thread 	lbaThread;
+	std::mutex 		mtx;
+	std::condition_variable cv_newKeyFrame;
+	bool 			newKeyFrame;
+	bool 			finishFlag;
+	std::atomic<bool> abortBA;	// written by the tracking thread, polled by the BA
+};
+#endif
 
-#endif
\ No newline at end of file
+#endif
@@ -14,7 +14,13 @@ public:
   float scaleFactor;
   float nLevels;
   
-  SysParams(){}
+  //run
+  int headless;      //no window at all, debug images only go to Debug.dir
+  string debugDir;   //debug images written here as png, none if empty
+  int debugEvery;    //debug images of every n-th frame only
+  string traceFile;  //per stage latencies written here as a Chrome trace, none if empty
+  
+  SysParams() : headless(0), debugEvery(1) {}
   
   SysParams(const string filename)
   {
@@ -37,6 +43,11 @@ public:
       scaleFactor = fparams["ORBextractor.scaleFactor"];
       nLevels = fparams["ORBextractor.nLevels"];
       
+      headless = fparams["System.headless"];
+      debugDir = (string)fparams["Debug.dir"];
+      debugEvery = fparams["Debug.every"].empty() ? 1 : (int)fparams["Debug.every"];
+      traceFile = (string)fparams["Profile.trace"];
+      
       
       fparams.release();
   }
@@ -3,6 +3,8 @@
  * Added functions: Save and Load from text files without using cv::FileStorage.
  * Date: August 2015
  * Raúl Mur-Artal
+ *
+ * Added functions: Save and Load from binary files, descriptors packed in one block.
  */
 
 /**
@@ -26,6 +28,8 @@
 #include <algorithm>
 #include <opencv2/core/core.hpp>
 #include <limits>
+#include <cstdio>
+#include <cstring>
 
 #include "FeatureVector.h"
 #include "BowVector.h"
@@ -246,6 +250,22 @@ public:
    */
   void saveToTextFile(const std::string &filename) const;  
 
+  /**
+   * Loads the vocabulary from a binary file written by saveToBinaryFile.
+   * The file is read at once, the node descriptors end up as rows of a
+   * single contiguous matrix.
+   * Only for descriptors stored as 1 x F::L CV_8U matrices.
+   * @param filename
+   */
+  bool loadFromBinaryFile(const std::string &filename);
+
+  /**
+   * Saves the vocabulary into a binary file
+   * @param filename
+   * @return false if a node descriptor is not F::L bytes or the file cannot be written
+   */
+  bool saveToBinaryFile(const std::string &filename) const;
+
   /**
    * Saves the vocabulary into a file
    * @param filename
@@ -1379,6 +1399,7 @@ bool TemplatedVocabulary<TDescriptor,F>::loadFromTextFile(const std::string &fil
     {
         string snode;
         getline(f,snode);
+        if(snode.empty()) continue;  // trailing newline
         stringstream ssnode;
         ssnode << snode;
 
@@ -1450,6 +1471,151 @@ void TemplatedVocabulary<TDescriptor,F>::saveToTextFile(const std::string &filen
 
 // --------------------------------------------------------------------------
 
+/// binary vocabulary: header, then per node (root excluded) arrays of parents,
+/// leaf flags, weights and descriptors, each one contiguous
+struct BinaryVocabularyHeader
+{
+  char magic[4];        // "DBWB"
+  int version;
+  int k, L, scoring, weighting;
+  int nodes;            // including the root
+  int descriptorBytes;
+};
+
+template<class TDescriptor, class F>
+bool TemplatedVocabulary<TDescriptor,F>::saveToBinaryFile(const std::string &filename) const
+{
+  BinaryVocabularyHeader h;
+  memcpy(h.magic, "DBWB", 4);
+  h.version = 1;
+  h.k = m_k;
+  h.L = m_L;
+  h.scoring = m_scoring;
+  h.weighting = m_weighting;
+  h.nodes = m_nodes.size();
+  h.descriptorBytes = F::L;
+
+  const size_t n = m_nodes.size() > 0 ? m_nodes.size() - 1 : 0;
+  vector<unsigned int> parents(n);
+  vector<unsigned char> leaves(n);
+  vector<double> weights(n);
+  vector<unsigned char> descriptors(n * F::L, 0);
+  for(size_t i = 0; i < n; ++i)
+  {
+    const Node &node = m_nodes[i+1];
+    parents[i] = node.parent;
+    leaves[i] = node.isLeaf() ? 1 : 0;
+    weights[i] = node.weight;
+    // a descriptor that is a view into a larger Mat (a row of the training set) is not continuous
+    const cv::Mat d = node.descriptor.isContinuous() ? node.descriptor : node.descriptor.clone();
+    if((int)d.total() * (int)d.elemSize() != F::L) return false;
+    memcpy(&descriptors[i * F::L], d.data, F::L);
+  }
+
+  FILE *f = fopen(filename.c_str(), "wb");
+  if(!f) return false;
+  bool ok = fwrite(&h, sizeof(h), 1, f) == 1;
+  if(n > 0)
+  {
+    ok = ok && fwrite(&parents[0], sizeof(unsigned int), n, f) == n;
+    ok = ok && fwrite(&leaves[0], 1, n, f) == n;
+    ok = ok && fwrite(&weights[0], sizeof(double), n, f) == n;
+    ok = ok && fwrite(&descriptors[0], 1, n * F::L, f) == n * F::L;
+  }
+  fclose(f);
+  return ok;
+}
+
+// --------------------------------------------------------------------------
+
+template<class TDescriptor, class F>
+bool TemplatedVocabulary<TDescriptor,F>::loadFromBinaryFile(const std::string &filename)
+{
+  FILE *f = fopen(filename.c_str(), "rb");
+  if(!f) return false;
+
+  // the whole file in one read, parsed from memory
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  vector<char> buf(size > 0 ? size : 0);
+  bool ok = size >= (long)sizeof(BinaryVocabularyHeader) && 
+    fread(&buf[0], 1, size, f) == (size_t)size;
+  fclose(f);
+  if(!ok) return false;
+
+  BinaryVocabularyHeader h;
+  memcpy(&h, &buf[0], sizeof(h));
+  if(memcmp(h.magic, "DBWB", 4) != 0 || h.version != 1 || h.nodes < 1 ||
+    h.descriptorBytes != F::L)
+  {
+    std::cerr << "Vocabulary loading failure: This is not a correct binary file!" << endl;
+    return false;
+  }
+  const size_t n = h.nodes - 1;
+  const char *p = &buf[0] + sizeof(h);
+  if((size_t)size != sizeof(h) + n * (sizeof(unsigned int) + 1 + sizeof(double) + F::L))
+  {
+    std::cerr << "Vocabulary loading failure: truncated binary file" << endl;
+    return false;
+  }
+  const char *parents = p;
+  const unsigned char *leaves = (const unsigned char*)(parents + n * sizeof(unsigned int));
+  const char *weights = (const char*)(leaves + n);
+  const unsigned char *descriptors = (const unsigned char*)(weights + n * sizeof(double));
+
+  m_k = h.k;
+  m_L = h.L;
+  m_scoring = (ScoringType)h.scoring;
+  m_weighting = (WeightingType)h.weighting;
+  createScoringObject();
+
+  m_words.clear();
+  m_nodes.clear();
+  m_nodes.resize(h.nodes);
+  m_nodes[0].id = 0;
+
+  // one block for all the descriptors, the nodes keep row headers into it
+  cv::Mat block(n > 0 ? n : 1, F::L, CV_8U);
+  if(n > 0) memcpy(block.data, descriptors, n * F::L);
+
+  size_t nwords = 0;
+  for(size_t i = 0; i < n; ++i) nwords += leaves[i];
+  m_words.reserve(nwords);
+
+  for(size_t i = 0; i < n; ++i)
+  {
+    const NodeId nid = i + 1;
+    Node &node = m_nodes[nid];
+    unsigned int pid;
+    memcpy(&pid, parents + i * sizeof(unsigned int), sizeof(pid));
+    double w;
+    memcpy(&w, weights + i * sizeof(double), sizeof(w));
+    if(pid >= nid)
+    {
+      std::cerr << "Vocabulary loading failure: bad parent in binary file" << endl;
+      m_nodes.clear();
+      m_words.clear();
+      return false;
+    }
+
+    node.id = nid;
+    node.parent = pid;
+    node.weight = w;
+    node.descriptor = block.row(i);
+    m_nodes[pid].children.push_back(nid);
+
+    if(leaves[i])
+    {
+      node.word_id = m_words.size();
+      m_words.push_back(&node);
+    }
+  }
+  return true;
+}
+
+// --------------------------------------------------------------------------
+
 template<class TDescriptor, class F>
 void TemplatedVocabulary<TDescriptor,F>::save(const std::string &filename) const
 {
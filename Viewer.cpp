@@ -1,25 +1,194 @@
 #include "Viewer.h"
+#include "pointcloudmapping.h"
+#include <pangolin/gl/glvbo.h>
+#include <unistd.h>
+#include <chrono>
 
-Viewer::Viewer()
+Viewer::Viewer() : finishFlag(false), stopped(false), mapping(0), hasCurrent(false)
 {
 	mImageWidth=640;
 	mImageHeight=480;
 	
-	mViewpointX=10;
-	mViewpointY=10;
-	mViewpointZ=10;
+	mViewpointX=0;
+	mViewpointY=-0.7;
+	mViewpointZ=-1.8;
 	mViewpointF=500;
-	
-// 	mViewpointX=0;
-// 	mViewpointY=-0.7;
-// 	mViewpointZ=-1.8;
-// 	mViewpointF=500;
-	
+}
+
+Viewer::~Viewer()
+{
+	finish();
+}
+
+void Viewer::start()
+{
+	if(!viewerThread.joinable())
+		viewerThread = std::thread(&Viewer::run, this);
+}
+
+void Viewer::finish()
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		finishFlag = true;
+	}
+	if(viewerThread.joinable())
+		viewerThread.join();
+}
+
+void Viewer::setMap(PointCloudMapping* m)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	mapping = m;
+}
+
+void Viewer::addKeyFrame(const Frame& kf, const Eigen::Isometry3d& Twc)
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		if(stopped) return;
+	}
+	NewKeyFrame k;
+	k.id = kf.id;
+	k.Twc = Twc;
+	for(size_t i=0; i<kf.lines.size(); i++)
+	{
+		const cv::Point3d& A = kf.lines[i].line3d.A;
+		const cv::Point3d& B = kf.lines[i].line3d.B;
+		if(!kf.lines[i].haveDepth || cv::norm(A-B) < 0.3) continue;
+		float e[6] = {(float)A.x, (float)A.y, (float)A.z, (float)B.x, (float)B.y, (float)B.z};
+		k.lines.insert(k.lines.end(), e, e+6);
+	}
+	std::lock_guard<std::mutex> lock(mtx);
+	if(!stopped) back.keyframes.push_back(k);
+}
+
+void Viewer::setPose(int id, const Eigen::Isometry3d& Twc)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	if(!stopped) back.poses[id] = Twc;
+}
+
+void Viewer::setCurrentPose(const Eigen::Isometry3d& Twc)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	if(stopped) return;
+	back.hasCurrent = true;
+	back.current = Twc;
+}
+
+void Viewer::applyUpdates(Updates& u)
+{
+	for(size_t i=0; i<u.keyframes.size(); i++)
+	{
+		NewKeyFrame& k = u.keyframes[i];
+		KeyFrameGl& g = keyframes[k.id];
+		g.Twc = k.Twc;
+		if(!k.lines.empty())
+		{
+			g.lines = std::make_shared<pangolin::GlBuffer>(pangolin::GlArrayBuffer, k.lines.size()/3, GL_FLOAT, 3, GL_STATIC_DRAW);
+			g.lines->Upload(&k.lines[0], k.lines.size()*sizeof(float));
+		}
+	}
+	for(PoseMap::iterator it = u.poses.begin(); it != u.poses.end(); ++it)
+	{
+		KeyFrameGlMap::iterator kf = keyframes.find(it->first);
+		if(kf != keyframes.end()) kf->second.Twc = it->second;
+	}
+	if(u.hasCurrent)
+	{
+		hasCurrent = true;
+		current = u.current;
+	}
+}
+
+void Viewer::updateMap()
+{
+	PointCloud::Ptr cloud;
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		if(mapping) cloud = mapping->snapshot();
+	}
+	if(cloud == mapCloud) return;
+	mapCloud = cloud;
+	mapPoints.reset();
+	mapColors.reset();
+	const size_t n = cloud ? cloud->points.size() : 0;
+	if(n == 0) return;
+	vector<float> xyz(3*n);
+	vector<uchar> rgb(3*n);
+	for(size_t j=0; j<n; j++)
+	{
+		const PointT& p = cloud->points[j];
+		xyz[3*j] = p.x; xyz[3*j+1] = p.y; xyz[3*j+2] = p.z;
+		rgb[3*j] = p.r; rgb[3*j+1] = p.g; rgb[3*j+2] = p.b;
+	}
+	mapPoints = std::make_shared<pangolin::GlBuffer>(pangolin::GlArrayBuffer, n, GL_FLOAT, 3, GL_STATIC_DRAW);
+	mapColors = std::make_shared<pangolin::GlBuffer>(pangolin::GlArrayBuffer, n, GL_UNSIGNED_BYTE, 3, GL_STATIC_DRAW);
+	mapPoints->Upload(&xyz[0], xyz.size()*sizeof(float));
+	mapColors->Upload(&rgb[0], rgb.size());
+}
+
+static void drawFrustum(float w)
+{
+	const float h = w*0.75;
+	const float z = w*0.6;
+	glBegin(GL_LINES);
+	glVertex3f(0,0,0);
+	glVertex3f(w,h,z);
+	glVertex3f(0,0,0);
+	glVertex3f(w,-h,z);
+	glVertex3f(0,0,0);
+	glVertex3f(-w,-h,z);
+	glVertex3f(0,0,0);
+	glVertex3f(-w,h,z);
+	glVertex3f(w,h,z);
+	glVertex3f(w,-h,z);
+	glVertex3f(-w,h,z);
+	glVertex3f(-w,-h,z);
+	glVertex3f(-w,h,z);
+	glVertex3f(w,h,z);
+	glVertex3f(-w,-h,z);
+	glVertex3f(w,-h,z);
+	glEnd();
+}
+
+void Viewer::draw()
+{
+	glPointSize(1);
+	if(mapPoints) pangolin::RenderVboCbo(*mapPoints, *mapColors, true, GL_POINTS);
+	for(KeyFrameGlMap::iterator it = keyframes.begin(); it != keyframes.end(); ++it)
+	{
+		KeyFrameGl& g = it->second;
+		glPushMatrix();
+		glMultMatrixd(g.Twc.matrix().data());  // column major as GL
+
+		glLineWidth(2);
+		glColor3f(0.0,1.0,0.0);
+		drawFrustum(0.02);
+
+		if(g.lines)
+		{
+			glLineWidth(4);
+			glColor3f(1.0,0.0,0.0);
+			pangolin::RenderVbo(*g.lines, GL_LINES);
+		}
+		glPopMatrix();
+	}
+	if(hasCurrent)
+	{
+		glPushMatrix();
+		glMultMatrixd(current.matrix().data());
+		glLineWidth(3);
+		glColor3f(0.0,0.0,1.0);
+		drawFrustum(0.04);
+		glPopMatrix();
+	}
 }
 
 void Viewer::run()
 {
-	pangolin::CreateWindowAndBind("ORB-SLAM2: Map Viewer",1024,768);
+	pangolin::CreateWindowAndBind("LineSLAM: Map Viewer",1024,768);
 	// 3D Mouse handler requires depth testing to be enabled
     glEnable(GL_DEPTH_TEST);
 	
@@ -27,8 +196,6 @@ void Viewer::run()
     glEnable (GL_BLEND);
     glBlendFunc (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 	
-	//pangolin::CreatePanel("menu").SetBounds(0.0,1.0,0.0,pangolin::Attach::Pix(175));
-	
 	// Define Camera Render Object (for view / scene browsing)
     pangolin::OpenGlRenderState s_cam(
                 pangolin::ProjectionMatrix(1024,768,mViewpointF,mViewpointF,512,389,0.1,1000),
@@ -37,72 +204,41 @@ void Viewer::run()
 
     // Add named OpenGL viewport to window and provide 3D Handler
     pangolin::View& d_cam = pangolin::CreateDisplay()
-            .SetBounds(0.0, 1.0, pangolin::Attach::Pix(175), 1.0, -1024.0f/768.0f)
+            .SetBounds(0.0, 1.0, 0.0, 1.0, -1024.0f/768.0f)
             .SetHandler(new pangolin::Handler3D(s_cam));
 	
-	pangolin::OpenGlMatrix Twc;
-    Twc.SetIdentity();
-	
-	while(1)
+	const double frameSeconds = 1.0/30;  // software GL does not wait for vsync
+	while(!pangolin::ShouldQuit())
 	{
+		std::chrono::steady_clock::time_point t = std::chrono::steady_clock::now();
+		Updates front;
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			if(finishFlag) break;
+			std::swap(front, back);
+		}
+		applyUpdates(front);
+		updateMap();
+
 		// Clear screen and activate view to render into
 		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 		d_cam.Activate(s_cam);
-
-		// Render OpenGL Cube
-		// pangolin::glDrawColouredCube();
-		pangolin::glDrawAxis(3);
-
-		//点的创建
-		glPointSize(10.0f);
-		glBegin(GL_POINTS);
-		glColor3f(1.0,1.0,1.0);
-		glVertex3f(0.0f,0.0f,0.0f);
-		glVertex3f(1,0,0);
-		glVertex3f(-2,2,0);
-		glEnd();
-
-		//把下面的点都做一次旋转变换
-		glPushMatrix();
-		//col major
-		std::vector<GLfloat > Twc = {1,0,0,0, 0,1,0,0 , 0,0,1,0 ,0,2,5,1};
-		glMultMatrixf(Twc.data());
-
-		//直线的创建
-		const float w = 2;
-		const float h = w*0.75;
-		const float z =- w*0.6;
-		glLineWidth(2);
-		glColor3f(1.0,0,0);
-		glBegin(GL_LINES);
-
-		glVertex3f(0,0,0);
-		glVertex3f(w,h,z);
-		glVertex3f(0,0,0);
-		glVertex3f(w,-h,z);
-		glVertex3f(0,0,0);
-		glVertex3f(-w,-h,z);
-		glVertex3f(0,0,0);
-		glVertex3f(-w,h,z);
-
-		glVertex3f(w,h,z);
-		glVertex3f(w,-h,z);
-
-		glVertex3f(-w,h,z);
-		glVertex3f(-w,-h,z);
-
-		glVertex3f(-w,h,z);
-		glVertex3f(w,h,z);
-
-		glVertex3f(-w,-h,z);
-		glVertex3f(w,-h,z);
-		glEnd();
-
-		glPopMatrix();
+		draw();
 
 		// Swap frames and Process Events
 		pangolin::FinishFrame();
+
+		double left = frameSeconds - std::chrono::duration<double>(std::chrono::steady_clock::now() - t).count();
+		if(left > 0) usleep(left*1e6);
+	}
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		stopped = true;
+		back = Updates();  // the images queued are released
 	}
+	keyframes.clear();  // the buffers go with the context
+	mapPoints.reset();
+	mapColors.reset();
+	mapCloud.reset();
+	pangolin::DestroyWindow("LineSLAM: Map Viewer");
 }
-
-
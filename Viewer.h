@@ -2,21 +2,93 @@
 #define VIEWER_H
 
 #include <pangolin/pangolin.h>
+#include "frame.h"
+#include <map>
+#include <memory>
+#include <thread>
+#include <mutex>
 
+class PointCloudMapping;
+
+//! map viewer running on its own thread, OpenGL 2 fixed pipeline only so that software GL (llvmpipe) works
+//! the dense map is the snapshot published by a PointCloudMapping, uploaded again only when a new one is published;
+//! keyframes are drawn as frustums and 3d lines in vertex buffers in the keyframe CS,
+//! a pose change only changes the matrix they are drawn with
+//! tracking writes keyframes and poses into a back buffer, swapped with the front one by the render loop,
+//! so that it only waits for a swap
 class Viewer
 {
 public:
 	Viewer();
+	~Viewer();
+	//! render loop on its own thread
+	void start();
+	//! render loop on the calling thread, until the window is closed
 	void run();
-	
-	
-	
+	//! dense map to draw, its snapshot() is polled by the render loop; null draws none
+	void setMap(PointCloudMapping* mapping);
+	//! the 3d lines are copied
+	//! updates are dropped once the render loop stopped (window closed)
+	void addKeyFrame(const Frame& kf, const Eigen::Isometry3d& Twc);
+	void setPose(int id, const Eigen::Isometry3d& Twc);
+	void setCurrentPose(const Eigen::Isometry3d& Twc);
+	//! close the window and join the thread
+	void finish();
+
 private:
-	float mImageWidth,mImageHeight;
-	float mViewpointX, mViewpointY, mViewpointZ, mViewpointF;
+	struct NewKeyFrame
+	{
+		int 				id;
+		vector<float> 		lines;		// 3d line endpoints, camera CS
+		Eigen::Isometry3d 	Twc;
+		EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	};
+	typedef std::map<int, Eigen::Isometry3d, std::less<int>,
+			 Eigen::aligned_allocator<std::pair<const int, Eigen::Isometry3d> > > PoseMap;
+	//! what tracking publishes between two rendered frames
+	struct Updates
+	{
+		vector<NewKeyFrame, Eigen::aligned_allocator<NewKeyFrame> > keyframes;
+		PoseMap 			poses;
+		bool 				hasCurrent;
+		Eigen::Isometry3d 	current;
+		Updates() : hasCurrent(false) {}
+		EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	};
+	//! GL side of a keyframe, only touched by the render thread
+	struct KeyFrameGl
+	{
+		std::shared_ptr<pangolin::GlBuffer> lines;
+		Eigen::Isometry3d 	Twc;
+		EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	};
+	typedef std::map<int, KeyFrameGl, std::less<int>,
+			 Eigen::aligned_allocator<std::pair<const int, KeyFrameGl> > > KeyFrameGlMap;
+
+	//! new keyframes to vertex buffers, pose changes to their matrices
+	void applyUpdates(Updates& u);
+	//! the latest snapshot of the map to vertex buffers, if it changed
+	void updateMap();
+	void draw();
+
+	float 				mImageWidth, mImageHeight;
+	float 				mViewpointX, mViewpointY, mViewpointZ, mViewpointF;
+
+	std::thread 		viewerThread;
+	std::mutex 			mtx;		// guards back, finishFlag, stopped and mapping
+	Updates 			back;
+	bool 				finishFlag;
+	bool 				stopped;	// render loop exited, nobody swaps back any more
+	PointCloudMapping* 	mapping;
+
+	KeyFrameGlMap 		keyframes;
+	PointCloud::Ptr 	mapCloud;	// snapshot in the map buffers
+	std::shared_ptr<pangolin::GlBuffer> mapPoints, mapColors;
+	bool 				hasCurrent;
+	Eigen::Isometry3d 	current;
 };
 
 
 
 
-#endif
\ No newline at end of file
+#endif
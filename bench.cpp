@@ -0,0 +1,274 @@
+//! micro-benchmarks of the front-end kernels on the images in data/
+//! usage: bench [settings] [data_dir] [json] [filter]
+//! each kernel is run in 5 batches of about min_time/5 seconds after a warm-up call, the median batch is
+//! reported as ns/op with the heap allocations per op and the throughput; the json file is meant for
+//! regression tracking, compare it between two builds
+#include "base.h"
+#include "utils.h"
+#include "SysParams.h"
+#include "icp.h"
+#include <atomic>
+#include <algorithm>
+#include <functional>
+#include <cstdio>
+#include <cerrno>
+
+//! every heap allocation of the process goes through here (operator new ends up in malloc), so that the
+//! allocations of OpenCV, PCL and g2o are counted too; glibc only
+static std::atomic<long> allocCount(0), allocBytes(0);
+extern "C" {
+void* __libc_malloc(size_t n);
+void* __libc_calloc(size_t n, size_t size);
+void* __libc_realloc(void* p, size_t n);
+void* __libc_memalign(size_t alignment, size_t n);
+void  __libc_free(void* p);
+
+static inline void countAlloc(size_t n)
+{
+	allocCount.fetch_add(1, std::memory_order_relaxed);
+	allocBytes.fetch_add(n, std::memory_order_relaxed);
+}
+void* malloc(size_t n) 				{ countAlloc(n); return __libc_malloc(n); }
+void* calloc(size_t n, size_t size) 	{ countAlloc(n*size); return __libc_calloc(n, size); }
+void* realloc(void* p, size_t n) 	{ countAlloc(n); return __libc_realloc(p, n); }
+void* memalign(size_t a, size_t n) 	{ countAlloc(n); return __libc_memalign(a, n); }
+void* aligned_alloc(size_t a, size_t n) { countAlloc(n); return __libc_memalign(a, n); }
+int posix_memalign(void** p, size_t a, size_t n)
+{
+	countAlloc(n);
+	*p = __libc_memalign(a, n);
+	return *p ? 0 : ENOMEM;
+}
+void free(void* p) 				{ __libc_free(p); }
+}
+
+struct BenchResult
+{
+	string 	name, unit;
+	long 	iterations;
+	double 	ns_per_op, min_ns_per_op;
+	double 	allocs_per_op, bytes_per_op;
+	double 	items_per_op;	// in unit, throughput = items_per_op/ns_per_op
+};
+
+static double min_time = 1.0;	// seconds per kernel
+static string filter;
+static vector<BenchResult> results;
+
+//! op is called once to warm up, then in 5 timed batches
+static void bench(const string& name, double items, const string& unit, const std::function<void()>& op)
+{
+	if(!filter.empty() && name.find(filter) == string::npos) return;
+	//the kernels that log to cout are silenced
+	std::streambuf* coutBuf = cout.rdbuf(0);
+	op();
+
+	//batch size from the warm-up speed
+	MyTimer timer;
+	long n = 1;
+	while(1)
+	{
+		timer.start();
+		for(long i=0; i<n; i++) op();
+		timer.end();
+		if(timer.time_s >= min_time/20 || n >= (1<<24)) break;
+		n *= 2;
+	}
+	n = max(1L, (long)(n*min_time/5/max(timer.time_s, 1e-9)));
+
+	vector<double> ns(5);
+	const long count0 = allocCount, bytes0 = allocBytes;
+	for(size_t b=0; b<ns.size(); b++)
+	{
+		timer.start();
+		for(long i=0; i<n; i++) op();
+		timer.end();
+		ns[b] = timer.time_ms*1e6/n;
+	}
+	cout.rdbuf(coutBuf);
+	cout.clear();
+	const double ops = 5.0*n;
+
+	BenchResult r;
+	r.name = name;
+	r.unit = unit;
+	r.iterations = 5*n;
+	r.allocs_per_op = (allocCount - count0)/ops;
+	r.bytes_per_op = (allocBytes - bytes0)/ops;
+	std::sort(ns.begin(), ns.end());
+	r.ns_per_op = ns[2];
+	r.min_ns_per_op = ns[0];
+	r.items_per_op = items;
+	results.push_back(r);
+
+	printf("%-28s %10ld %14.0f %10.1f %12.0f %10.2f M%s/s\n", name.c_str(), r.iterations, r.ns_per_op,
+	       r.allocs_per_op, r.bytes_per_op, items/r.ns_per_op*1e3, unit.c_str());
+	fflush(stdout);
+}
+
+static bool saveJson(const string& filename)
+{
+	FILE* f = fopen(filename.c_str(), "w");
+	if(!f) return false;
+	fprintf(f, "{\n\"min_time_s\": %g,\n\"benchmarks\": [", min_time);
+	for(size_t i=0; i<results.size(); i++)
+	{
+		const BenchResult& r = results[i];
+		fprintf(f, "%s\n{\"name\": \"%s\", \"iterations\": %ld, \"ns_per_op\": %.1f, \"min_ns_per_op\": %.1f, "
+			"\"allocs_per_op\": %.2f, \"bytes_per_op\": %.0f, \"items_per_op\": %g, \"unit\": \"%s\", \"items_per_s\": %.1f}",
+			i ? "," : "", r.name.c_str(), r.iterations, r.ns_per_op, r.min_ns_per_op, r.allocs_per_op,
+			r.bytes_per_op, r.items_per_op, r.unit.c_str(), r.items_per_op/r.ns_per_op*1e9);
+	}
+	fprintf(f, "\n]\n}\n");
+	return fclose(f) == 0;
+}
+
+//! the depth samples of an image line with their covariances, as in Frame::extractLineDepth
+static vector<RandomPoint3d> linePoints(const Frame& f, const FrameLine& l)
+{
+	vector<RandomPoint3d> pts;
+	const double numSmp = min((int)cv::norm(l.p-l.q), 100);
+	for(int j=0; j<numSmp; j++)
+	{
+		cv::Point2d pt = l.p*(1-j/numSmp) + l.q*(j/numSmp);
+		int col = (int)pt.x, row = (int)pt.y;
+		if(col<0 || row<0 || col>=f.depth.cols || row>=f.depth.rows) continue;
+		float d = f.depth.at<float>(row, col);
+		if(d < 1e-2) continue;
+		double z = d/Frame::camera.scale;
+		cv::Point3d p((pt.x-Frame::camera.cx)/Frame::camera.fx*z, (pt.y-Frame::camera.cy)/Frame::camera.fy*z, z);
+		pts.push_back(compPt3dCov(p, Frame::K));
+	}
+	return pts;
+}
+
+int main(int argc, char** argv)
+{
+	string settings = argc > 1 ? argv[1] : "../TUM2.yaml";
+	string dir = argc > 2 ? argv[2] : "../data/";
+	string json = argc > 3 ? argv[3] : "";
+	if(argc > 4) filter = argv[4];
+	if(!dir.empty() && dir[dir.size()-1] != '/') dir += "/";
+
+	SysParams sysparams(settings);
+	Camera camera(sysparams);
+	SystemParameters para;
+	Frame f1(0.0, dir+"img1.png", dir+"depth1.png", camera);
+	Frame f2(0.1, dir+"img2.png", dir+"depth2.png", camera);
+	if(f1.rgb.empty() || f2.rgb.empty() || f1.depth.empty() || f2.depth.empty())
+	{
+		cout<<"Usage: bench [settings] [data_dir] [json] [filter], images not found in "<<dir<<endl;
+		return -1;
+	}
+	const double pixels = f1.gray.total();
+
+	//inputs of the kernels, computed once
+	cv::Mat xGrad, yGrad;
+	cv::Sobel(f1.gray, xGrad, CV_64F, 1, 0, 3);
+	cv::Sobel(f1.gray, yGrad, CV_64F, 0, 1, 3);
+	vector<vector<RandomPoint3d> > linePts;
+	size_t nLinePts = 0;
+	for(size_t i=0; i<f1.lines.size(); i++)
+	{
+		vector<RandomPoint3d> pts = linePoints(f1, f1.lines[i]);
+		if(pts.size() < 10) continue;
+		nLinePts += pts.size();
+		linePts.push_back(pts);
+	}
+	vector<RandomLine3d> lines3d;
+	for(size_t i=0; i<linePts.size(); i++)
+	{
+		RandomLine3d l = extract3dline_mahdist(linePts[i], para);
+		if(l.pts.size() >= 10) lines3d.push_back(l);
+	}
+
+	vector<DMatch> bf_matches, pt_matches, ln_matches;
+	BruteForceMatcher<HammingLUT> bf_matcher;
+	bf_matcher.match(f1.mDescriptors, f2.mDescriptors, bf_matches);
+	pt_matches = GmsMatch(f1, f2, bf_matches);
+	vector<vector<int> > line_matches;
+	trackLine(f1.lines, f2.lines, line_matches, para);
+	for(size_t j=0; j<line_matches.size(); j++)
+		if(f1.lines[line_matches[j][0]].haveDepth && f2.lines[line_matches[j][1]].haveDepth)
+			ln_matches.push_back(DMatch(line_matches[j][0], line_matches[j][1], 0));
+
+	cv::Mat_<cv::Vec3f> organized(f1.depth.rows, f1.depth.cols);
+	for(int r=0; r<f1.depth.rows; r++)
+		for(int c=0; c<f1.depth.cols; c++)
+		{
+			float z = f1.depth.at<float>(r, c)/camera.scale*1000;	//mm, as AHCPlane
+			organized(r, c) = cv::Vec3f((c-camera.cx)/camera.fx*z, (r-camera.cy)/camera.fy*z, z);
+		}
+
+	cout<<"Images "<<f1.gray.cols<<"x"<<f1.gray.rows<<", "<<f1.lines.size()<<" lines, "<<lines3d.size()<<" 3d lines, "
+	    <<f1.mvKeypoints.size()<<" keypoints, "<<pt_matches.size()<<" point and "<<ln_matches.size()<<" line matches"<<endl;
+	printf("%-28s %10s %14s %10s %12s %16s\n", "kernel", "iters", "ns/op", "allocs/op", "bytes/op", "throughput");
+
+	IplImage ipl = f1.gray;
+	bench("callLsd", pixels, "px", [&](){
+		free_ntuple_list(callLsd(&ipl));
+	});
+	bench("callEDLines", pixels, "px", [&](){
+		int n;
+		delete[] callEDLines(f1.gray, &n);
+	});
+	vector<FrameLine> msldLines = f1.lines;
+	bench("computeMSLD", msldLines.size(), "line", [&](){
+		for(size_t i=0; i<msldLines.size(); i++)
+			computeMSLD(msldLines[i], &xGrad, &yGrad);
+	});
+	bench("extract3dline_mahdist", nLinePts, "pt", [&](){
+		for(size_t i=0; i<linePts.size(); i++)
+			extract3dline_mahdist(linePts[i], para);
+	});
+	bench("MLEstimateLine3d", lines3d.size(), "line", [&](){
+		for(size_t i=0; i<lines3d.size(); i++)
+		{
+			RandomLine3d l = lines3d[i];
+			MLEstimateLine3d(l, 100);
+		}
+	});
+	bench("trackLine", f1.lines.size(), "line", [&](){
+		vector<vector<int> > m;
+		trackLine(f1.lines, f2.lines, m, para);
+	});
+	bench("ORBextractor::extract", pixels, "px", [&](){
+		vector<cv::KeyPoint> kps;
+		cv::Mat desc;
+		Frame::orbextractor->extract(f1.rgb, kps, desc);
+	});
+	bench("BruteForceMatcher::match", f1.mDescriptors.rows, "desc", [&](){
+		vector<DMatch> m;
+		bf_matcher.match(f1.mDescriptors, f2.mDescriptors, m);
+	});
+	bench("GmsMatch", bf_matches.size(), "match", [&](){
+		GmsMatch(f1, f2, bf_matches);
+	});
+	bench("getTransform_PtsLines_ransac", pt_matches.size()+ln_matches.size(), "match", [&](){
+		vector<DMatch> pt_inliers, ln_inliers;
+		Eigen::Matrix4f tf;
+		float rmse;
+		getTransform_PtsLines_ransac(&f1, &f2, pt_matches, ln_matches, pt_inliers, ln_inliers, tf, rmse, para);
+	});
+	PlaneFitter pf;
+	pf.minSupport = 3000;
+	pf.windowWidth = 10;
+	pf.windowHeight = 10;
+	pf.doRefine = true;
+	OrganizedImage3D Ixyz(organized);
+	bench("PlaneFitter::run", pixels, "px", [&](){
+		vector<vector<int> > membership;
+		pf.run(&Ixyz, &membership, 0, 0, false);
+	});
+	ProjectiveIcp icp(camera);
+	bench("getIcpAlignment", pixels, "px", [&](){
+		getIcpAlignment(&f1, &f2, Eigen::Matrix4f::Identity(), 0, &icp);
+	});
+	bench("img2cloud", pixels, "px", [&](){
+		f1.img2cloud();
+	});
+
+	if(!json.empty() && !saveJson(json))
+		cout<<"Cannot write "<<json<<endl;
+	return 0;
+}
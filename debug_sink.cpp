@@ -0,0 +1,94 @@
+#include "debug_sink.h"
+#include <opencv2/highgui/highgui.hpp>
+#include <cstdio>
+#include <sys/stat.h>
+
+DebugSink::DebugSink(const string& dir_, int every_, size_t ringSize_, bool display_, size_t queueSize_)
+	: dir(dir_), every(every_), ringSize(ringSize_), queueSize(queueSize_ > 0 ? queueSize_ : 1), display(display_),
+	  dropped(0), finishFlag(false)
+{
+	if(!dir.empty())
+		mkdir(dir.c_str(), 0755);
+	sinkThread = std::thread(&DebugSink::run, this);
+}
+
+DebugSink::~DebugSink()
+{
+	finish();
+}
+
+void DebugSink::push(const string& name, long unsigned int frame, const cv::Mat& img)
+{
+	if(img.empty() || !wants(frame)) return;
+	std::lock_guard<std::mutex> lock(mtx);
+	if(finishFlag) return;
+	if(queue.size() >= queueSize) {
+		dropped++;
+		return;
+	}
+	DebugImage d;
+	d.name = name;
+	d.frame = frame;
+	d.img = img;
+	queue.push_back(d);
+	cv_imageUpdate.notify_one();
+}
+
+void DebugSink::recent(vector<DebugImage>& images)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	images.assign(ring.begin(), ring.end());
+}
+
+int DebugSink::droppedNum()
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	return dropped;
+}
+
+void DebugSink::finish()
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		finishFlag = true;
+	}
+	cv_imageUpdate.notify_one();
+	if(sinkThread.joinable())
+		sinkThread.join();
+}
+
+void DebugSink::run()
+{
+	while(1)
+	{
+		DebugImage d;
+		{
+			std::unique_lock<std::mutex> lock(mtx);
+			while(queue.empty() && !finishFlag)
+				cv_imageUpdate.wait(lock);
+			if(queue.empty()) break;
+			d = queue.front();
+			queue.pop_front();
+		}
+
+		if(!dir.empty())
+		{
+			char filename[64];
+			snprintf(filename, sizeof(filename), "_%06lu.png", d.frame);
+			cv::imwrite(dir + "/" + d.name + filename, d.img);
+		}
+		if(display)
+		{
+			// all windows belong to this thread, the events are pumped here and never block
+			cv::imshow(d.name, d.img);
+			cv::waitKey(1);
+		}
+
+		std::lock_guard<std::mutex> lock(mtx);
+		ring.push_back(d);
+		while(ring.size() > ringSize)
+			ring.pop_front();
+	}
+	if(display)
+		cv::destroyAllWindows();
+}
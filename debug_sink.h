@@ -0,0 +1,54 @@
+#ifndef DEBUG_SINK_H
+#define DEBUG_SINK_H
+
+#include "base.h"
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <condition_variable>
+
+//! debug images off the tracking path: they are handed over and written by a thread, as png into dir
+//! and/or shown in a window, and the last ones are kept in a ring buffer
+//! only every n-th frame is taken, check wants() before drawing an overlay
+//! nothing ever waits for a key
+class DebugSink
+{
+public:
+	struct DebugImage
+	{
+		string 				name;
+		long unsigned int 	frame;
+		cv::Mat 			img;
+	};
+
+	//! dir empty: nothing written; every <= 0: nothing taken; display: imshow on the sink thread
+	DebugSink(const string& dir, int every = 1, size_t ringSize = 16, bool display = false, size_t queueSize = 8);
+	~DebugSink();
+	//! false for every frame without a window or a dir, the ring alone does not make the overlays worth drawing
+	bool wants(long unsigned int frame) const { return every > 0 && (display || !dir.empty()) && frame%every == 0; }
+	//! img is shared, not copied, it must not be drawn on afterwards
+	//! dropped if the queue is full or the frame is not wanted
+	void push(const string& name, long unsigned int frame, const cv::Mat& img);
+	//! the ring buffer, oldest first
+	void recent(vector<DebugImage>& images);
+	int droppedNum();
+	//! stop the thread after the queued images are handled
+	void finish();
+
+private:
+	void run();
+
+	string 				dir;
+	int 				every;
+	size_t 				ringSize, queueSize;
+	bool 				display;
+
+	std::thread 		sinkThread;
+	std::mutex 			mtx;			// guards queue, ring, dropped and finishFlag
+	std::condition_variable cv_imageUpdate;
+	std::deque<DebugImage> queue, ring;
+	int 				dropped;
+	bool 				finishFlag;
+};
+
+#endif
@@ -1,38 +1,21 @@
 #include "edge_se3_norm.h"
-#include "utils.h"
 
 using namespace std;
 
 namespace g2o {
 	using namespace std;
 
-	EdgeSE3Norm::EdgeSE3Norm() : BaseBinaryEdge<3, Vector3D, VertexSE3, VertexPointXYZ>() {
+	EdgeSE3Norm::EdgeSE3Norm() : BaseBinaryEdge<3, Vector4d, VertexSE3, VertexPlane>() {
 		information().setIdentity();
-		J.fill(0);
-		J.block<3,3>(0,0) = -Eigen::Matrix3d::Identity();
-		cache = 0;
-		offsetParam = 0;
-		resizeParameters(1);
-		installParameter(offsetParam, 0, 0); 
+		_measurement << 0, 0, 1, 0;
+		Bm = VertexPlane::tangentBasis(_measurement.head<3>());
 	}
 
-	bool EdgeSE3Norm::resolveCaches(){
-		ParameterVector pv(1);
-		pv[0]=offsetParam;
-		resolveCache(cache, (OptimizableGraph::Vertex*)_vertices[0],"CACHE_SE3_OFFSET",pv);
-		return cache != 0;
-	}
-
-
 	bool EdgeSE3Norm::read(std::istream& is) {
-		int pId;
-		is >> pId;
-		setParameterId(0, pId);
-		// measured endpoints
-		Vector3D meas;
-		for (int i=0; i<3; i++) is >> meas[i];
+		// measured plane
+		Vector4d meas;
+		for (int i=0; i<4; i++) is >> meas[i];
 		setMeasurement(meas);
-		// information matrix is the identity for features, could be changed to allow arbitrary covariances    
 		if (is.bad()) {
 			return false;
 		}
@@ -45,13 +28,12 @@ namespace g2o {
 			if (is.bad()) {
 				//  we overwrite the information matrix
 				information().setIdentity();
-			} 
+			}
 			return true;
 	}
 
 	bool EdgeSE3Norm::write(std::ostream& os) const {
-		os << offsetParam->id() << " ";
-		for (int i=0; i<3; i++) os  << measurement()[i] << " ";
+		for (int i=0; i<4; i++) os  << measurement()[i] << " ";
 		for (int i=0; i<information().rows(); i++)
 			for (int j=i; j<information().cols(); j++) {
 				os <<  information()(i,j) << " ";
@@ -61,45 +43,54 @@ namespace g2o {
 
 
 	void EdgeSE3Norm::computeError() {
-		VertexSE3 *cam = static_cast<VertexSE3>(_vertices[0]);
-		
-		VertexPointXYZ *point = static_cast<VertexPointXYZ*>(_vertices[1]);
+		const VertexSE3 *cam = static_cast<const VertexSE3*>(_vertices[0]);
+		const VertexPlane *plane = static_cast<const VertexPlane*>(_vertices[1]);
 
-		Vector3D perr = cache->w2n() * point->estimate();
+		// plane predicted in the camera CS
+		Vector4d pred = VertexPlane::transformToFrame(plane->estimate(), cam->estimate());
 
-		// error, which is backwards from the normal observed - calculated
-		// _measurement is the measured projection
-		_error = perr - _measurement;	
+		_error.head<2>() = Bm.transpose() * pred.head<3>();
+		_error(2) = pred(3) - _measurement(3);
 	}
-	
-	
+
+	void EdgeSE3Norm::linearizeOplus() {
+		const VertexSE3 *cam = static_cast<const VertexSE3*>(_vertices[0]);
+		const VertexPlane *plane = static_cast<const VertexPlane*>(_vertices[1]);
+		const Eigen::Isometry3d& T = cam->estimate();
+		const Eigen::Matrix3d R = T.linear();
+		const Vector3d nw = plane->normal();
+		const Vector3d nc = R.transpose() * nw;
+
+		// camera update T*[dR(dq), dt], dR ~ I+[2dq]x
+		_jacobianOplusXi.setZero();
+		_jacobianOplusXi.block<2,3>(0,3) = 2 * Bm.transpose() * skew(nc);
+		_jacobianOplusXi.block<1,3>(2,0) = nc.transpose();
+
+		// plane update rotates nw by Bw*u, then d += ud
+		const Eigen::Matrix<double,3,2> dn = -skew(nw) * VertexPlane::tangentBasis(nw);
+		_jacobianOplusXj.setZero();
+		_jacobianOplusXj.block<2,2>(0,0) = Bm.transpose() * R.transpose() * dn;
+		_jacobianOplusXj.block<1,2>(2,0) = T.translation().transpose() * dn;
+		_jacobianOplusXj(2,2) = 1;
+	}
+
 	bool EdgeSE3Norm::setMeasurementFromState()
-	{ 
-		// calculate the projection
-		VertexPointXYZ *point = static_cast<VertexPointXYZ*>(_vertices[1]);
-		
-		const Vector3D &pt = point->estimate();
-		// SE3OffsetCache* vcache = (SE3OffsetCache*) cam->getCache(_cacheIds[0]);
-		// if (! vcache){
-		//   cerr << "fatal error in retrieving cache" << endl;
-		// }
-
-		Vector3D perr = cache->w2n() * pt;
-		_measurement = perr;
+	{
+		const VertexSE3 *cam = static_cast<const VertexSE3*>(_vertices[0]);
+		const VertexPlane *plane = static_cast<const VertexPlane*>(_vertices[1]);
+		setMeasurement(VertexPlane::transformToFrame(plane->estimate(), cam->estimate()));
 		return true;
 	}
 
 
-	void EdgeSE3Norm::initialEstimate(const OptimizableGraph::VertexSet& from, OptimizableGraph::Vertex* /*to_*/) // ???
-	{ // estimate 3d pt world position by cam pose and current meas pt
+	void EdgeSE3Norm::initialEstimate(const OptimizableGraph::VertexSet& from, OptimizableGraph::Vertex* /*to_*/)
+	{ // plane in world by cam pose and the measured plane
 		(void) from;
-		assert(from.size() == 1 && from.count(_vertices[0]) == 1 && "Can not initialize VertexDepthCam position by VertexTrackXYZ");
+		assert(from.size() == 1 && from.count(_vertices[0]) == 1 && "Can not initialize VertexPlane by VertexSE3");
 
 		VertexSE3 *cam = dynamic_cast<VertexSE3*>(_vertices[0]);
-		VertexPointXYZ *point = dynamic_cast<VertexPointXYZ*>(_vertices[1]);
-		
-		//Vector3D p=_measurement;
-		//point->setEstimate(cam->estimate() * (offsetParam->offset() * p));
+		VertexPlane *plane = dynamic_cast<VertexPlane*>(_vertices[1]);
+		plane->setEstimate(VertexPlane::transformFromFrame(_measurement, cam->estimate()));
 	}
 
-}
\ No newline at end of file
+}
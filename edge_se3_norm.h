@@ -1,19 +1,22 @@
-#ifndef G2O_EDGE_SE3_LINE_ENDPTS_H_
-#define G2O_EDGE_SE3_LINE_ENDPTS_H_
+#ifndef G2O_EDGE_SE3_NORM_H_
+#define G2O_EDGE_SE3_NORM_H_
 #include "g2o/core/base_binary_edge.h"
-#include "g2o/types/slam3d/vertex_pointxyz.h"
 #include "g2o/types/slam3d/vertex_se3.h"
-#include "g2o/types/slam3d/parameter_se3_offset.h"
 #include "g2o/types/slam3d/g2o_types_slam3d_api.h"
 #include "g2o/stuff/opengl_wrapper.h"
 
-#include "Eigen/src/SVD/JacobiSVD.h"
+#include "vertex_plane.h"
 #include <iostream>
 
 
 namespace g2o {
 	using namespace Eigen;
-	class EdgeSE3Norm : public BaseBinaryEdge<3, Vector3D, VertexSE3, VertexPointXYZ>
+	/**
+	 * \brief observation of a plane landmark from a camera
+	 * the measurement is the plane (n,d) in the camera CS, the error is the predicted
+	 * normal in the tangent basis of the measured one and the difference of d
+	 */
+	class EdgeSE3Norm : public BaseBinaryEdge<3, Vector4d, VertexSE3, VertexPlane>
 	{
 	public:
 		EIGEN_MAKE_ALIGNED_OPERATOR_NEW
@@ -22,43 +25,43 @@ namespace g2o {
 		virtual bool write(std::ostream& os) const;
 		// return the error estimate as a 3-vector
 		void computeError();
+		// jacobians w.r.t. the VertexSE3 and VertexPlane updates
+		virtual void linearizeOplus();
 
-		virtual void setMeasurement(const Vector3D& m){
+		virtual void setMeasurement(const Vector4d& m){
 			_measurement = m;
+			double len = _measurement.head<3>().norm();
+			if(len > 0) _measurement /= len;
+			Bm = VertexPlane::tangentBasis(_measurement.head<3>());
 		}
 
 		virtual bool setMeasurementData(const double* d){
-			Eigen::Map<const Vector3D> v(d);
-			_measurement = v;
+			Eigen::Map<const Vector4d> v(d);
+			setMeasurement(v);
 			return true;
 		}
 
 		virtual bool getMeasurementData(double* d) const{
-			Eigen::Map<Vector3D> v(d);
+			Eigen::Map<Vector4d> v(d);
 			v=_measurement;
 			return true;
 		}
 
-		virtual int measurementDimension() const {return 3;}
+		virtual int measurementDimension() const {return 4;}
 
 		virtual bool setMeasurementFromState() ;
 
-		virtual double initialEstimatePossible(const OptimizableGraph::VertexSet& from, 
-						OptimizableGraph::Vertex* to) { 
-			(void) to; 
+		virtual double initialEstimatePossible(const OptimizableGraph::VertexSet& from,
+						OptimizableGraph::Vertex* to) {
+			(void) to;
 			return (from.count(_vertices[0]) == 1 ? 1.0 : -1.0);
 		}
 
 		virtual void initialEstimate(const OptimizableGraph::VertexSet& from, OptimizableGraph::Vertex* to);
-		
-		const ParameterSE3Offset* offsetParameter() { return offsetParam; }
 
 	private:
-		Eigen::Matrix<double,3,9> J; // jacobian before projection
-		ParameterSE3Offset* offsetParam;
-		CacheSE3Offset* cache;
-		virtual bool resolveCaches();
+		Eigen::Matrix<double,3,2> Bm; // tangent basis of the measured normal
 	};
 
 }
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,178 @@
+#include "evaluation.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cmath>
+
+namespace
+{
+bool earlier(const StampedPose& a, const StampedPose& b) { return a.t < b.t; }
+
+ErrorStats statistics(std::vector<double> e)
+{
+	ErrorStats s;
+	s.n = e.size();
+	if(e.empty()) return s;
+	double sum = 0, sq = 0;
+	for(size_t i=0; i<e.size(); i++)
+	{
+		sum += e[i];
+		sq += e[i]*e[i];
+		s.max = std::max(s.max, e[i]);
+	}
+	s.mean = sum/e.size();
+	s.rmse = sqrt(sq/e.size());
+	std::nth_element(e.begin(), e.begin()+e.size()/2, e.end());
+	s.median = e[e.size()/2];
+	return s;
+}
+
+//! first pose at or after t, traj sorted
+size_t lowerBound(const Trajectory& traj, double t)
+{
+	StampedPose p;
+	p.t = t;
+	return std::lower_bound(traj.begin(), traj.end(), p, earlier) - traj.begin();
+}
+}
+
+bool loadTUMTrajectory(const std::string& filename, Trajectory& traj)
+{
+	traj.clear();
+	std::ifstream in(filename.c_str());
+	if(!in) return false;
+	std::string line;
+	while(getline(in, line))
+	{
+		if(line.empty() || line[0] == '#') continue;
+		std::istringstream ss(line);
+		double t, x, y, z, qx, qy, qz, qw;
+		if(!(ss>>t>>x>>y>>z>>qx>>qy>>qz>>qw)) continue;
+		StampedPose p;
+		p.t = t;
+		p.Twc = Eigen::Isometry3d::Identity();
+		p.Twc.linear() = Eigen::Quaterniond(qw, qx, qy, qz).normalized().toRotationMatrix();
+		p.Twc.translation() = Eigen::Vector3d(x, y, z);
+		traj.push_back(p);
+	}
+	std::stable_sort(traj.begin(), traj.end(), earlier);
+	return true;
+}
+
+bool saveTUMTrajectory(const std::string& filename, const Trajectory& traj)
+{
+	std::ofstream out(filename.c_str());
+	if(!out) return false;
+	out<<std::fixed;
+	for(size_t i=0; i<traj.size(); i++)
+	{
+		const Eigen::Vector3d t = traj[i].Twc.translation();
+		const Eigen::Quaterniond q(traj[i].Twc.rotation());
+		out<<std::setprecision(6)<<traj[i].t<<" "<<std::setprecision(9)<<t.x()<<" "<<t.y()<<" "<<t.z()
+		   <<" "<<q.x()<<" "<<q.y()<<" "<<q.z()<<" "<<q.w()<<"\n";
+	}
+	return out.good();
+}
+
+void associate(const Trajectory& est, const Trajectory& gt, double maxDt, Trajectory& estOut, Trajectory& gtOut)
+{
+	estOut.clear();
+	gtOut.clear();
+	for(size_t i=0; i<est.size(); i++)
+	{
+		size_t k = lowerBound(gt, est[i].t);
+		if(k > 0 && (k == gt.size() || est[i].t - gt[k-1].t < gt[k].t - est[i].t)) k--;
+		if(k >= gt.size() || fabs(gt[k].t - est[i].t) > maxDt) continue;
+		estOut.push_back(est[i]);
+		gtOut.push_back(gt[k]);
+	}
+}
+
+ErrorStats computeATE(const Trajectory& est, const Trajectory& gt)
+{
+	const int n = std::min(est.size(), gt.size());
+	if(n < 3) return ErrorStats();
+	Eigen::Matrix3Xd src(3, n), dst(3, n);
+	for(int i=0; i<n; i++)
+	{
+		src.col(i) = est[i].Twc.translation();
+		dst.col(i) = gt[i].Twc.translation();
+	}
+	//Horn: rotation and translation, no scale for RGB-D
+	const Eigen::Matrix4d A = Eigen::umeyama(src, dst, false);
+	std::vector<double> e(n);
+	for(int i=0; i<n; i++)
+		e[i] = (A.topLeftCorner<3,3>()*src.col(i) + A.topRightCorner<3,1>() - dst.col(i)).norm();
+	return statistics(e);
+}
+
+void computeRPE(const Trajectory& est, const Trajectory& gt, double delta, ErrorStats& trans, ErrorStats& rot)
+{
+	std::vector<double> et, er;
+	const size_t n = std::min(est.size(), gt.size());
+	for(size_t i=0; i<n; i++)
+	{
+		size_t j = lowerBound(est, est[i].t + delta);
+		if(j >= n) break;
+		const Eigen::Isometry3d dGt = gt[i].Twc.inverse()*gt[j].Twc;
+		const Eigen::Isometry3d dEst = est[i].Twc.inverse()*est[j].Twc;
+		const Eigen::Isometry3d E = dGt.inverse()*dEst;
+		et.push_back(E.translation().norm());
+		er.push_back(Eigen::AngleAxisd(E.rotation()).angle()*180/M_PI);
+	}
+	trans = statistics(et);
+	rot = statistics(er);
+}
+
+void FrameLog::add(double timestamp, double ms, bool keyframe)
+{
+	timestamps.push_back(timestamp);
+	latencies.push_back(ms);
+	keyframes.push_back(keyframe);
+}
+
+bool FrameLog::save(const std::string& filename) const
+{
+	std::ofstream out(filename.c_str());
+	if(!out) return false;
+	out<<std::fixed;
+	for(size_t i=0; i<timestamps.size(); i++)
+		out<<std::setprecision(6)<<timestamps[i]<<" "<<std::setprecision(3)<<latencies[i]<<" "<<(keyframes[i] ? 1 : 0)<<"\n";
+	return out.good();
+}
+
+bool FrameLog::load(const std::string& filename)
+{
+	timestamps.clear();
+	latencies.clear();
+	keyframes.clear();
+	std::ifstream in(filename.c_str());
+	if(!in) return false;
+	double t, ms;
+	int kf;
+	while(in>>t>>ms>>kf)
+		add(t, ms, kf != 0);
+	return true;
+}
+
+int FrameLog::keyFrameNum() const
+{
+	return std::count(keyframes.begin(), keyframes.end(), true);
+}
+
+double FrameLog::fps() const
+{
+	double ms = 0;
+	for(size_t i=0; i<latencies.size(); i++) ms += latencies[i];
+	return ms > 0 ? latencies.size()/(ms/1000) : 0;
+}
+
+double FrameLog::percentile(double p) const
+{
+	if(latencies.empty()) return 0;
+	std::vector<double> v = latencies;
+	const size_t k = std::min(v.size()-1, (size_t)(p*(v.size()-1) + 0.5));
+	std::nth_element(v.begin(), v.begin()+k, v.end());
+	return v[k];
+}
@@ -0,0 +1,56 @@
+#ifndef EVALUATION_H
+#define EVALUATION_H
+
+#include <string>
+#include <vector>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <Eigen/StdVector>
+
+//! trajectory accuracy against a TUM ground truth, as evaluate_ate.py / evaluate_rpe.py of the TUM
+//! benchmark tools, and the per frame log of a run
+
+struct StampedPose
+{
+	double 				t;
+	Eigen::Isometry3d 	Twc;
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+typedef std::vector<StampedPose, Eigen::aligned_allocator<StampedPose> > Trajectory;
+
+struct ErrorStats
+{
+	int 	n;
+	double 	rmse, mean, median, max;
+	ErrorStats() : n(0), rmse(0), mean(0), median(0), max(0) {}
+};
+
+//! "timestamp tx ty tz qx qy qz qw" per line, '#' comments; sorted by timestamp
+bool loadTUMTrajectory(const std::string& filename, Trajectory& traj);
+bool saveTUMTrajectory(const std::string& filename, const Trajectory& traj);
+//! pairs each pose of est with the ground truth pose closest in time, within maxDt seconds
+void associate(const Trajectory& est, const Trajectory& gt, double maxDt, Trajectory& estOut, Trajectory& gtOut);
+//! absolute trajectory error (m) after the rigid alignment of est onto gt, associated pairs
+ErrorStats computeATE(const Trajectory& est, const Trajectory& gt);
+//! relative pose error over delta seconds, translation in m and rotation in deg, associated pairs
+void computeRPE(const Trajectory& est, const Trajectory& gt, double delta, ErrorStats& trans, ErrorStats& rot);
+
+//! tracking latency of every frame of a run, "timestamp latency_ms keyframe" per line
+class FrameLog
+{
+public:
+	void add(double timestamp, double ms, bool keyframe);
+	bool save(const std::string& filename) const;
+	bool load(const std::string& filename);
+	int size() const { return timestamps.size(); }
+	int keyFrameNum() const;
+	//! frames per second of tracking alone
+	double fps() const;
+	//! latency percentile in ms, p in [0,1]
+	double percentile(double p) const;
+
+	std::vector<double> 	timestamps, latencies;
+	std::vector<bool> 		keyframes;
+};
+
+#endif
@@ -0,0 +1,232 @@
+#include "flat_vocabulary.h"
+#include <thread>
+#include <cstring>
+#include <algorithm>
+#ifdef __POPCNT__
+#include <nmmintrin.h>
+#endif
+
+using namespace std;
+
+static inline int popcount64(uint64_t x)
+{
+#ifdef __POPCNT__
+	return _mm_popcnt_u64(x);
+#else
+	return __builtin_popcountll(x);
+#endif
+}
+
+static inline int hamming256(const uint64_t* a, const uint64_t* b)
+{
+	return popcount64(a[0]^b[0]) + popcount64(a[1]^b[1]) + popcount64(a[2]^b[2]) + popcount64(a[3]^b[3]);
+}
+
+static inline bool packable(const cv::Mat& d)
+{
+	return d.data && d.isContinuous() && d.total()*d.elemSize() == 4*sizeof(uint64_t);
+}
+
+bool FlatVocabulary::loadVocabulary(const std::string& filename)
+{
+	bool binary = filename.size()>4 && filename.substr(filename.size()-4)==".bin";
+	bool ok = binary ? loadFromBinaryFile(filename) : loadFromTextFile(filename);
+	if(ok) flatten();
+	return ok;
+}
+
+void FlatVocabulary::flatten()
+{
+	const size_t n = m_nodes.size();
+	desc.assign(4*n, 0);
+	firstChild.assign(n, -1);
+	numChildren.assign(n, 0);
+	node.assign(n, 0);
+	word.assign(n, 0);
+	weight.assign(n, 0);
+	if(n == 0) return;
+
+	// breadth first, the flat indexes of the children are given when their parent is visited
+	size_t next = 1;
+	for(size_t f=0; f<next; ++f)
+	{
+		const Node& nd = m_nodes[node[f]];
+		if(f > 0 && packable(nd.descriptor))
+			memcpy(&desc[4*f], nd.descriptor.data, 4*sizeof(uint64_t));
+		word[f] = nd.word_id;
+		weight[f] = nd.weight;
+		if(nd.isLeaf()) continue;
+		firstChild[f] = next;
+		numChildren[f] = nd.children.size();
+		for(size_t c=0; c<nd.children.size() && next<n; ++c)
+			node[next++] = nd.children[c];
+	}
+}
+
+int FlatVocabulary::descend(const uint64_t* d, int nidLevel, int& nidFlat) const
+{
+	int f = 0;
+	int level = 0;
+	nidFlat = 0;  // root
+	while(firstChild[f] >= 0)
+	{
+		++level;
+		const int c0 = firstChild[f], cn = c0 + numChildren[f];
+		int best = c0;
+		int best_d = hamming256(d, &desc[4*c0]);
+		for(int c=c0+1; c<cn; ++c)
+		{
+			int dist = hamming256(d, &desc[4*c]);
+			if(dist < best_d) {
+				best_d = dist;
+				best = c;
+			}
+		}
+		f = best;
+		if(level == nidLevel) nidFlat = f;
+	}
+	return f;
+}
+
+void FlatVocabulary::descend(const cv::Mat& descriptors, int begin, int end, int nidLevel,
+			     int* leaf, int* nidFlat) const
+{
+	const int G = 16;
+	uint64_t d[G][4];
+	int f[G];
+	for(int i0=begin; i0<end; i0+=G)
+	{
+		const int g_n = min(G, end-i0);
+		for(int g=0; g<g_n; ++g) {
+			memcpy(d[g], descriptors.ptr<uchar>(i0+g), sizeof(d[g]));
+			f[g] = 0;
+			nidFlat[i0+g] = 0;
+		}
+		for(int level=1, active=g_n; active>0; ++level)
+		{
+			// the children blocks of the whole group are requested before any is compared
+			for(int g=0; g<g_n; ++g) {
+				if(firstChild[f[g]] < 0) continue;
+				const char* p = (const char*)&desc[4*firstChild[f[g]]];
+				const char* pe = (const char*)&desc[4*(firstChild[f[g]]+numChildren[f[g]])];
+				for(; p<pe; p+=64) __builtin_prefetch(p);
+			}
+			active = 0;
+			for(int g=0; g<g_n; ++g) {
+				if(firstChild[f[g]] < 0) continue;
+				const int c0 = firstChild[f[g]], cn = c0 + numChildren[f[g]];
+				int best = c0;
+				int best_d = hamming256(d[g], &desc[4*c0]);
+				for(int c=c0+1; c<cn; ++c)
+				{
+					int dist = hamming256(d[g], &desc[4*c]);
+					if(dist < best_d) {
+						best_d = dist;
+						best = c;
+					}
+				}
+				f[g] = best;
+				if(level == nidLevel) nidFlat[i0+g] = best;
+				if(firstChild[best] >= 0) {
+					__builtin_prefetch(&firstChild[best]);
+					__builtin_prefetch(&numChildren[best]);
+					++active;
+				}
+			}
+		}
+		for(int g=0; g<g_n; ++g)
+			leaf[i0+g] = f[g];
+	}
+}
+
+void FlatVocabulary::transform(const cv::Mat& feature, DBoW2::WordId& word_id, DBoW2::WordValue& w,
+			       DBoW2::NodeId* nid, int levelsup) const
+{
+	if(desc.empty() || !packable(feature)) {
+		ORBVocabulary::transform(feature, word_id, w, nid, levelsup);
+		return;
+	}
+	uint64_t d[4];
+	memcpy(d, feature.data, sizeof(d));
+	int nidFlat;
+	int f = descend(d, m_L - levelsup, nidFlat);
+	word_id = word[f];
+	w = weight[f];
+	if(nid) *nid = node[nidFlat];
+}
+
+void FlatVocabulary::transform(const cv::Mat& descriptors, DBoW2::BowVector& v, DBoW2::FeatureVector& fv,
+			       int levelsup) const
+{
+	v.clear();
+	fv.clear();
+	if(empty()) return;
+
+	const int N = descriptors.rows;
+	if(desc.empty() || descriptors.cols*descriptors.elemSize() != 4*sizeof(uint64_t))
+	{
+		vector<cv::Mat> rows(N);
+		for(int i=0; i<N; i++) rows[i] = descriptors.row(i);
+		ORBVocabulary::transform(rows, v, fv, levelsup);
+		return;
+	}
+
+	// leaves and the levelsup nodes of all the features, in parallel
+	vector<int> leaf(N), nidFlat(N);
+	const int nidLevel = m_L - levelsup;
+	const int nt = min(threads, max(1, N/500));  // a thread per 500 features at least
+	vector<std::thread> pool;
+	for(int t=1; t<nt; ++t)
+		pool.push_back(std::thread([&, t]() {
+			descend(descriptors, (long)N*t/nt, (long)N*(t+1)/nt, nidLevel, &leaf[0], &nidFlat[0]);
+		}));
+	if(N > 0) descend(descriptors, 0, N/nt, nidLevel, &leaf[0], &nidFlat[0]);
+	for(size_t t=0; t<pool.size(); ++t)
+		pool[t].join();
+
+	// sorted by word and node first, so that the maps are filled in order at their end
+	// the stable sort keeps the feature order of the base class within a word or node
+	vector<pair<DBoW2::WordId,int> > words;
+	vector<pair<DBoW2::NodeId,int> > nodes;
+	words.reserve(N);
+	nodes.reserve(N);
+	for(int i=0; i<N; ++i)
+	{
+		if(weight[leaf[i]] <= 0) continue;  // stopped
+		words.push_back(make_pair(word[leaf[i]], leaf[i]));
+		nodes.push_back(make_pair(node[nidFlat[i]], i));
+	}
+	stable_sort(words.begin(), words.end(),
+		    [](const pair<DBoW2::WordId,int>& a, const pair<DBoW2::WordId,int>& b) { return a.first < b.first; });
+	stable_sort(nodes.begin(), nodes.end(),
+		    [](const pair<DBoW2::NodeId,int>& a, const pair<DBoW2::NodeId,int>& b) { return a.first < b.first; });
+
+	DBoW2::LNorm norm;
+	bool must = m_scoring_object->mustNormalize(norm);
+	const bool tf = m_weighting == DBoW2::TF || m_weighting == DBoW2::TF_IDF;
+	for(size_t i=0; i<words.size(); )
+	{
+		// TF adds up the weight of every feature, IDF and BINARY keep one
+		DBoW2::WordValue w = 0;
+		size_t j = i;
+		for(; j<words.size() && words[j].first == words[i].first; ++j)
+			if(tf || j == i) w += weight[words[j].second];
+		v.insert(v.end(), make_pair(words[i].first, w));
+		i = j;
+	}
+	for(size_t i=0; i<nodes.size(); )
+	{
+		DBoW2::FeatureVector::iterator it = fv.insert(fv.end(), make_pair(nodes[i].first, vector<unsigned int>()));
+		size_t j = i;
+		for(; j<nodes.size() && nodes[j].first == nodes[i].first; ++j)
+			it->second.push_back(nodes[j].second);
+		i = j;
+	}
+	if(tf && !v.empty() && !must)
+	{
+		const double nd = v.size();
+		for(DBoW2::BowVector::iterator vit = v.begin(); vit != v.end(); vit++)
+			vit->second /= nd;
+	}
+	if(must) v.normalize(norm);
+}
@@ -0,0 +1,52 @@
+#ifndef FLAT_VOCABULARY_H
+#define FLAT_VOCABULARY_H
+
+#include <vector>
+#include <string>
+#include <stdint.h>
+#include "Thirdparty/DBoW2/DBoW2/FORB.h"
+#include "Thirdparty/DBoW2/DBoW2/TemplatedVocabulary.h"
+
+typedef DBoW2::TemplatedVocabulary<DBoW2::FORB::TDescriptor, DBoW2::FORB> ORBVocabulary;
+
+//! ORB vocabulary with a flat copy of the tree for transform()
+//! nodes are stored level by level with siblings next to each other, the 256 bit descriptors
+//! packed as 4 x 64 bits and compared with popcount. the BoW vectors are the same as the
+//! base class ones, the descriptors of a frame can be transformed on several threads
+class FlatVocabulary : public ORBVocabulary
+{
+public:
+	FlatVocabulary() : threads(2) {}
+	//! text or binary (.bin, see voc2bin) vocabulary, flattened after loading
+	bool loadVocabulary(const std::string& filename);
+	//! rebuild the flat tree, needed whenever the base class tree changes
+	void flatten();
+	void setThreads(int n) { threads = n > 0 ? n : 1; }
+
+	using ORBVocabulary::transform;
+	//! descriptors as rows of a CV_8U matrix, as Frame::mDescriptors
+	void transform(const cv::Mat& descriptors, DBoW2::BowVector& v, DBoW2::FeatureVector& fv,
+		       int levelsup) const;
+
+protected:
+	//! one feature down the flat tree, every transform() of the base class ends here
+	virtual void transform(const cv::Mat& feature, DBoW2::WordId& word_id, DBoW2::WordValue& weight,
+			       DBoW2::NodeId* nid = NULL, int levelsup = 0) const;
+
+private:
+	//! flat index of the leaf reached by d, nidFlat is the node passed at level nidLevel
+	int descend(const uint64_t* d, int nidLevel, int& nidFlat) const;
+	//! descend of the rows [begin,end) of descriptors, a few features go down in lockstep so that
+	//! the children of one are prefetched while the others are compared
+	void descend(const cv::Mat& descriptors, int begin, int end, int nidLevel, int* leaf, int* nidFlat) const;
+
+	int 						threads;
+	std::vector<uint64_t> 		desc;		// 4 words per flat node
+	std::vector<int> 			firstChild;	// flat index of the first child, -1 for leaves
+	std::vector<int> 			numChildren;
+	std::vector<DBoW2::NodeId> 	node;		// flat index -> node id
+	std::vector<DBoW2::WordId> 	word;
+	std::vector<DBoW2::WordValue> weight;
+};
+
+#endif
@@ -5,6 +5,7 @@
 #include "ORBextractor.h"
 #include "Camera.h"
 #include "base.h"
+#include "flat_vocabulary.h"
 #include <numpy/ndarrayobject.h>
 #include "AHCPlaneFitter.hpp"
 
@@ -44,6 +45,7 @@ struct OrganizedImage3D {
 typedef ahc::PlaneFitter< OrganizedImage3D > PlaneFitter;
 
 class SystemParameters;
+class DebugSink;
 
 
 class RandomPoint3d 
@@ -171,6 +173,25 @@ public:
     }
 };
 
+class FramePlane
+{
+public:
+    static const int 	CELL_SIZE = 20; //pixels, size of the image cells recording the plane's support
+
+    cv::Point3d 	n;      //unit normal, pointing towards the camera
+    double 			d;      //plane equation n.x+d=0, in meter
+    cv::Point3d 	center; //center of mass of the supporting points
+    double 			mse;    //mean square point-plane distance, m^2
+    int 			N;      //number of supporting points
+    vector<int> 	cells;  //sorted ids of image cells (CELL_SIZE x CELL_SIZE) covered by the plane
+
+    int 			pid;  //local id in frame
+    int 			gid;  //global id
+
+    FramePlane(){gid=-1;}
+    ~FramePlane(){}
+};
+
 class Frame
 {
 public:
@@ -179,6 +200,7 @@ public:
     double      				timestamp;
     bool        				isKeyFrame;
     vector<FrameLine> 			lines;
+    vector<FramePlane>			planes;  //filled by AHCPlane
     cv::Mat     				R, t;
     cv::Mat     				rgb, gray;
     cv::Mat     				depth, oriDepth;
@@ -209,10 +231,13 @@ public:
     vector<cv::KeyPoint>		feature_locations_2d_;
     vector<Eigen::Vector4f>		feature_locations_3d_;
     
-    //BoW
-    //ORBVocabulary	  			*mpORBVocabulary;
-    //DBoW2::BowVector  			mBowVec;
-    //DBoW2::FeatureVector		mFeatureVec;
+    //BoW, filled by computeBow
+    static FlatVocabulary		*mpORBVocabulary;
+    DBoW2::BowVector  			mBowVec;
+    DBoW2::FeatureVector		mFeatureVec;
+    
+    //debug images (plane segmentation) go here if set
+    static DebugSink			*debugSink;
     
     //POSE
     cv::Mat 					mTcw;    //Camera pose
@@ -262,7 +287,10 @@ public:
 	void planeEquation(vector<vector<double>>& equations);
 	
 	//fast plane extraction 
-	void AHCPlane();
+	//pf: fitter of the sequence, it keeps the planes of the previous frame passed to it
+	//Tcp: motion from that frame to this one (p_cur = Tcp*p_prev, in meters), used to seed the
+	//segmentation with the previous frame's planes
+	void AHCPlane(PlaneFitter& pf, const Eigen::Matrix4d& Tcp = Eigen::Matrix4d::Identity());
 	
 };
 
@@ -292,18 +320,25 @@ public:
 	int 	line3d_mle_iter_num;
 	int 	line_detect_algorithm;
 	double 	msld_sample_interval;
-	int 	ransac_iters_line_motion;
+	int 	ransac_iters_line_motion;	// max iterations, stops earlier once ransac_confidence is reached
+	double	ransac_confidence;			// probability of having drawn an all-inlier sample
+	int		ransac_threads;				// threads scoring hypotheses in parallel
 	int 	adjacent_linematch_window;
 	int 	line_match_number_weight;
 	int 	min_feature_matches;
 	double 	max_mah_dist_for_inliers;
 	double  g2o_line_error_weight;
+	double	g2o_plane_normal_std;		// in rad, std of the plane normal measurement
+	double	g2o_plane_dist_std;			// in meter, std of the plane offset measurement
 	int 	min_matches_loopclose;
 	
 	int		num_2dlinematch_keyframe;	// detect keyframe, minmum number of 2d line matches left
 	int		num_3dlinematch_keyframe;
 	double	pt2line3d_dist_relmotion;	// in meter, 
 	double  line3d_angle_relmotion;		// in degree
+	double	plane_angle_match;			// in degree, max angle between normals of matched planes
+	double	plane_dist_match;			// in meter, max offset difference of matched planes
+	double	plane_overlap_match;		// min ratio of overlapping image cells of matched planes
 	int		num_raw_frame_skip;			// number of raw frame to skip when tracking lines
 	int		window_length_keyframe;		
 	bool	fast_motion;
@@ -316,6 +351,12 @@ public:
 	// ----- loop closing -----
 	double 	loopclose_interval;  // frames, check loop closure
 	int		loopclose_min_3dmatch;  // min_num for 3d line matches between two frames
+	// ----- out of core map -----
+	string	map_chunk_dir;			// chunks written out of RAM go here
+	double	map_chunk_size;			// in meter, edge of the voxel map chunks
+	double	map_working_radius;		// in meter, chunks and keyframes around the camera stay in RAM
+	int		map_budget_voxels;		// MB, voxel map chunks beyond it are written out
+	int		map_budget_images;		// MB, keyframe images beyond it are written out
 	
 	bool 	dark_lighting;
 	double	max_img_brightness;
@@ -350,17 +391,24 @@ public:
 	    // ----- relative motion -----
 	    pt2line3d_dist_relmotion	= 0.05;	// in meter, 
 	    line3d_angle_relmotion		= 10;
+	    plane_angle_match			= 10;
+	    plane_dist_match			= 0.1;
+	    plane_overlap_match			= 0.3;
 	    fast_motion					= 1;
 	    inlier_ratio_constvel		= 0.4;
 	    dark_lighting				= false;
 	    max_img_brightness			= 0;
-	    ransac_iters_line_motion	= 50;
+	    ransac_iters_line_motion	= 500;	// closed-form minimal hypotheses
+	    ransac_confidence			= 0.99;
+	    ransac_threads				= 4;
 	    adjacent_linematch_window 	= 10;
 	    
 	    line_match_number_weight    = 1; //0.5
 	    min_feature_matches 		= 3;
 	    max_mah_dist_for_inliers 	= 3;
 	    g2o_line_error_weight 		= 1.0;
+	    g2o_plane_normal_std		= 0.02;
+	    g2o_plane_dist_std			= 0.02;
 	    min_matches_loopclose 		= 20;
 	    
 	    // ----- lba -----
@@ -371,6 +419,13 @@ public:
 	    loopclose_interval			= 50;  // frames, check loop closure
 	    loopclose_min_3dmatch		= 30;  // min_num for 3d line matches between two frames
     
+	    // ----- out of core map -----
+	    map_chunk_dir				= "chunks";
+	    map_chunk_size				= 2;
+	    map_working_radius			= 5;
+	    map_budget_voxels			= 512;
+	    map_budget_images			= 2048;
+    
 	    // ----- lsd setting -----
 	    lsd_angle_th 				= 40;   //  22.5
 	    lsd_density_th				= 0.7;
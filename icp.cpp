@@ -0,0 +1,230 @@
+#include "icp.h"
+#include <cmath>
+#include <chrono>
+#include "profiler.h"
+#include <Eigen/Cholesky>
+
+//! correspondences per batch of the normal equation
+static const int BATCH = 128;
+
+ProjectiveIcp::ProjectiveIcp(const Camera& cam)
+{
+	camera = cam;
+	levels = 3;
+	max_iterations[0] = 4;
+	max_iterations[1] = 6;
+	max_iterations[2] = 10;
+	max_iterations[3] = 10;
+	dist_thresh = 0.1;
+	angle_thresh = 30;
+	huber_delta = 0.02;
+	min_update = 1e-5;
+	min_inliers = 100;
+	max_depth = 10;
+}
+
+void ProjectiveIcp::buildPyramid(const cv::Mat& depth, std::vector<Level>& pyr)
+{
+	pyr.resize(levels);
+	Level& l0 = pyr[0];
+	l0.rows = depth.rows;
+	l0.cols = depth.cols;
+	l0.fx = camera.fx;
+	l0.fy = camera.fy;
+	l0.cx = camera.cx;
+	l0.cy = camera.cy;
+	l0.depth.resize(l0.rows*l0.cols);
+	for(int r=0; r<l0.rows; r++)
+	{
+		const float* d = depth.ptr<float>(r);
+		for(int c=0; c<l0.cols; c++)
+		{
+			float z = d[c]/camera.scale;
+			l0.depth[r*l0.cols+c] = (z>0 && z<max_depth) ? z : 0;
+		}
+	}
+	computeMaps(l0);
+
+	for(int l=1; l<levels; l++)
+	{
+		const Level& fine = pyr[l-1];
+		Level& lv = pyr[l];
+		lv.rows = fine.rows/2;
+		lv.cols = fine.cols/2;
+		lv.fx = fine.fx/2;
+		lv.fy = fine.fy/2;
+		lv.cx = (fine.cx+0.5f)/2-0.5f;
+		lv.cy = (fine.cy+0.5f)/2-0.5f;
+		lv.depth.resize(lv.rows*lv.cols);
+		//average the valid depths of the 2x2 block that agree with the first valid one
+		for(int r=0; r<lv.rows; r++)
+		{
+			for(int c=0; c<lv.cols; c++)
+			{
+				const float* d0 = &fine.depth[(2*r)*fine.cols+2*c];
+				const float* d1 = d0+fine.cols;
+				const float block[4] = {d0[0], d0[1], d1[0], d1[1]};
+				float ref = 0, sum = 0;
+				int n = 0;
+				for(int k=0; k<4; k++)
+				{
+					if(block[k]<=0) continue;
+					if(n==0) ref = block[k];
+					if(std::fabs(block[k]-ref) > 0.05f*ref) continue;
+					sum += block[k];
+					n++;
+				}
+				lv.depth[r*lv.cols+c] = n>0 ? sum/n : 0;
+			}
+		}
+		computeMaps(lv);
+	}
+}
+
+void ProjectiveIcp::computeMaps(Level& lv)
+{
+	const int n = lv.rows*lv.cols;
+	lv.V.resize(n);
+	lv.N.resize(n);
+	for(int r=0; r<lv.rows; r++)
+	{
+		for(int c=0; c<lv.cols; c++)
+		{
+			const int i = r*lv.cols+c;
+			const float z = lv.depth[i];
+			lv.V[i] = Eigen::Vector3f((c-lv.cx)/lv.fx*z, (r-lv.cy)/lv.fy*z, z);
+		}
+	}
+	for(int r=0; r<lv.rows; r++)
+	{
+		for(int c=0; c<lv.cols; c++)
+		{
+			const int i = r*lv.cols+c;
+			lv.N[i].setZero();
+			if(r+1>=lv.rows || c+1>=lv.cols) continue;
+			const float z = lv.depth[i], zr = lv.depth[i+1], zd = lv.depth[i+lv.cols];
+			if(z<=0 || zr<=0 || zd<=0) continue;
+			if(std::fabs(zr-z) > 0.05f*z || std::fabs(zd-z) > 0.05f*z) continue;  //depth discontinuity
+			Eigen::Vector3f nrm = (lv.V[i+1]-lv.V[i]).cross(lv.V[i+lv.cols]-lv.V[i]);
+			const float len = nrm.norm();
+			if(len < 1e-12f) continue;
+			nrm /= len;
+			if(nrm.dot(lv.V[i]) > 0) nrm = -nrm;  //towards camera
+			lv.N[i] = nrm;
+		}
+	}
+}
+
+int ProjectiveIcp::solveLevel(const Level& src, const Level& tgt, int level, Eigen::Isometry3d& T, IcpReport& report)
+{
+	const float dist_th = dist_thresh*(1<<level);
+	const float cos_th = std::cos(angle_thresh*M_PI/180);
+	const float delta = huber_delta*(1<<level);
+	const int n = src.rows*src.cols;
+
+	report.converged = false;
+	int it = 0;
+	for(; it<max_iterations[level]; it++)
+	{
+		const Eigen::Matrix3f R = T.linear().cast<float>();
+		const Eigen::Vector3f t = T.translation().cast<float>();
+		int m = 0, n_valid = 0, k = 0;
+		double sse = 0;
+		//6x6 normal equation, correspondences are gathered as columns sqrt(w)*jacobian
+		//and folded in a batch at a time, so that the products run on packets instead of scalars
+		Eigen::Matrix<double,6,6> A = Eigen::Matrix<double,6,6>::Zero();
+		Eigen::Matrix<double,6,1> b = Eigen::Matrix<double,6,1>::Zero();
+		Eigen::Matrix<float,6,BATCH> J;
+		Eigen::Matrix<float,BATCH,1> r;
+		for(int i=0; i<n; i++)
+		{
+			if(src.N[i].isZero()) continue;
+			n_valid++;
+			const Eigen::Vector3f p = R*src.V[i]+t;
+			if(p(2) <= 0) continue;
+			const int u = (int)std::floor(tgt.fx*p(0)/p(2)+tgt.cx+0.5f);
+			const int v = (int)std::floor(tgt.fy*p(1)/p(2)+tgt.cy+0.5f);
+			if(u<0 || u>=tgt.cols || v<0 || v>=tgt.rows) continue;
+			const int j = v*tgt.cols+u;
+			const Eigen::Vector3f& nt = tgt.N[j];
+			if(nt.isZero()) continue;
+			const Eigen::Vector3f diff = p-tgt.V[j];
+			if(diff.squaredNorm() > dist_th*dist_th) continue;
+			if((R*src.N[i]).dot(nt) < cos_th) continue;
+
+			//residual nt.(exp(xi)*p - q), jacobian w.r.t. xi = (omega, v) is [(p x nt)', nt']
+			const float res = nt.dot(diff);
+			const float sw = std::fabs(res) <= delta ? 1.0f : std::sqrt(delta/std::fabs(res));  //sqrt of the huber weight
+			J.col(k).head<3>() = sw*p.cross(nt);
+			J.col(k).tail<3>() = sw*nt;
+			r(k) = sw*res;
+			sse += res*res;
+			m++;
+			if(++k == BATCH)
+			{
+				A.noalias() += (J*J.transpose()).cast<double>();
+				b.noalias() += (J*r).cast<double>();
+				k = 0;
+			}
+		}
+		if(k > 0)
+		{
+			A.noalias() += (J.leftCols(k)*J.leftCols(k).transpose()).cast<double>();
+			b.noalias() += (J.leftCols(k)*r.head(k)).cast<double>();
+		}
+		report.inliers = m;
+		report.inlier_ratio = n_valid>0 ? (double)m/n_valid : 0;
+		report.rmse = m>0 ? std::sqrt(sse/m) : 0;
+		if(m < min_inliers) return -1;
+
+		const Eigen::Matrix<double,6,1> xi = A.ldlt().solve(-b);
+
+		Eigen::Isometry3d dT = Eigen::Isometry3d::Identity();
+		const double angle = xi.head<3>().norm();
+		if(angle > 1e-12)
+			dT.linear() = Eigen::AngleAxisd(angle, xi.head<3>()/angle).toRotationMatrix();
+		dT.translation() = xi.tail<3>();
+		T = dT*T;
+		report.iterations++;
+		if(xi.norm() < min_update)
+		{
+			report.converged = true;
+			return it+1;
+		}
+	}
+	return it;
+}
+
+Eigen::Isometry3d ProjectiveIcp::align(const cv::Mat& source, const cv::Mat& target,
+				       const Eigen::Isometry3d& guess, IcpReport* report)
+{
+	PROF_SCOPE(PROF_ICP);
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	IcpReport rep;
+	Eigen::Isometry3d T = guess;
+
+	buildPyramid(source, src_pyr);
+	buildPyramid(target, tgt_pyr);
+
+	bool ok = true;
+	for(int l=levels-1; l>=0; l--)
+	{
+		const int it = solveLevel(src_pyr[l], tgt_pyr[l], l, T, rep);
+		if(it < 0)
+		{
+			ok = false;
+			rep.level_iterations.push_back(0);
+			break;
+		}
+		rep.level_iterations.push_back(it);
+	}
+	rep.valid = ok;
+	if(!ok)
+	{
+		rep.converged = false;
+		T = guess;
+	}
+	rep.time_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now()-start).count();
+	if(report) *report = rep;
+	return T;
+}
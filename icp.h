@@ -0,0 +1,65 @@
+#ifndef PROJECTIVE_ICP_H
+#define PROJECTIVE_ICP_H
+
+#include <vector>
+#include <opencv2/core/core.hpp>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include "Camera.h"
+
+//! convergence report of ProjectiveIcp::align
+struct IcpReport
+{
+	bool 	valid;			// every level had min_inliers correspondences, align returns the guess otherwise
+	bool 	converged;		// update fell below min_update on the finest level
+	int 	iterations;		// Gauss-Newton iterations over all levels
+	int 	inliers;		// correspondences of the last iteration
+	double 	inlier_ratio;	// inliers / valid source points of the last level
+	double 	rmse;			// point-to-plane rmse of the inliers, meter
+	double 	time_ms;
+	std::vector<int> level_iterations;	// coarse to fine
+
+	IcpReport(): valid(false), converged(false), iterations(0), inliers(0), inlier_ratio(0), rmse(0), time_ms(0) {}
+};
+
+//! point-to-plane ICP between two organized depth images
+//! correspondences are found by projecting into the target image (no KdTree),
+//! and the pose is solved coarse-to-fine on a depth pyramid
+//! an instance keeps its pyramids between calls, one per thread
+class ProjectiveIcp
+{
+public:
+	int 	levels;				// pyramid levels (at most 4), level 0 is full resolution
+	int 	max_iterations[4];	// per level, index = level
+	double 	dist_thresh;		// meter, max correspondence distance on level 0, doubled per level
+	double 	angle_thresh;		// degree, max angle between source and target normals
+	double 	huber_delta;		// meter, robust kernel on the point-to-plane residual
+	double 	min_update;			// stop a level when the update norm is below
+	int 	min_inliers;
+	float 	max_depth;			// meter, farther measurements are ignored
+
+	ProjectiveIcp(const Camera& cam);
+
+	//! source and target are raw depth images (CV_32F, depth/camera.scale in meter)
+	//! the result T maps a point of the source CS into the target CS
+	Eigen::Isometry3d align(const cv::Mat& source, const cv::Mat& target,
+				const Eigen::Isometry3d& guess = Eigen::Isometry3d::Identity(), IcpReport* report = 0);
+
+private:
+	struct Level
+	{
+		int 	rows, cols;
+		float 	fx, fy, cx, cy;
+		std::vector<float> 				depth;	// meter, 0 if invalid
+		std::vector<Eigen::Vector3f> 	V, N;	// vertex and normal maps, N is zero if invalid
+	};
+
+	void buildPyramid(const cv::Mat& depth, std::vector<Level>& pyr);
+	void computeMaps(Level& lv);
+	int solveLevel(const Level& src, const Level& tgt, int level, Eigen::Isometry3d& T, IcpReport& report);
+
+	Camera 				camera;
+	std::vector<Level> 	src_pyr, tgt_pyr;
+};
+
+#endif
@@ -7,6 +7,15 @@
 #include "SysParams.h"
 #include "PnPsolver.h"
 #include "Viewer.h"
+#include "Map.h"
+#include "pose_graph.h"
+#include "loop_closing.h"
+#include "map_io.h"
+#include "pointcloudmapping.h"
+#include "tsdf_volume.h"
+#include "map_chunks.h"
+#include "debug_sink.h"
+#include "evaluation.h"
 #include "pydensecrf/pydensecrf/densecrf/include/Eigen/src/Core/products/GeneralBlockPanelKernel.h"
 #include <iostream>
 
@@ -85,17 +94,30 @@ Eigen::Isometry3d cvMat2Eigen(Mat& rvec,Mat& tvec)
       return T;
 }
 
+//!motion of a single frame at constant velocity, T spans n frames
+Eigen::Matrix4d perFrameMotion(const Eigen::Isometry3d& T, int n)
+{
+	Eigen::AngleAxisd aa(T.rotation());
+	Eigen::Isometry3d Tn = Eigen::Isometry3d::Identity();
+	Tn.linear() = Eigen::AngleAxisd(aa.angle()/max(n, 1), aa.axis()).toRotationMatrix();
+	Tn.translation() = T.translation()/max(n, 1);
+	return Tn.matrix();
+}
+
 double normTransform(Mat rvec,Mat tvec)
 {
       return fabs(min(cv::norm(rvec), 2*M_PI-cv::norm(rvec)))+ fabs(cv::norm(tvec));
 }
 
 
-void isKeyframe(Frame& keyFrame,Frame& frame,g2o::SparseOptimizer& opti, Eigen::Isometry3d T)
+void isKeyframe(Frame& keyFrame,Frame& frame,g2o::SparseOptimizer& opti, Eigen::Isometry3d T,
+		IncrementalPoseGraph* poseGraph = 0)
 {
 	g2o::VertexSE3 *v = new g2o::VertexSE3();
 	v->setId(frame.id);
-	v->setEstimate(Eigen::Isometry3d::Identity());
+	//chain the relative motion, plane landmarks are initialized from this estimate
+	g2o::VertexSE3* vk = dynamic_cast<g2o::VertexSE3*>(opti.vertex(keyFrame.id));
+	v->setEstimate(vk ? vk->estimate()*T : Eigen::Isometry3d::Identity());
 	opti.addVertex(v);
 	
 	g2o::EdgeSE3* edge=new g2o::EdgeSE3();
@@ -112,10 +134,61 @@ void isKeyframe(Frame& keyFrame,Frame& frame,g2o::SparseOptimizer& opti, Eigen::
 	
 	edge->setMeasurement(T);
 	opti.addEdge(edge);
+	if(poseGraph) poseGraph->addEdge(keyFrame.id, frame.id, T, information);
 	return;
 }
 
 
+//!add the matched planes as persistent landmarks of the pose graph
+//!planes already observed by keyFrame keep their landmark (gid), new ones are created from keyFrame's pose
+void addPlaneLandmarks(Frame& keyFrame, Frame& frame, const vector<DMatch>& pl_matches,
+		       g2o::SparseOptimizer& opti, int& nextPlaneId, SystemParameters& sysPara)
+{
+	const int PLANE_VERTEX_ID_BASE = 10000000;  //above all frame ids
+	g2o::VertexSE3* vk = dynamic_cast<g2o::VertexSE3*>(opti.vertex(keyFrame.id));
+	g2o::VertexSE3* vf = dynamic_cast<g2o::VertexSE3*>(opti.vertex(frame.id));
+	if(!vk || !vf) return;
+
+	for(size_t i=0; i<pl_matches.size(); i++)
+	{
+		FramePlane& pk = keyFrame.planes[pl_matches[i].queryIdx];
+		FramePlane& pf = frame.planes[pl_matches[i].trainIdx];
+		Eigen::Vector4d meas_k(pk.n.x, pk.n.y, pk.n.z, pk.d);
+		Eigen::Vector4d meas_f(pf.n.x, pf.n.y, pf.n.z, pf.d);
+
+		if(pk.gid < 0)
+		{
+			pk.gid = nextPlaneId++;
+			g2o::VertexPlane* v = new g2o::VertexPlane();
+			v->setId(PLANE_VERTEX_ID_BASE+pk.gid);
+			v->setEstimate(g2o::VertexPlane::transformFromFrame(meas_k, vk->estimate()));
+			v->setMarginalized(true);
+			opti.addVertex(v);
+
+			g2o::EdgeSE3Norm* e = new g2o::EdgeSE3Norm();
+			e->vertices()[0] = vk;
+			e->vertices()[1] = v;
+			e->setMeasurement(meas_k);
+			e->information() = planeInformation(pk, sysPara);
+			g2o::RobustKernelHuber* rk = new g2o::RobustKernelHuber;
+			rk->setDelta(5.99);
+			e->setRobustKernel(rk);
+			opti.addEdge(e);
+		}
+		pf.gid = pk.gid;
+
+		g2o::EdgeSE3Norm* e = new g2o::EdgeSE3Norm();
+		e->vertices()[0] = vf;
+		e->vertices()[1] = opti.vertex(PLANE_VERTEX_ID_BASE+pf.gid);
+		e->setMeasurement(meas_f);
+		e->information() = planeInformation(pf, sysPara);
+		g2o::RobustKernelHuber* rk = new g2o::RobustKernelHuber;
+		rk->setDelta(5.99);
+		e->setRobustKernel(rk);
+		opti.addEdge(e);
+	}
+}
+
 void loadImage(string rootpath, const string strAssociationFilename,  vector<double>& vdTimestamps,
 	       vector<string>& vstrFilenamesRGB,  vector<string>& vstrFilenamesDepth)
 {
@@ -142,9 +215,51 @@ void loadImage(string rootpath, const string strAssociationFilename,  vector<dou
 	return;
 }
 
-void saveTUMAllTrajectory(vector<Frame> AllFrame)
+//!a tracked frame relative to its reference keyframe, so that it follows the keyframe when that is optimized
+struct TrackedFrame
 {
-	
+	double 				t;
+	int 				ref;	// index into keyFrame
+	int 				n;		// frames since the reference keyframe
+	Eigen::Isometry3d 	Tkc;	// frame CS to the reference keyframe CS
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+typedef vector<TrackedFrame, Eigen::aligned_allocator<TrackedFrame> > TrackedFrameVector;
+
+//every tracked frame, from the final pose of its reference keyframe, in time order
+void saveTUMAllTrajectory(const vector<Frame>& keyFrame, const TrackedFrameVector& tracked)
+{
+	Trajectory traj;
+	for(size_t i=0; i<tracked.size(); i++)
+	{
+		const Frame& kf = keyFrame[tracked[i].ref];
+		if(kf.mRwc.empty() || kf.mOw.empty()) continue;
+		Eigen::Matrix3d r;
+		cv::cv2eigen(kf.mRwc, r);
+		Eigen::Isometry3d Twk = Eigen::Isometry3d::Identity();
+		Twk.linear() = r;
+		Twk.translation() = Eigen::Vector3d(kf.mOw.at<double>(0), kf.mOw.at<double>(1), kf.mOw.at<double>(2));
+		StampedPose p;
+		p.t = tracked[i].t;
+		p.Twc = Twk*tracked[i].Tkc;
+		traj.push_back(p);
+	}
+	std::sort(traj.begin(), traj.end(), [](const StampedPose& a, const StampedPose& b) { return a.t < b.t; });
+	saveTUMTrajectory("traject_all.txt", traj);
+}
+
+//!the frames between the reference keyframe and the next one, n frames later at Tkn (its CS to the keyframe CS),
+//!interpolated along Tkn: slerp of the rotation, linear translation
+void interpolateTracked(TrackedFrameVector& tracked, int ref, const Eigen::Isometry3d& Tkn, int n)
+{
+	const Eigen::Quaterniond q(Tkn.rotation());
+	for(size_t i=tracked.size(); i-- > 0 && tracked[i].ref == ref; )
+	{
+		const double s = (double)tracked[i].n/max(n, 1);
+		tracked[i].Tkc = Eigen::Isometry3d::Identity();
+		tracked[i].Tkc.linear() = Eigen::Quaterniond::Identity().slerp(s, q).toRotationMatrix();
+		tracked[i].Tkc.translation() = s*Tkn.translation();
+	}
 }
 
 void saveTUMKeyTrajectory(vector<Frame> keyFrame)
@@ -169,12 +284,34 @@ void saveTUMKeyTrajectory(vector<Frame> keyFrame)
 
 int main(int argc, char** argv)
 {	
-	if(argc!=3){
-		cout<<"No parameters."<<endl;
+	//--headless: no window and no key waits, as System.headless in the settings
+	//--frames n: the first n images only, 0 for all; 300 by default with a window, all headless
+	bool headless = false;
+	int maxFrames = -1;
+	parseRunFlags(argc, argv, headless, maxFrames);
+	if(argc!=3 && argc!=4){
+		cout<<"Usage: lineslam [--headless] [--frames n] dataset_path settings [vocabulary]"<<endl;
 		return 0;
 	}
 	string rootpath=argv[1];
 	SysParams sysparams(argv[2]); 
+	headless = headless || sysparams.headless;
+	//per stage latencies printed at exit
+	Profiler::start(sysparams.traceFile);
+	//debug images are written/shown by the sink thread, never on the tracking path
+	DebugSink debugSink(sysparams.debugDir, sysparams.debugEvery, 16, !headless);
+	Frame::debugSink = &debugSink;
+	//loop closing is enabled by the ORB vocabulary, text or binary (see voc2bin)
+	if(argc==4)
+	{
+		Frame::mpORBVocabulary = new FlatVocabulary();
+		if(!Frame::mpORBVocabulary->loadVocabulary(argv[3]))
+		{
+			cout<<"Failed to load vocabulary "<<argv[3]<<", loop closing disabled"<<endl;
+			delete Frame::mpORBVocabulary;
+			Frame::mpORBVocabulary = 0;
+		}
+	}
 	
 	SystemParameters sysPara;   //line parameters
 	Camera camera(sysparams);
@@ -193,13 +330,19 @@ int main(int argc, char** argv)
 	if(vstrFilenamesRGB.empty())return 0;
 	if(vstrFilenamesRGB.size()!=vstrFilenamesDepth.size())return 0;
 
-	nImages = 300;  //Number of images. For testing
+	if(maxFrames < 0) maxFrames = headless ? 0 : 300;
+	if(maxFrames > 0) nImages = min(nImages, maxFrames);
 	
 	//First Frame
 	Mat rgb1 = imread(vstrFilenamesRGB[0], CV_LOAD_IMAGE_UNCHANGED );
 	Mat depth1 = imread(vstrFilenamesDepth[0], CV_LOAD_IMAGE_ANYDEPTH);
 	Frame frame1(vdTimestamps[0],rgb1,depth1,camera);
 	frame1.rgbname=vstrFilenamesRGB[0];
+	//planes of the last frame seed the next one, warped by the constant velocity prediction
+	PlaneFitter planeFitter;
+	ProjectiveIcp icp(camera);  //used by tracking only, the other threads have their own
+	Eigen::Matrix4d velocity = Eigen::Matrix4d::Identity();  //p_cur = velocity*p_prev
+	frame1.AHCPlane(planeFitter);
 
 	vector<Frame> allFrame;
 	vector<Frame> keyFrame;
@@ -219,18 +362,46 @@ int main(int argc, char** argv)
 	v->setEstimate(Eigen::Isometry3d::Identity());
 	v->setFixed(true);
 	globalOptimizer.addVertex(v);
+	int nextPlaneId = 0;  //global id of the plane landmarks
+
+	//keyframes and point/line landmarks, refined by the local BA while tracking
+	Map3d map;
+	map.addKeyFrame(frame1, Eigen::Isometry3d::Identity());
+#ifdef SLAM_LBA
+	LocalMapping localMapping(&map, sysPara);
+#endif
+	//keyframe poses solved while tracking
+	IncrementalPoseGraph poseGraph(0);
+	LoopClosing loopClosing(&poseGraph, sysPara);
+	loopClosing.insertKeyFrame(frame1);
 	
-	//for global map
+	//for global map, keyframes are integrated by the mapping thread as they come and again once optimized
 	PointCloud::Ptr globalMap ( new PointCloud() ); 
-	PointCloud::Ptr tmp(new PointCloud());
-	pcl::VoxelGrid<PointT> voxel;
 	double gridsize = 0.03; 
-	voxel.setLeafSize( gridsize, gridsize, gridsize );
+	PointCloudMapping pointCloudMapping(sysPara, gridsize, 16, false);  //the live map is in the viewer
+	KeyFrameImageStore imageStore(sysPara.map_chunk_dir, (size_t)sysPara.map_budget_images<<20, sysPara.map_working_radius);
+	pointCloudMapping.insertKeyFrame(frame1, Eigen::Isometry3d::Identity());
+	std::unique_ptr<Viewer> viewer;  //live map, draws the snapshots of the mapping thread
+	if(!headless)
+	{
+		viewer.reset(new Viewer());
+		viewer->setMap(&pointCloudMapping);
+		viewer->start();
+		viewer->addKeyFrame(frame1, Eigen::Isometry3d::Identity());
+	}
+	TsdfVolume tsdf(0.01f, 0.04f);  //surface mesh, from the optimized poses
 
 	MyTimer mytimer;
 	mytimer.start();
+	FrameLog frameLog;  //per frame latency, for slam_bench
+	TrackedFrameVector tracked(1);  //pose of every tracked frame, for traject_all.txt
+	tracked[0].t = vdTimestamps[0];
+	tracked[0].ref = tracked[0].n = 0;
+	tracked[0].Tkc = Eigen::Isometry3d::Identity();
     for(int i=1; i < nImages; i+=1)  //nImages
     {
+		MyTimer frameTimer;
+		frameTimer.start();
 		int keyFrameflag=keyFrame.size();
 		for(int k=0; k<1;k++)
 		{
@@ -240,12 +411,16 @@ int main(int argc, char** argv)
 			
 			cout<<"---------------------------------------------------------------"<<endl;
 			cout<<"Frame id:"<<i<<endl;
-			Mat rgb2=imread(vstrFilenamesRGB[i],CV_LOAD_IMAGE_UNCHANGED);
-			Mat depth2=imread(vstrFilenamesDepth[i],CV_LOAD_IMAGE_UNCHANGED);
+			Mat rgb2, depth2;
+			{
+				PROF_SCOPE(PROF_DECODE);
+				rgb2=imread(vstrFilenamesRGB[i],CV_LOAD_IMAGE_UNCHANGED);
+				depth2=imread(vstrFilenamesDepth[i],CV_LOAD_IMAGE_UNCHANGED);
+			}
 			Frame frame2(vdTimestamps[i],rgb2,depth2,camera);
 			frame2.rgbname = vstrFilenamesRGB[i];
 			
-			frame2.AHCPlane();
+			frame2.AHCPlane(planeFitter, velocity);
 			//continue;
 
 			//brightness
@@ -275,7 +450,10 @@ int main(int argc, char** argv)
 			BruteForceMatcher<HammingLUT> bf_matcher;
 			if(frame1.mDescriptors.rows!=0 && frame2.mDescriptors.rows!= 0)
 			{
-				bf_matcher.match(frame1.mDescriptors,frame2.mDescriptors,bf_matches);
+				{
+					PROF_SCOPE(PROF_MATCH);
+					bf_matcher.match(frame1.mDescriptors,frame2.mDescriptors,bf_matches);
+				}
 
 #ifdef GMS_MATCHER
 				pt_matches = GmsMatch(frame1,frame2, bf_matches);
@@ -291,7 +469,10 @@ int main(int argc, char** argv)
 			vector<vector<int>> matches;
 			vector<DMatch>      ln_matches;
 			
-			trackLine(frame1.lines,frame2.lines, matches, sysPara);
+			{
+				PROF_SCOPE(PROF_MATCH);
+				trackLine(frame1.lines,frame2.lines, matches, sysPara);
+			}
 			for(size_t j=0; j<matches.size(); j++)
 			{
 				int p1 = matches[j][0];
@@ -308,37 +489,37 @@ int main(int argc, char** argv)
 			/**************************************************/
 			/****************Feature visulalization************/
 			/**************************************************/
-			Mat img;
-			drawMatches(frame1.rgb,frame1.mvKeypoints,frame2.rgb,frame2.mvKeypoints,pt_matches,img);
-			cv::imshow("Point Match",img);
-			//if(pt_matches.size()<5&&frame2.id<200)waitKey(500);
-			cvWaitKey(1);
-			
-			cv::Mat output = drawInlier(frame1,frame2, matches);
-			cv::Mat src1,src2;
-			frame1.rgb.copyTo(src1);
-			frame2.rgb.copyTo(src2);
-			srand((unsigned int)time(NULL));
-			for(size_t k=0; k<matches.size();k++)
+			if(debugSink.wants(frame2.id))
 			{
-				int p = matches[k][0];
-				int q = matches[k][1];
-				cv::Point2f left1 = frame1.lines[p].p;
-				cv::Point2f left2 = frame1.lines[p].q;
-				cv::Point2f right1 = frame2.lines[q].p + cv::Point2d((double)src1.cols,0.f);
-				cv::Point2f right2 = frame2.lines[q].q + cv::Point2d((double)src1.cols,0.f);
-				cv::line(output,left1,left2,cv::Scalar(0,0,255),2);
-				cv::line(output,right1,right2,cv::Scalar(0,0,255),2);
-				int r = rand()%255;
-				int g = rand()%255;
-				int b = rand()%255;
+				Mat img;
+				drawMatches(frame1.rgb,frame1.mvKeypoints,frame2.rgb,frame2.mvKeypoints,pt_matches,img);
+				debugSink.push("Point Match", frame2.id, img);
 				
-				cv::Point2f left = cv::Point2f((left1.x+left2.x)/2,(left1.y+left2.y)/2);
-				cv::Point2f right = cv::Point2f((right1.x+right2.x)/2,(right1.y+right2.y)/2);
-				cv::line(output,left,right,cv::Scalar(b,g,r),2);
+				cv::Mat output = drawInlier(frame1,frame2, matches);
+				cv::Mat src1,src2;
+				frame1.rgb.copyTo(src1);
+				frame2.rgb.copyTo(src2);
+				srand((unsigned int)time(NULL));
+				for(size_t k=0; k<matches.size();k++)
+				{
+					int p = matches[k][0];
+					int q = matches[k][1];
+					cv::Point2f left1 = frame1.lines[p].p;
+					cv::Point2f left2 = frame1.lines[p].q;
+					cv::Point2f right1 = frame2.lines[q].p + cv::Point2d((double)src1.cols,0.f);
+					cv::Point2f right2 = frame2.lines[q].q + cv::Point2d((double)src1.cols,0.f);
+					cv::line(output,left1,left2,cv::Scalar(0,0,255),2);
+					cv::line(output,right1,right2,cv::Scalar(0,0,255),2);
+					int r = rand()%255;
+					int g = rand()%255;
+					int b = rand()%255;
+					
+					cv::Point2f left = cv::Point2f((left1.x+left2.x)/2,(left1.y+left2.y)/2);
+					cv::Point2f right = cv::Point2f((right1.x+right2.x)/2,(right1.y+right2.y)/2);
+					cv::line(output,left,right,cv::Scalar(b,g,r),2);
+				}
+				debugSink.push("Line Match", frame2.id, output);
 			}
-			cv::imshow("Line Match", output);
-			cvWaitKey();
 			
 			
 			int line_threshold = std::max(3.0, 0.3* 0.5* (frame1.lines.size() + frame2.lines.size()));
@@ -360,7 +541,13 @@ int main(int argc, char** argv)
 				}
 #endif
 				vector<DMatch> t;
-				if(ln_matches.size() == 0&&pt_matches.size()==0)continue;
+				if(ln_matches.size() == 0&&pt_matches.size()==0)
+				{
+					//lost, the previous planes and motion no longer apply
+					planeFitter.resetTemporal();
+					velocity = Eigen::Matrix4d::Identity();
+					continue;
+				}
 				if(pt_matches.size()<50)  pt_matches = t;
 				//if(pt_matches.size()>10*ln_matches.size()) ln_matches=t;
 				
@@ -370,9 +557,36 @@ int main(int argc, char** argv)
 				bool valid;
 				//Eigen::Matrix4f T = getTransform_Lns_Pts_pcl(&frame1,&frame2,pt_matches,ln_matches,valid);
 				Eigen::Matrix4f Tt = Eigen::Matrix4f::Identity();
-				Tt = getIcpAlignment( &frame1,  &frame2);
 				Eigen::Matrix4f T = Eigen::Matrix4f::Identity();
-				T = Tt.inverse();
+				
+				//constant velocity motion since the keyframe, the prior for plane association and ICP
+				Eigen::Matrix4d Tpred = Eigen::Matrix4d::Identity();
+				for(int j=frame1.id; j<frame2.id; j++) Tpred = velocity*Tpred;
+				
+				//plane registration, full-cloud ICP only if the scene does not constrain the motion
+				vector<DMatch> pl_matches;
+				matchPlanes(&frame1, &frame2, Eigen::Isometry3d(Tpred), pl_matches, sysPara);
+				cout<<"Plane matches: "<<pl_matches.size()<<endl;
+				Eigen::Isometry3d Tp = getTransform_Planes_Lns_Pts(&frame1, &frame2, pl_matches, ln_matches, pt_matches, valid, sysPara);
+				if(valid)
+				{
+					Tt = Tp.matrix().cast<float>();
+					T = Tt.inverse();
+					//refine jointly with the plane observations
+					getTransformFromHybridMatchesG2O(&frame1,&frame2,pt_matches,ln_matches,T,10,sysPara,pl_matches);
+				}
+				else
+				{
+					//from the predicted motion, kept if ICP fails
+					IcpReport icpReport;
+					Tt = getIcpAlignment(&frame1, &frame2, Tpred.cast<float>(), &icpReport, &icp);
+					if(!icpReport.valid)
+					{
+						cout<<"ICP failed, constant velocity motion kept"<<endl;
+						Tt = Tpred.cast<float>();
+					}
+					T = Tt.inverse();
+				}
 				cout<<"T-before"<<T<<endl;
 				
 #ifdef SEGMENT
@@ -413,22 +627,76 @@ int main(int argc, char** argv)
 							
 				
 				
+				//the frames since the keyframe follow the registered motion, not the predicted one
+				interpolateTracked(tracked, keyFrameflag-1, T1, frame2.id-frame1.id);
 				if(tooFar(T1.matrix()))
 				{
 					cout<<"Too Far"<<endl;
+					velocity = Eigen::Matrix4d::Identity();
 					//cv::waitKey();
 					//continue;
 				}
+				else velocity = perFrameMotion(T1.inverse(), frame2.id-frame1.id);
 				cout<<T1.matrix()<<endl;
 
 				
-				if(k==0) keyFrame.push_back(frame2);
-				isKeyframe(frame1,frame2,globalOptimizer,T1);
+				//chain from the keyframe pose refined by the local BA
+				Eigen::Isometry3d Twk;
+				g2o::VertexSE3* vk = dynamic_cast<g2o::VertexSE3*>(globalOptimizer.vertex(frame1.id));
+				if(vk && map.pose(frame1.id, Twk)) vk->setEstimate(Twk);
+				isKeyframe(frame1,frame2,globalOptimizer,T1,&poseGraph);
+				addPlaneLandmarks(keyFrame[keyFrameflag-1-10*k],frame2,pl_matches,globalOptimizer,nextPlaneId,sysPara);
+				if(k==0) 
+				{
+					keyFrame.push_back(frame2);
+					TrackedFrame tf;
+					tf.t = frame2.timestamp;
+					tf.ref = keyFrame.size()-1;
+					tf.n = 0;
+					tf.Tkc = Eigen::Isometry3d::Identity();
+					tracked.push_back(tf);
+					g2o::VertexSE3* v2 = dynamic_cast<g2o::VertexSE3*>(globalOptimizer.vertex(frame2.id));
+					map.addKeyFrame(frame2, v2->estimate(), &frame1, pt_matches, ln_matches);
+#ifdef SLAM_LBA
+					localMapping.insertKeyFrame();
+#endif
+					loopClosing.insertKeyFrame(frame2);
+					pointCloudMapping.insertKeyFrame(frame2, v2->estimate());
+					if(viewer) viewer->addKeyFrame(frame2, v2->estimate());
+					imageStore.update(keyFrame, map, v2->estimate().translation());
+				}
 				
 			}
+			else
+			{
+				//between keyframes: predicted at constant velocity, interpolated once the next keyframe is registered
+				TrackedFrame tf;
+				tf.t = frame2.timestamp;
+				tf.ref = keyFrameflag-1;
+				tf.n = frame2.id-frame1.id;
+				Eigen::Matrix4d Tck = Eigen::Matrix4d::Identity();
+				for(int j=0; j<tf.n; j++) Tck = velocity*Tck;
+				tf.Tkc = Eigen::Isometry3d(Tck).inverse();
+				tracked.push_back(tf);
+			}
 		}
+		frameTimer.end();
+		frameLog.add(vdTimestamps[i], frameTimer.time_ms, (int)keyFrame.size() > keyFrameflag);
     } 
     mytimer.end();
+    cout<<"Tracking time: "<<mytimer.time_ms<<" ms"<<endl;
+#ifdef SLAM_LBA
+	localMapping.finish();
+#endif
+	loopClosing.finish();
+	poseGraph.finish();
+	//start the final refinement from the incrementally solved poses, the locally refined ones otherwise
+	for(size_t i=0; i<keyFrame.size(); i++)
+	{
+		Eigen::Isometry3d Twk;
+		g2o::VertexSE3* vertex = dynamic_cast<g2o::VertexSE3*>(globalOptimizer.vertex(keyFrame[i].id));
+		if(vertex && (poseGraph.pose(keyFrame[i].id, Twk) || map.pose(keyFrame[i].id, Twk))) vertex->setEstimate(Twk);
+	}
 
 	/*
 	g2o::EdgeSE3* edge=new g2o::EdgeSE3();
@@ -446,13 +714,29 @@ int main(int argc, char** argv)
 	edge->setMeasurement(T2);
 	globalOptimizer.addEdge(edge);*/
 	
+	//loop constraints found while tracking
+	LoopEdgeVector loops = loopClosing.loops();
+	for(size_t i=0; i<loops.size(); i++)
+	{
+		g2o::EdgeSE3* edge=new g2o::EdgeSE3();
+		edge->vertices()[0]= globalOptimizer.vertex(loops[i].from);
+		edge->vertices()[1]= globalOptimizer.vertex(loops[i].to);
+		g2o::RobustKernelHuber* rk = new g2o::RobustKernelHuber;
+		rk->setDelta(5.99);
+		edge->setRobustKernel(rk);
+		edge->setInformation(loops[i].info);
+		edge->setMeasurement(loops[i].T);
+		globalOptimizer.addEdge(edge);
+	}
+	cout<<"Loops: "<<loops.size()<<endl;
+	
 #ifdef GLOBAL_BA
     //optimization
     globalOptimizer.setVerbose(true);  
     cout<<"optimizing pose graph. Vertices "<<globalOptimizer.vertices().size()<<endl;
     //globalOptimizer.save("result_before.g2o");
     globalOptimizer.initializeOptimization();
-    globalOptimizer.optimize(100);
+    globalOptimizer.optimize(10);  //poses are already solved, refine with the plane landmarks
     //globalOptimizer.save("result_after.g2o");
     cout<<"optimization done."<<endl;
 	
@@ -464,35 +748,50 @@ int main(int argc, char** argv)
         Eigen::Isometry3d pose = vertex->estimate(); 
 		
 		keyFrame[i].setPose(toCvMat(pose.matrix()).inv());
+		if(!imageStore.restore(keyFrame[i])) continue;
 			
-        PointCloud::Ptr p = keyFrame[i].img2cloud();  //keyFrame[i].planeExtraction();
-        pcl::transformPointCloud( *p, *tmp, pose.matrix()); //pose = Twc
-        *globalMap += *tmp;
-        tmp->clear();
-        p->clear();
+        pointCloudMapping.insertKeyFrame(keyFrame[i], pose, true); //pose = Twc, moved voxels are taken back first
+        if(viewer) viewer->setPose(keyFrame[i].id, pose);
+        tsdf.integrate(keyFrame[i], pose);
+        imageStore.update(keyFrame, map, pose.translation());
     }
-    
-
-    
-    voxel.setInputCloud( globalMap );
-    voxel.filter( *tmp );
-    globalMap.swap(tmp);
+#endif
+    pointCloudMapping.finish();
+    globalMap = pointCloudMapping.snapshot();
+    if(pointCloudMapping.droppedNum() > 0)
+        cout<<"Mapping queue full, "<<pointCloudMapping.droppedNum()<<" keyframes not mapped"<<endl;
     cout<<"KeyFrame size:  "<<keyFrame.size()<<endl;
     cout<<"Global map size："<<globalMap->points.size()<<endl;
     //pcl::io::savePCDFileASCII("1.pcd",*globalMap);
-#endif
 	
 	//drawPangolin(keyFrame);
 	
 	saveTUMKeyTrajectory(keyFrame);
+	saveTUMAllTrajectory(keyFrame, tracked);  //the frames lost at a keyframe step have no pose
+	frameLog.save("frames.txt");
+	cout<<"Tracking: "<<frameLog.fps()<<" fps, latency p50 "<<frameLog.percentile(0.5)<<" ms, p95 "<<frameLog.percentile(0.95)<<" ms"<<endl;
 	pcl::io::savePCDFile("global.pcd",*globalMap);
+	saveMap("map.bin", keyFrame, globalOptimizer, &map, globalMap.get(), &pointCloudMapping.voxels());
+	if(tsdf.blockNum() > 0)
+	{
+		TsdfMesh mesh;
+		tsdf.extractMesh(mesh);
+		mesh.savePLY("mesh.ply");
+		cout<<"Mesh: "<<mesh.vertices.size()<<" vertices, "<<mesh.triangles.size()<<" triangles"<<endl;
+	}
+	
+	Frame::debugSink = 0;
+	debugSink.finish();
+	if(debugSink.droppedNum() > 0)
+		cout<<"Debug queue full, "<<debugSink.droppedNum()<<" images not written"<<endl;
+	if(headless) return 0;
 	
 	testSeg(globalMap);
 	
-    pcl::visualization::CloudViewer viewer("viewer");
-    viewer.showCloud(globalMap);
-	//viewer.runOnVisualizationThread(setPCLBackGround);
-    while(!viewer.wasStopped()){}
+    pcl::visualization::CloudViewer cloudViewer("viewer");
+    cloudViewer.showCloud(globalMap);
+	//cloudViewer.runOnVisualizationThread(setPCLBackGround);
+    while(!cloudViewer.wasStopped()){}
 
     return 0;
 }
@@ -571,137 +870,20 @@ void testSeg(PointCloud::Ptr cloud)
 
 void drawPangolin(vector<Frame>& frames)
 {
-	
-	float mImageWidth = 640;
-	float mImageHeight = 480;
-	float mViewpointX = 0;
-	float mViewpointY = -0.7;
-	float mViewpointZ = -1.8;
-	float mViewpointF = 500;
-	
-	pangolin::CreateWindowAndBind("LineSLAM",1024,768);
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_BLEND);
-	
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	
-	
-	pangolin::OpenGlRenderState s_cam(
-			pangolin::ProjectionMatrix(1024,768,mViewpointF,mViewpointF,512,389,0.1,1000),
-			pangolin::ModelViewLookAt(mViewpointX,mViewpointY,mViewpointZ, 0,0,0,0.0,1.0, 0.0)
-			);
-			
-	pangolin::View& d_cam = pangolin::CreateDisplay()
-            .SetBounds(0.0, 1.0, pangolin::Attach::Pix(175), 1.0, -1024.0f/768.0f)
-            .SetHandler(new pangolin::Handler3D(s_cam));
-	
-	pangolin::OpenGlMatrix Twc;
-    Twc.SetIdentity();
-	
-	while(!pangolin::ShouldQuit())
+	PointCloudMapping mapping(SystemParameters(), 0.03, frames.size(), false);
+	Viewer viewer;
+	viewer.setMap(&mapping);
+	for(size_t idx = 0; idx<frames.size(); idx++)
 	{
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-		d_cam.Activate(s_cam);
-		
-		//pangolin::glDrawAxis(3);
-		//pangolin::glDrawColouredCube();
-		
-		
-		for(int idx = 0; idx<frames.size(); idx+=1)
-		{
-			
-			Mat mRwc = frames[idx].mRcw;
-			Mat mOw = frames[idx].mOw;
-			
-			
-			std::vector<GLfloat> Twc = {
-				(float)mRwc.at<double>(0,0),(float)mRwc.at<double>(0,1),(float)mRwc.at<double>(0,2),0,
-				(float)mRwc.at<double>(1,0),(float)mRwc.at<double>(1,1),(float)mRwc.at<double>(1,2),0,
-				(float)mRwc.at<double>(2,0),(float)mRwc.at<double>(2,1),(float)mRwc.at<double>(2,2),0,
-				(float)mOw.at<double>(0),(float)mOw.at<double>(1),(float)mOw.at<double>(2),1
-			};//frame.mTwc;
-			
-			glPushMatrix();
-			//std::vector<GLfloat> Twc = {1,0,0,0, 0,1,0,0 , 0,0,1,0 ,2,0,0,1};//frame.mTwc;
-			glMultMatrixf(Twc.data());
-			
-			const float w = 0.02;
-			const float h = w*0.75;
-			const float z = w*0.6;
-			glLineWidth(2);
-			glColor3f(0.0,1.0,0.0);
-			glBegin(GL_LINES);
-			glVertex3f(0,0,0);
-			glVertex3f(w,h,z);
-			glVertex3f(0,0,0);
-			glVertex3f(w,-h,z);
-			glVertex3f(0,0,0);
-			glVertex3f(-w,-h,z);
-			glVertex3f(0,0,0);
-			glVertex3f(-w,h,z);
-			glVertex3f(w,h,z);
-			glVertex3f(w,-h,z);
-			glVertex3f(-w,h,z);
-			glVertex3f(-w,-h,z);
-			glVertex3f(-w,h,z);
-			glVertex3f(w,h,z);
-			glVertex3f(-w,-h,z);
-			glVertex3f(w,-h,z);
-			glEnd();
-			
-			
-			if(idx<30)
-			{
-				glLineWidth(10);
-				glColor3f(1.0,0.0,0.0);
-				glBegin(GL_LINES);
-				for(int i=0 ;i< frames[idx].lines.size(); i++)
-				{
-					cv::Point3d A = frames[idx].lines[i].line3d.A;
-					cv::Point3d B = frames[idx].lines[i].line3d.B;
-					
-					if(cv::norm(A-B)<0.3)continue;
-					
-					glVertex3f(A.x,A.y,A.z);
-					glVertex3f(B.x,B.y,B.z);
-					
-				}
-				glEnd();
-			}
-			{
-	
-			
-				glPointSize(1);
-				glBegin(GL_POINTS);
-				
-				PointCloud::Ptr cloud = frames[idx].img2cloud();
-				for(int k=0; k<cloud->points.size(); k++)
-				{
-					PointT p = cloud->points[k];
-					
-					uint32_t x = p.rgba;
-					
-					uint32_t alpha = (x & 0xff000000) >> 24;
-					uint32_t red = (x & 0x00ff0000) >> 16;
-					uint32_t green = (x & 0x0000ff00) >> 8;
-					uint32_t blue = (x & 0x000000ff);
-					
-					glColor3f(red/255.0,green/255.0,blue/255.0);
-					glVertex3f(p.x,p.y,p.z);
-				}
-				glEnd();
-			}
-			
-			glPopMatrix();
-			
-		}
-		
-		pangolin::FinishFrame();
-		
+		if(frames[idx].mTcw.empty()) continue;
+		Eigen::Matrix4d Tcw;
+		cv::cv2eigen(frames[idx].mTcw, Tcw);
+		Eigen::Isometry3d Twc = Eigen::Isometry3d(Tcw).inverse();
+		viewer.addKeyFrame(frames[idx], Twc);
+		mapping.insertKeyFrame(frames[idx], Twc, true);
 	}
-
-	
-
+	mapping.finish();
+	viewer.run();
 }
 
 
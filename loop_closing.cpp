@@ -0,0 +1,223 @@
+#include "loop_closing.h"
+
+KeyFrameDatabase::KeyFrameDatabase(const ORBVocabulary* voc_)
+	: voc(voc_)
+{
+	if(voc) invertedFile.resize(voc->size());
+}
+
+void KeyFrameDatabase::add(int kf, const DBoW2::BowVector& bow)
+{
+	if((int)bows.size() <= kf) bows.resize(kf+1);
+	bows[kf] = bow;
+	for(DBoW2::BowVector::const_iterator it = bow.begin(); it != bow.end(); ++it)
+		invertedFile[it->first].push_back(kf);
+}
+
+void KeyFrameDatabase::query(const DBoW2::BowVector& bow, int maxKf, double minScore,
+			     vector<pair<double,int> >& candidates) const
+{
+	candidates.clear();
+	maxKf = min(maxKf, (int)bows.size());
+	if(maxKf <= 0) return;
+
+	// words in common, only keyframes sharing a word are visited
+	vector<int> common(maxKf, 0);
+	int maxCommon = 0;
+	for(DBoW2::BowVector::const_iterator it = bow.begin(); it != bow.end(); ++it)
+	{
+		const std::list<int>& kfs = invertedFile[it->first];
+		for(std::list<int>::const_iterator k = kfs.begin(); k != kfs.end(); ++k)
+		{
+			if(*k >= maxKf) break;  // lists are sorted by insertion
+			if(++common[*k] > maxCommon) maxCommon = common[*k];
+		}
+	}
+	if(maxCommon == 0) return;
+
+	// score only the keyframes close to the best word overlap
+	const int minCommon = 0.8*maxCommon;
+	for(int k=0; k<maxKf; ++k)
+	{
+		if(common[k] < minCommon) continue;
+		double s = voc->score(bow, bows[k]);
+		if(s >= minScore) candidates.push_back(make_pair(s, k));
+	}
+	sort(candidates.rbegin(), candidates.rend());
+}
+
+
+LoopClosing::LoopClosing(IncrementalPoseGraph* poseGraph_, const SystemParameters& sysPara_)
+	: poseGraph(poseGraph_), sysPara(sysPara_), database(Frame::mpORBVocabulary), finishFlag(false)
+{
+	loopThread = std::thread(&LoopClosing::run, this);
+}
+
+LoopClosing::~LoopClosing()
+{
+	finish();
+}
+
+void LoopClosing::insertKeyFrame(const Frame& kf)
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	queue.push_back(kf);
+	cv_newKeyFrame.notify_one();
+}
+
+void LoopClosing::finish()
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		finishFlag = true;
+	}
+	cv_newKeyFrame.notify_one();
+	if(loopThread.joinable())
+		loopThread.join();
+}
+
+LoopEdgeVector LoopClosing::loops()
+{
+	std::lock_guard<std::mutex> lock(loopMutex);
+	return loopEdges;
+}
+
+void LoopClosing::run()
+{
+	while(1)
+	{
+		Frame kf;
+		{
+			std::unique_lock<std::mutex> lock(mtx);
+			while(queue.empty() && !finishFlag)
+				cv_newKeyFrame.wait(lock);
+			if(queue.empty()) break;
+			kf = queue.front();
+			queue.pop_front();
+		}
+		if(!Frame::mpORBVocabulary) continue;  // no vocabulary loaded, nothing to detect
+
+		kf.computeBow();
+		LoopEdge loop;
+		if(detectLoop(kf, loop) >= 0)
+		{
+			if(poseGraph) poseGraph->addEdge(loop.from, loop.to, loop.T, loop.info);
+			std::lock_guard<std::mutex> lock(loopMutex);
+			loopEdges.push_back(loop);
+		}
+		database.add(keyframes.size(), kf.mBowVec);
+		// verification only needs the features, the images would stay alive with the copy
+		kf.rgb.release();
+		kf.gray.release();
+		kf.depth.release();
+		kf.oriDepth.release();
+		keyframes.push_back(kf);
+	}
+}
+
+int LoopClosing::detectLoop(Frame& kf, LoopEdge& loop)
+{
+	if(keyframes.empty()) return -1;
+	const ORBVocabulary* voc = Frame::mpORBVocabulary;
+
+	// the recent keyframes see the same place anyway, a loop has to score as high as they do
+	double minScore = 1;
+	for(int i=keyframes.size()-1; i>=0 && i>=(int)keyframes.size()-3; --i)
+		minScore = min(minScore, voc->score(kf.mBowVec, keyframes[i].mBowVec));
+
+	int maxKf = keyframes.size();
+	while(maxKf > 0 && (double)kf.id - keyframes[maxKf-1].id < sysPara.loopclose_interval)
+		--maxKf;
+
+	vector<pair<double,int> > candidates;
+	database.query(kf.mBowVec, maxKf, minScore, candidates);
+	for(size_t i=0; i<candidates.size() && i<3; ++i)
+	{
+		if(verifyLoop(keyframes[candidates[i].second], kf, loop))
+			return candidates[i].second;
+	}
+	return -1;
+}
+
+static bool validPoint(const Eigen::Vector4f& p)
+{
+	return !std::isnan(p(2)) && p(2) >= 1e-2 && p(2) <= 10;
+}
+
+//! lines matched by descriptor only, the motion between loop frames is unknown
+static void matchLinesByDescriptor(const vector<FrameLine>& f1, const vector<FrameLine>& f2,
+				   vector<cv::DMatch>& matches)
+{
+	const double desDiffThresh = 0.85;
+	const double ratio_dist_1st2nd = 0.7;
+	matches.clear();
+	if(f1.empty() || f2.empty()) return;
+
+	cv::Mat desDiff = cv::Mat::zeros(f1.size(), f2.size(), CV_64F)+100;
+	for(size_t i=0; i<f1.size(); ++i) {
+		if(!f1[i].haveDepth) continue;
+		for(size_t j=0; j<f2.size(); ++j) {
+			if(!f2[j].haveDepth) continue;
+			desDiff.at<double>(i,j) = cv::norm(f1[i].des - f2[j].des);
+		}
+	}
+	for(int i=0; i<desDiff.rows; ++i) {
+		double minVal;
+		cv::Point minPos;
+		cv::minMaxLoc(desDiff.row(i), &minVal, NULL, &minPos, NULL);
+		if(minVal >= desDiffThresh) continue;
+		double minV;
+		cv::Point minP;
+		cv::minMaxLoc(desDiff.col(minPos.x), &minV, NULL, &minP, NULL);
+		if(i != minP.y) continue;  // mutual best
+		double rowmin2 = 100;
+		for(int j=0; j<desDiff.cols; ++j)
+			if(j != minPos.x) rowmin2 = min(rowmin2, desDiff.at<double>(i,j));
+		if(rowmin2*ratio_dist_1st2nd > minVal)
+			matches.push_back(cv::DMatch(i, minPos.x, minVal));
+	}
+}
+
+bool LoopClosing::verifyLoop(Frame& older, Frame& kf, LoopEdge& loop)
+{
+	const float max_hamming = 50;
+	const float ratio = 0.8;
+
+	// older is the query, kf the train frame
+	vector<cv::DMatch> pt_matches;
+	if(older.mDescriptors.rows != 0 && kf.mDescriptors.rows != 0)
+	{
+		vector<vector<cv::DMatch> > knn;
+		BruteForceMatcher<HammingLUT> bf_matcher;
+		{
+			PROF_SCOPE(PROF_MATCH);
+			bf_matcher.knnMatch(older.mDescriptors, kf.mDescriptors, knn, 2);
+		}
+		for(size_t i=0; i<knn.size(); ++i)
+		{
+			if(knn[i].empty() || knn[i][0].distance > max_hamming) continue;
+			if(knn[i].size() > 1 && knn[i][0].distance > ratio*knn[i][1].distance) continue;
+			const cv::DMatch& m = knn[i][0];
+			if(validPoint(older.feature_locations_3d_[m.queryIdx]) && validPoint(kf.feature_locations_3d_[m.trainIdx]))
+				pt_matches.push_back(m);
+		}
+	}
+	if((int)pt_matches.size() < sysPara.min_matches_loopclose) return false;
+
+	vector<cv::DMatch> ln_matches;
+	matchLinesByDescriptor(older.lines, kf.lines, ln_matches);
+
+	vector<cv::DMatch> pt_inliers, ln_inliers;
+	Eigen::Matrix4f tf = Eigen::Matrix4f::Identity();
+	float rmse;
+	getTransform_PtsLines_ransac(&older, &kf, pt_matches, ln_matches, pt_inliers, ln_inliers, tf, rmse, sysPara);
+	int inliers = pt_inliers.size() + ln_inliers.size();
+	if(inliers < sysPara.loopclose_min_3dmatch || !tf.allFinite()) return false;
+
+	loop.from = older.id;
+	loop.to = kf.id;
+	loop.T = Eigen::Isometry3d(tf.cast<double>());
+	loop.info = Eigen::Matrix<double,6,6>::Identity()*100;  // as the odometry edges
+	loop.inliers = inliers;
+	return true;
+}
@@ -0,0 +1,75 @@
+#ifndef LOOP_CLOSING_H
+#define LOOP_CLOSING_H
+
+#include "utils.h"
+#include "pose_graph.h"
+#include <list>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+//! inverted file of the keyframes' BoW vectors, word id -> keyframes containing the word
+class KeyFrameDatabase
+{
+public:
+	KeyFrameDatabase(const ORBVocabulary* voc);
+	//! kf is the index of the keyframe in the caller's list, increasing
+	void add(int kf, const DBoW2::BowVector& bow);
+	//! keyframes [0,maxKf) sharing enough words with bow and scoring at least minScore, best first
+	void query(const DBoW2::BowVector& bow, int maxKf, double minScore,
+		   vector<pair<double,int> >& candidates) const;
+	int size() const { return bows.size(); }
+
+private:
+	const ORBVocabulary* 		voc;
+	vector<std::list<int> > 	invertedFile;
+	vector<DBoW2::BowVector> 	bows;
+};
+
+//! loop constraint between two keyframes, as the pose graph edges
+struct LoopEdge
+{
+	int 						from, to;	// earlier and later keyframe id
+	Eigen::Isometry3d 			T;			// pose of "to" in the CS of "from"
+	Eigen::Matrix<double,6,6> 	info;
+	int 						inliers;	// point + line RANSAC inliers
+	EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+};
+typedef vector<LoopEdge, Eigen::aligned_allocator<LoopEdge> > LoopEdgeVector;
+
+//! detects loops on its own thread: BoW query of each new keyframe against the database,
+//! candidates verified by the hybrid point/line RANSAC, accepted loops added to the pose graph
+class LoopClosing
+{
+public:
+	LoopClosing(IncrementalPoseGraph* poseGraph, const SystemParameters& sysPara);
+	~LoopClosing();
+	//! kf is copied, its BoW is computed on the loop thread
+	void insertKeyFrame(const Frame& kf);
+	//! stop the thread after the queued keyframes are checked
+	void finish();
+	LoopEdgeVector loops();
+
+private:
+	void run();
+	//! index of the verified loop keyframe, -1 if none
+	int detectLoop(Frame& kf, LoopEdge& loop);
+	bool verifyLoop(Frame& older, Frame& kf, LoopEdge& loop);
+
+	IncrementalPoseGraph* 	poseGraph;
+	SystemParameters 		sysPara;
+	KeyFrameDatabase 		database;
+	vector<Frame> 			keyframes;		// only touched by the loop thread
+
+	std::thread 			loopThread;
+	std::mutex 				mtx;			// guards queue and finishFlag
+	std::condition_variable cv_newKeyFrame;
+	std::deque<Frame> 		queue;
+	bool 					finishFlag;
+
+	std::mutex 				loopMutex;		// guards loopEdges
+	LoopEdgeVector 			loopEdges;
+};
+
+#endif
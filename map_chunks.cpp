@@ -0,0 +1,149 @@
+#include "map_chunks.h"
+#include <algorithm>
+#include <stdint.h>
+#include <cstdio>
+#include <zlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+bool writeCompressed(const string& filename, const vector<char>& data)
+{
+	uLongf n = compressBound(data.size());
+	vector<Bytef> out(n);
+	if(compress2(&out[0], &n, (const Bytef*)data.data(), data.size(), Z_BEST_SPEED) != Z_OK)
+		return false;
+	FILE* f = fopen(filename.c_str(), "wb");
+	if(!f) return false;
+	uint64_t raw = data.size();
+	bool ok = fwrite(&raw, sizeof(raw), 1, f) == 1 && fwrite(&out[0], 1, n, f) == n;
+	fclose(f);
+	return ok;
+}
+
+bool readCompressed(const string& filename, vector<char>& data)
+{
+	FILE* f = fopen(filename.c_str(), "rb");
+	if(!f) return false;
+	uint64_t raw = 0;
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f) - (long)sizeof(raw);
+	fseek(f, 0, SEEK_SET);
+	vector<Bytef> in(std::max(0L, size));
+	bool ok = size >= 0 && fread(&raw, sizeof(raw), 1, f) == 1 && fread(in.data(), 1, in.size(), f) == in.size();
+	fclose(f);
+	if(!ok) return false;
+	data.resize(raw);
+	uLongf n = raw;
+	return uncompress((Bytef*)data.data(), &n, in.data(), in.size()) == Z_OK && n == raw;
+}
+
+static void putMat(vector<char>& buf, const cv::Mat& m)
+{
+	int h[3] = {m.rows, m.cols, m.type()};
+	buf.insert(buf.end(), (const char*)h, (const char*)(h+3));
+	for(int i=0; i<m.rows; i++)
+		buf.insert(buf.end(), (const char*)m.ptr(i), (const char*)m.ptr(i) + m.cols*m.elemSize());
+}
+
+static cv::Mat getMat(const vector<char>& buf, size_t& pos)
+{
+	cv::Mat m;
+	int h[3];
+	if(pos + sizeof(h) > buf.size()) return m;
+	memcpy(h, &buf[pos], sizeof(h));
+	pos += sizeof(h);
+	if(h[0] <= 0 || h[1] <= 0) return m;
+	m.create(h[0], h[1], h[2]);
+	size_t n = m.total()*m.elemSize();
+	if(pos + n > buf.size()) return cv::Mat();
+	memcpy(m.data, &buf[pos], n);
+	pos += n;
+	return m;
+}
+
+KeyFrameImageStore::KeyFrameImageStore(const string& _dir, size_t _budget, double _radius)
+	: dir(_dir), budget(_budget), resident(0), radius(_radius)
+{
+	mkdir(dir.c_str(), 0755);
+}
+
+KeyFrameImageStore::~KeyFrameImageStore()
+{
+	for(std::set<long unsigned int>::iterator it = written.begin(); it != written.end(); ++it)
+		unlink(filename(*it).c_str());
+}
+
+string KeyFrameImageStore::filename(long unsigned int id) const
+{
+	char name[64];
+	sprintf(name, "/kf_%lu.z", id);
+	return dir + name;
+}
+
+size_t KeyFrameImageStore::imageBytes(const Frame& f)
+{
+	const cv::Mat* m[4] = {&f.rgb, &f.gray, &f.depth, &f.oriDepth};
+	size_t n = 0;
+	for(int i=0; i<4; i++)
+		n += m[i]->total()*m[i]->elemSize();
+	return n;
+}
+
+void KeyFrameImageStore::update(vector<Frame>& keyFrames, Map3d& map, const Eigen::Vector3d& cam)
+{
+	vector<pair<double,int> > far;  // resident keyframes beyond the radius
+	resident = 0;
+	for(size_t i=0; i<keyFrames.size(); i++)
+	{
+		size_t n = imageBytes(keyFrames[i]);
+		if(n == 0) continue;
+		resident += n;
+		Eigen::Isometry3d Twc;
+		if(!map.pose(keyFrames[i].id, Twc)) continue;
+		double d = (Twc.translation() - cam).norm();
+		if(d > radius) far.push_back(make_pair(d, (int)i));
+	}
+	if(resident <= budget) return;
+
+	sort(far.rbegin(), far.rend());
+	for(size_t i=0; i<far.size() && resident > budget; i++)
+	{
+		Frame& f = keyFrames[far[i].second];
+		// images do not change, a keyframe read back keeps its file
+		if(!written.count(f.id))
+		{
+			vector<char> buf;
+			putMat(buf, f.rgb);
+			putMat(buf, f.gray);
+			putMat(buf, f.oriDepth);
+			if(!writeCompressed(filename(f.id), buf)) {
+				cout<<"KeyFrameImageStore: cannot write "<<filename(f.id)<<endl;
+				return;
+			}
+			written.insert(f.id);
+		}
+		resident -= imageBytes(f);
+		f.rgb.release();
+		f.gray.release();
+		f.depth.release();
+		f.oriDepth.release();
+	}
+}
+
+bool KeyFrameImageStore::restore(Frame& f)
+{
+	if(!f.depth.empty()) return true;
+	if(!written.count(f.id)) return false;
+	vector<char> buf;
+	if(!readCompressed(filename(f.id), buf)) {
+		cout<<"KeyFrameImageStore: cannot read "<<filename(f.id)<<endl;
+		return false;
+	}
+	size_t pos = 0;
+	f.rgb = getMat(buf, pos);
+	f.gray = getMat(buf, pos);
+	f.oriDepth = getMat(buf, pos);
+	f.oriDepth.convertTo(f.depth, CV_32F);
+	resident += imageBytes(f);
+	return !f.depth.empty();
+}
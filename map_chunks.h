@@ -0,0 +1,38 @@
+#ifndef MAP_CHUNKS_H
+#define MAP_CHUNKS_H
+
+#include "Map.h"
+#include <set>
+
+//! zlib compressed file, the raw size is stored first
+bool writeCompressed(const string& filename, const vector<char>& data);
+bool readCompressed(const string& filename, vector<char>& data);
+
+//! images of the keyframes, by far the largest part of them, written to disk once the keyframe is
+//! beyond the working radius around the camera and the resident images exceed the budget
+//! the rest of the keyframe (features, lines, planes) stays in RAM
+class KeyFrameImageStore
+{
+public:
+	//! dir is created if needed, budget in bytes, radius in meters
+	KeyFrameImageStore(const string& dir, size_t budget, double radius);
+	//! the written files are removed
+	~KeyFrameImageStore();
+	//! keyframes are placed by their pose in map, the farthest from cam are written out first
+	void update(vector<Frame>& keyFrames, Map3d& map, const Eigen::Vector3d& cam);
+	//! images of f read back if they were written out, false if f has none
+	bool restore(Frame& f);
+	//! resident image bytes at the last update
+	size_t residentBytes() const { return resident; }
+
+private:
+	string filename(long unsigned int id) const;
+	static size_t imageBytes(const Frame& f);
+
+	string 		dir;
+	size_t 		budget, resident;
+	double 		radius;
+	std::set<long unsigned int> written;	// keyframe ids
+};
+
+#endif
@@ -0,0 +1,699 @@
+#include "map_io.h"
+#include "voxel_map.h"
+#include <stdint.h>
+#include <cstring>
+#include <algorithm>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+static const char 	MAP_MAGIC[4] = {'G','S','L','M'};
+static const int 	MAP_VERSION = 1;
+
+//! graph element types in the GRPH section
+enum { MAP_VERTEX_SE3 = 0, MAP_VERTEX_PLANE = 1 };
+enum { MAP_EDGE_SE3 = 0, MAP_EDGE_SE3_NORM = 1 };
+enum { MAP_KERNEL_NONE = 0, MAP_KERNEL_HUBER = 1, MAP_KERNEL_CAUCHY = 2 };
+
+//! appends to a buffer written at once, arrays start 8 byte aligned
+class MapWriter
+{
+public:
+	vector<char> buf;
+
+	void append(const void* p, size_t n) { buf.insert(buf.end(), (const char*)p, (const char*)p + n); }
+	void align() { buf.resize((buf.size()+7) & ~size_t(7), 0); }
+	template<class T> void put(const T& v) { append(&v, sizeof(T)); }
+	void putDoubles(const double* p, size_t n) { append(p, n*sizeof(double)); }
+	//! plain old data only
+	template<class T, class A> void putArray(const vector<T,A>& v)
+	{
+		put<uint64_t>(v.size());
+		align();
+		if(!v.empty()) append(&v[0], v.size()*sizeof(T));
+		align();
+	}
+	void putString(const string& s)
+	{
+		put<uint64_t>(s.size());
+		append(s.data(), s.size());
+		align();
+	}
+	void putMat(const cv::Mat& m)
+	{
+		put<int32_t>(m.rows);
+		put<int32_t>(m.cols);
+		put<int32_t>(m.type());
+		put<int32_t>(0);
+		for(int i=0; i<m.rows; i++)
+			append(m.ptr(i), m.cols*m.elemSize());
+		align();
+	}
+	size_t beginSection(const char* tag)
+	{
+		align();
+		append(tag, 4);
+		put<uint32_t>(0);
+		put<uint64_t>(0);  // size, patched by endSection
+		return buf.size();
+	}
+	void endSection(size_t begin)
+	{
+		align();
+		uint64_t size = buf.size() - begin;
+		memcpy(&buf[begin - sizeof(uint64_t)], &size, sizeof(size));
+	}
+};
+
+//! reads from a mapped file, ok turns false on the first read past the end
+class MapReader
+{
+public:
+	const char* 	base;
+	const char* 	p;
+	const char* 	end;
+	bool 			ok;
+
+	MapReader(const char* b, size_t n) : base(b), p(b), end(b+n), ok(true) {}
+
+	bool read(void* dst, size_t n)
+	{
+		if(!ok || (size_t)(end-p) < n) { ok = false; return false; }
+		memcpy(dst, p, n);
+		p += n;
+		return true;
+	}
+	void align()
+	{
+		size_t off = ((p-base) + 7) & ~size_t(7);
+		if(off > (size_t)(end-base)) { ok = false; return; }
+		p = base + off;
+	}
+	//! n items of at least size bytes each can still be in the file, ok turns false otherwise
+	bool fits(uint64_t n, size_t size)
+	{
+		if(ok && n > (size_t)(end-p)/size) ok = false;
+		return ok;
+	}
+	template<class T> T get() { T v = T(); read(&v, sizeof(T)); return v; }
+	void getDoubles(double* dst, size_t n) { read(dst, n*sizeof(double)); }
+	template<class T, class A> void getArray(vector<T,A>& v)
+	{
+		uint64_t n = get<uint64_t>();
+		align();
+		if(!fits(n, sizeof(T))) { v.clear(); return; }
+		v.resize(n);
+		if(n) read(&v[0], n*sizeof(T));
+		align();
+	}
+	string getString()
+	{
+		uint64_t n = get<uint64_t>();
+		if(!ok || n > (size_t)(end-p)) { ok = false; return string(); }
+		string s(p, n);
+		p += n;
+		align();
+		return s;
+	}
+	cv::Mat getMat()
+	{
+		int rows = get<int32_t>(), cols = get<int32_t>(), type = get<int32_t>();
+		get<int32_t>();
+		cv::Mat m;
+		if(!ok || rows < 0 || cols < 0 || type != CV_MAT_TYPE(type) || CV_MAT_DEPTH(type) > CV_64F) { ok = false; return m; }
+		if(rows > 0 && cols > 0 && fits((uint64_t)rows*cols, CV_ELEM_SIZE(type)))
+		{
+			m.create(rows, cols, type);
+			for(int i=0; i<rows && ok; i++)
+				read(m.ptr(i), cols*m.elemSize());
+		}
+		align();
+		return m;
+	}
+};
+
+static void putPoint(MapWriter& w, const cv::Point3d& p) { w.put(p.x); w.put(p.y); w.put(p.z); }
+static cv::Point3d getPoint(MapReader& r)
+{
+	cv::Point3d p;
+	p.x = r.get<double>(); p.y = r.get<double>(); p.z = r.get<double>();
+	return p;
+}
+
+static void putFrame(MapWriter& w, const Frame& f)
+{
+	w.put<uint64_t>(f.id);
+	w.put<double>(f.timestamp);
+	w.put<int32_t>(f.isKeyFrame);
+	w.put<int32_t>(f.N);
+	w.putString(f.rgbname);
+	w.putMat(f.mTcw);
+
+	w.putMat(f.mDescriptors);
+	w.putArray(f.mvKeypoints);
+	w.putArray(f.mvKeypointsUn);
+	w.putArray(f.feature_locations_2d_);
+	w.putArray(f.feature_locations_3d_);
+
+	w.put<uint64_t>(f.lines.size());
+	for(size_t i=0; i<f.lines.size(); i++)
+	{
+		const FrameLine& l = f.lines[i];
+		w.put(l.p.x); w.put(l.p.y); w.put(l.q.x); w.put(l.q.y);
+		w.put(l.r.x); w.put(l.r.y);
+		w.putDoubles(l.lineEq2d, 3);
+		w.put<int32_t>(l.haveDepth);
+		w.put<int32_t>(l.lid);
+		w.put<int32_t>(l.gid);
+		w.put<int32_t>(l.lid_prvKfrm);
+		w.putMat(l.l);
+		w.putMat(l.des);
+		const RandomLine3d& ln = l.line3d;
+		putPoint(w, ln.A); putPoint(w, ln.B);
+		putPoint(w, ln.u); putPoint(w, ln.d);
+		w.putMat(ln.covA);
+		w.putMat(ln.covB);
+		putPoint(w, ln.rndA.pos);
+		w.putMat(ln.rndA.cov);
+		putPoint(w, ln.rndB.pos);
+		w.putMat(ln.rndB.cov);
+	}
+
+	w.put<uint64_t>(f.planes.size());
+	for(size_t i=0; i<f.planes.size(); i++)
+	{
+		const FramePlane& pl = f.planes[i];
+		putPoint(w, pl.n);
+		putPoint(w, pl.center);
+		w.put(pl.d);
+		w.put(pl.mse);
+		w.put<int32_t>(pl.N);
+		w.put<int32_t>(pl.pid);
+		w.put<int32_t>(pl.gid);
+		w.put<int32_t>(0);
+		w.putArray(pl.cells);
+	}
+
+	w.put<uint64_t>(f.mBowVec.size());
+	for(DBoW2::BowVector::const_iterator it = f.mBowVec.begin(); it != f.mBowVec.end(); ++it)
+	{
+		w.put<uint32_t>(it->first);
+		w.put<uint32_t>(0);
+		w.put<double>(it->second);
+	}
+	w.put<uint64_t>(f.mFeatureVec.size());
+	for(DBoW2::FeatureVector::const_iterator it = f.mFeatureVec.begin(); it != f.mFeatureVec.end(); ++it)
+	{
+		w.put<uint32_t>(it->first);
+		w.put<uint32_t>(0);
+		w.putArray(it->second);
+	}
+}
+
+static RandomPoint3d getRandomPoint(MapReader& r)
+{
+	cv::Point3d pos = getPoint(r);
+	cv::Mat cov = r.getMat();
+	if(cov.rows == 3 && cov.cols == 3) return RandomPoint3d(pos, cov);  // recomputes the decomposition
+	return RandomPoint3d(pos);
+}
+
+static void getFrame(MapReader& r, Frame& f)
+{
+	f.id = r.get<uint64_t>();
+	f.timestamp = r.get<double>();
+	f.isKeyFrame = r.get<int32_t>();
+	f.N = r.get<int32_t>();
+	f.rgbname = r.getString();
+	cv::Mat Tcw = r.getMat();
+	if(!Tcw.empty()) f.setPose(Tcw);
+
+	f.mDescriptors = r.getMat();
+	r.getArray(f.mvKeypoints);
+	r.getArray(f.mvKeypointsUn);
+	r.getArray(f.feature_locations_2d_);
+	r.getArray(f.feature_locations_3d_);
+
+	uint64_t nLines = r.get<uint64_t>();
+	f.lines.clear();
+	r.fits(nLines, 200);  // lower bound of the bytes of an item, a corrupted count fails here
+	for(uint64_t i=0; i<nLines && r.ok; i++)
+	{
+		FrameLine l;
+		l.p.x = r.get<double>(); l.p.y = r.get<double>();
+		l.q.x = r.get<double>(); l.q.y = r.get<double>();
+		l.r.x = r.get<double>(); l.r.y = r.get<double>();
+		r.getDoubles(l.lineEq2d, 3);
+		l.haveDepth = r.get<int32_t>();
+		l.lid = r.get<int32_t>();
+		l.gid = r.get<int32_t>();
+		l.lid_prvKfrm = r.get<int32_t>();
+		l.l = r.getMat();
+		l.des = r.getMat();
+		RandomLine3d& ln = l.line3d;
+		ln.A = getPoint(r); ln.B = getPoint(r);
+		ln.u = getPoint(r); ln.d = getPoint(r);
+		ln.covA = r.getMat();
+		ln.covB = r.getMat();
+		ln.rndA = getRandomPoint(r);
+		ln.rndB = getRandomPoint(r);
+		f.lines.push_back(l);
+	}
+
+	uint64_t nPlanes = r.get<uint64_t>();
+	f.planes.clear();
+	r.fits(nPlanes, 80);
+	for(uint64_t i=0; i<nPlanes && r.ok; i++)
+	{
+		FramePlane pl;
+		pl.n = getPoint(r);
+		pl.center = getPoint(r);
+		pl.d = r.get<double>();
+		pl.mse = r.get<double>();
+		pl.N = r.get<int32_t>();
+		pl.pid = r.get<int32_t>();
+		pl.gid = r.get<int32_t>();
+		r.get<int32_t>();
+		r.getArray(pl.cells);
+		f.planes.push_back(pl);
+	}
+
+	f.mBowVec.clear();
+	uint64_t nWords = r.get<uint64_t>();
+	r.fits(nWords, 16);
+	for(uint64_t i=0; i<nWords && r.ok; i++)
+	{
+		DBoW2::WordId wid = r.get<uint32_t>();
+		r.get<uint32_t>();
+		double v = r.get<double>();
+		f.mBowVec.insert(f.mBowVec.end(), make_pair(wid, v));
+	}
+	f.mFeatureVec.clear();
+	uint64_t nNodes = r.get<uint64_t>();
+	r.fits(nNodes, 16);
+	for(uint64_t i=0; i<nNodes && r.ok; i++)
+	{
+		DBoW2::NodeId nid = r.get<uint32_t>();
+		r.get<uint32_t>();
+		DBoW2::FeatureVector::iterator it = f.mFeatureVec.insert(f.mFeatureVec.end(), make_pair(nid, vector<unsigned int>()));
+		r.getArray(it->second);
+	}
+}
+
+static void putKernel(MapWriter& w, const g2o::OptimizableGraph::Edge* e)
+{
+	const g2o::RobustKernel* rk = e->robustKernel();
+	int type = MAP_KERNEL_NONE;
+	if(dynamic_cast<const g2o::RobustKernelHuber*>(rk)) type = MAP_KERNEL_HUBER;
+	else if(dynamic_cast<const g2o::RobustKernelCauchy*>(rk)) type = MAP_KERNEL_CAUCHY;
+	w.put<int32_t>(type);
+	w.put<int32_t>(0);
+	w.put<double>(rk ? rk->delta() : 0);
+}
+
+static void getKernel(MapReader& r, g2o::OptimizableGraph::Edge* e)
+{
+	int type = r.get<int32_t>();
+	r.get<int32_t>();
+	double delta = r.get<double>();
+	g2o::RobustKernel* rk = 0;
+	if(type == MAP_KERNEL_HUBER) rk = new g2o::RobustKernelHuber;
+	else if(type == MAP_KERNEL_CAUCHY) rk = new g2o::RobustKernelCauchy;
+	if(rk) {
+		rk->setDelta(delta);
+		e->setRobustKernel(rk);
+	}
+}
+
+static bool edgeLess(const g2o::HyperGraph::Edge* a, const g2o::HyperGraph::Edge* b)
+{
+	if(a->vertices()[0]->id() != b->vertices()[0]->id()) return a->vertices()[0]->id() < b->vertices()[0]->id();
+	return a->vertices()[1]->id() < b->vertices()[1]->id();
+}
+
+static void putGraph(MapWriter& w, const g2o::SparseOptimizer& optimizer)
+{
+	// sorted by id, so that the same graph gives the same file
+	vector<int> ids;
+	for(g2o::HyperGraph::VertexIDMap::const_iterator it = optimizer.vertices().begin(); it != optimizer.vertices().end(); ++it)
+		ids.push_back(it->first);
+	sort(ids.begin(), ids.end());
+
+	size_t countPos = w.buf.size();
+	w.put<uint64_t>(0);
+	uint64_t nVertices = 0;
+	for(size_t i=0; i<ids.size(); i++)
+	{
+		const g2o::HyperGraph::Vertex* hv = optimizer.vertex(ids[i]);
+		if(const g2o::VertexSE3* v = dynamic_cast<const g2o::VertexSE3*>(hv)) {
+			w.put<int32_t>(MAP_VERTEX_SE3);
+			w.put<int32_t>(v->id());
+			w.put<int32_t>(v->fixed());
+			w.put<int32_t>(0);
+			w.putDoubles(v->estimate().matrix().data(), 16);
+		} else if(const g2o::VertexPlane* v = dynamic_cast<const g2o::VertexPlane*>(hv)) {
+			w.put<int32_t>(MAP_VERTEX_PLANE);
+			w.put<int32_t>(v->id());
+			w.put<int32_t>(v->fixed());
+			w.put<int32_t>(0);
+			w.putDoubles(v->estimate().data(), 4);
+		} else
+			continue;
+		nVertices++;
+	}
+	memcpy(&w.buf[countPos], &nVertices, sizeof(nVertices));
+
+	vector<const g2o::HyperGraph::Edge*> edges(optimizer.edges().begin(), optimizer.edges().end());
+	sort(edges.begin(), edges.end(), edgeLess);
+	countPos = w.buf.size();
+	w.put<uint64_t>(0);
+	uint64_t nEdges = 0;
+	for(size_t i=0; i<edges.size(); i++)
+	{
+		if(const g2o::EdgeSE3* e = dynamic_cast<const g2o::EdgeSE3*>(edges[i])) {
+			w.put<int32_t>(MAP_EDGE_SE3);
+			w.put<int32_t>(e->vertices()[0]->id());
+			w.put<int32_t>(e->vertices()[1]->id());
+			w.put<int32_t>(0);
+			w.putDoubles(e->measurement().matrix().data(), 16);
+			w.putDoubles(e->information().data(), 36);
+			putKernel(w, e);
+		} else if(const g2o::EdgeSE3Norm* e = dynamic_cast<const g2o::EdgeSE3Norm*>(edges[i])) {
+			w.put<int32_t>(MAP_EDGE_SE3_NORM);
+			w.put<int32_t>(e->vertices()[0]->id());
+			w.put<int32_t>(e->vertices()[1]->id());
+			w.put<int32_t>(0);
+			w.putDoubles(e->measurement().data(), 4);
+			w.putDoubles(e->information().data(), 9);
+			putKernel(w, e);
+		} else
+			continue;
+		nEdges++;
+	}
+	memcpy(&w.buf[countPos], &nEdges, sizeof(nEdges));
+	if(nVertices != ids.size() || nEdges != edges.size())
+		cout<<"saveMap: "<<ids.size()-nVertices<<" vertices and "<<edges.size()-nEdges<<" edges of unknown type skipped"<<endl;
+}
+
+static bool getGraph(MapReader& r, g2o::SparseOptimizer& optimizer)
+{
+	optimizer.clear();
+	uint64_t nVertices = r.get<uint64_t>();
+	r.fits(nVertices, 48);
+	for(uint64_t i=0; i<nVertices && r.ok; i++)
+	{
+		int type = r.get<int32_t>(), id = r.get<int32_t>(), fixed = r.get<int32_t>();
+		r.get<int32_t>();
+		if(type == MAP_VERTEX_SE3) {
+			Eigen::Isometry3d T;
+			r.getDoubles(T.matrix().data(), 16);
+			g2o::VertexSE3* v = new g2o::VertexSE3();
+			v->setId(id);
+			v->setEstimate(T);
+			v->setFixed(fixed);
+			optimizer.addVertex(v);
+		} else if(type == MAP_VERTEX_PLANE) {
+			Eigen::Vector4d pl;
+			r.getDoubles(pl.data(), 4);
+			g2o::VertexPlane* v = new g2o::VertexPlane();
+			v->setId(id);
+			v->setEstimate(pl);
+			v->setFixed(fixed);
+			optimizer.addVertex(v);
+		} else
+			return false;
+	}
+
+	uint64_t nEdges = r.get<uint64_t>();
+	r.fits(nEdges, 80);
+	for(uint64_t i=0; i<nEdges && r.ok; i++)
+	{
+		int type = r.get<int32_t>(), id0 = r.get<int32_t>(), id1 = r.get<int32_t>();
+		r.get<int32_t>();
+		g2o::OptimizableGraph::Edge* edge = 0;
+		if(type == MAP_EDGE_SE3) {
+			Eigen::Isometry3d T;
+			Eigen::Matrix<double,6,6> info;
+			r.getDoubles(T.matrix().data(), 16);
+			r.getDoubles(info.data(), 36);
+			g2o::EdgeSE3* e = new g2o::EdgeSE3();
+			e->setMeasurement(T);
+			e->setInformation(info);
+			edge = e;
+		} else if(type == MAP_EDGE_SE3_NORM) {
+			Eigen::Vector4d m;
+			Eigen::Matrix3d info;
+			r.getDoubles(m.data(), 4);
+			r.getDoubles(info.data(), 9);
+			g2o::EdgeSE3Norm* e = new g2o::EdgeSE3Norm();
+			e->setMeasurement(m);
+			e->setInformation(info);
+			edge = e;
+		} else
+			return false;
+		getKernel(r, edge);
+		edge->setVertex(0, optimizer.vertex(id0));
+		edge->setVertex(1, optimizer.vertex(id1));
+		if(!edge->vertex(0) || !edge->vertex(1) || !optimizer.addEdge(edge)) {
+			delete edge;
+			return false;
+		}
+	}
+	return r.ok;
+}
+
+static void putLandmarks(MapWriter& w, Map3d& map)
+{
+	std::lock_guard<std::mutex> lock(map.mapMutex);
+	w.put<uint64_t>(map.keyframes.size());
+	for(size_t i=0; i<map.keyframes.size(); i++)
+	{
+		const MapKeyFrame& kf = map.keyframes[i];
+		w.put<int32_t>(kf.id);
+		w.put<int32_t>(0);
+		w.put<double>(kf.timestamp);
+		w.putDoubles(kf.Twc.matrix().data(), 16);
+		w.putArray(kf.ptLmk);
+		w.putArray(kf.lnLmk);
+		w.put<uint64_t>(kf.pts.size());
+		for(size_t j=0; j<kf.pts.size(); j++)
+		{
+			w.put<int32_t>(kf.pts[j].lmk);
+			w.put<int32_t>(0);
+			w.putDoubles(kf.pts[j].pos.data(), 3);
+			w.putDoubles(kf.pts[j].info.data(), 9);
+		}
+		w.put<uint64_t>(kf.lns.size());
+		for(size_t j=0; j<kf.lns.size(); j++)
+		{
+			w.put<int32_t>(kf.lns[j].lmk);
+			w.put<int32_t>(0);
+			w.putDoubles(kf.lns[j].endpts.data(), 6);
+			w.putDoubles(kf.lns[j].endptCov.data(), 36);
+			w.putDoubles(kf.lns[j].endpt_AffnMat.data(), 36);
+		}
+	}
+	w.putArray(map.points);
+	w.putArray(map.lines);
+}
+
+static void getLandmarks(MapReader& r, Map3d& map)
+{
+	std::lock_guard<std::mutex> lock(map.mapMutex);
+	map.keyframes.clear();
+	map.kfIndex.clear();
+	uint64_t nKf = r.get<uint64_t>();
+	r.fits(nKf, 160);
+	for(uint64_t i=0; i<nKf && r.ok; i++)
+	{
+		MapKeyFrame kf;
+		kf.id = r.get<int32_t>();
+		r.get<int32_t>();
+		kf.timestamp = r.get<double>();
+		r.getDoubles(kf.Twc.matrix().data(), 16);
+		r.getArray(kf.ptLmk);
+		r.getArray(kf.lnLmk);
+		uint64_t nPts = r.get<uint64_t>();
+		r.fits(nPts, 104);
+		for(uint64_t j=0; j<nPts && r.ok; j++)
+		{
+			MapPointObs o;
+			o.lmk = r.get<int32_t>();
+			r.get<int32_t>();
+			r.getDoubles(o.pos.data(), 3);
+			r.getDoubles(o.info.data(), 9);
+			kf.pts.push_back(o);
+		}
+		uint64_t nLns = r.get<uint64_t>();
+		r.fits(nLns, 632);
+		for(uint64_t j=0; j<nLns && r.ok; j++)
+		{
+			MapLineObs o;
+			o.lmk = r.get<int32_t>();
+			r.get<int32_t>();
+			r.getDoubles(o.endpts.data(), 6);
+			r.getDoubles(o.endptCov.data(), 36);
+			r.getDoubles(o.endpt_AffnMat.data(), 36);
+			kf.lns.push_back(o);
+		}
+		map.kfIndex[kf.id] = map.keyframes.size();
+		map.keyframes.push_back(kf);
+	}
+	r.getArray(map.points);
+	r.getArray(map.lines);
+}
+
+static void putCloud(MapWriter& w, const PointCloud& cloud)
+{
+	w.put<uint64_t>(cloud.points.size());
+	for(size_t i=0; i<cloud.points.size(); i++)
+	{
+		const PointT& p = cloud.points[i];
+		w.put<float>(p.x); w.put<float>(p.y); w.put<float>(p.z);
+		w.put<uint32_t>(p.rgba);
+	}
+}
+
+static void getCloud(MapReader& r, PointCloud& cloud)
+{
+	uint64_t n = r.get<uint64_t>();
+	if(!r.fits(n, 16)) return;
+	cloud.points.resize(n);
+	for(uint64_t i=0; i<n; i++)
+	{
+		PointT& p = cloud.points[i];
+		p.x = r.get<float>(); p.y = r.get<float>(); p.z = r.get<float>();
+		p.rgba = r.get<uint32_t>();
+	}
+	cloud.width = cloud.points.size();
+	cloud.height = 1;
+	cloud.is_dense = false;
+}
+
+static void putVoxels(MapWriter& w, const VoxelMap& voxels)
+{
+	vector<VoxelMap::VoxelRecord> v;
+	voxels.exportVoxels(v);
+	w.put<double>(voxels.resolution());
+	w.putArray(v);
+}
+
+static void getVoxels(MapReader& r, VoxelMap& voxels)
+{
+	double res = r.get<double>();
+	vector<VoxelMap::VoxelRecord> v;
+	r.getArray(v);
+	if(!r.ok) return;
+	if(res != voxels.resolution()) {
+		cout<<"loadMap: voxel map of resolution "<<res<<" not loaded into one of "<<voxels.resolution()<<endl;
+		return;
+	}
+	voxels.importVoxels(v);
+}
+
+bool saveMap(const string& filename, const vector<Frame>& keyFrames, const g2o::SparseOptimizer& optimizer,
+	     Map3d* map, const PointCloud* cloud, const VoxelMap* voxels)
+{
+	MapWriter w;
+	w.append(MAP_MAGIC, 4);
+	w.put<int32_t>(MAP_VERSION);
+
+	size_t s = w.beginSection("KFRM");
+	w.put<uint64_t>(keyFrames.size());
+	for(size_t i=0; i<keyFrames.size(); i++)
+		putFrame(w, keyFrames[i]);
+	w.endSection(s);
+
+	s = w.beginSection("GRPH");
+	putGraph(w, optimizer);
+	w.endSection(s);
+
+	if(map) {
+		s = w.beginSection("LMKS");
+		putLandmarks(w, *map);
+		w.endSection(s);
+	}
+	if(cloud) {
+		s = w.beginSection("CLOD");
+		putCloud(w, *cloud);
+		w.endSection(s);
+	}
+	if(voxels) {
+		s = w.beginSection("VOXM");
+		putVoxels(w, *voxels);
+		w.endSection(s);
+	}
+
+	FILE* f = fopen(filename.c_str(), "wb");
+	if(!f) {
+		cout<<"saveMap: cannot open "<<filename<<endl;
+		return false;
+	}
+	bool ok = fwrite(&w.buf[0], 1, w.buf.size(), f) == w.buf.size();
+	fclose(f);
+	return ok;
+}
+
+bool loadMap(const string& filename, vector<Frame>& keyFrames, g2o::SparseOptimizer& optimizer,
+	     Map3d* map, PointCloud* cloud, VoxelMap* voxels)
+{
+	int fd = open(filename.c_str(), O_RDONLY);
+	if(fd < 0) {
+		cout<<"loadMap: cannot open "<<filename<<endl;
+		return false;
+	}
+	struct stat st;
+	if(fstat(fd, &st) != 0 || st.st_size < 8) {
+		close(fd);
+		return false;
+	}
+	void* data = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if(data == MAP_FAILED) return false;
+
+	MapReader r((const char*)data, st.st_size);
+	char magic[4];
+	r.read(magic, 4);
+	int version = r.get<int32_t>();
+	bool ok = memcmp(magic, MAP_MAGIC, 4) == 0 && version == MAP_VERSION;
+	if(!ok)
+		cout<<"loadMap: "<<filename<<" is not a map file of version "<<MAP_VERSION<<endl;
+
+	while(ok)
+	{
+		r.align();
+		if(r.p >= r.end) break;
+		char tag[4];
+		r.read(tag, 4);
+		r.get<uint32_t>();
+		uint64_t size = r.get<uint64_t>();
+		if(!r.ok || size > (size_t)(r.end-r.p)) { ok = false; break; }
+		MapReader sec(r.p, size);
+		sec.base = r.base;  // alignment is relative to the file
+		r.p += size;
+
+		if(memcmp(tag, "KFRM", 4) == 0) {
+			uint64_t n = sec.get<uint64_t>();
+			keyFrames.clear();
+			if(sec.fits(n, 64)) keyFrames.reserve(n);
+			for(uint64_t i=0; i<n && sec.ok; i++) {
+				keyFrames.push_back(Frame());
+				getFrame(sec, keyFrames.back());
+				// frames created after loading must not reuse the ids of the map
+				Frame::nextid = std::max(Frame::nextid, keyFrames.back().id + 1);
+			}
+		} else if(memcmp(tag, "GRPH", 4) == 0) {
+			if(!getGraph(sec, optimizer)) sec.ok = false;
+		} else if(memcmp(tag, "LMKS", 4) == 0 && map) {
+			getLandmarks(sec, *map);
+		} else if(memcmp(tag, "CLOD", 4) == 0 && cloud) {
+			getCloud(sec, *cloud);
+		} else if(memcmp(tag, "VOXM", 4) == 0 && voxels) {
+			getVoxels(sec, *voxels);
+		}
+		ok = sec.ok;
+	}
+	munmap(data, st.st_size);
+	if(!ok) cout<<"loadMap: "<<filename<<" is corrupted"<<endl;
+	return ok;
+}
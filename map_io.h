@@ -0,0 +1,22 @@
+#ifndef MAP_IO_H
+#define MAP_IO_H
+
+#include "Map.h"
+
+class VoxelMap;
+
+//! versioned binary map file:
+//! keyframes (pose, keypoints and descriptors, 3d lines with covariances, planes, BoW),
+//! the pose graph with its plane landmarks, the point/line landmarks of Map3d, the fused cloud and the voxel map
+//! sections are tagged and 8 byte aligned, a reader skips the sections it does not know
+//! images are not stored, a loaded keyframe has no rgb/depth
+bool saveMap(const string& filename, const vector<Frame>& keyFrames, const g2o::SparseOptimizer& optimizer,
+	     Map3d* map = 0, const PointCloud* cloud = 0, const VoxelMap* voxels = 0);
+
+//! the file is mapped and the arrays copied out of it
+//! optimizer is cleared and refilled, its algorithm has to be set already
+//! Frame::nextid is moved past the loaded keyframe ids, counts are checked against the file size
+bool loadMap(const string& filename, vector<Frame>& keyFrames, g2o::SparseOptimizer& optimizer,
+	     Map3d* map = 0, PointCloud* cloud = 0, VoxelMap* voxels = 0);
+
+#endif
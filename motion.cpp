@@ -1,957 +1,1422 @@
-#include "utils.h"
-#include "frame.h"
-#include "edge_se3_lineendpts.h"
-
-#define OPT_USE_MAHDIST
-#define MOTION_USE_MAHDIST
-
-#define POINT
-#define LINE
-#define VERBOSE
-
-
-inline double depth_std_dev(double depth)
-{
-  static double depth_std_dev = 0.006;
-  // Previously used 0.006 
-  //http://www.ros.org/wiki/openni_kinect/kinect_accuracy;
-  return depth_std_dev * depth * depth;
-}
-
-//Functions without dependencies
-inline double depth_covariance(double depth)
-{
-  double stddev = depth_std_dev(depth);
-  return stddev * stddev;
-}
-
-inline Eigen::Matrix3d point_information_matrix(double distance)
-{
-  Eigen::Matrix3d inf_mat = Eigen::Matrix3d::Identity();
-  inf_mat(2,2) = 1.0/depth_covariance(distance);
-  return inf_mat;
-}
-
-
-//!Set parameters for icp optimizer
-void optimizerSetup(g2o::SparseOptimizer& optimizer,cv::Mat K)
-{
-    //sparse optimizer
-    g2o::BlockSolverX::LinearSolverType * linearSolver = new g2o::LinearSolverCholmod<g2o ::BlockSolverX::PoseMatrixType>();
-    g2o::BlockSolverX * blocksolver = new g2o::BlockSolverX(linearSolver);
-    g2o::OptimizationAlgorithmLevenberg* algorithm = new g2o::OptimizationAlgorithmLevenberg(blocksolver);
-    optimizer.setAlgorithm(algorithm);
-    
-    //camera parameters
-    g2o::ParameterCamera* cameraParams = new g2o::ParameterCamera();
-    double fx = K.at<double>(0,0);
-    double fy = K.at<double>(1,1);
-    double cx = K.at<double>(0,2);
-    double cy = K.at<double>(1,2);
-    cameraParams->setKcam(fx,fy,cx,cy);
-    g2o::SE3Quat offset; // identity
-    cameraParams->setOffset(offset);
-    
-    cameraParams->setId(0);
-    optimizer.addParameter(cameraParams);
-}
-
-
-//first cam is fixed, transformation from the first to the second cam will be computed
-std::pair<g2o::VertexSE3*, g2o::VertexSE3*>  sensorVerticesSetup(g2o::SparseOptimizer& optimizer, Eigen::Matrix4f& tf_estimate)
-{
-    g2o::VertexSE3 *vc1 = new VertexSE3();
-    Eigen::Quaterniond q(tf_estimate.topLeftCorner<3,3>().cast<double>());//initialize rotation from estimate 
-    Eigen::Vector3d    t(tf_estimate.topRightCorner<3,1>().cast<double>());//initialize translation from estimate
-    g2o::SE3Quat cam(q,t);
-    vc1->setEstimate(g2o::SE3Quat());
-    vc1->setId(0);  
-    vc1->setFixed(true);
-    optimizer.addVertex(vc1);
-  
-    g2o::VertexSE3 *vc2 = new VertexSE3();
-    vc2->setEstimate(cam);
-    vc2->setId(1); 
-    vc2->setFixed(false);
-    optimizer.addVertex(vc2);
-    
-    // add to optimizer
-    return std::make_pair(vc1, vc2);
-}
-
-g2o::EdgeSE3PointXYZDepth* edgeToFeature(const Frame* node, unsigned int feature_id,
-                              g2o::VertexSE3* camera_vertex, g2o::VertexPointXYZ* feature_vertex)
-{
-    g2o::EdgeSE3PointXYZDepth* edge = new g2o::EdgeSE3PointXYZDepth();
-    cv::KeyPoint kp = node->feature_locations_2d_[feature_id];
-    Vector4f position = node->feature_locations_3d_[feature_id];
-    float d = position(2);
-  
-    feature_vertex->setEstimate(position.cast<double>().head<3>());
-    feature_vertex->setFixed(false);
-    
-    //cout<<kp.pt.x<<" "<<kp.pt.y<<" "<<d<<endl;
-    Eigen::Vector3d pix_d(kp.pt.x,kp.pt.y,d);  //
-    edge->setMeasurement(pix_d);
-    Eigen::Matrix3d info_mat = point_information_matrix(d);
-    edge->setInformation(info_mat);
-    
- 
-    edge->setParameterId(0,0);
-    edge->setRobustKernel(new g2o::RobustKernelHuber());  //true
-    edge->vertices()[0] = camera_vertex;
-    edge->vertices()[1] = feature_vertex;
-   
-   
-    return edge;
-}
-
-//!Compute 
-void getTransformFromMatchesG2O(const Frame* earlier_node, const Frame* newer_node,
-                                const std::vector<cv::DMatch> & matches,
-                                Eigen::Matrix4f& transformation_estimate, 
-                                int iterations)
-{
-    std::vector<cv::DMatch> matches_with_depth;
-    BOOST_FOREACH(const cv::DMatch& m, matches)
-    {
-      
-		Point2f kp1 = earlier_node->feature_locations_2d_[m.queryIdx].pt;
-		Point2f kp2 = newer_node->feature_locations_2d_[m.trainIdx].pt;
-
-		
-		float depth1 = earlier_node->feature_locations_3d_[m.queryIdx](2);
-		float depth2 = newer_node->feature_locations_3d_[m.trainIdx](2);
-		
-		if( depth1>=1e-2&&depth1<=10&&depth2>=1e-2&&depth2<=10
-		&&(kp1.x>=1&&kp1.x<=640&&kp1.y>=1&&kp1.y<=480)
-		&&(kp2.x>=1&&kp2.x<=640&&kp2.y>=1&&kp2.y<=480))
-		{
-			matches_with_depth.push_back(m);
-		}
-    }
-    
-  
-    cout<<"matches_all       :"<<matches.size()<<endl;
-    cout<<"matches_with_depth:"<<matches_with_depth.size()<<endl;
-
-    g2o::SparseOptimizer* optimizer = new g2o::SparseOptimizer();
-    optimizerSetup(*optimizer, Frame::K);
-    Eigen::Matrix4f tfinv = transformation_estimate;//Eigen::Matrix4f::Identity();
-    std::pair<g2o::VertexSE3*, g2o::VertexSE3*> cams = sensorVerticesSetup(*optimizer, tfinv);
-
-    int v_id = optimizer->vertices().size(); //0 and 1 are taken by sensor vertices
-    
-    //For each match, create a vertex and connect it to the sensor vertices with the measured position
-    BOOST_FOREACH(const cv::DMatch& m, matches_with_depth)
-    {
-		g2o::VertexPointXYZ* v = new g2o::VertexPointXYZ();
-		v->setId(v_id++);
-		v->setMarginalized(true);
-		v->setFixed(false);
-		optimizer->addVertex(v);
-		
-		g2o::EdgeSE3PointXYZDepth* e1 = edgeToFeature(earlier_node, m.queryIdx, cams.first,  v);
-		optimizer->addEdge(e1);
-		
-		g2o::EdgeSE3PointXYZDepth* e2 = edgeToFeature(newer_node,   m.trainIdx, cams.second, v);
-		optimizer->addEdge(e2);  
-    }
-    
-    //start optimization
-    optimizer->setVerbose(false);
-    optimizer->initializeOptimization();
-    std::cout<<"g2o error "<< optimizer->activeChi2();
-    optimizer->optimize(100);
-    std::cout<<" => " <<optimizer->activeChi2()<<std::endl;
-    
-    transformation_estimate = cams.second->estimate().cast<float>().matrix();
-    delete optimizer;
-}
-
-
-Eigen::Isometry3d getTransformFromHybridMatchesG2O (const Frame* earlier_node, const Frame* newer_node,
-                                       const std::vector<cv::DMatch> & pt_matches,
-                                       const std::vector<cv::DMatch> & ln_matches,
-                                       Eigen::Matrix4f& transformation_estimate, 
-                                       int iterations,  SystemParameters sysPara)
-{
-  
-	std::vector<cv::DMatch> matches_with_depth;
-	BOOST_FOREACH(const cv::DMatch& m, pt_matches)
-	{
-
-		Point2f kp1 = earlier_node->feature_locations_2d_[m.queryIdx].pt;
-		Point2f kp2 = newer_node->feature_locations_2d_[m.trainIdx].pt;
-
-		
-		float depth1 = earlier_node->feature_locations_3d_[m.queryIdx](2);
-		float depth2 = newer_node->feature_locations_3d_[m.trainIdx](2);
-		
-		if( depth1>=1e-2&&depth1<=10&&depth2>=1e-2&&depth2<=10
-			&&(kp1.x>=1&&kp1.x<=640&&kp1.y>=1&&kp1.y<=480)
-			&&(kp2.x>=1&&kp2.x<=640&&kp2.y>=1&&kp2.y<=480))
-		{
-			matches_with_depth.push_back(m);
-		}
-	}
- 
-	//G2O Initialization
-	g2o::SparseOptimizer* optimizer = new g2o::SparseOptimizer();
-	optimizerSetup(*optimizer, Frame::K);
-	
-	Eigen::Matrix4f tfinv = transformation_estimate;//Eigen::Matrix4f::Identity();//transformation_estimate.inverse();
-	std::pair<g2o::VertexSE3*, g2o::VertexSE3*> cams = sensorVerticesSetup(*optimizer, tfinv);
-	int v_id = optimizer->vertices().size(); //0 and 1 are taken by sensor vertices
-	
-	vector<g2o::EdgeSE3PointXYZ*>   pt_edges;
-	vector<g2o::EdgeSE3LineEndpts*> ln_edges;
-
-	//add the parameter representing the sensor offset  
-	g2o::ParameterSE3Offset* sensorOffset = new g2o::ParameterSE3Offset;
-	sensorOffset->setOffset(Eigen::Isometry3d::Identity());
-	sensorOffset->setId(1);
-	optimizer->addParameter(sensorOffset);
-
-	//camera intrinsic parameters 
-	double  fx = Frame::K.at<double>(0,0), 
-			fy = Frame::K.at<double>(1,1),
-			cu = Frame::K.at<double>(0,2),
-			cv = Frame::K.at<double>(1,2);
-
-#ifdef SEGMENT
-	{
-		for(int ii=0; ii<1; ii++)
-		{
-			Eigen::Vector3d norm_older(earlier_node->c[0],earlier_node->c[1],earlier_node->c[2]);
-			Eigen::Vector3d norm_newer(newer_node->c[0],newer_node->c[1],newer_node->c[2]);
-			
-			g2o::VertexPointXYZ* v= new g2o::VertexPointXYZ();
-			v->setEstimate(norm_newer);
-			v->setId(v_id++);
-			v->setMarginalized(true);
-			v->setFixed(false);
-			optimizer->addVertex(v);
-
-			g2o::EdgeSE3PointXYZ* e_older = new g2o::EdgeSE3PointXYZ();
-			e_older->vertices()[0] = dynamic_cast<g2o::OptimizableGraph::Vertex*>(cams.first); 
-			e_older->vertices()[1] = dynamic_cast<g2o::OptimizableGraph::Vertex*>(v);
-			e_older->setMeasurement(norm_older);
-			//e_older->information() = compPt3dCov(pt_older, fx, fy, cu, cv).cast<double>().inverse();
-			g2o::RobustKernelHuber* rk = new g2o::RobustKernelHuber;
-			rk->setDelta(5.99);
-			e_older->setRobustKernel(rk);
-			e_older->setParameterId(0,1);
-			optimizer->addEdge(e_older);
-			
-			g2o::EdgeSE3PointXYZ* e_newer = new g2o::EdgeSE3PointXYZ();
-			e_newer->vertices()[0] = dynamic_cast<g2o::OptimizableGraph::Vertex*>(cams.second); 
-			e_newer->vertices()[1] = dynamic_cast<g2o::OptimizableGraph::Vertex*>(v);
-			e_newer->setMeasurement(norm_newer);
-			//e_newer->information() = compPt3dCov(pt_newer, fx, fy, cu, cv).cast<double>().inverse();
-			g2o::RobustKernelHuber* rk1 = new g2o::RobustKernelHuber;
-			rk1->setDelta(5.99);
-			e_newer->setRobustKernel(rk1);
-			e_newer->setParameterId(0,1);
-			optimizer->addEdge(e_newer);
-			
-			pt_edges.push_back(e_older);
-			pt_edges.push_back(e_newer);
-		}
-	}	
-#endif
-		
-		
-	  
-      // ************** point matches *****************//
-#ifdef POINT
-	//cout<<"Point matches:"<<matches_with_depth.size();
-	BOOST_FOREACH(const cv::DMatch& m, matches_with_depth)
-	{
-		Eigen::Vector3f pt_older = earlier_node->feature_locations_3d_[m.queryIdx].head<3>();
-		Eigen::Vector3f pt_newer = newer_node->feature_locations_3d_[m.trainIdx].head<3>();
-
-		g2o::VertexPointXYZ* v = new g2o::VertexPointXYZ(); 
-		v->setEstimate(pt_newer.cast<double>());
-		v->setId(v_id++);
-		v->setMarginalized(true);
-		v->setFixed(false);
-		optimizer->addVertex(v);
-		
-		g2o::EdgeSE3PointXYZ* e_older = new g2o::EdgeSE3PointXYZ();
-		e_older->vertices()[0] = dynamic_cast<g2o::OptimizableGraph::Vertex*>(cams.first); 
-		e_older->vertices()[1] = dynamic_cast<g2o::OptimizableGraph::Vertex*>(v);
-		e_older->setMeasurement(pt_older.cast<double>());
-		e_older->information() = compPt3dCov(pt_older, fx, fy, cu, cv).cast<double>().inverse();
-		g2o::RobustKernelHuber* rk = new g2o::RobustKernelHuber;
-		rk->setDelta(5.99);
-		e_older->setRobustKernel(rk);
-		e_older->setParameterId(0,1);
-		optimizer->addEdge(e_older);
-		
-		g2o::EdgeSE3PointXYZ* e_newer = new g2o::EdgeSE3PointXYZ();
-		e_newer->vertices()[0] = dynamic_cast<g2o::OptimizableGraph::Vertex*>(cams.second); 
-		e_newer->vertices()[1] = dynamic_cast<g2o::OptimizableGraph::Vertex*>(v);
-		e_newer->setMeasurement(pt_newer.cast<double>());
-		e_newer->information() = compPt3dCov(pt_newer, fx, fy, cu, cv).cast<double>().inverse();
-		g2o::RobustKernelHuber* rk1 = new g2o::RobustKernelHuber;
-		rk1->setDelta(5.99);
-		e_newer->setRobustKernel(rk1);
-		e_newer->setParameterId(0,1);
-		optimizer->addEdge(e_newer);
-		
-		pt_edges.push_back(e_older);
-		pt_edges.push_back(e_newer);
-		
-	}
-#endif
-  
-      //*************** line matches ****************//
-#ifdef LINE
-      //cout<<"    Line matches:"<<ln_matches.size()<<endl;
-      BOOST_FOREACH(const cv::DMatch& m, ln_matches) 
-      {
-		g2o::VertexLineEndpts* v = new g2o::VertexLineEndpts();
-		Eigen::Vector6d line_new;
-		
-		line_new << newer_node->lines[m.trainIdx].line3d.A.x, newer_node->lines[m.trainIdx].line3d.A.y, newer_node->lines[m.trainIdx].line3d.A.z,
-				newer_node->lines[m.trainIdx].line3d.B.x, newer_node->lines[m.trainIdx].line3d.B.y, newer_node->lines[m.trainIdx].line3d.B.z; 
-		
-		//cout<<"Line new:"<<line_new<<endl;
-		// line represented wrt the newer node (second, fixed one)
-		v->setEstimate(line_new); 
-		v->setId(v_id++);
-		v->setMarginalized(true);
-		v->setFixed(false);
-		optimizer->addVertex(v);
-
-		// create edges between line and cams    
-		// newer node
-		g2o::EdgeSE3LineEndpts * e_newer = new g2o::EdgeSE3LineEndpts();
-		e_newer->vertices()[0] = dynamic_cast<g2o::OptimizableGraph::Vertex*>(cams.second); 
-		e_newer->vertices()[1] = dynamic_cast<g2o::OptimizableGraph::Vertex*>(v);
-		e_newer->setMeasurement(line_new);
-		e_newer->information() = Matrix6d::Identity() ;//* sysPara.g2o_line_error_weight;  // must be identity!
-		cv::Mat covA = newer_node->lines[m.trainIdx].line3d.rndA.cov;
-		cv::Mat covB = newer_node->lines[m.trainIdx].line3d.rndB.cov;            
-		e_newer->endptCov = Matrix6d::Identity();
-		for(int ii=0; ii<3; ++ii) {
-			for(int jj=0; jj<3; ++jj) {
-			e_newer->endptCov(ii,jj) = covA.at<double>(ii,jj);
-			e_newer->endptCov(ii+3,jj+3) = covB.at<double>(ii,jj);
-			}
-		}       
-
-		{
-			Eigen::JacobiSVD<Eigen::Matrix3d> svd(e_newer->endptCov.block<3,3>(0,0),Eigen::ComputeFullU);
-			Eigen::Matrix3d D_invsqrt;
-			D_invsqrt.fill(0);
-			D_invsqrt(0,0) = sqrt(1/svd.singularValues()(0));
-			D_invsqrt(1,1) = sqrt(1/svd.singularValues()(1));
-			D_invsqrt(2,2) = sqrt(1/svd.singularValues()(2));
-			Eigen::Matrix3d am = D_invsqrt * svd.matrixU().transpose();
-			e_newer->endpt_AffnMat.block<3,3>(0,0) = am;
-		}
-		{
-			Eigen::JacobiSVD<Eigen::Matrix3d> svd(e_newer->endptCov.block<3,3>(3,3),Eigen::ComputeFullU);
-			Eigen::Matrix3d D_invsqrt;
-			D_invsqrt.fill(0);
-			D_invsqrt(0,0) = sqrt(1/svd.singularValues()(0));
-			D_invsqrt(1,1) = sqrt(1/svd.singularValues()(1));
-			D_invsqrt(2,2) = sqrt(1/svd.singularValues()(2));
-			Eigen::Matrix3d am = D_invsqrt * svd.matrixU().transpose();
-			e_newer->endpt_AffnMat.block<3,3>(3,3) = am;
-		}
-		g2o::RobustKernelHuber* rk = new g2o::RobustKernelHuber;
-		rk->setDelta(5.99);
-		e_newer->setRobustKernel(rk);
-		e_newer->setParameterId(0,1);// param id 0 of the edge corresponds to param id 1 of the optimizer     
-		optimizer->addEdge(e_newer);    
-		
-		//// edge to older node
-		g2o::EdgeSE3LineEndpts* e_older = new g2o::EdgeSE3LineEndpts();
-		e_older->vertices()[0] = dynamic_cast<g2o::OptimizableGraph::Vertex*>(cams.first); 
-		e_older->vertices()[1] = dynamic_cast<g2o::OptimizableGraph::Vertex*>(v);
-		Eigen::Vector6d line_older;
-		line_older << earlier_node->lines[m.queryIdx].line3d.A.x, earlier_node->lines[m.queryIdx].line3d.A.y, earlier_node->lines[m.queryIdx].line3d.A.z,
-				earlier_node->lines[m.queryIdx].line3d.B.x, earlier_node->lines[m.queryIdx].line3d.B.y, earlier_node->lines[m.queryIdx].line3d.B.z;
-		e_older->setMeasurement(line_older);
-		e_older->information() = Eigen::Matrix6d::Identity();// * sysPara.g2o_line_error_weight;  // must be identity!
-		covA = earlier_node->lines[m.queryIdx].line3d.rndA.cov;            
-		covB = earlier_node->lines[m.queryIdx].line3d.rndB.cov;
-		e_older->endptCov = Eigen::Matrix6d::Identity() ;
-		for(int ii=0; ii<3; ++ii) {
-			for(int jj=0; jj<3; ++jj) {
-			e_older->endptCov(ii,jj) = covA.at<double>(ii,jj);
-			e_older->endptCov(ii+3,jj+3) = covB.at<double>(ii,jj);
-			}
-		}
-
-		{
-			Eigen::JacobiSVD<Eigen::Matrix3d> svd(e_older->endptCov.block<3,3>(0,0),Eigen::ComputeFullU);
-			Eigen::Matrix3d D_invsqrt;
-			D_invsqrt.fill(0);
-			D_invsqrt(0,0) = sqrt(1/svd.singularValues()(0));
-			D_invsqrt(1,1) = sqrt(1/svd.singularValues()(1));
-			D_invsqrt(2,2) = sqrt(1/svd.singularValues()(2));
-			Eigen::Matrix3d am = D_invsqrt * svd.matrixU().transpose();
-			e_older->endpt_AffnMat.block<3,3>(0,0) = am;
-		}
-		
-		{
-			Eigen::JacobiSVD<Eigen::Matrix3d> svd(e_older->endptCov.block<3,3>(3,3),Eigen::ComputeFullU);
-			Eigen::Matrix3d D_invsqrt;
-			D_invsqrt.fill(0);
-			D_invsqrt(0,0) = sqrt(1/svd.singularValues()(0));
-			D_invsqrt(1,1) = sqrt(1/svd.singularValues()(1));
-			D_invsqrt(2,2) = sqrt(1/svd.singularValues()(2));
-			Eigen::Matrix3d am = D_invsqrt * svd.matrixU().transpose();
-			e_older->endpt_AffnMat.block<3,3>(3,3) = am;
-		}
-		g2o::RobustKernelHuber* rk1 = new g2o::RobustKernelHuber;
-		rk1->setDelta(5.99);
-		e_older->setRobustKernel(rk1);
-		e_older->setParameterId(0,1);
-		optimizer->addEdge(e_older); 
-
-		ln_edges.push_back(e_newer);
-		ln_edges.push_back(e_older); 
-      }
-#endif
-
-	optimizer->setVerbose(false);
-	optimizer->initializeOptimization();
-#ifdef VERBOSE
-	double pterr = 0, lnerr = 0;
-	for(int i=0; i<pt_edges.size();++i)
-	{
-		pt_edges[i]->computeError();
-		pterr += pt_edges[i]->chi2();
-	}
-	for(int i=0; i<ln_edges.size();++i) 
-	{
-		ln_edges[i]->computeError();
-		lnerr += ln_edges[i]->chi2();
-	}
-	//cout<<"Original:"<<pterr<<" \t "<<lnerr<<" \t "<<lnerr/(pterr+lnerr)<<endl;
-#endif
-      
-      optimizer->optimize(100);
-      
-#ifdef VERBOSE
-      pterr = 0, lnerr = 0;
-      for(int i=0; i<pt_edges.size();++i) {
-		pt_edges[i]->computeError();
-		pterr += pt_edges[i]->chi2();
-      }
-      for(int i=0; i<ln_edges.size();++i) {
-		ln_edges[i]->computeError();
-		lnerr += ln_edges[i]->chi2();
-      }
-      //cout<<"After:   "<<pterr<<" \t "<<lnerr<<" \t "<<lnerr/(pterr+lnerr)<<endl;
-#endif
-      /*
-       *Eigen::Matrix4f rst = vc1->estimate().cast<float>().inverse().matrix();
-		for(int i=0; i<3; ++i) {
-			t.at<double>(i) = rst(i,3);
-			for(int j=0; j<3; ++j) 
-				R.at<double>(i,j) = rst(i,j);
-		}
-       */
-      transformation_estimate = cams.second->estimate().cast<float>().matrix();
-      delete optimizer;
-	  return cams.second->estimate();
-}  
-
-
-
-bool computeRelativeMotion_svd (vector<RandomLine3d> a, vector<RandomLine3d> b, cv::Mat& R, cv::Mat& t)
-	// input needs at least 2 correspondences of non-parallel lines
-	// the resulting R and t works as below: x'=Rx+t for point pair(x,x');
-{
-	if(a.size()<2)	{return false;}
-	// convert to the representation of Zhang's paper
-	for(int i=0; i<a.size(); ++i) {
-		cv::Point3d l, m;
-		if(cv::norm(a[i].u)<0.9) {
-			l = a[i].B - a[i].A;
-			m = (a[i].A + a[i].B) * 0.5;
-			a[i].u = l * (1/cv::norm(l));
-			a[i].d = a[i].u.cross(m);
-		}
-		if(cv::norm(b[i].u)<0.9){		
-			l = b[i].B - b[i].A;
-			m = (b[i].A + b[i].B) * 0.5;
-			b[i].u = l * (1/cv::norm(l));
-			b[i].d = b[i].u.cross(m);
-		}
-	}
-
-	cv::Mat A = cv::Mat::zeros(4,4,CV_64F);
-	for(int i=0; i<a.size(); ++i) {
-		cv::Mat Ai = cv::Mat::zeros(4,4,CV_64F);
-		Ai.at<double>(0,1) = (a[i].u-b[i].u).x;
-		Ai.at<double>(0,2) = (a[i].u-b[i].u).y;
-		Ai.at<double>(0,3) = (a[i].u-b[i].u).z;
-		Ai.at<double>(1,0) = (b[i].u-a[i].u).x;
-		Ai.at<double>(2,0) = (b[i].u-a[i].u).y;
-		Ai.at<double>(3,0) = (b[i].u-a[i].u).z;
-		vec2SkewMat(a[i].u+b[i].u).copyTo(Ai.rowRange(1,4).colRange(1,4));
-		A = A + Ai.t()*Ai;
-	}
-	cv::SVD svd(A);
-	cv::Mat q = svd.u.col(3);
-	//cout<<"q="<<q<<endl;
-	R = q2r(q);
-	cv::Mat uu = cv::Mat::zeros(3,3,CV_64F),
-		udr= cv::Mat::zeros(3,1,CV_64F);
-	for(int i=0; i<a.size(); ++i) {
-		uu = uu + vec2SkewMat(b[i].u)*vec2SkewMat(b[i].u).t();
-		udr = udr + vec2SkewMat(b[i].u).t()* (cvpt2mat(b[i].d,0)-R*cvpt2mat(a[i].d,0));
-	}
-	t = uu.inv()*udr;	
-	return true;
-}
-
-bool isSamePlane(vector<double> a, vector<double> b)
-{
-	if(a[0]*b[0]+a[1]*b[1]+a[2]*b[2]>0.95&&abs(a[3]-b[3])<0.05)
-	{
-		cout<<"A:"<<a[0]<<" "<<a[1]<<" "<<a[2]<<" "<<a[3]<<endl;
-		cout<<"B:"<<b[0]<<" "<<b[1]<<" "<<b[2]<<" "<<b[3]<<endl;
-		return true;
-	}
-	else return false;
-}
-
-Eigen::Matrix4f getIcpAlignment(Frame* queryNode,  Frame* trainNode)
-{
-	PointCloud::Ptr cloud1(new PointCloud);
-	PointCloud::Ptr cloud2(new PointCloud); 
-	
-	//cloud1 = queryNode->img2cloud();
-	//cloud2 = trainNode->img2cloud();
-	
-	cloud1 = queryNode->planeExtraction();
-	cloud2 = trainNode->planeExtraction();
-	
-	
-    ///////////////////////////
-	/*
-	MyTimer timer;
-	timer.start();
-	vector<vector<double>> e1,e2;
-	queryNode->planeEquation(e1);
-	trainNode->planeEquation(e2);
-	
-	timer.end();
-	timer.start();
-	
-	cout<<"Plane matches:"<<endl;
-	for(int i=0; i<e1.size();i++)
-	{
-		for(int j=0; j<e2.size();j++)
-		{
-			isSamePlane(e1[i],e2[j]);
-		}
-	}
-	timer.end();
-	*/
-	//////////////////////////////
-	
-	//pcl::visualization::CloudViewer viewer ("Cluster viewer");
-	//viewer.showCloud(cloud2);
-	//while (!viewer.wasStopped ()){}
-	
-	pcl::IterativeClosestPoint<PointT, PointT> icp;
-	icp.setInputCloud(cloud1);
-	icp.setInputTarget(cloud2);
-	PointCloud Final;
-	icp.align(Final);
-	cout << "has converged:" << icp.hasConverged() 
-		<<" score: " <<icp.getFitnessScore() << endl;
-	//cout << icp.getFinalTransformation() <<endl;
-	
-	return icp.getFinalTransformation();
-}
-
-
-Eigen::Matrix4f getTransform_Lns_Pts_pcl( const Frame* queryNode, const Frame* trainNode,
-					const std::vector<cv::DMatch>& point_matches_ori,
-					const std::vector<cv::DMatch>& line_matches, bool& valid)
-// Note: the result transforms a point from the queryNode's CS to the trainNode's CS
-{
-    std::vector<cv::DMatch> point_matches;
-	BOOST_FOREACH(const cv::DMatch& m, point_matches_ori)
-	{
-	    Point2f kp1 = queryNode->feature_locations_2d_[m.queryIdx].pt;
-	    Point2f kp2 = trainNode->feature_locations_2d_[m.trainIdx].pt;
-
-	    
-	    float depth1 = queryNode->feature_locations_3d_[m.queryIdx](2);
-	    float depth2 = trainNode->feature_locations_3d_[m.trainIdx](2);
-	    
-	    if( depth1>=1e-3&&depth1<=10&&depth2>=1e-3&&depth2<=10
-	      &&(kp1.x>=1&&kp1.x<=640&&kp1.y>=1&&kp1.y<=480)
-	      &&(kp2.x>=1&&kp2.x<=640&&kp2.y>=1&&kp2.y<=480))
-	    {
-			point_matches.push_back(m);
-	    }
-	}
-    
-	if(point_matches.size()<1 || point_matches.size()+line_matches.size()<3) { 
-		valid = false;
-		return Eigen::Matrix4f();
-	}
-	pcl::TransformationFromCorrespondences tfc;
-
-	//// project the point to all lines
-	for(int i=0; i < line_matches.size(); ++i) 
-	{
-		int ptidx = rand()%point_matches.size();
-		cv::Point3d query_pt(queryNode->feature_locations_3d_[point_matches[ptidx].queryIdx](0),
-  				     queryNode->feature_locations_3d_[point_matches[ptidx].queryIdx](1),
-  				     queryNode->feature_locations_3d_[point_matches[ptidx].queryIdx](2));
-		
-		cv::Point3d train_pt(trainNode->feature_locations_3d_[point_matches[ptidx].trainIdx](0),
-  				     trainNode->feature_locations_3d_[point_matches[ptidx].trainIdx](1),
-  				     trainNode->feature_locations_3d_[point_matches[ptidx].trainIdx](2));
-		
-		const cv::DMatch& m = line_matches[i];
-		cv::Point3d query_prj = projectPt3d2Ln3d_2 (query_pt, queryNode->lines[m.queryIdx].line3d.A, queryNode->lines[m.queryIdx].line3d.B);
-		cv::Point3d train_prj = projectPt3d2Ln3d_2 (train_pt, trainNode->lines[m.trainIdx].line3d.A, trainNode->lines[m.trainIdx].line3d.B);
-  		
-  		Eigen::Vector3f from(query_prj.x, query_prj.y, query_prj.z);
-  		Eigen::Vector3f to(train_prj.x, train_prj.y, train_prj.z);
-  		if(isnan(from(2)) || isnan(to(2))) 
-			continue;
-  		float weight =1/(abs(to[2]) + abs(from[2]));
-  		tfc.add(from, to, weight);
-	}
-	
-	//// add points to the tfc
-	for(int i=0; i<point_matches.size();++i) {
-		const cv::DMatch& m = point_matches[i];
-		Eigen::Vector3f from = queryNode->feature_locations_3d_[m.queryIdx].head<3>();
-  		Eigen::Vector3f to = trainNode->feature_locations_3d_[m.trainIdx].head<3>();
-  		if(isnan(from(2)) || isnan(to(2)))
-  			continue;
-  		float weight = 1.0;
-  		weight =1/(abs(to[2]) + abs(from[2]));
-  		tfc.add(from, to, weight);
-  	}
-
-	if(tfc.getNoOfSamples()<3)
-		valid = false;
-  	else
-  		valid = true;
-	//get relative movement from samples
-  	return tfc.getTransformation().matrix();
-}
-
-
-Eigen::Isometry3d getTransform_Line_svd(const Frame* queryNode, const Frame* trainNode, 
-				      const std::vector<cv::DMatch>& matches,
-				      bool& valid)
-// Note: the result transforms a point from the queryNode's CS to the trainNode's CS
-{
-	if(matches.size()<2) {
-		valid = false;
-		return Eigen::Isometry3d::Identity();
-	}
-	vector<RandomLine3d>  query(matches.size()), train(matches.size());
-	for(int i=0; i<matches.size(); ++i) {
-		query[i] = queryNode->lines[matches[i].queryIdx].line3d;
-		train[i] = trainNode->lines[matches[i].trainIdx].line3d;
-	}
-	cv::Mat R, t;
-	valid = computeRelativeMotion_svd (query, train, R, t);
-	Eigen::Matrix4f tf;
-	tf << R.at<double>(0,0), R.at<double>(0,1), R.at<double>(0,2), t.at<double>(0),
-	      R.at<double>(1,0), R.at<double>(1,1), R.at<double>(1,2), t.at<double>(1),
-	      R.at<double>(2,0), R.at<double>(2,1), R.at<double>(2,2), t.at<double>(2),
-	      0, 0, 0, 1;
-	
-	Eigen::Matrix3d rot;
-	rot << R.at<double>(0,0), R.at<double>(0,1), R.at<double>(0,2),
-	      R.at<double>(1,0), R.at<double>(1,1), R.at<double>(1,2),
-	      R.at<double>(2,0), R.at<double>(2,1), R.at<double>(2,2);
-	
-	Eigen::AngleAxisd v;
-	v.fromRotationMatrix(rot);
-	
-	Eigen::Isometry3d res = Eigen::Isometry3d::Identity();
-	res.rotate(v);
-	res.pretranslate(Eigen::Vector3d(t.at<double>(0),t.at<double>(1),t.at<double>(2)));
-
-	return res;
-}
-
-
-double errorFunction(const Eigen::Vector4f& x1, const Eigen::Vector4f& x2,
-                      const Eigen::Matrix4d& transformation)
-{
-	//Take from paramter_server or cam info
-	static const double cam_angle_x = 58.0/180.0*M_PI;
-	static const double cam_angle_y = 45.0/180.0*M_PI;
-	static const double cam_resol_x = 640;
-	static const double cam_resol_y = 480;
-	static const double raster_stddev_x = 3*tan(cam_angle_x/cam_resol_x);  //5pix stddev in x
-	static const double raster_stddev_y = 3*tan(cam_angle_y/cam_resol_y);  //5pix stddev in y
-	static const double raster_cov_x = raster_stddev_x * raster_stddev_x;
-	static const double raster_cov_y = raster_stddev_y * raster_stddev_y;
-	static const bool 	use_error_shortcut = true;
-
-	bool nan1 = isnan(x1(2));
-	bool nan2 = isnan(x2(2));
-	if(nan1||nan2){
-		return std::numeric_limits<double>::max();
-	}
-	Eigen::Vector4d x_1 = x1.cast<double>();
-	Eigen::Vector4d x_2 = x2.cast<double>();
-
-	Eigen::Matrix4d tf_21 = transformation.inverse();
-
-	Eigen::Vector3d mu_1 = x_1.head<3>();
-	Eigen::Vector3d mu_2 = x_2.head<3>();
-	Eigen::Vector3d mu_1_in_frame_2 = (tf_21 * x_1).head<3>(); // μ₁⁽²⁾  = T₁₂ μ₁⁽¹⁾  
-	//New Shortcut to determine clear outliers
-	if(use_error_shortcut)
-	{
-		double delta_sq_norm = (mu_1_in_frame_2 - mu_2).squaredNorm();
-		double sigma_max_1 = std::max(raster_cov_x, depth_covariance(mu_1(2)));//Assuming raster_cov_x and _y to be approx. equal
-		double sigma_max_2 = std::max(raster_cov_x, depth_covariance(mu_2(2)));//Assuming raster_cov_x and _y to be approx. equal
-		if(delta_sq_norm > 2.0 * (sigma_max_1+sigma_max_2)) //Factor 3 for mahal dist should be gotten from caller
-		{
-			return std::numeric_limits<double>::max();
-		}
-	} 
-
-	Eigen::Matrix3d rotation_mat = tf_21.block(0,0,3,3);
-
-	//Point 1
-	Eigen::Matrix3d cov1 = Eigen::Matrix3d::Zero();
-	cov1(0,0) = 1 * raster_cov_x * mu_1(2); //how big is 1px std dev in meter, depends on depth
-	cov1(1,1) = 1 * raster_cov_y * mu_1(2); //how big is 1px std dev in meter, depends on depth
-	if(nan1) cov1(2,2) = 1e9; //stddev for unknown: should be within 100m
-	else     cov1(2,2) = depth_covariance(mu_1(2));
-
-	//Point2
-	Eigen::Matrix3d cov2 = Eigen::Matrix3d::Zero();
-	cov2(0,0) = 1 * raster_cov_x* mu_2(2); //how big is 1px std dev in meter, depends on depth
-	cov2(1,1) = 1 * raster_cov_y* mu_2(2); //how big is 1px std dev in meter, depends on depth
-	if(nan2) cov2(2,2) = 1e9; 			   //stddev for unknown: should be within 100m
-	else     cov2(2,2) = depth_covariance(mu_2(2));
-
-	Eigen::Matrix3d cov1_in_frame_2 = rotation_mat.transpose() * cov1 * rotation_mat;//Works since the cov is diagonal => Eig-Vec-Matrix is Identity
-
-	// Δμ⁽²⁾ =  μ₁⁽²⁾ - μ₂⁽²⁾
-	Eigen::Vector3d delta_mu_in_frame_2 = mu_1_in_frame_2 - mu_2;
-	if(std::isnan(delta_mu_in_frame_2(2))){
-		delta_mu_in_frame_2(2) = 0.0;//Hack: set depth error to 0 if NaN 
-	}
-	// Σc = (Σ₁ + Σ₂)
-	Eigen::Matrix3d cov_mat_sum_in_frame_2 = cov1_in_frame_2 + cov2;     
-	//ΔμT Σc⁻¹Δμ  
-	//double sqrd_mahalanobis_distance = delta_mu_in_frame_2.transpose() * cov_mat_sum_in_frame_2.inverse() * delta_mu_in_frame_2;
-	double sqrd_mahalanobis_distance = delta_mu_in_frame_2.transpose() *cov_mat_sum_in_frame_2.ldlt().solve(delta_mu_in_frame_2);
-	
-	if(!(sqrd_mahalanobis_distance >= 0.0))
-	{
-		return std::numeric_limits<double>::max();
-	}
-	return sqrd_mahalanobis_distance;
-}
-
-
-Eigen::Isometry3d getTransform_PtsLines_ransac (const Frame* queryNode, const Frame* trainNode, 
-			  const std::vector<cv::DMatch> all_point_matches,
-			  const std::vector<cv::DMatch> all_line_matches,
-			  std::vector<cv::DMatch>& output_point_inlier_matches,
-			  std::vector<cv::DMatch>& output_line_inlier_matches,
-			  Eigen::Matrix4f& ransac_tf, 
-			  float& inlier_rmse,  SystemParameters sysPara)
-// input: 3d point matches + 3d line matches
-// output: rigid transform between two frames
-{
-	
-	Eigen::Isometry3d resT;
-	int nPt = all_point_matches.size();
-	int nLn = all_line_matches.size();
-
-	int line_weight = 1;
-
-	vector<int> pt_indexes(nPt);
-	vector<int> ln_indexes(nLn);
-	for(int i=0; i<pt_indexes.size(); ++i)  pt_indexes[i] = i;
-	for(int i=0; i<ln_indexes.size(); ++i)  ln_indexes[i] = i;
-	
-	int minPtSetSize = min(2, nPt);
-	int minLnSetSize = min(2, nLn);
-	double ln_angle_thres_deg = sysPara.line3d_angle_relmotion;  //10
-	double mahdist4inlier = sysPara.max_mah_dist_for_inliers;    //3
-
-	std::vector<Eigen::Vector4f, Eigen::aligned_allocator<Eigen::Vector4f> > train_lines_A(nLn), train_lines_B(nLn), query_lines_A(nLn), query_lines_B(nLn);
-	for(int i=0; i<nLn; ++i) 
-	{
-	    cv::DMatch m = all_line_matches[i];
-	    train_lines_A[i] = (Eigen::Vector4f(trainNode->lines[m.trainIdx].line3d.A.x, trainNode->lines[m.trainIdx].line3d.A.y, trainNode->lines[m.trainIdx].line3d.A.z, 1));
-	    train_lines_B[i] = (Eigen::Vector4f(trainNode->lines[m.trainIdx].line3d.B.x, trainNode->lines[m.trainIdx].line3d.B.y, trainNode->lines[m.trainIdx].line3d.B.z, 1));
-	    query_lines_A[i] = (Eigen::Vector4f(queryNode->lines[m.queryIdx].line3d.A.x, queryNode->lines[m.queryIdx].line3d.A.y, queryNode->lines[m.queryIdx].line3d.A.z, 1));
-	    query_lines_B[i] = (Eigen::Vector4f(queryNode->lines[m.queryIdx].line3d.B.x, queryNode->lines[m.queryIdx].line3d.B.y, queryNode->lines[m.queryIdx].line3d.B.z, 1));
-	} 
-
-	int iter = 0; 	
-	float sum_squared_error = 1e9;
-	vector<cv::DMatch> max_point_inlier_set, max_line_inlier_set;
-	Eigen::Matrix4f tf_best;
-	
-	//Start Ransac
-	while (iter < 50) 
-	{
-		iter++;
-		std::vector<cv::DMatch> ptMch, lnMch;
-		random_unique(pt_indexes.begin(), pt_indexes.end(), minPtSetSize);
-		for(int i=0; i<minPtSetSize; ++i) 
-		{ 
-			ptMch.push_back(all_point_matches[pt_indexes[i]]);
-		}
-		
-		
-		random_unique(ln_indexes.begin(), ln_indexes.end(), minLnSetSize);
-		for(int i=0; i<minLnSetSize; ++i) 
-		{
-			lnMch.push_back(all_line_matches[ln_indexes[i]]);
-		}
-		
-		Eigen::Matrix4f tf;
-		
-		float sse = 0;
-		
-		getTransformFromHybridMatchesG2O(queryNode,trainNode,  ptMch, lnMch, tf, 25, sysPara);
-
-		///// evaluate minimal solution /////
-		vector<cv::DMatch> inlier_point_matches, inlier_line_matches;
-		inlier_point_matches.reserve(nPt); 
-		inlier_line_matches.reserve(nLn);
-		Eigen::Matrix4d tf_d = tf.cast<double>();
-		for(int i=0; i<all_point_matches.size(); ++i)  
-		{
-			double mah_dist_sq = errorFunction(queryNode->feature_locations_3d_[all_point_matches[i].queryIdx], 
-							    trainNode->feature_locations_3d_[all_point_matches[i].trainIdx], tf_d);
-			if (mah_dist_sq < mahdist4inlier * mahdist4inlier) 
-			{
-				inlier_point_matches.push_back(all_point_matches[i]);
-				sse += mah_dist_sq; 
-			}        	
-		}
-		for(int i=0; i<all_line_matches.size(); ++i) 
-		{
-			Eigen::Vector4f qA_tf = tf * query_lines_A[i];
-			Eigen::Vector4f qB_tf = tf * query_lines_B[i];		
-			cv::Point3d qA_in_train(qA_tf(0),qA_tf(1),qA_tf(2));
-			cv::Point3d qB_in_train(qB_tf(0),qB_tf(1),qB_tf(2));
-			double mah_dist_a = mah_dist3d_pt_line(trainNode->lines[all_line_matches[i].trainIdx].line3d.rndA, qA_in_train, qB_in_train) ;
-			double mah_dist_b = mah_dist3d_pt_line(trainNode->lines[all_line_matches[i].trainIdx].line3d.rndB, qA_in_train, qB_in_train);			
-			if(mah_dist_a < mahdist4inlier && mah_dist_b < mahdist4inlier) 
-			{
-				inlier_line_matches.push_back(all_line_matches[i]);
-				sse += mah_dist_a * mah_dist_a + mah_dist_b * mah_dist_b;
-			}		
-		
-
-			double dist = 0.5*dist3d_pt_line (qA_in_train, trainNode->lines[all_line_matches[i].trainIdx].line3d.A, trainNode->lines[all_line_matches[i].trainIdx].line3d.B)
-				    + 0.5*dist3d_pt_line (qB_in_train, trainNode->lines[all_line_matches[i].trainIdx].line3d.A, trainNode->lines[all_line_matches[i].trainIdx].line3d.B);
-			cv::Point3d l1 = qA_in_train - qB_in_train;
-			cv::Point3d l2 = trainNode->lines[all_line_matches[i].trainIdx].line3d.A - trainNode->lines[all_line_matches[i].trainIdx].line3d.B;			
-			double angle = 180*acos(abs(l1.dot(l2)/cv::norm(l1)/cv::norm(l2)))/PI; 
-
-			if(dist < sysPara.pt2line3d_dist_relmotion && angle < sysPara.line3d_angle_relmotion) 
-			{
-				inlier_line_matches.push_back(all_line_matches[i]);
-				sse += mah_dist_a * mah_dist_a + mah_dist_b * mah_dist_b;
-			}
-		}
-		if(inlier_point_matches.size() + line_weight * inlier_line_matches.size() 
-			> max_point_inlier_set.size() + line_weight * max_line_inlier_set.size()) 
-		{
-			max_point_inlier_set = inlier_point_matches;
-			max_line_inlier_set  = inlier_line_matches;
-			tf_best = tf;
-			sum_squared_error = sse;
-		}
-	}
-
-	cout<<"RANSAC:"<<max_point_inlier_set.size()<<" "<<max_line_inlier_set.size()<<endl;
-	
-	///////// refine solution /////////
-	vector<cv::DMatch> refined_point_inliers, refined_line_inliers ;
-	Eigen::Matrix4f refined_tf = tf_best;
-	int tmp_best_line_mah;
-	resT = getTransformFromHybridMatchesG2O (queryNode,trainNode,  max_point_inlier_set, max_line_inlier_set, refined_tf, 25, sysPara);
-	double refined_rmse = sqrt(sum_squared_error/(max_point_inlier_set.size() + max_line_inlier_set.size()));
-
-	//return resT;
-
-	for(int iter = 0; iter <20; ++iter) {
-		vector<cv::DMatch> tmp_pt_inliers, tmp_ln_inliers;
-		tmp_pt_inliers.reserve(all_point_matches.size()); tmp_ln_inliers.reserve(all_line_matches.size());
-		double tmp_sse = 0;
-		
-		Eigen::Matrix4d refined_tf_d = refined_tf.cast<double>();
-        for(int i=0; i<all_point_matches.size(); ++i)  {
-        	double mah_dist_sq = errorFunction(queryNode->feature_locations_3d_[all_point_matches[i].queryIdx], 
-        		                             trainNode->feature_locations_3d_[all_point_matches[i].trainIdx], refined_tf_d);
-        	
-        	if (mah_dist_sq < mahdist4inlier * mahdist4inlier) {
-        		tmp_pt_inliers.push_back(all_point_matches[i]);
-        		tmp_sse += mah_dist_sq; 
-        	}        	
-        }
-
-        int tmp_line_mah_inlier = 0;
-        for(int i=0; i<all_line_matches.size(); ++i) {
-        	Eigen::Vector4f qA_tf = refined_tf * query_lines_A[i];
-        	Eigen::Vector4f qB_tf = refined_tf * query_lines_B[i];		
-			cv::Point3d qA_in_train(qA_tf(0),qA_tf(1),qA_tf(2)), qB_in_train(qB_tf(0),qB_tf(1),qB_tf(2));
-			double mah_dist_a = mah_dist3d_pt_line(trainNode->lines[all_line_matches[i].trainIdx].line3d.rndA, qA_in_train, qB_in_train); 
-			double mah_dist_b = mah_dist3d_pt_line(trainNode->lines[all_line_matches[i].trainIdx].line3d.rndB, qA_in_train, qB_in_train);
-			if(mah_dist_a < mahdist4inlier && mah_dist_b < mahdist4inlier) {
-				tmp_line_mah_inlier++;
-				tmp_ln_inliers.push_back(all_line_matches[i]);
-				tmp_sse += mah_dist_a * mah_dist_a + mah_dist_b * mah_dist_b;
-
-			}					
-			
-			double dist = 0.5*dist3d_pt_line (qA_in_train, trainNode->lines[all_line_matches[i].trainIdx].line3d.A, trainNode->lines[all_line_matches[i].trainIdx].line3d.B)
-						+ 0.5*dist3d_pt_line (qB_in_train, trainNode->lines[all_line_matches[i].trainIdx].line3d.A, trainNode->lines[all_line_matches[i].trainIdx].line3d.B);
-			cv::Point3d l1 = qA_in_train - qB_in_train, 
-				l2 = trainNode->lines[all_line_matches[i].trainIdx].line3d.A - trainNode->lines[all_line_matches[i].trainIdx].line3d.B;			
-			double angle = 180*acos(abs(l1.dot(l2)/cv::norm(l1)/cv::norm(l2)))/PI; 
-
-			if(dist < sysPara.pt2line3d_dist_relmotion && angle < sysPara.line3d_angle_relmotion) {
-				tmp_ln_inliers.push_back(all_line_matches[i]);
-				tmp_sse += mah_dist_a * mah_dist_a+ mah_dist_b * mah_dist_b;
-			}
-	
-        }
-        if( tmp_pt_inliers.size() + tmp_ln_inliers.size() * sysPara.line_match_number_weight 
-              > refined_point_inliers.size() + refined_line_inliers.size() * sysPara.line_match_number_weight)
-		{
-           	tmp_best_line_mah = tmp_line_mah_inlier;
-        	refined_point_inliers = tmp_pt_inliers;
-        	refined_line_inliers = tmp_ln_inliers;
-        	refined_rmse = sqrt(tmp_sse/(tmp_pt_inliers.size() + tmp_ln_inliers.size()));       
-        	resT = getTransformFromHybridMatchesG2O (queryNode,trainNode,refined_point_inliers, refined_line_inliers, refined_tf, 20, sysPara);
-
-        } else
-        	break;
-
-   	}
-
-	output_point_inlier_matches = refined_point_inliers;
-	output_line_inlier_matches = refined_line_inliers;
-	inlier_rmse = refined_rmse;
-	ransac_tf = refined_tf;
-	return resT;
-} 
\ No newline at end of file
+#include "utils.h"
+#include "frame.h"
+#include "edge_se3_lineendpts.h"
+#include "point_error.h"
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <random>
+#include <memory>
+
+#define OPT_USE_MAHDIST
+#define MOTION_USE_MAHDIST
+
+#define POINT
+#define LINE
+#define PLANE
+#define VERBOSE
+
+
+inline Eigen::Matrix3d point_information_matrix(double distance)
+{
+  Eigen::Matrix3d inf_mat = Eigen::Matrix3d::Identity();
+  inf_mat(2,2) = 1.0/depth_covariance(distance);
+  return inf_mat;
+}
+
+
+//!Set parameters for icp optimizer
+void optimizerSetup(g2o::SparseOptimizer& optimizer,cv::Mat K)
+{
+    //sparse optimizer
+    g2o::BlockSolverX::LinearSolverType * linearSolver = new g2o::LinearSolverCholmod<g2o ::BlockSolverX::PoseMatrixType>();
+    g2o::BlockSolverX * blocksolver = new g2o::BlockSolverX(linearSolver);
+    g2o::OptimizationAlgorithmLevenberg* algorithm = new g2o::OptimizationAlgorithmLevenberg(blocksolver);
+    optimizer.setAlgorithm(algorithm);
+    
+    //camera parameters
+    g2o::ParameterCamera* cameraParams = new g2o::ParameterCamera();
+    double fx = K.at<double>(0,0);
+    double fy = K.at<double>(1,1);
+    double cx = K.at<double>(0,2);
+    double cy = K.at<double>(1,2);
+    cameraParams->setKcam(fx,fy,cx,cy);
+    g2o::SE3Quat offset; // identity
+    cameraParams->setOffset(offset);
+    
+    cameraParams->setId(0);
+    optimizer.addParameter(cameraParams);
+}
+
+
+//first cam is fixed, transformation from the first to the second cam will be computed
+std::pair<g2o::VertexSE3*, g2o::VertexSE3*>  sensorVerticesSetup(g2o::SparseOptimizer& optimizer, Eigen::Matrix4f& tf_estimate)
+{
+    g2o::VertexSE3 *vc1 = new VertexSE3();
+    Eigen::Quaterniond q(tf_estimate.topLeftCorner<3,3>().cast<double>());//initialize rotation from estimate 
+    Eigen::Vector3d    t(tf_estimate.topRightCorner<3,1>().cast<double>());//initialize translation from estimate
+    g2o::SE3Quat cam(q,t);
+    vc1->setEstimate(g2o::SE3Quat());
+    vc1->setId(0);  
+    vc1->setFixed(true);
+    optimizer.addVertex(vc1);
+  
+    g2o::VertexSE3 *vc2 = new VertexSE3();
+    vc2->setEstimate(cam);
+    vc2->setId(1); 
+    vc2->setFixed(false);
+    optimizer.addVertex(vc2);
+    
+    // add to optimizer
+    return std::make_pair(vc1, vc2);
+}
+
+g2o::EdgeSE3PointXYZDepth* edgeToFeature(const Frame* node, unsigned int feature_id,
+                              g2o::VertexSE3* camera_vertex, g2o::VertexPointXYZ* feature_vertex)
+{
+    g2o::EdgeSE3PointXYZDepth* edge = new g2o::EdgeSE3PointXYZDepth();
+    cv::KeyPoint kp = node->feature_locations_2d_[feature_id];
+    Vector4f position = node->feature_locations_3d_[feature_id];
+    float d = position(2);
+  
+    feature_vertex->setEstimate(position.cast<double>().head<3>());
+    feature_vertex->setFixed(false);
+    
+    //cout<<kp.pt.x<<" "<<kp.pt.y<<" "<<d<<endl;
+    Eigen::Vector3d pix_d(kp.pt.x,kp.pt.y,d);  //
+    edge->setMeasurement(pix_d);
+    Eigen::Matrix3d info_mat = point_information_matrix(d);
+    edge->setInformation(info_mat);
+    
+ 
+    edge->setParameterId(0,0);
+    edge->setRobustKernel(new g2o::RobustKernelHuber());  //true
+    edge->vertices()[0] = camera_vertex;
+    edge->vertices()[1] = feature_vertex;
+   
+   
+    return edge;
+}
+
+//!Compute 
+void getTransformFromMatchesG2O(const Frame* earlier_node, const Frame* newer_node,
+                                const std::vector<cv::DMatch> & matches,
+                                Eigen::Matrix4f& transformation_estimate, 
+                                int iterations)
+{
+    std::vector<cv::DMatch> matches_with_depth;
+    BOOST_FOREACH(const cv::DMatch& m, matches)
+    {
+      
+		Point2f kp1 = earlier_node->feature_locations_2d_[m.queryIdx].pt;
+		Point2f kp2 = newer_node->feature_locations_2d_[m.trainIdx].pt;
+
+		
+		float depth1 = earlier_node->feature_locations_3d_[m.queryIdx](2);
+		float depth2 = newer_node->feature_locations_3d_[m.trainIdx](2);
+		
+		if( depth1>=1e-2&&depth1<=10&&depth2>=1e-2&&depth2<=10
+		&&(kp1.x>=1&&kp1.x<=640&&kp1.y>=1&&kp1.y<=480)
+		&&(kp2.x>=1&&kp2.x<=640&&kp2.y>=1&&kp2.y<=480))
+		{
+			matches_with_depth.push_back(m);
+		}
+    }
+    
+  
+    cout<<"matches_all       :"<<matches.size()<<endl;
+    cout<<"matches_with_depth:"<<matches_with_depth.size()<<endl;
+
+    g2o::SparseOptimizer* optimizer = new g2o::SparseOptimizer();
+    optimizerSetup(*optimizer, Frame::K);
+    Eigen::Matrix4f tfinv = transformation_estimate;//Eigen::Matrix4f::Identity();
+    std::pair<g2o::VertexSE3*, g2o::VertexSE3*> cams = sensorVerticesSetup(*optimizer, tfinv);
+
+    int v_id = optimizer->vertices().size(); //0 and 1 are taken by sensor vertices
+    
+    //For each match, create a vertex and connect it to the sensor vertices with the measured position
+    BOOST_FOREACH(const cv::DMatch& m, matches_with_depth)
+    {
+		g2o::VertexPointXYZ* v = new g2o::VertexPointXYZ();
+		v->setId(v_id++);
+		v->setMarginalized(true);
+		v->setFixed(false);
+		optimizer->addVertex(v);
+		
+		g2o::EdgeSE3PointXYZDepth* e1 = edgeToFeature(earlier_node, m.queryIdx, cams.first,  v);
+		optimizer->addEdge(e1);
+		
+		g2o::EdgeSE3PointXYZDepth* e2 = edgeToFeature(newer_node,   m.trainIdx, cams.second, v);
+		optimizer->addEdge(e2);  
+    }
+    
+    //start optimization
+    optimizer->setVerbose(false);
+    optimizer->initializeOptimization();
+    std::cout<<"g2o error "<< optimizer->activeChi2();
+    {
+        PROF_SCOPE(PROF_G2O);
+        optimizer->optimize(100);
+    }
+    std::cout<<" => " <<optimizer->activeChi2()<<std::endl;
+    
+    transformation_estimate = cams.second->estimate().cast<float>().matrix();
+    delete optimizer;
+}
+
+
+//!g2o problem of getTransformFromHybridMatchesG2O kept alive between calls (one per thread)
+//!vertices and edges are pooled and only re-parametrized, each call optimizes the edges it uses
+//!each call trims a pool to the landmarks it uses or to POOL_KEEP, whichever is more
+class HybridG2OContext
+{
+public:
+	static const size_t POOL_KEEP = 1024;
+
+	g2o::SparseOptimizer 	optimizer;
+	g2o::VertexSE3 			*cam1, *cam2;	//cam1 is fixed at the origin
+	
+	HybridG2OContext()
+	{
+		optimizerSetup(optimizer, Frame::K);
+		Eigen::Matrix4f tf = Eigen::Matrix4f::Identity();
+		std::pair<g2o::VertexSE3*, g2o::VertexSE3*> cams = sensorVerticesSetup(optimizer, tf);
+		cam1 = cams.first;
+		cam2 = cams.second;
+		next_id = optimizer.vertices().size();
+		
+		//add the parameter representing the sensor offset  
+		g2o::ParameterSE3Offset* sensorOffset = new g2o::ParameterSE3Offset;
+		sensorOffset->setOffset(Eigen::Isometry3d::Identity());
+		sensorOffset->setId(1);
+		optimizer.addParameter(sensorOffset);
+	}
+	
+	//!i-th point landmark with its edges to cam1 (older) and cam2 (newer)
+	void point(size_t i, g2o::VertexPointXYZ*& v, g2o::EdgeSE3PointXYZ*& e_older, g2o::EdgeSE3PointXYZ*& e_newer)
+	{
+		while(pt_vertices.size() <= i)
+		{
+			g2o::VertexPointXYZ* nv = new g2o::VertexPointXYZ();
+			addVertex(nv);
+			pt_vertices.push_back(nv);
+			pt_edges.push_back(newEdge<g2o::EdgeSE3PointXYZ>(cam1, nv, true));
+			pt_edges.push_back(newEdge<g2o::EdgeSE3PointXYZ>(cam2, nv, true));
+		}
+		v = pt_vertices[i];
+		e_older = pt_edges[2*i];
+		e_newer = pt_edges[2*i+1];
+	}
+	
+	void line(size_t i, g2o::VertexLineEndpts*& v, g2o::EdgeSE3LineEndpts*& e_older, g2o::EdgeSE3LineEndpts*& e_newer)
+	{
+		while(ln_vertices.size() <= i)
+		{
+			g2o::VertexLineEndpts* nv = new g2o::VertexLineEndpts();
+			addVertex(nv);
+			ln_vertices.push_back(nv);
+			ln_edges.push_back(newEdge<g2o::EdgeSE3LineEndpts>(cam1, nv, true));
+			ln_edges.push_back(newEdge<g2o::EdgeSE3LineEndpts>(cam2, nv, true));
+		}
+		v = ln_vertices[i];
+		e_older = ln_edges[2*i];
+		e_newer = ln_edges[2*i+1];
+	}
+	
+	void plane(size_t i, g2o::VertexPlane*& v, g2o::EdgeSE3Norm*& e_older, g2o::EdgeSE3Norm*& e_newer)
+	{
+		while(pl_vertices.size() <= i)
+		{
+			g2o::VertexPlane* nv = new g2o::VertexPlane();
+			addVertex(nv);
+			pl_vertices.push_back(nv);
+			pl_edges.push_back(newEdge<g2o::EdgeSE3Norm>(cam1, nv, false));
+			pl_edges.push_back(newEdge<g2o::EdgeSE3Norm>(cam2, nv, false));
+		}
+		v = pl_vertices[i];
+		e_older = pl_edges[2*i];
+		e_newer = pl_edges[2*i+1];
+	}
+	
+	//!drops the pooled landmarks beyond the first max(n, POOL_KEEP) of each kind, with their edges
+	void trim(size_t n_pt, size_t n_ln, size_t n_pl)
+	{
+		trimPool(pt_vertices, pt_edges, max(n_pt, (size_t)POOL_KEEP));
+		trimPool(ln_vertices, ln_edges, max(n_ln, (size_t)POOL_KEEP));
+		trimPool(pl_vertices, pl_edges, max(n_pl, (size_t)POOL_KEEP));
+	}
+	
+private:
+	int next_id;
+	vector<g2o::VertexPointXYZ*> 	pt_vertices;
+	vector<g2o::EdgeSE3PointXYZ*> 	pt_edges;	//2 per vertex, older and newer
+	vector<g2o::VertexLineEndpts*> 	ln_vertices;
+	vector<g2o::EdgeSE3LineEndpts*> ln_edges;
+	vector<g2o::VertexPlane*> 		pl_vertices;
+	vector<g2o::EdgeSE3Norm*> 		pl_edges;
+	
+	void addVertex(g2o::OptimizableGraph::Vertex* v)
+	{
+		v->setId(next_id++);
+		v->setMarginalized(true);
+		v->setFixed(false);
+		optimizer.addVertex(v);
+	}
+	
+	template<class VertexT, class EdgeT>
+	void trimPool(vector<VertexT*>& vertices, vector<EdgeT*>& edges, size_t keep)
+	{
+		while(vertices.size() > keep)
+		{
+			optimizer.removeVertex(vertices.back());  //deletes its two edges
+			vertices.pop_back();
+			edges.resize(edges.size()-2);
+		}
+	}
+	
+	template<class EdgeT>
+	EdgeT* newEdge(g2o::VertexSE3* cam, g2o::OptimizableGraph::Vertex* v, bool sensorOffset)
+	{
+		EdgeT* e = new EdgeT();
+		e->vertices()[0] = cam;
+		e->vertices()[1] = v;
+		g2o::RobustKernelHuber* rk = new g2o::RobustKernelHuber;
+		rk->setDelta(5.99);
+		e->setRobustKernel(rk);
+		if(sensorOffset) e->setParameterId(0,1);// param id 0 of the edge corresponds to param id 1 of the optimizer
+		optimizer.addEdge(e);
+		return e;
+	}
+};
+
+static HybridG2OContext& hybridG2OContext()
+{
+	static thread_local HybridG2OContext ctx;
+	return ctx;
+}
+
+Eigen::Isometry3d getTransformFromHybridMatchesG2O (const Frame* earlier_node, const Frame* newer_node,
+                                       const std::vector<cv::DMatch> & pt_matches,
+                                       const std::vector<cv::DMatch> & ln_matches,
+                                       Eigen::Matrix4f& transformation_estimate, 
+                                       int iterations,  SystemParameters sysPara,
+                                       const std::vector<cv::DMatch> & pl_matches)
+{
+  
+	std::vector<cv::DMatch> matches_with_depth;
+	BOOST_FOREACH(const cv::DMatch& m, pt_matches)
+	{
+
+		Point2f kp1 = earlier_node->feature_locations_2d_[m.queryIdx].pt;
+		Point2f kp2 = newer_node->feature_locations_2d_[m.trainIdx].pt;
+
+		
+		float depth1 = earlier_node->feature_locations_3d_[m.queryIdx](2);
+		float depth2 = newer_node->feature_locations_3d_[m.trainIdx](2);
+		
+		if( depth1>=1e-2&&depth1<=10&&depth2>=1e-2&&depth2<=10
+			&&(kp1.x>=1&&kp1.x<=640&&kp1.y>=1&&kp1.y<=480)
+			&&(kp2.x>=1&&kp2.x<=640&&kp2.y>=1&&kp2.y<=480))
+		{
+			matches_with_depth.push_back(m);
+		}
+	}
+ 
+	//G2O Initialization, the pooled graph is reused and only the edges set below are optimized
+	HybridG2OContext& ctx = hybridG2OContext();
+	g2o::SparseOptimizer* optimizer = &ctx.optimizer;
+	
+	Eigen::Matrix4f tfinv = transformation_estimate;//Eigen::Matrix4f::Identity();//transformation_estimate.inverse();
+	ctx.cam2->setEstimate(Eigen::Isometry3d(tfinv.cast<double>()));
+	std::pair<g2o::VertexSE3*, g2o::VertexSE3*> cams = std::make_pair(ctx.cam1, ctx.cam2);
+	size_t n_pt = 0, n_ln = 0, n_pl = 0;
+	g2o::HyperGraph::EdgeSet active_edges;
+	
+	vector<g2o::EdgeSE3PointXYZ*>   pt_edges;
+	vector<g2o::EdgeSE3LineEndpts*> ln_edges;
+	vector<g2o::EdgeSE3Norm*> 		pl_edges;
+
+	//camera intrinsic parameters 
+	double  fx = Frame::K.at<double>(0,0), 
+			fy = Frame::K.at<double>(1,1),
+			cu = Frame::K.at<double>(0,2),
+			cv = Frame::K.at<double>(1,2);
+
+#ifdef SEGMENT
+	{
+		for(int ii=0; ii<1; ii++)
+		{
+			Eigen::Vector3d norm_older(earlier_node->c[0],earlier_node->c[1],earlier_node->c[2]);
+			Eigen::Vector3d norm_newer(newer_node->c[0],newer_node->c[1],newer_node->c[2]);
+			
+			g2o::VertexPointXYZ* v;
+			g2o::EdgeSE3PointXYZ *e_older, *e_newer;
+			ctx.point(n_pt++, v, e_older, e_newer);
+			v->setEstimate(norm_newer);
+
+			e_older->setMeasurement(norm_older);
+			e_older->information().setIdentity();
+			//e_older->information() = compPt3dCov(pt_older, fx, fy, cu, cv).cast<double>().inverse();
+			active_edges.insert(e_older);
+			
+			e_newer->setMeasurement(norm_newer);
+			e_newer->information().setIdentity();
+			//e_newer->information() = compPt3dCov(pt_newer, fx, fy, cu, cv).cast<double>().inverse();
+			active_edges.insert(e_newer);
+			
+			pt_edges.push_back(e_older);
+			pt_edges.push_back(e_newer);
+		}
+	}	
+#endif
+		
+		
+	  
+      // ************** point matches *****************//
+#ifdef POINT
+	//cout<<"Point matches:"<<matches_with_depth.size();
+	BOOST_FOREACH(const cv::DMatch& m, matches_with_depth)
+	{
+		Eigen::Vector3f pt_older = earlier_node->feature_locations_3d_[m.queryIdx].head<3>();
+		Eigen::Vector3f pt_newer = newer_node->feature_locations_3d_[m.trainIdx].head<3>();
+
+		g2o::VertexPointXYZ* v;
+		g2o::EdgeSE3PointXYZ *e_older, *e_newer;
+		ctx.point(n_pt++, v, e_older, e_newer);
+		v->setEstimate(pt_newer.cast<double>());
+		
+		e_older->setMeasurement(pt_older.cast<double>());
+		e_older->information() = compPt3dCov(pt_older, fx, fy, cu, cv).cast<double>().inverse();
+		active_edges.insert(e_older);
+		
+		e_newer->setMeasurement(pt_newer.cast<double>());
+		e_newer->information() = compPt3dCov(pt_newer, fx, fy, cu, cv).cast<double>().inverse();
+		active_edges.insert(e_newer);
+		
+		pt_edges.push_back(e_older);
+		pt_edges.push_back(e_newer);
+		
+	}
+#endif
+  
+      //*************** line matches ****************//
+#ifdef LINE
+      //cout<<"    Line matches:"<<ln_matches.size()<<endl;
+      BOOST_FOREACH(const cv::DMatch& m, ln_matches) 
+      {
+		g2o::VertexLineEndpts* v;
+		g2o::EdgeSE3LineEndpts *e_older, *e_newer;
+		ctx.line(n_ln++, v, e_older, e_newer);
+		Eigen::Vector6d line_new;
+		
+		line_new << newer_node->lines[m.trainIdx].line3d.A.x, newer_node->lines[m.trainIdx].line3d.A.y, newer_node->lines[m.trainIdx].line3d.A.z,
+				newer_node->lines[m.trainIdx].line3d.B.x, newer_node->lines[m.trainIdx].line3d.B.y, newer_node->lines[m.trainIdx].line3d.B.z; 
+		
+		//cout<<"Line new:"<<line_new<<endl;
+		// line represented wrt the newer node (second, fixed one)
+		v->setEstimate(line_new); 
+
+		// edges between line and cams    
+		// newer node
+		e_newer->setMeasurement(line_new);
+		e_newer->information() = Matrix6d::Identity() ;//* sysPara.g2o_line_error_weight;  // must be identity!
+		cv::Mat covA = newer_node->lines[m.trainIdx].line3d.rndA.cov;
+		cv::Mat covB = newer_node->lines[m.trainIdx].line3d.rndB.cov;            
+		e_newer->endptCov = Matrix6d::Identity();
+		for(int ii=0; ii<3; ++ii) {
+			for(int jj=0; jj<3; ++jj) {
+			e_newer->endptCov(ii,jj) = covA.at<double>(ii,jj);
+			e_newer->endptCov(ii+3,jj+3) = covB.at<double>(ii,jj);
+			}
+		}       
+
+		{
+			Eigen::JacobiSVD<Eigen::Matrix3d> svd(e_newer->endptCov.block<3,3>(0,0),Eigen::ComputeFullU);
+			Eigen::Matrix3d D_invsqrt;
+			D_invsqrt.fill(0);
+			D_invsqrt(0,0) = sqrt(1/svd.singularValues()(0));
+			D_invsqrt(1,1) = sqrt(1/svd.singularValues()(1));
+			D_invsqrt(2,2) = sqrt(1/svd.singularValues()(2));
+			Eigen::Matrix3d am = D_invsqrt * svd.matrixU().transpose();
+			e_newer->endpt_AffnMat.block<3,3>(0,0) = am;
+		}
+		{
+			Eigen::JacobiSVD<Eigen::Matrix3d> svd(e_newer->endptCov.block<3,3>(3,3),Eigen::ComputeFullU);
+			Eigen::Matrix3d D_invsqrt;
+			D_invsqrt.fill(0);
+			D_invsqrt(0,0) = sqrt(1/svd.singularValues()(0));
+			D_invsqrt(1,1) = sqrt(1/svd.singularValues()(1));
+			D_invsqrt(2,2) = sqrt(1/svd.singularValues()(2));
+			Eigen::Matrix3d am = D_invsqrt * svd.matrixU().transpose();
+			e_newer->endpt_AffnMat.block<3,3>(3,3) = am;
+		}
+		active_edges.insert(e_newer);
+		
+		//// edge to older node
+		Eigen::Vector6d line_older;
+		line_older << earlier_node->lines[m.queryIdx].line3d.A.x, earlier_node->lines[m.queryIdx].line3d.A.y, earlier_node->lines[m.queryIdx].line3d.A.z,
+				earlier_node->lines[m.queryIdx].line3d.B.x, earlier_node->lines[m.queryIdx].line3d.B.y, earlier_node->lines[m.queryIdx].line3d.B.z;
+		e_older->setMeasurement(line_older);
+		e_older->information() = Eigen::Matrix6d::Identity();// * sysPara.g2o_line_error_weight;  // must be identity!
+		covA = earlier_node->lines[m.queryIdx].line3d.rndA.cov;            
+		covB = earlier_node->lines[m.queryIdx].line3d.rndB.cov;
+		e_older->endptCov = Eigen::Matrix6d::Identity() ;
+		for(int ii=0; ii<3; ++ii) {
+			for(int jj=0; jj<3; ++jj) {
+			e_older->endptCov(ii,jj) = covA.at<double>(ii,jj);
+			e_older->endptCov(ii+3,jj+3) = covB.at<double>(ii,jj);
+			}
+		}
+
+		{
+			Eigen::JacobiSVD<Eigen::Matrix3d> svd(e_older->endptCov.block<3,3>(0,0),Eigen::ComputeFullU);
+			Eigen::Matrix3d D_invsqrt;
+			D_invsqrt.fill(0);
+			D_invsqrt(0,0) = sqrt(1/svd.singularValues()(0));
+			D_invsqrt(1,1) = sqrt(1/svd.singularValues()(1));
+			D_invsqrt(2,2) = sqrt(1/svd.singularValues()(2));
+			Eigen::Matrix3d am = D_invsqrt * svd.matrixU().transpose();
+			e_older->endpt_AffnMat.block<3,3>(0,0) = am;
+		}
+		
+		{
+			Eigen::JacobiSVD<Eigen::Matrix3d> svd(e_older->endptCov.block<3,3>(3,3),Eigen::ComputeFullU);
+			Eigen::Matrix3d D_invsqrt;
+			D_invsqrt.fill(0);
+			D_invsqrt(0,0) = sqrt(1/svd.singularValues()(0));
+			D_invsqrt(1,1) = sqrt(1/svd.singularValues()(1));
+			D_invsqrt(2,2) = sqrt(1/svd.singularValues()(2));
+			Eigen::Matrix3d am = D_invsqrt * svd.matrixU().transpose();
+			e_older->endpt_AffnMat.block<3,3>(3,3) = am;
+		}
+		active_edges.insert(e_older);
+
+		ln_edges.push_back(e_newer);
+		ln_edges.push_back(e_older); 
+      }
+#endif
+
+      //*************** plane matches ****************//
+#ifdef PLANE
+	BOOST_FOREACH(const cv::DMatch& m, pl_matches)
+	{
+		const FramePlane& pl_older = earlier_node->planes[m.queryIdx];
+		const FramePlane& pl_newer = newer_node->planes[m.trainIdx];
+		Eigen::Vector4d plane_older(pl_older.n.x, pl_older.n.y, pl_older.n.z, pl_older.d);
+		Eigen::Vector4d plane_newer(pl_newer.n.x, pl_newer.n.y, pl_newer.n.z, pl_newer.d);
+
+		// plane represented wrt the older node, which is fixed at the origin
+		g2o::VertexPlane* v;
+		g2o::EdgeSE3Norm *e_older, *e_newer;
+		ctx.plane(n_pl++, v, e_older, e_newer);
+		v->setEstimate(plane_older);
+
+		e_older->setMeasurement(plane_older);
+		e_older->information() = planeInformation(pl_older, sysPara);
+		active_edges.insert(e_older);
+
+		e_newer->setMeasurement(plane_newer);
+		e_newer->information() = planeInformation(pl_newer, sysPara);
+		active_edges.insert(e_newer);
+
+		pl_edges.push_back(e_older);
+		pl_edges.push_back(e_newer);
+	}
+#endif
+
+	//before initializeOptimization, the optimizer keeps no pointer to the removed ones
+	ctx.trim(n_pt, n_ln, n_pl);
+	if(active_edges.empty())
+		return cams.second->estimate();
+	optimizer->setVerbose(false);
+	optimizer->initializeOptimization(active_edges);
+#ifdef VERBOSE
+	double pterr = 0, lnerr = 0;
+	for(int i=0; i<pt_edges.size();++i)
+	{
+		pt_edges[i]->computeError();
+		pterr += pt_edges[i]->chi2();
+	}
+	for(int i=0; i<ln_edges.size();++i) 
+	{
+		ln_edges[i]->computeError();
+		lnerr += ln_edges[i]->chi2();
+	}
+	//cout<<"Original:"<<pterr<<" \t "<<lnerr<<" \t "<<lnerr/(pterr+lnerr)<<endl;
+#endif
+      
+      {
+        PROF_SCOPE(PROF_G2O);
+        optimizer->optimize(100);
+      }
+      
+#ifdef VERBOSE
+      pterr = 0, lnerr = 0;
+      for(int i=0; i<pt_edges.size();++i) {
+		pt_edges[i]->computeError();
+		pterr += pt_edges[i]->chi2();
+      }
+      for(int i=0; i<ln_edges.size();++i) {
+		ln_edges[i]->computeError();
+		lnerr += ln_edges[i]->chi2();
+      }
+      //cout<<"After:   "<<pterr<<" \t "<<lnerr<<" \t "<<lnerr/(pterr+lnerr)<<endl;
+#endif
+      /*
+       *Eigen::Matrix4f rst = vc1->estimate().cast<float>().inverse().matrix();
+		for(int i=0; i<3; ++i) {
+			t.at<double>(i) = rst(i,3);
+			for(int j=0; j<3; ++j) 
+				R.at<double>(i,j) = rst(i,j);
+		}
+       */
+      transformation_estimate = cams.second->estimate().cast<float>().matrix();
+	  return cams.second->estimate();
+}  
+
+
+
+bool computeRelativeMotion_svd (vector<RandomLine3d> a, vector<RandomLine3d> b, cv::Mat& R, cv::Mat& t)
+	// input needs at least 2 correspondences of non-parallel lines
+	// the resulting R and t works as below: x'=Rx+t for point pair(x,x');
+{
+	if(a.size()<2)	{return false;}
+	// convert to the representation of Zhang's paper
+	for(int i=0; i<a.size(); ++i) {
+		cv::Point3d l, m;
+		if(cv::norm(a[i].u)<0.9) {
+			l = a[i].B - a[i].A;
+			m = (a[i].A + a[i].B) * 0.5;
+			a[i].u = l * (1/cv::norm(l));
+			a[i].d = a[i].u.cross(m);
+		}
+		if(cv::norm(b[i].u)<0.9){		
+			l = b[i].B - b[i].A;
+			m = (b[i].A + b[i].B) * 0.5;
+			b[i].u = l * (1/cv::norm(l));
+			b[i].d = b[i].u.cross(m);
+		}
+	}
+
+	cv::Mat A = cv::Mat::zeros(4,4,CV_64F);
+	for(int i=0; i<a.size(); ++i) {
+		cv::Mat Ai = cv::Mat::zeros(4,4,CV_64F);
+		Ai.at<double>(0,1) = (a[i].u-b[i].u).x;
+		Ai.at<double>(0,2) = (a[i].u-b[i].u).y;
+		Ai.at<double>(0,3) = (a[i].u-b[i].u).z;
+		Ai.at<double>(1,0) = (b[i].u-a[i].u).x;
+		Ai.at<double>(2,0) = (b[i].u-a[i].u).y;
+		Ai.at<double>(3,0) = (b[i].u-a[i].u).z;
+		vec2SkewMat(a[i].u+b[i].u).copyTo(Ai.rowRange(1,4).colRange(1,4));
+		A = A + Ai.t()*Ai;
+	}
+	cv::SVD svd(A);
+	cv::Mat q = svd.u.col(3);
+	//cout<<"q="<<q<<endl;
+	R = q2r(q);
+	cv::Mat uu = cv::Mat::zeros(3,3,CV_64F),
+		udr= cv::Mat::zeros(3,1,CV_64F);
+	for(int i=0; i<a.size(); ++i) {
+		uu = uu + vec2SkewMat(b[i].u)*vec2SkewMat(b[i].u).t();
+		udr = udr + vec2SkewMat(b[i].u).t()* (cvpt2mat(b[i].d,0)-R*cvpt2mat(a[i].d,0));
+	}
+	t = uu.inv()*udr;	
+	return true;
+}
+
+double planeOverlap(const Frame* queryNode, const Frame* trainNode,
+		    const FramePlane& a, const FramePlane& b, const Eigen::Isometry3d& T)
+// ratio of a's image cells that fall into b's cells after being lifted onto plane a, moved by T and reprojected
+{
+	if(a.cells.empty() || b.cells.empty()) return 0;
+	const Camera& cam = Frame::camera;
+	const int cs = FramePlane::CELL_SIZE;
+	const int qCols = (queryNode->depth.cols+cs-1)/cs;
+	const int tCols = (trainNode->depth.cols+cs-1)/cs;
+	const int tRows = (trainNode->depth.rows+cs-1)/cs;
+	const Eigen::Vector3d n(a.n.x, a.n.y, a.n.z);
+	int hits = 0;
+	for(size_t i=0; i<a.cells.size(); ++i) {
+		const double u = (a.cells[i]%qCols + 0.5)*cs;
+		const double v = (a.cells[i]/qCols + 0.5)*cs;
+		const Eigen::Vector3d ray((u-cam.cx)/cam.fx, (v-cam.cy)/cam.fy, 1);
+		const double nr = n.dot(ray);
+		if(fabs(nr) < 1e-6) continue;
+		const double z = -a.d/nr;
+		if(z <= 0) continue;
+		const Eigen::Vector3d X = T*(z*ray);
+		if(X(2) <= 0) continue;
+		const int cu = (int)floor((cam.fx*X(0)/X(2)+cam.cx)/cs);
+		const int cv = (int)floor((cam.fy*X(1)/X(2)+cam.cy)/cs);
+		if(cu<0 || cu>=tCols || cv<0 || cv>=tRows) continue;
+		if(std::binary_search(b.cells.begin(), b.cells.end(), cv*tCols+cu)) ++hits;
+	}
+	return (double)hits/std::min(a.cells.size(), b.cells.size());
+}
+
+Eigen::Matrix3d planeInformation(const FramePlane& pl, const SystemParameters& sysPara)
+// rough planes (large fitting mse) are down-weighted
+{
+	double sd2 = sysPara.g2o_plane_dist_std*sysPara.g2o_plane_dist_std;
+	double s = 1 + pl.mse/sd2;
+	Eigen::Matrix3d info = Eigen::Matrix3d::Zero();
+	info(0,0) = info(1,1) = 1.0/(s*sysPara.g2o_plane_normal_std*sysPara.g2o_plane_normal_std);
+	info(2,2) = 1.0/(s*sd2);
+	return info;
+}
+
+bool isSamePlane(const FramePlane& a, const FramePlane& b, const Eigen::Isometry3d& T, SystemParameters& sysPara)
+// a is in the query CS and T transforms it to b's CS
+{
+	Eigen::Vector3d n = T.rotation()*Eigen::Vector3d(a.n.x, a.n.y, a.n.z);
+	double d = a.d - n.dot(T.translation());
+	double cosang = n(0)*b.n.x + n(1)*b.n.y + n(2)*b.n.z;
+	return cosang > cos(sysPara.plane_angle_match*PI/180) && fabs(d-b.d) < sysPara.plane_dist_match;
+}
+
+void matchPlanes(const Frame* queryNode, const Frame* trainNode, const Eigen::Isometry3d& T,
+		 std::vector<cv::DMatch>& matches, SystemParameters& sysPara)
+// T: prior of the motion from the queryNode's CS to the trainNode's CS
+{
+	matches.clear();
+	std::vector<cv::DMatch> cands;
+	for(size_t i=0; i<queryNode->planes.size(); ++i) {
+		for(size_t j=0; j<trainNode->planes.size(); ++j) {
+			const FramePlane& a = queryNode->planes[i];
+			const FramePlane& b = trainNode->planes[j];
+			if(!isSamePlane(a, b, T, sysPara)) continue;
+			double overlap = planeOverlap(queryNode, trainNode, a, b, T);
+			if(overlap < sysPara.plane_overlap_match) continue;
+			cands.push_back(cv::DMatch(i, j, 1-overlap));
+		}
+	}
+	//greedy one-to-one assignment, largest overlap first
+	std::sort(cands.begin(), cands.end());
+	std::vector<bool> qUsed(queryNode->planes.size(), false), tUsed(trainNode->planes.size(), false);
+	for(size_t k=0; k<cands.size(); ++k) {
+		if(qUsed[cands[k].queryIdx] || tUsed[cands[k].trainIdx]) continue;
+		qUsed[cands[k].queryIdx] = tUsed[cands[k].trainIdx] = true;
+		matches.push_back(cands[k]);
+	}
+}
+
+inline Eigen::Vector3d linePointPerpendicular(const Vector6d& ln, const Eigen::Vector3d& p)
+// vector from the closest point of line (A,B) to p
+{
+	Eigen::Vector3d u = (ln.tail<3>()-ln.head<3>()).normalized();
+	Eigen::Vector3d ap = p - ln.head<3>();
+	return ap - u*u.dot(ap);
+}
+
+bool computeRelativeMotion_PlLnPt(const PlaneEqVector& pl_a, const PlaneEqVector& pl_b,
+				  const LineEndptsVector& ln_a, const LineEndptsVector& ln_b,
+				  const vector<Eigen::Vector3d>& pt_a, const vector<Eigen::Vector3d>& pt_b,
+				  Eigen::Isometry3d& T)
+	// planes as (n,d) with n.x+d=0, lines as two endpoints (A,B), points as xyz
+	// the resulting T works as x_b = T*x_a;
+	// rotation needs 2 non-parallel directions, translation needs to be fully constrained, e.g. 3 planes
+	// minimal sets are 3 points, 2 non-parallel lines or 1 point + 1 line not passing through it
+{
+	// rotation: maximize the weighted sum of b'Ra over normals, line directions and centered points
+	Eigen::Matrix3d H = Eigen::Matrix3d::Zero();
+	for(size_t i=0; i<pl_a.size(); ++i)
+		H += pl_a[i].head<3>() * pl_b[i].head<3>().transpose();
+	for(size_t i=0; i<ln_a.size(); ++i) {
+		Eigen::Vector3d ua = (ln_a[i].tail<3>()-ln_a[i].head<3>()).normalized();
+		Eigen::Vector3d ub = (ln_b[i].tail<3>()-ln_b[i].head<3>()).normalized();
+		if(ua.dot(ub) < 0) ub = -ub;  // endpoints order is arbitrary, assume rotation < 90 deg
+		H += ua * ub.transpose();
+	}
+	Eigen::Vector3d ca = Eigen::Vector3d::Zero(), cb = Eigen::Vector3d::Zero();
+	if(pt_a.size() >= 2) {
+		for(size_t i=0; i<pt_a.size(); ++i) {
+			ca += pt_a[i];
+			cb += pt_b[i];
+		}
+		ca /= pt_a.size();
+		cb /= pt_b.size();
+		double spread = 0;
+		for(size_t i=0; i<pt_a.size(); ++i)
+			spread += (pt_a[i]-ca).squaredNorm();
+		spread /= pt_a.size();
+		if(spread > 1e-6)
+			for(size_t i=0; i<pt_a.size(); ++i)
+				H += (pt_a[i]-ca) * (pt_b[i]-cb).transpose() / spread;
+	}
+	if(pt_a.size() < 3) {  // few points: the perpendiculars from the lines to the points are directions too
+		for(size_t j=0; j<pt_a.size(); ++j)
+			for(size_t i=0; i<ln_a.size(); ++i) {
+				Eigen::Vector3d va = linePointPerpendicular(ln_a[i], pt_a[j]);
+				Eigen::Vector3d vb = linePointPerpendicular(ln_b[i], pt_b[j]);
+				if(va.norm() > 0.05 && vb.norm() > 0.05)
+					H += va.normalized() * vb.normalized().transpose();
+			}
+	}
+	Eigen::JacobiSVD<Eigen::Matrix3d> svd(H, Eigen::ComputeFullU | Eigen::ComputeFullV);
+	if(svd.singularValues()(1) < 1e-2*svd.singularValues()(0) || svd.singularValues()(0) < EPS)
+		return false;
+	Eigen::Matrix3d D = Eigen::Matrix3d::Identity();
+	D(2,2) = (svd.matrixV()*svd.matrixU().transpose()).determinant() > 0 ? 1 : -1;
+	Eigen::Matrix3d R = svd.matrixV() * D * svd.matrixU().transpose();
+
+	// translation: linear least squares
+	Eigen::Matrix3d M = Eigen::Matrix3d::Zero();
+	Eigen::Vector3d r = Eigen::Vector3d::Zero();
+	for(size_t i=0; i<pl_a.size(); ++i) {  // (R*n_a).t = d_a - d_b
+		Eigen::Vector3d n = pl_b[i].head<3>();
+		M += n * n.transpose();
+		r += n * (pl_a[i](3) - pl_b[i](3));
+	}
+	for(size_t i=0; i<ln_a.size(); ++i) {  // R*m_a+t on line b
+		Eigen::Vector3d ub = (ln_b[i].tail<3>()-ln_b[i].head<3>()).normalized();
+		Eigen::Matrix3d P = Eigen::Matrix3d::Identity() - ub * ub.transpose();
+		Eigen::Vector3d ma = 0.5*(ln_a[i].head<3>()+ln_a[i].tail<3>());
+		Eigen::Vector3d mb = 0.5*(ln_b[i].head<3>()+ln_b[i].tail<3>());
+		M += P;
+		r += P * (mb - R*ma);
+	}
+	for(size_t i=0; i<pt_a.size(); ++i) {  // R*p_a+t = p_b
+		M += Eigen::Matrix3d::Identity();
+		r += pt_b[i] - R*pt_a[i];
+	}
+	Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> eig(M);
+	if(eig.eigenvalues()(0) < 1e-2)
+		return false;
+
+	T = Eigen::Isometry3d::Identity();
+	T.linear() = R;
+	T.translation() = M.ldlt().solve(r);
+	return true;
+}
+
+Eigen::Isometry3d getTransform_Planes_Lns_Pts(const Frame* queryNode, const Frame* trainNode,
+				      const std::vector<cv::DMatch>& plane_matches,
+				      const std::vector<cv::DMatch>& line_matches,
+				      const std::vector<cv::DMatch>& point_matches,
+				      bool& valid, SystemParameters& sysPara)
+// Note: the result transforms a point from the queryNode's CS to the trainNode's CS
+{
+	PlaneEqVector pl_q, pl_t;
+	for(size_t i=0; i<plane_matches.size(); ++i) {
+		const FramePlane& a = queryNode->planes[plane_matches[i].queryIdx];
+		const FramePlane& b = trainNode->planes[plane_matches[i].trainIdx];
+		pl_q.push_back(Eigen::Vector4d(a.n.x, a.n.y, a.n.z, a.d));
+		pl_t.push_back(Eigen::Vector4d(b.n.x, b.n.y, b.n.z, b.d));
+	}
+	LineEndptsVector ln_q, ln_t;
+	for(size_t i=0; i<line_matches.size(); ++i) {
+		const RandomLine3d& a = queryNode->lines[line_matches[i].queryIdx].line3d;
+		const RandomLine3d& b = trainNode->lines[line_matches[i].trainIdx].line3d;
+		Vector6d la, lb;
+		la << a.A.x, a.A.y, a.A.z, a.B.x, a.B.y, a.B.z;
+		lb << b.A.x, b.A.y, b.A.z, b.B.x, b.B.y, b.B.z;
+		ln_q.push_back(la);
+		ln_t.push_back(lb);
+	}
+	vector<Eigen::Vector3d> pt_q, pt_t;
+	for(size_t i=0; i<point_matches.size(); ++i) {
+		Eigen::Vector3d a = queryNode->feature_locations_3d_[point_matches[i].queryIdx].head<3>().cast<double>();
+		Eigen::Vector3d b = trainNode->feature_locations_3d_[point_matches[i].trainIdx].head<3>().cast<double>();
+		if(isnan(a(2)) || isnan(b(2)) || a(2)<1e-3 || b(2)<1e-3 || a(2)>10 || b(2)>10) continue;
+		pt_q.push_back(a);
+		pt_t.push_back(b);
+	}
+
+	// least squares is not robust, drop line and point outliers w.r.t. the current estimate and solve again
+	Eigen::Isometry3d T = Eigen::Isometry3d::Identity();
+	const double thresh = 2*sysPara.pt2line3d_dist_relmotion;
+	valid = false;
+	for(int iter=0; iter<3; ++iter) {
+		if(!computeRelativeMotion_PlLnPt(pl_q, pl_t, ln_q, ln_t, pt_q, pt_t, T)) {
+			valid = false;
+			break;
+		}
+		valid = true;
+		size_t n_ln = 0, n_pt = 0;
+		for(size_t i=0; i<ln_q.size(); ++i) {
+			Eigen::Vector3d A = ln_t[i].head<3>(), u = (ln_t[i].tail<3>()-A).normalized();
+			Eigen::Vector3d qa = T*Eigen::Vector3d(ln_q[i].head<3>()) - A;
+			Eigen::Vector3d qb = T*Eigen::Vector3d(ln_q[i].tail<3>()) - A;
+			if((qa-qa.dot(u)*u).norm() < thresh && (qb-qb.dot(u)*u).norm() < thresh) {
+				ln_q[n_ln] = ln_q[i];
+				ln_t[n_ln++] = ln_t[i];
+			}
+		}
+		for(size_t i=0; i<pt_q.size(); ++i) {
+			if((T*pt_q[i]-pt_t[i]).norm() < thresh) {
+				pt_q[n_pt] = pt_q[i];
+				pt_t[n_pt++] = pt_t[i];
+			}
+		}
+		if(n_ln == ln_q.size() && n_pt == pt_q.size()) break;
+		ln_q.resize(n_ln); ln_t.resize(n_ln);
+		pt_q.resize(n_pt); pt_t.resize(n_pt);
+	}
+#ifdef VERBOSE
+	cout<<"Plane registration: "<<pl_q.size()<<" planes, "<<ln_q.size()<<" lines, "<<pt_q.size()<<" points, valid "<<valid<<endl;
+#endif
+	if(!valid && line_matches.size() >= 2)
+		return getTransform_Line_svd(queryNode, trainNode, line_matches, valid);
+	return T;
+}
+
+Eigen::Matrix4f getIcpAlignment(Frame* queryNode, Frame* trainNode, const Eigen::Matrix4f& guess, IcpReport* report,
+				ProjectiveIcp* icp)
+// Note: the result transforms a point from the queryNode's CS to the trainNode's CS
+{
+	std::unique_ptr<ProjectiveIcp> tmp;
+	if(!icp)
+	{
+		tmp.reset(new ProjectiveIcp(Frame::camera));
+		icp = tmp.get();
+	}
+	
+	Eigen::Isometry3d T0(guess.cast<double>());
+	IcpReport rep;
+	Eigen::Isometry3d T = icp->align(queryNode->depth, trainNode->depth, T0, &rep);
+#ifdef VERBOSE
+	cout << "has converged:" << rep.converged 
+		<<" rmse: " <<rep.rmse <<" inliers: "<<rep.inlier_ratio<<" iterations: "<<rep.iterations
+		<<" time: "<<rep.time_ms<<"ms"<< endl;
+#endif
+	if(report) *report = rep;
+	
+	return T.matrix().cast<float>();
+}
+
+
+Eigen::Matrix4f getTransform_Lns_Pts_pcl( const Frame* queryNode, const Frame* trainNode,
+					const std::vector<cv::DMatch>& point_matches_ori,
+					const std::vector<cv::DMatch>& line_matches, bool& valid)
+// Note: the result transforms a point from the queryNode's CS to the trainNode's CS
+{
+    std::vector<cv::DMatch> point_matches;
+	BOOST_FOREACH(const cv::DMatch& m, point_matches_ori)
+	{
+	    Point2f kp1 = queryNode->feature_locations_2d_[m.queryIdx].pt;
+	    Point2f kp2 = trainNode->feature_locations_2d_[m.trainIdx].pt;
+
+	    
+	    float depth1 = queryNode->feature_locations_3d_[m.queryIdx](2);
+	    float depth2 = trainNode->feature_locations_3d_[m.trainIdx](2);
+	    
+	    if( depth1>=1e-3&&depth1<=10&&depth2>=1e-3&&depth2<=10
+	      &&(kp1.x>=1&&kp1.x<=640&&kp1.y>=1&&kp1.y<=480)
+	      &&(kp2.x>=1&&kp2.x<=640&&kp2.y>=1&&kp2.y<=480))
+	    {
+			point_matches.push_back(m);
+	    }
+	}
+    
+	if(point_matches.size()<1 || point_matches.size()+line_matches.size()<3) { 
+		valid = false;
+		return Eigen::Matrix4f();
+	}
+	pcl::TransformationFromCorrespondences tfc;
+
+	//// project the point to all lines
+	for(int i=0; i < line_matches.size(); ++i) 
+	{
+		int ptidx = rand()%point_matches.size();
+		cv::Point3d query_pt(queryNode->feature_locations_3d_[point_matches[ptidx].queryIdx](0),
+  				     queryNode->feature_locations_3d_[point_matches[ptidx].queryIdx](1),
+  				     queryNode->feature_locations_3d_[point_matches[ptidx].queryIdx](2));
+		
+		cv::Point3d train_pt(trainNode->feature_locations_3d_[point_matches[ptidx].trainIdx](0),
+  				     trainNode->feature_locations_3d_[point_matches[ptidx].trainIdx](1),
+  				     trainNode->feature_locations_3d_[point_matches[ptidx].trainIdx](2));
+		
+		const cv::DMatch& m = line_matches[i];
+		cv::Point3d query_prj = projectPt3d2Ln3d_2 (query_pt, queryNode->lines[m.queryIdx].line3d.A, queryNode->lines[m.queryIdx].line3d.B);
+		cv::Point3d train_prj = projectPt3d2Ln3d_2 (train_pt, trainNode->lines[m.trainIdx].line3d.A, trainNode->lines[m.trainIdx].line3d.B);
+  		
+  		Eigen::Vector3f from(query_prj.x, query_prj.y, query_prj.z);
+  		Eigen::Vector3f to(train_prj.x, train_prj.y, train_prj.z);
+  		if(isnan(from(2)) || isnan(to(2))) 
+			continue;
+  		float weight =1/(abs(to[2]) + abs(from[2]));
+  		tfc.add(from, to, weight);
+	}
+	
+	//// add points to the tfc
+	for(int i=0; i<point_matches.size();++i) {
+		const cv::DMatch& m = point_matches[i];
+		Eigen::Vector3f from = queryNode->feature_locations_3d_[m.queryIdx].head<3>();
+  		Eigen::Vector3f to = trainNode->feature_locations_3d_[m.trainIdx].head<3>();
+  		if(isnan(from(2)) || isnan(to(2)))
+  			continue;
+  		float weight = 1.0;
+  		weight =1/(abs(to[2]) + abs(from[2]));
+  		tfc.add(from, to, weight);
+  	}
+
+	if(tfc.getNoOfSamples()<3)
+		valid = false;
+  	else
+  		valid = true;
+	//get relative movement from samples
+  	return tfc.getTransformation().matrix();
+}
+
+
+Eigen::Isometry3d getTransform_Line_svd(const Frame* queryNode, const Frame* trainNode, 
+				      const std::vector<cv::DMatch>& matches,
+				      bool& valid)
+// Note: the result transforms a point from the queryNode's CS to the trainNode's CS
+{
+	if(matches.size()<2) {
+		valid = false;
+		return Eigen::Isometry3d::Identity();
+	}
+	vector<RandomLine3d>  query(matches.size()), train(matches.size());
+	for(int i=0; i<matches.size(); ++i) {
+		query[i] = queryNode->lines[matches[i].queryIdx].line3d;
+		train[i] = trainNode->lines[matches[i].trainIdx].line3d;
+	}
+	cv::Mat R, t;
+	valid = computeRelativeMotion_svd (query, train, R, t);
+	Eigen::Matrix4f tf;
+	tf << R.at<double>(0,0), R.at<double>(0,1), R.at<double>(0,2), t.at<double>(0),
+	      R.at<double>(1,0), R.at<double>(1,1), R.at<double>(1,2), t.at<double>(1),
+	      R.at<double>(2,0), R.at<double>(2,1), R.at<double>(2,2), t.at<double>(2),
+	      0, 0, 0, 1;
+	
+	Eigen::Matrix3d rot;
+	rot << R.at<double>(0,0), R.at<double>(0,1), R.at<double>(0,2),
+	      R.at<double>(1,0), R.at<double>(1,1), R.at<double>(1,2),
+	      R.at<double>(2,0), R.at<double>(2,1), R.at<double>(2,2);
+	
+	Eigen::AngleAxisd v;
+	v.fromRotationMatrix(rot);
+	
+	Eigen::Isometry3d res = Eigen::Isometry3d::Identity();
+	res.rotate(v);
+	res.pretranslate(Eigen::Vector3d(t.at<double>(0),t.at<double>(1),t.at<double>(2)));
+
+	return res;
+}
+
+
+double errorFunctionInv(const Eigen::Vector4f& x1, const Eigen::Vector4f& x2,
+                      const Eigen::Matrix4d& tf_21)
+// as errorFunction, but given the inverse transformation so that it is computed once per hypothesis
+{
+	//sensor model in point_error.h
+	static const bool 	use_error_shortcut = true;
+
+	bool nan1 = isnan(x1(2));
+	bool nan2 = isnan(x2(2));
+	if(nan1||nan2){
+		return std::numeric_limits<double>::max();
+	}
+	Eigen::Vector4d x_1 = x1.cast<double>();
+	Eigen::Vector4d x_2 = x2.cast<double>();
+
+	Eigen::Vector3d mu_1 = x_1.head<3>();
+	Eigen::Vector3d mu_2 = x_2.head<3>();
+	Eigen::Vector3d mu_1_in_frame_2 = (tf_21 * x_1).head<3>(); // μ₁⁽²⁾  = T₁₂ μ₁⁽¹⁾  
+	//New Shortcut to determine clear outliers
+	if(use_error_shortcut)
+	{
+		double delta_sq_norm = (mu_1_in_frame_2 - mu_2).squaredNorm();
+		double sigma_max_1 = std::max(raster_cov_x, depth_covariance(mu_1(2)));//Assuming raster_cov_x and _y to be approx. equal
+		double sigma_max_2 = std::max(raster_cov_x, depth_covariance(mu_2(2)));//Assuming raster_cov_x and _y to be approx. equal
+		if(delta_sq_norm > 2.0 * (sigma_max_1+sigma_max_2)) //Factor 3 for mahal dist should be gotten from caller
+		{
+			return std::numeric_limits<double>::max();
+		}
+	} 
+
+	Eigen::Matrix3d rotation_mat = tf_21.block(0,0,3,3);
+
+	//Point 1
+	Eigen::Matrix3d cov1 = Eigen::Matrix3d::Zero();
+	cov1(0,0) = 1 * raster_cov_x * mu_1(2); //how big is 1px std dev in meter, depends on depth
+	cov1(1,1) = 1 * raster_cov_y * mu_1(2); //how big is 1px std dev in meter, depends on depth
+	if(nan1) cov1(2,2) = 1e9; //stddev for unknown: should be within 100m
+	else     cov1(2,2) = depth_covariance(mu_1(2));
+
+	//Point2
+	Eigen::Matrix3d cov2 = Eigen::Matrix3d::Zero();
+	cov2(0,0) = 1 * raster_cov_x* mu_2(2); //how big is 1px std dev in meter, depends on depth
+	cov2(1,1) = 1 * raster_cov_y* mu_2(2); //how big is 1px std dev in meter, depends on depth
+	if(nan2) cov2(2,2) = 1e9; 			   //stddev for unknown: should be within 100m
+	else     cov2(2,2) = depth_covariance(mu_2(2));
+
+	Eigen::Matrix3d cov1_in_frame_2 = rotation_mat.transpose() * cov1 * rotation_mat;//Works since the cov is diagonal => Eig-Vec-Matrix is Identity
+
+	// Δμ⁽²⁾ =  μ₁⁽²⁾ - μ₂⁽²⁾
+	Eigen::Vector3d delta_mu_in_frame_2 = mu_1_in_frame_2 - mu_2;
+	if(std::isnan(delta_mu_in_frame_2(2))){
+		delta_mu_in_frame_2(2) = 0.0;//Hack: set depth error to 0 if NaN 
+	}
+	// Σc = (Σ₁ + Σ₂)
+	Eigen::Matrix3d cov_mat_sum_in_frame_2 = cov1_in_frame_2 + cov2;     
+	//ΔμT Σc⁻¹Δμ  
+	//double sqrd_mahalanobis_distance = delta_mu_in_frame_2.transpose() * cov_mat_sum_in_frame_2.inverse() * delta_mu_in_frame_2;
+	double sqrd_mahalanobis_distance = delta_mu_in_frame_2.transpose() *cov_mat_sum_in_frame_2.ldlt().solve(delta_mu_in_frame_2);
+	
+	if(!(sqrd_mahalanobis_distance >= 0.0))
+	{
+		return std::numeric_limits<double>::max();
+	}
+	return sqrd_mahalanobis_distance;
+}
+
+double errorFunction(const Eigen::Vector4f& x1, const Eigen::Vector4f& x2,
+                      const Eigen::Matrix4d& transformation)
+{
+	return errorFunctionInv(x1, x2, transformation.inverse());
+}
+
+//! Wald's sequential probability ratio test (Chum & Matas, PAMI 2008): the likelihood ratio of
+//! "bad model" over "good model" is updated match by match, the hypothesis is rejected once it exceeds A
+class SprtTest
+{
+public:
+	//! never rejects
+	SprtTest() : A(std::numeric_limits<double>::infinity()), lambda_in(1), lambda_out(1) {}
+	//! eps: inlier ratio of a good model, delta: ratio of matches consistent with a bad one,
+	//! model_cost: time of a hypothesis in units of match evaluations
+	SprtTest(double eps, double delta = 0.05, double model_cost = 50)
+		: A(std::numeric_limits<double>::infinity()), lambda_in(1), lambda_out(1)
+	{
+		eps = min(eps, 0.99);
+		if(eps <= delta) return;
+		lambda_in  = delta/eps;
+		lambda_out = (1-delta)/(1-eps);
+		double C = (1-delta)*log((1-delta)/(1-eps)) + delta*log(delta/eps);
+		A = model_cost/C + 1;
+		for(int i=0; i<10; ++i)
+			A = model_cost/C + 1 + log(A);
+	}
+	//! update lambda with the next match, true if the hypothesis is to be rejected
+	bool reject(bool inlier, double& lambda) const
+	{
+		lambda *= inlier ? lambda_in : lambda_out;
+		return lambda > A;
+	}
+private:
+	double A, lambda_in, lambda_out;
+};
+
+inline int ransacIterBound(double inlier_ratio, int sample_size, double confidence, int max_iters)
+// number of iterations to draw an all-inlier sample with the given confidence
+{
+	double good = pow(inlier_ratio, sample_size);
+	if(good <= 1e-12) return max_iters;
+	if(good >= 1-1e-12) return 1;
+	double n = log(1-confidence)/log(1-good);
+	return n < max_iters ? int(ceil(n)) : max_iters;
+}
+
+
+Eigen::Isometry3d getTransform_PtsLines_ransac (const Frame* queryNode, const Frame* trainNode, 
+			  const std::vector<cv::DMatch> all_point_matches,
+			  const std::vector<cv::DMatch> all_line_matches,
+			  std::vector<cv::DMatch>& output_point_inlier_matches,
+			  std::vector<cv::DMatch>& output_line_inlier_matches,
+			  Eigen::Matrix4f& ransac_tf, 
+			  float& inlier_rmse,  SystemParameters sysPara)
+// input: 3d point matches + 3d line matches
+// output: rigid transform between two frames
+{
+	PROF_SCOPE(PROF_RANSAC);
+	Eigen::Isometry3d resT;
+	int nPt = all_point_matches.size();
+	int nLn = all_line_matches.size();
+
+	int line_weight = 1;
+
+	vector<int> pt_indexes(nPt);
+	vector<int> ln_indexes(nLn);
+	for(int i=0; i<pt_indexes.size(); ++i)  pt_indexes[i] = i;
+	for(int i=0; i<ln_indexes.size(); ++i)  ln_indexes[i] = i;
+	
+	double ln_angle_thres_deg = sysPara.line3d_angle_relmotion;  //10
+	double mahdist4inlier = sysPara.max_mah_dist_for_inliers;    //3
+
+	std::vector<Eigen::Vector4f, Eigen::aligned_allocator<Eigen::Vector4f> > train_lines_A(nLn), train_lines_B(nLn), query_lines_A(nLn), query_lines_B(nLn);
+	for(int i=0; i<nLn; ++i) 
+	{
+	    cv::DMatch m = all_line_matches[i];
+	    train_lines_A[i] = (Eigen::Vector4f(trainNode->lines[m.trainIdx].line3d.A.x, trainNode->lines[m.trainIdx].line3d.A.y, trainNode->lines[m.trainIdx].line3d.A.z, 1));
+	    train_lines_B[i] = (Eigen::Vector4f(trainNode->lines[m.trainIdx].line3d.B.x, trainNode->lines[m.trainIdx].line3d.B.y, trainNode->lines[m.trainIdx].line3d.B.z, 1));
+	    query_lines_A[i] = (Eigen::Vector4f(queryNode->lines[m.queryIdx].line3d.A.x, queryNode->lines[m.queryIdx].line3d.A.y, queryNode->lines[m.queryIdx].line3d.A.z, 1));
+	    query_lines_B[i] = (Eigen::Vector4f(queryNode->lines[m.queryIdx].line3d.B.x, queryNode->lines[m.queryIdx].line3d.B.y, queryNode->lines[m.queryIdx].line3d.B.z, 1));
+	} 
+	vector<Eigen::Vector3d> train_pts(nPt), query_pts(nPt);
+	for(int i=0; i<nPt; ++i) 
+	{
+		train_pts[i] = trainNode->feature_locations_3d_[all_point_matches[i].trainIdx].head<3>().cast<double>();
+		query_pts[i] = queryNode->feature_locations_3d_[all_point_matches[i].queryIdx].head<3>().cast<double>();
+	}
+	
+	//minimal sets solved in closed form: 3 points, 2 lines, 1 point + 1 line
+	enum {SET_3PT, SET_2LN, SET_1PT1LN};
+	vector<int> set_types;
+	if(nPt >= 3) set_types.push_back(SET_3PT);
+	if(nLn >= 2) set_types.push_back(SET_2LN);
+	if(nPt >= 1 && nLn >= 1) set_types.push_back(SET_1PT1LN);
+	const PlaneEqVector no_planes;
+
+	const int max_iters = sysPara.ransac_iters_line_motion;
+	const int nData = nPt + nLn;
+	vector<int> eval_order(nData);  // SPRT needs the matches in random order
+	for(int i=0; i<nData; ++i)  eval_order[i] = i;
+	random_unique(eval_order.begin(), eval_order.end(), nData);
+	PointErrorBatch pt_batch;  // points in the order they are scored, evaluated block by block
+	vector<int> pt_slot(nPt);
+	pt_batch.reserve(nPt);
+	for(int k=0; k<nData; ++k) 
+	{
+		int i = eval_order[k];
+		if(i >= nPt) continue;
+		pt_slot[i] = pt_batch.size();
+		pt_batch.add(queryNode->feature_locations_3d_[all_point_matches[i].queryIdx], 
+			     trainNode->feature_locations_3d_[all_point_matches[i].trainIdx]);
+	}
+	const int pt_block = 32;
+
+	std::mutex best_mtx;
+	std::atomic<int> next_iter(0), iter_limit(max_iters);
+	int best_score = 0;
+	float sum_squared_error = 1e9;
+	vector<unsigned char> best_pt_flags(nPt, 0), best_ln_flags(nLn, 0);
+	Eigen::Matrix4f tf_best = Eigen::Matrix4f::Identity();
+	SprtTest best_sprt;  // no early rejection until a first model is found
+
+	// point flags are 0/1, line flags count the passed tests (0-2) as each adds an inlier entry
+	auto scoreHypothesis = [&](const Eigen::Matrix4f& tf, const SprtTest& sprt, vector<double>& pt_err,
+				   vector<unsigned char>& pt_flags, vector<unsigned char>& ln_flags, float& sse)->bool
+	{
+		const Eigen::Matrix4d tf_21 = tf.cast<double>().inverse();
+		const Eigen::Matrix4f tf_qt = tf.inverse();  // query CS to train CS
+		double lambda = 1;
+		int pt_done = 0;
+		sse = 0;
+		for(int k=0; k<nData; ++k) 
+		{
+			int i = eval_order[k];
+			bool inlier;
+			if(i < nPt) 
+			{
+				int slot = pt_slot[i];
+				if(slot == pt_done) 
+				{
+					int end = min(pt_done + pt_block, nPt);
+					pt_batch.evaluate(tf_21, pt_done, end, &pt_err[pt_done]);
+					pt_done = end;
+				}
+				double mah_dist_sq = pt_err[slot];
+				inlier = mah_dist_sq < mahdist4inlier * mahdist4inlier;
+				pt_flags[i] = inlier;
+				if(inlier) sse += mah_dist_sq;
+			}
+			else
+			{
+				i -= nPt;
+				const RandomLine3d& tl = trainNode->lines[all_line_matches[i].trainIdx].line3d;
+				Eigen::Vector4f qA_tf = tf_qt * query_lines_A[i];
+				Eigen::Vector4f qB_tf = tf_qt * query_lines_B[i];		
+				cv::Point3d qA_in_train(qA_tf(0),qA_tf(1),qA_tf(2));
+				cv::Point3d qB_in_train(qB_tf(0),qB_tf(1),qB_tf(2));
+				double mah_dist_a = mah_dist3d_pt_line(tl.rndA, qA_in_train, qB_in_train);
+				double mah_dist_b = mah_dist3d_pt_line(tl.rndB, qA_in_train, qB_in_train);
+				double sq = mah_dist_a * mah_dist_a + mah_dist_b * mah_dist_b;
+				ln_flags[i] = 0;
+				if(mah_dist_a < mahdist4inlier && mah_dist_b < mahdist4inlier) 
+				{
+					ln_flags[i]++;
+					sse += sq;
+				}
+				double dist = 0.5*dist3d_pt_line (qA_in_train, tl.A, tl.B) + 0.5*dist3d_pt_line (qB_in_train, tl.A, tl.B);
+				cv::Point3d l1 = qA_in_train - qB_in_train;
+				cv::Point3d l2 = tl.A - tl.B;			
+				double angle = 180*acos(abs(l1.dot(l2)/cv::norm(l1)/cv::norm(l2)))/PI; 
+				if(dist < sysPara.pt2line3d_dist_relmotion && angle < sysPara.line3d_angle_relmotion) 
+				{
+					ln_flags[i]++;
+					sse += sq;
+				}
+				inlier = ln_flags[i] > 0;
+			}
+			if(sprt.reject(inlier, lambda))
+				return false;
+		}
+		return true;
+	};
+
+	auto worker = [&](unsigned seed)
+	{
+		std::mt19937 rng(seed);
+		vector<int> pt_idx(pt_indexes), ln_idx(ln_indexes);
+		vector<unsigned char> pt_flags(nPt), ln_flags(nLn);
+		vector<double> pt_err(nPt);
+		vector<Eigen::Vector3d> pa, pb;
+		LineEndptsVector la, lb;
+		while(true) 
+		{
+			int iter = next_iter++;
+			if(iter >= iter_limit) break;
+
+			// hypothesis maps the train CS to the query CS, as the g2o estimate
+			pa.clear(); pb.clear(); la.clear(); lb.clear();
+			int nSetPt = 0, nSetLn = 0;
+			switch(set_types[iter % set_types.size()])
+			{
+				case SET_3PT:    nSetPt = 3; break;
+				case SET_2LN:    nSetLn = 2; break;
+				case SET_1PT1LN: nSetPt = 1; nSetLn = 1; break;
+			}
+			for(int i=0; i<nSetPt; ++i) 
+			{ 
+				std::swap(pt_idx[i], pt_idx[i + rng()%(nPt-i)]);
+				pa.push_back(train_pts[pt_idx[i]]);
+				pb.push_back(query_pts[pt_idx[i]]);
+			}
+			for(int i=0; i<nSetLn; ++i) 
+			{
+				std::swap(ln_idx[i], ln_idx[i + rng()%(nLn-i)]);
+				int k = ln_idx[i];
+				Vector6d a, b;
+				a << train_lines_A[k].head<3>().cast<double>(), train_lines_B[k].head<3>().cast<double>();
+				b << query_lines_A[k].head<3>().cast<double>(), query_lines_B[k].head<3>().cast<double>();
+				la.push_back(a);
+				lb.push_back(b);
+			}
+			Eigen::Isometry3d T;
+			if(!computeRelativeMotion_PlLnPt(no_planes, no_planes, la, lb, pa, pb, T))
+				continue;
+			Eigen::Matrix4f tf = T.matrix().cast<float>();
+
+			SprtTest sprt;
+			{
+				std::lock_guard<std::mutex> lock(best_mtx);
+				sprt = best_sprt;
+			}
+			float sse;
+			if(!scoreHypothesis(tf, sprt, pt_err, pt_flags, ln_flags, sse))
+				continue;
+
+			int nPtIn = 0, nLnIn = 0, nLnEntries = 0;
+			for(int i=0; i<nPt; ++i)  nPtIn += pt_flags[i];
+			for(int i=0; i<nLn; ++i)  { nLnIn += ln_flags[i] > 0; nLnEntries += ln_flags[i]; }
+			int score = nPtIn + line_weight * nLnEntries;
+
+			std::lock_guard<std::mutex> lock(best_mtx);
+			if(score > best_score) 
+			{
+				best_score = score;
+				best_pt_flags = pt_flags;
+				best_ln_flags = ln_flags;
+				tf_best = tf;
+				sum_squared_error = sse;
+				double w = double(nPtIn + nLnIn) / nData;
+				best_sprt = SprtTest(w);
+				iter_limit = min(iter_limit.load(), ransacIterBound(w, nSetPt+nSetLn, sysPara.ransac_confidence, max_iters));
+			}
+		}
+	};
+
+	//Start Ransac
+	if(set_types.empty())  //too few matches for a minimal set, a single hypothesis from all of them
+	{
+		getTransformFromHybridMatchesG2O(queryNode,trainNode,  all_point_matches, all_line_matches, tf_best, 25, sysPara);
+		float sse;
+		vector<double> pt_err(nPt);
+		scoreHypothesis(tf_best, best_sprt, pt_err, best_pt_flags, best_ln_flags, sse);
+		sum_squared_error = sse;
+	}
+	else
+	{
+		int nThreads = max(1, sysPara.ransac_threads);
+		vector<std::thread> threads;
+		for(int t=1; t<nThreads; ++t)
+			threads.push_back(std::thread(worker, (unsigned)rand()));
+		worker((unsigned)rand());
+		for(size_t t=0; t<threads.size(); ++t)
+			threads[t].join();
+	}
+
+	vector<cv::DMatch> max_point_inlier_set, max_line_inlier_set;
+	for(int i=0; i<nPt; ++i)
+		if(best_pt_flags[i]) max_point_inlier_set.push_back(all_point_matches[i]);
+	for(int i=0; i<nLn; ++i)
+		for(int j=0; j<best_ln_flags[i]; ++j) max_line_inlier_set.push_back(all_line_matches[i]);
+
+	cout<<"RANSAC:"<<max_point_inlier_set.size()<<" "<<max_line_inlier_set.size()<<" in "<<min(next_iter.load(), max_iters)<<" iterations"<<endl;
+	
+	///////// refine solution /////////
+	vector<cv::DMatch> refined_point_inliers, refined_line_inliers ;
+	Eigen::Matrix4f refined_tf = tf_best;
+	int tmp_best_line_mah;
+	resT = getTransformFromHybridMatchesG2O (queryNode,trainNode,  max_point_inlier_set, max_line_inlier_set, refined_tf, 25, sysPara);
+	double refined_rmse = sqrt(sum_squared_error/(max_point_inlier_set.size() + max_line_inlier_set.size()));
+
+	//return resT;
+
+	vector<double> refined_pt_err(nPt);
+	for(int iter = 0; iter <20; ++iter) {
+		vector<cv::DMatch> tmp_pt_inliers, tmp_ln_inliers;
+		tmp_pt_inliers.reserve(all_point_matches.size()); tmp_ln_inliers.reserve(all_line_matches.size());
+		double tmp_sse = 0;
+		
+		Eigen::Matrix4d refined_tf_21 = refined_tf.cast<double>().inverse();
+		Eigen::Matrix4f refined_tf_qt = refined_tf.inverse();
+		pt_batch.evaluate(refined_tf_21, refined_pt_err.data());
+        for(int i=0; i<all_point_matches.size(); ++i)  {
+        	double mah_dist_sq = refined_pt_err[pt_slot[i]];
+        	
+        	if (mah_dist_sq < mahdist4inlier * mahdist4inlier) {
+        		tmp_pt_inliers.push_back(all_point_matches[i]);
+        		tmp_sse += mah_dist_sq; 
+        	}        	
+        }
+
+        int tmp_line_mah_inlier = 0;
+        for(int i=0; i<all_line_matches.size(); ++i) {
+        	Eigen::Vector4f qA_tf = refined_tf_qt * query_lines_A[i];
+        	Eigen::Vector4f qB_tf = refined_tf_qt * query_lines_B[i];		
+			cv::Point3d qA_in_train(qA_tf(0),qA_tf(1),qA_tf(2)), qB_in_train(qB_tf(0),qB_tf(1),qB_tf(2));
+			double mah_dist_a = mah_dist3d_pt_line(trainNode->lines[all_line_matches[i].trainIdx].line3d.rndA, qA_in_train, qB_in_train); 
+			double mah_dist_b = mah_dist3d_pt_line(trainNode->lines[all_line_matches[i].trainIdx].line3d.rndB, qA_in_train, qB_in_train);
+			if(mah_dist_a < mahdist4inlier && mah_dist_b < mahdist4inlier) {
+				tmp_line_mah_inlier++;
+				tmp_ln_inliers.push_back(all_line_matches[i]);
+				tmp_sse += mah_dist_a * mah_dist_a + mah_dist_b * mah_dist_b;
+
+			}					
+			
+			double dist = 0.5*dist3d_pt_line (qA_in_train, trainNode->lines[all_line_matches[i].trainIdx].line3d.A, trainNode->lines[all_line_matches[i].trainIdx].line3d.B)
+						+ 0.5*dist3d_pt_line (qB_in_train, trainNode->lines[all_line_matches[i].trainIdx].line3d.A, trainNode->lines[all_line_matches[i].trainIdx].line3d.B);
+			cv::Point3d l1 = qA_in_train - qB_in_train, 
+				l2 = trainNode->lines[all_line_matches[i].trainIdx].line3d.A - trainNode->lines[all_line_matches[i].trainIdx].line3d.B;			
+			double angle = 180*acos(abs(l1.dot(l2)/cv::norm(l1)/cv::norm(l2)))/PI; 
+
+			if(dist < sysPara.pt2line3d_dist_relmotion && angle < sysPara.line3d_angle_relmotion) {
+				tmp_ln_inliers.push_back(all_line_matches[i]);
+				tmp_sse += mah_dist_a * mah_dist_a+ mah_dist_b * mah_dist_b;
+			}
+	
+        }
+        if( tmp_pt_inliers.size() + tmp_ln_inliers.size() * sysPara.line_match_number_weight 
+              > refined_point_inliers.size() + refined_line_inliers.size() * sysPara.line_match_number_weight)
+		{
+           	tmp_best_line_mah = tmp_line_mah_inlier;
+        	refined_point_inliers = tmp_pt_inliers;
+        	refined_line_inliers = tmp_ln_inliers;
+        	refined_rmse = sqrt(tmp_sse/(tmp_pt_inliers.size() + tmp_ln_inliers.size()));       
+        	resT = getTransformFromHybridMatchesG2O (queryNode,trainNode,refined_point_inliers, refined_line_inliers, refined_tf, 20, sysPara);
+
+        } else
+        	break;
+
+   	}
+
+	output_point_inlier_matches = refined_point_inliers;
+	output_line_inlier_matches = refined_line_inliers;
+	inlier_rmse = refined_rmse;
+	ransac_tf = refined_tf;
+	return resT;
+} 
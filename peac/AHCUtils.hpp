@@ -1,113 +1,213 @@
-//
-// Copyright 2014 Mitsubishi Electric Research Laboratories All
-// Rights Reserved.
-//
-// Permission to use, copy and modify this software and its
-// documentation without fee for educational, research and non-profit
-// purposes, is hereby granted, provided that the above copyright
-// notice, this paragraph, and the following three paragraphs appear
-// in all copies.
-//
-// To request permission to incorporate this software into commercial
-// products contact: Director; Mitsubishi Electric Research
-// Laboratories (MERL); 201 Broadway; Cambridge, MA 02139.
-//
-// IN NO EVENT SHALL MERL BE LIABLE TO ANY PARTY FOR DIRECT,
-// INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
-// LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
-// DOCUMENTATION, EVEN IF MERL HAS BEEN ADVISED OF THE POSSIBILITY OF
-// SUCH DAMAGES.
-//
-// MERL SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING, BUT NOT
-// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
-// FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON AN
-// "AS IS" BASIS, AND MERL HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE,
-// SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
-//
-#pragma once
-
-#include<string>
-#include "opencv2/opencv.hpp"
-
-namespace ahc {
-namespace utils {
-
-/**
- *  \brief Generate pseudo-colors 
- *  
- *  \param [in] ncolors number of colors to be generated (will be reset to 10 if ncolors<=0)
- *  \return a vector of cv::Vec3b
- */
-inline std::vector<cv::Vec3b> pseudocolor(int ncolors) {
-	srand((unsigned int)time(0));
-	if(ncolors<=0) ncolors=10;
-	std::vector<cv::Vec3b> ret(ncolors);
-	for(int i=0; i<ncolors; ++i) {
-		cv::Vec3b& color=ret[i];
-		color[0]=rand()%255;
-		color[1]=rand()%255;
-		color[2]=rand()%255;
-	}
-	return ret;
-}
-
-/**
-\brief helper class for measuring time elapse
-*/
-struct Timer {
-	int scale;
-	double startTick;
-
-	/**
-	constructor
-	
-	@param scale time scale, 1 means second, 1000 means milli-second,
-	             1/60.0 means minutes, etc.
-	*/
-	Timer(int scale=1) {
-		this->scale = scale;
-		startTick=0;
-	}
-
-	/**
-	start record time, similar to matlab function "tic";
-	
-	@return the start tick
-	*/
-	inline double tic() {
-		return startTick = (double)cv::getTickCount();
-	}
-
-	/**
-	return duration from last tic, in (second * scale), similar to matlab function "toc"
-	
-	@return duration from last tic,  in (second * scale)
-	*/
-	inline double toc() {
-		return ((double)cv::getTickCount()-startTick)/cv::getTickFrequency() * scale;
-	}
-	inline double toc(std::string tag) {
-		double time=toc();
-		std::cout<<tag<<" "<<time<<std::endl;
-		return time;
-	}
-
-	/**
-	equivalent to { toc(); tic(); }
-	
-	@return duration from last tic,  in (second * scale)
-	*/
-	inline double toctic() {
-		double ret = ((double)cv::getTickCount()-startTick)/cv::getTickFrequency() * scale;
-		tic();
-		return ret;
-	}
-	inline double toctic(std::string tag) {
-		double time=toctic();
-		std::cout<<tag<<" "<<time<<std::endl;
-		return time;
-	}
-};
-
-} //utils
-} //ach
\ No newline at end of file
+//
+// Copyright 2014 Mitsubishi Electric Research Laboratories All
+// Rights Reserved.
+//
+// Permission to use, copy and modify this software and its
+// documentation without fee for educational, research and non-profit
+// purposes, is hereby granted, provided that the above copyright
+// notice, this paragraph, and the following three paragraphs appear
+// in all copies.
+//
+// To request permission to incorporate this software into commercial
+// products contact: Director; Mitsubishi Electric Research
+// Laboratories (MERL); 201 Broadway; Cambridge, MA 02139.
+//
+// IN NO EVENT SHALL MERL BE LIABLE TO ANY PARTY FOR DIRECT,
+// INDIRECT, SPECIAL, INCIDENTAL, OR CONSEQUENTIAL DAMAGES, INCLUDING
+// LOST PROFITS, ARISING OUT OF THE USE OF THIS SOFTWARE AND ITS
+// DOCUMENTATION, EVEN IF MERL HAS BEEN ADVISED OF THE POSSIBILITY OF
+// SUCH DAMAGES.
+//
+// MERL SPECIFICALLY DISCLAIMS ANY WARRANTIES, INCLUDING, BUT NOT
+// LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+// FOR A PARTICULAR PURPOSE. THE SOFTWARE PROVIDED HEREUNDER IS ON AN
+// "AS IS" BASIS, AND MERL HAS NO OBLIGATIONS TO PROVIDE MAINTENANCE,
+// SUPPORT, UPDATES, ENHANCEMENTS, OR MODIFICATIONS.
+//
+#pragma once
+
+#include<string>
+#include<vector>
+#include<thread>
+#include<atomic>
+#include<mutex>
+#include<condition_variable>
+#include<functional>
+#include<algorithm>
+#include "opencv2/opencv.hpp"
+
+namespace ahc {
+namespace utils {
+
+/**
+ *  \brief Generate pseudo-colors 
+ *  
+ *  \param [in] ncolors number of colors to be generated (will be reset to 10 if ncolors<=0)
+ *  \return a vector of cv::Vec3b
+ */
+inline std::vector<cv::Vec3b> pseudocolor(int ncolors) {
+	srand((unsigned int)time(0));
+	if(ncolors<=0) ncolors=10;
+	std::vector<cv::Vec3b> ret(ncolors);
+	for(int i=0; i<ncolors; ++i) {
+		cv::Vec3b& color=ret[i];
+		color[0]=rand()%255;
+		color[1]=rand()%255;
+		color[2]=rand()%255;
+	}
+	return ret;
+}
+
+/**
+ *  \brief a fixed set of worker threads, started once and reused by every parallelRange
+ *  
+ *  \details jobs run one at a time (a shared pool serializes its callers); 
+ * the calling thread takes part as thread 0
+ */
+class ThreadPool {
+public:
+	/**
+	 *  \param [in] nThreads number of threads including the caller, <=0 means std::thread::hardware_concurrency()
+	 */
+	explicit ThreadPool(int nThreads=0) : job(0), generation(0), busy(0), stop(false) {
+		if(nThreads<=0) nThreads=(int)std::thread::hardware_concurrency();
+		for(int t=1; t<nThreads; ++t) workers.push_back(std::thread(&ThreadPool::work, this, t));
+	}
+
+	~ThreadPool() {
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			stop=true;
+		}
+		wake.notify_all();
+		for(int t=0; t<(int)workers.size(); ++t) workers[t].join();
+	}
+
+	inline int size() const { return (int)workers.size()+1; }
+
+	/**
+	 *  \brief run f over [0,n) on the pool
+	 *  
+	 *  \param [in] n number of items
+	 *  \param [in] f callable as f(begin, end, tid), processing items [begin,end) on thread tid
+	 *  \param [in] grain number of items grabbed by a thread at a time
+	 *  
+	 *  \details items are handed out dynamically so that uneven items are balanced;
+	 * tid is in [0,size()) and can be used to index per-thread scratch buffers
+	 */
+	template<class F>
+	void parallelRange(const int n, const F& f, const int grain=1) {
+		if(n<=0) return;
+		std::lock_guard<std::mutex> running(runMtx);
+		if(workers.empty() || n<=grain) {
+			f(0,n,0);
+			return;
+		}
+		std::atomic<int> next(0);
+		const std::function<void(int)> chunks=[&](const int tid) {
+			for(int b=next.fetch_add(grain); b<n; b=next.fetch_add(grain)) {
+				f(b,std::min(n,b+grain),tid);
+			}
+		};
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			job=&chunks;
+			busy=(int)workers.size();
+			++generation;
+		}
+		wake.notify_all();
+		chunks(0);
+		std::unique_lock<std::mutex> lock(mtx);
+		done.wait(lock, [this]{ return busy==0; });
+		job=0;
+	}
+
+private:
+	ThreadPool(const ThreadPool&);
+	ThreadPool& operator=(const ThreadPool&);
+
+	void work(const int tid) {
+		int seen=0;
+		std::unique_lock<std::mutex> lock(mtx);
+		for(;;) {
+			wake.wait(lock, [&]{ return stop || generation!=seen; });
+			if(stop) return;
+			seen=generation;
+			const std::function<void(int)>* f=job;
+			lock.unlock();
+			(*f)(tid);
+			lock.lock();
+			if(--busy==0) done.notify_one();
+		}
+	}
+
+	std::vector<std::thread> workers;
+	std::mutex runMtx;		//one parallelRange at a time
+	std::mutex mtx;			//guards job, generation, busy and stop
+	std::condition_variable wake, done;
+	const std::function<void(int)>* job;
+	int generation;
+	int busy;				//#workers still running the current job
+	bool stop;
+};
+
+/**
+\brief helper class for measuring time elapse
+*/
+struct Timer {
+	int scale;
+	double startTick;
+
+	/**
+	constructor
+	
+	@param scale time scale, 1 means second, 1000 means milli-second,
+	             1/60.0 means minutes, etc.
+	*/
+	Timer(int scale=1) {
+		this->scale = scale;
+		startTick=0;
+	}
+
+	/**
+	start record time, similar to matlab function "tic";
+	
+	@return the start tick
+	*/
+	inline double tic() {
+		return startTick = (double)cv::getTickCount();
+	}
+
+	/**
+	return duration from last tic, in (second * scale), similar to matlab function "toc"
+	
+	@return duration from last tic,  in (second * scale)
+	*/
+	inline double toc() {
+		return ((double)cv::getTickCount()-startTick)/cv::getTickFrequency() * scale;
+	}
+	inline double toc(std::string tag) {
+		double time=toc();
+		std::cout<<tag<<" "<<time<<std::endl;
+		return time;
+	}
+
+	/**
+	equivalent to { toc(); tic(); }
+	
+	@return duration from last tic,  in (second * scale)
+	*/
+	inline double toctic() {
+		double ret = ((double)cv::getTickCount()-startTick)/cv::getTickFrequency() * scale;
+		tic();
+		return ret;
+	}
+	inline double toctic(std::string tag) {
+		double time=toctic();
+		std::cout<<tag<<" "<<time<<std::endl;
+		return time;
+	}
+};
+
+} //utils
+} //ach
@@ -0,0 +1,98 @@
+#include "point_error.h"
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+void PointErrorBatch::clear()
+{
+	x1.clear(); y1.clear(); z1.clear();
+	x2.clear(); y2.clear(); z2.clear();
+	c1x.clear(); c1y.clear(); c1z.clear();
+	c2x.clear(); c2y.clear(); c2z.clear();
+	gate.clear();
+}
+
+void PointErrorBatch::reserve(size_t n)
+{
+	x1.reserve(n); y1.reserve(n); z1.reserve(n);
+	x2.reserve(n); y2.reserve(n); z2.reserve(n);
+	c1x.reserve(n); c1y.reserve(n); c1z.reserve(n);
+	c2x.reserve(n); c2y.reserve(n); c2z.reserve(n);
+	gate.reserve(n);
+}
+
+void PointErrorBatch::add(const Eigen::Vector4f& p1, const Eigen::Vector4f& p2)
+{
+	bool ok = !std::isnan(p1(2)) && !std::isnan(p2(2));
+	// invalid points are kept as zeros so that the batch stays free of NaN arithmetic
+	double a[3], b[3];
+	for(int k=0; k<3; ++k) {
+		a[k] = ok ? p1(k) : 0;
+		b[k] = ok ? p2(k) : 0;
+	}
+	x1.push_back(a[0]); y1.push_back(a[1]); z1.push_back(a[2]);
+	x2.push_back(b[0]); y2.push_back(b[1]); z2.push_back(b[2]);
+	double dc1 = depth_covariance(a[2]), dc2 = depth_covariance(b[2]);
+	c1x.push_back(raster_cov_x * a[2]);
+	c1y.push_back(raster_cov_y * a[2]);
+	c1z.push_back(dc1);
+	c2x.push_back(raster_cov_x * b[2]);
+	c2y.push_back(raster_cov_y * b[2]);
+	c2z.push_back(dc2);
+	gate.push_back(ok ? 2.0 * (std::max(raster_cov_x, dc1) + std::max(raster_cov_x, dc2)) : -1);
+}
+
+void PointErrorBatch::evaluate(const Eigen::Matrix4d& tf_21, size_t begin, size_t end, double* err) const
+{
+	const double r00 = tf_21(0,0), r01 = tf_21(0,1), r02 = tf_21(0,2), t0 = tf_21(0,3);
+	const double r10 = tf_21(1,0), r11 = tf_21(1,1), r12 = tf_21(1,2), t1 = tf_21(1,3);
+	const double r20 = tf_21(2,0), r21 = tf_21(2,1), r22 = tf_21(2,2), t2 = tf_21(2,3);
+	const double max_err = std::numeric_limits<double>::max();
+	if(begin >= end) return;
+
+	const double* __restrict px1 = &x1[0];
+	const double* __restrict py1 = &y1[0];
+	const double* __restrict pz1 = &z1[0];
+	const double* __restrict px2 = &x2[0];
+	const double* __restrict py2 = &y2[0];
+	const double* __restrict pz2 = &z2[0];
+	const double* __restrict pc1x = &c1x[0];
+	const double* __restrict pc1y = &c1y[0];
+	const double* __restrict pc1z = &c1z[0];
+	const double* __restrict pc2x = &c2x[0];
+	const double* __restrict pc2y = &c2y[0];
+	const double* __restrict pc2z = &c2z[0];
+	const double* __restrict pgate = &gate[0];
+	double* __restrict out = err;
+
+	for(size_t i=begin; i<end; ++i)
+	{
+		// delta = T_21*x1 - x2
+		double dx = r00*px1[i] + r01*py1[i] + r02*pz1[i] + t0 - px2[i];
+		double dy = r10*px1[i] + r11*py1[i] + r12*pz1[i] + t1 - py2[i];
+		double dz = r20*px1[i] + r21*py1[i] + r22*pz1[i] + t2 - pz2[i];
+		double dsq = dx*dx + dy*dy + dz*dz;
+
+		// S = R'*C1*R + C2, symmetric
+		double a = pc1x[i], b = pc1y[i], c = pc1z[i];
+		double s00 = r00*r00*a + r10*r10*b + r20*r20*c + pc2x[i];
+		double s01 = r00*r01*a + r10*r11*b + r20*r21*c;
+		double s02 = r00*r02*a + r10*r12*b + r20*r22*c;
+		double s11 = r01*r01*a + r11*r11*b + r21*r21*c + pc2y[i];
+		double s12 = r01*r02*a + r11*r12*b + r21*r22*c;
+		double s22 = r02*r02*a + r12*r12*b + r22*r22*c + pc2z[i];
+
+		// delta'*S^-1*delta by the adjugate
+		double a00 = s11*s22 - s12*s12;
+		double a01 = s02*s12 - s01*s22;
+		double a02 = s01*s12 - s02*s11;
+		double a11 = s00*s22 - s02*s02;
+		double a12 = s01*s02 - s00*s12;
+		double a22 = s00*s11 - s01*s01;
+		double det = s00*a00 + s01*a01 + s02*a02;
+		double q = a00*dx*dx + a11*dy*dy + a22*dz*dz + 2*(a01*dx*dy + a02*dx*dz + a12*dy*dz);
+		double d = q / det;
+
+		out[i-begin] = (dsq <= pgate[i] && d >= 0) ? d : max_err;
+	}
+}
@@ -0,0 +1,52 @@
+#ifndef POINT_ERROR_BATCH_H
+#define POINT_ERROR_BATCH_H
+
+#include <vector>
+#include <cstddef>
+#include <cmath>
+#include <Eigen/Core>
+
+//! sensor model of the point matches, used by errorFunction and PointErrorBatch
+//! raster: 3 px stddev over the 58x45 deg field of view of a 640x480 Kinect, as a variance per meter of depth
+static const double raster_stddev_x = 3*tan(58.0/180.0*M_PI/640);
+static const double raster_stddev_y = 3*tan(45.0/180.0*M_PI/480);
+static const double raster_cov_x = raster_stddev_x * raster_stddev_x;
+static const double raster_cov_y = raster_stddev_y * raster_stddev_y;
+
+//! depth stddev grows with the square of the depth (http://www.ros.org/wiki/openni_kinect/kinect_accuracy)
+inline double depth_std_dev(double depth)
+{
+	return 0.006 * depth * depth;
+}
+
+inline double depth_covariance(double depth)
+{
+	double stddev = depth_std_dev(depth);
+	return stddev * stddev;
+}
+
+//! squared mahalanobis distances of matched 3d points, the same error as errorFunction
+//! in motion.cpp, evaluated for a whole match set at once
+//! the points are stored as structure of arrays with the per point covariances precomputed,
+//! so that the loop over the points has no branches and vectorizes
+class PointErrorBatch
+{
+public:
+	void clear();
+	void reserve(size_t n);
+	//! x1 in the first frame, x2 in the second one (homogeneous, w is ignored)
+	void add(const Eigen::Vector4f& x1, const Eigen::Vector4f& x2);
+	size_t size() const { return x1.size(); }
+
+	//! errors of matches [begin,end) into err[0..end-begin), tf_21 maps the first frame to the second
+	//! clear outliers and invalid points get std::numeric_limits<double>::max()
+	void evaluate(const Eigen::Matrix4d& tf_21, size_t begin, size_t end, double* err) const;
+	void evaluate(const Eigen::Matrix4d& tf_21, double* err) const { evaluate(tf_21, 0, size(), err); }
+
+private:
+	std::vector<double> x1, y1, z1, x2, y2, z2;
+	std::vector<double> c1x, c1y, c1z, c2x, c2y, c2z;	// diagonal covariances
+	std::vector<double> gate;		// squared distance above which a match is a clear outlier, -1 if invalid
+};
+
+#endif
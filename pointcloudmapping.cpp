@@ -1,33 +1,107 @@
 #include "pointcloudmapping.h"
 
-PointCloudMapping::PointCloudMapping()
+PointCloudMapping::PointCloudMapping(const SystemParameters& sysPara, double resolution, size_t queueSize_, bool showViewer_)
+	: queueSize(queueSize_ > 0 ? queueSize_ : 1), showViewer(showViewer_),
+	  voxelMap(resolution, sysPara.map_chunk_size), dropped(0), finishFlag(false)
 {
+	voxelMap.setStorage(sysPara.map_chunk_dir, (size_t)sysPara.map_budget_voxels<<20, sysPara.map_working_radius);
+	globalMap = boost::make_shared<PointCloud>();
+	mappingThread = std::thread(&PointCloudMapping::run, this);
+}
 
-	globalMap=boost::make_shared<PointCloud>();
-	viewerThread=make_shared<thread>(bind(&PointCloudMapping::viewer,this));
-	
+PointCloudMapping::~PointCloudMapping()
+{
+	finish();
+}
 
+bool PointCloudMapping::insertKeyFrame(int id, const cv::Mat& rgb, const cv::Mat& depth, const Eigen::Isometry3d& Twc, bool wait)
+{
+	if(depth.empty() || rgb.empty()) return false;
+	std::unique_lock<std::mutex> lock(mtx);
+	if(finishFlag) return false;
+	if(queue.size() >= queueSize)
+	{
+		if(!wait) {
+			dropped++;
+			return false;
+		}
+		while(queue.size() >= queueSize)
+			cv_queueSpace.wait(lock);
+	}
+	MappingJob job;
+	job.id = id;
+	job.rgb = rgb;
+	job.depth = depth;
+	job.Twc = Twc;
+	queue.push_back(job);
+	cv_keyframeUpdate.notify_one();
+	return true;
+}
+
+PointCloud::Ptr PointCloudMapping::snapshot()
+{
+	std::lock_guard<std::mutex> lock(snapshotMutex);
+	return globalMap;
+}
+
+int PointCloudMapping::droppedNum()
+{
+	std::lock_guard<std::mutex> lock(mtx);
+	return dropped;
 }
 
+void PointCloudMapping::finish()
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		finishFlag = true;
+	}
+	cv_keyframeUpdate.notify_one();
+	if(mappingThread.joinable())
+		mappingThread.join();
+}
 
-void PointCloudMapping::viewer()
+void PointCloudMapping::run()
 {
-	pcl::visualization::CloudViewer viewer("viewer");
+	std::shared_ptr<pcl::visualization::CloudViewer> viewer;
+	if(showViewer) viewer = std::make_shared<pcl::visualization::CloudViewer>("viewer");
 	while(1)
 	{
+		// everything queued so far is one batch, published once
+		std::deque<MappingJob, Eigen::aligned_allocator<MappingJob> > batch;
 		{
-			unique_lock<mutex> lck_shutdown(shutDownMutex);
-			if(shutDownFlag)break;
+			std::unique_lock<std::mutex> lock(mtx);
+			while(queue.empty() && !finishFlag)
+				cv_keyframeUpdate.wait(lock);
+			if(queue.empty()) break;
+			batch.swap(queue);
 		}
+		cv_queueSpace.notify_all();
+
+		for(size_t i=0; i<batch.size(); i++)
 		{
-			unique_lock<mutex> lck_keyframeUpdate(keyframeUpdateMutex);
-			cv_keyframeUpdate.wait(lck_keyframeUpdate);
-		}
-		
-		{
-			unique_lock<mutex> lck_keyframe(keyframeMutex);
-			
+			PROF_SCOPE(PROF_MAP_INTEGRATE);
+			// a bare frame over the shared images, for img2cloud and the camera of Frame
+			Frame f;
+			f.rgb = batch[i].rgb;
+			f.depth = batch[i].depth;
+			voxelMap.integrate(batch[i].id, *f.img2cloud(), batch[i].Twc);
 		}
+
+		publish(true, viewer.get());
+	}
+	// the resident snapshot misses the chunks on disk
+	if(snapshot()->size() != voxelMap.size())
+		publish(false, viewer.get());
+}
+
+void PointCloudMapping::publish(bool residentOnly, pcl::visualization::CloudViewer* viewer)
+{
+	PointCloud::Ptr cloud = boost::make_shared<PointCloud>();
+	voxelMap.toCloud(*cloud, 1, residentOnly);
+	{
+		std::lock_guard<std::mutex> lock(snapshotMutex);
+		globalMap = cloud;
 	}
-	return;
+	if(viewer) viewer->showCloud(cloud);
 }
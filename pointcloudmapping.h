@@ -2,32 +2,66 @@
 #define POINT_CLOUD_MAPPING_H
 
 
-#include "base.h"
+#include "frame.h"
+#include "voxel_map.h"
+#include <thread>
+#include <mutex>
+#include <deque>
 #include <condition_variable>
 
+//! dense map built on its own thread: keyframe images are queued by tracking, turned into clouds and
+//! integrated into a VoxelMap of the given resolution; the chunks in RAM are published after each batch,
+//! those written out of the working radius only in the last snapshot, so that a batch never reads the disk
+//! the queue is bounded, tracking never waits on the map
 class PointCloudMapping
 {
 public:
-	PointCloudMapping();
-	void viewer();
-	
-	
-	std::shared_ptr<thread> viewerThread;
-	
-	PointCloud::Ptr globalMap;
-	bool 		shutDownFlag=false;
-	std::mutex 	shutDownMutex;
-	
-	condition_variable 	cv_keyframeUpdate;
-	std::mutex  		keyframeUpdateMutex;
-	
-	std::mutex 			keyframeMutex;
-	
-	
-	double resolution = 0.05;
+	PointCloudMapping(const SystemParameters& sysPara, double resolution = 0.05, size_t queueSize = 16, bool showViewer = true);
+	~PointCloudMapping();
+	//! images are shared, not copied; a keyframe inserted again is re-integrated at its new pose
+	//! returns false and drops the keyframe if the queue is full, unless wait is set
+	bool insertKeyFrame(int id, const cv::Mat& rgb, const cv::Mat& depth, const Eigen::Isometry3d& Twc, bool wait = false);
+	bool insertKeyFrame(const Frame& kf, const Eigen::Isometry3d& Twc, bool wait = false)
+	{
+		return insertKeyFrame(kf.id, kf.rgb, kf.depth, Twc, wait);
+	}
+	//! latest published map, never modified once published
+	PointCloud::Ptr snapshot();
+	int droppedNum();
+	//! stop the thread after the queued keyframes are integrated, the last snapshot holds all of them
+	void finish();
+	//! the map integrated so far, only once finish() returned
+	const VoxelMap& voxels() const { return voxelMap; }
 
+private:
+	struct MappingJob
+	{
+		int 				id;
+		cv::Mat 			rgb, depth;
+		Eigen::Isometry3d 	Twc;
+		EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	};
+
+	void run();
+	//! snapshot of the map, the chunks on disk included unless residentOnly
+	void publish(bool residentOnly, pcl::visualization::CloudViewer* viewer);
+
+	size_t 				queueSize;
+	bool 				showViewer;
+	VoxelMap 			voxelMap;		// only touched by the mapping thread
+
+	std::thread 		mappingThread;
+	std::mutex 			mtx;			// guards queue, dropped and finishFlag
+	std::condition_variable cv_keyframeUpdate;
+	std::condition_variable cv_queueSpace;
+	std::deque<MappingJob, Eigen::aligned_allocator<MappingJob> > queue;
+	int 				dropped;
+	bool 				finishFlag;
+
+	std::mutex 			snapshotMutex;	// guards globalMap
+	PointCloud::Ptr 	globalMap;
 };
 
 
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,168 @@
+#include "pose_graph.h"
+#include <iostream>
+#include "profiler.h"
+#include "g2o/examples/interactive_slam/g2o_incremental/graph_optimizer_sparse_incremental.h"
+#include "g2o/examples/interactive_slam/g2o_interactive/types_slam3d_online.h"
+
+using namespace std;
+
+IncrementalPoseGraph::IncrementalPoseGraph(int firstId, int batchEveryN_)
+	: optimizer(new g2o::SparseOptimizerIncremental), batchEveryN(batchEveryN_), lastBatchStep(0),
+	  firstOptimization(true), finishFlag(false)
+{
+	optimizer->setVerbose(false);
+	optimizer->initSolver(6, batchEveryN);
+
+	g2o::OnlineVertexSE3* v = new g2o::OnlineVertexSE3;
+	v->setId(firstId);
+	v->setEstimate(Eigen::Isometry3d::Identity());
+	v->updatedEstimate = v->estimate();
+	v->setFixed(true);
+	optimizer->addVertex(v);
+	poses[firstId] = v->estimate();
+
+	solverThread = std::thread(&IncrementalPoseGraph::run, this);
+}
+
+IncrementalPoseGraph::~IncrementalPoseGraph()
+{
+	finish();
+	delete optimizer;
+}
+
+void IncrementalPoseGraph::addEdge(int from, int to, const Eigen::Isometry3d& T,
+				   const Eigen::Matrix<double,6,6>& information)
+{
+	PoseEdge e;
+	e.from = from;
+	e.to = to;
+	e.T = T;
+	e.info = information;
+	std::lock_guard<std::mutex> lock(mtx);
+	pending.push_back(e);
+	cv_newEdge.notify_one();
+}
+
+bool IncrementalPoseGraph::pose(int id, Eigen::Isometry3d& Twc)
+{
+	std::lock_guard<std::mutex> lock(poseMutex);
+	PoseMap::const_iterator it = poses.find(id);
+	if(it == poses.end()) return false;
+	Twc = it->second;
+	return true;
+}
+
+int IncrementalPoseGraph::solvedNum()
+{
+	std::lock_guard<std::mutex> lock(poseMutex);
+	return poses.size();
+}
+
+void IncrementalPoseGraph::finish()
+{
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		finishFlag = true;
+	}
+	cv_newEdge.notify_one();
+	if(solverThread.joinable())
+		solverThread.join();
+}
+
+void IncrementalPoseGraph::run()
+{
+	while(1)
+	{
+		PoseEdgeVector edges;
+		{
+			std::unique_lock<std::mutex> lock(mtx);
+			while(pending.empty() && !finishFlag)
+				cv_newEdge.wait(lock);
+			if(pending.empty()) break;
+			edges.swap(pending);  // everything queued meanwhile goes into one update
+		}
+		if(!update(edges))
+			cout<<"incremental pose graph update failed"<<endl;
+	}
+}
+
+bool IncrementalPoseGraph::update(const PoseEdgeVector& edges)
+{
+	g2o::HyperGraph::VertexSet verticesAdded;
+	g2o::HyperGraph::EdgeSet edgesAdded;
+	bool loop = false;
+	for(size_t i=0; i<edges.size(); ++i)
+	{
+		const PoseEdge& pe = edges[i];
+		g2o::OnlineVertexSE3* v1 = static_cast<g2o::OnlineVertexSE3*>(optimizer->vertex(pe.from));
+		g2o::OnlineVertexSE3* v2 = static_cast<g2o::OnlineVertexSE3*>(optimizer->vertex(pe.to));
+		if(!v1 && !v2) {
+			cout<<"pose graph edge "<<pe.from<<"-"<<pe.to<<" not connected, skipped"<<endl;
+			continue;
+		}
+		int newVertex = 0;  // 1: from is new, 2: to is new
+		if(!v1) {
+			v1 = new g2o::OnlineVertexSE3;
+			v1->setId(pe.from);
+			optimizer->addVertex(v1);
+			verticesAdded.insert(v1);
+			newVertex = 1;
+		}
+		if(!v2) {
+			v2 = new g2o::OnlineVertexSE3;
+			v2->setId(pe.to);
+			optimizer->addVertex(v2);
+			verticesAdded.insert(v2);
+			newVertex = 2;
+		}
+		if(!newVertex) loop = true;
+
+		g2o::OnlineEdgeSE3* e = new g2o::OnlineEdgeSE3;
+		e->vertices()[0] = v1;
+		e->vertices()[1] = v2;
+		e->setMeasurement(pe.T);
+		e->setInformation(pe.info);
+		optimizer->addEdge(e);
+		edgesAdded.insert(e);
+
+		// initialize the new end from the solved one
+		g2o::OptimizableGraph::VertexSet known;
+		if(newVertex == 2) {
+			known.insert(v1);
+			e->initialEstimate(known, v2);
+		} else if(newVertex == 1) {
+			known.insert(v2);
+			e->initialEstimate(known, v1);
+		}
+	}
+	if(edgesAdded.empty()) return true;
+
+	// relinearize the whole graph every batchEveryN vertices and after a loop closure,
+	// rank updates in between
+	optimizer->batchStep = false;
+	if(loop || (int)optimizer->vertices().size() - lastBatchStep >= batchEveryN) {
+		lastBatchStep = optimizer->vertices().size();
+		optimizer->batchStep = true;
+	}
+
+	if(firstOptimization) {
+		if(!optimizer->initializeOptimization()) return false;
+	} else {
+		if(!optimizer->updateInitialization(verticesAdded, edgesAdded)) return false;
+	}
+	{
+		PROF_SCOPE(PROF_G2O);
+		optimizer->optimize(1, !firstOptimization);
+	}
+	firstOptimization = false;
+
+	// publish, an update may move every pose of the graph
+	std::lock_guard<std::mutex> lock(poseMutex);
+	for(g2o::HyperGraph::VertexIDMap::const_iterator it = optimizer->vertices().begin();
+	    it != optimizer->vertices().end(); ++it)
+	{
+		const g2o::OnlineVertexSE3* v = static_cast<const g2o::OnlineVertexSE3*>(it->second);
+		poses[v->id()] = v->updatedEstimate;
+	}
+	return true;
+}
@@ -0,0 +1,65 @@
+#ifndef POSE_GRAPH_H
+#define POSE_GRAPH_H
+
+#include <map>
+#include <vector>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <Eigen/StdVector>
+
+namespace g2o {
+	class SparseOptimizerIncremental;
+}
+
+//! keyframe pose graph solved incrementally on its own thread (g2o_incremental, cholmod rank updates)
+//! edges are queued by tracking and loop closing, each batch of new edges costs one incremental update
+//! instead of the full optimize at the end of the run
+class IncrementalPoseGraph
+{
+public:
+	//! firstId is the fixed origin of the graph
+	IncrementalPoseGraph(int firstId = 0, int batchEveryN = 100);
+	~IncrementalPoseGraph();
+	//! T is the pose of "to" in the CS of "from", as EdgeSE3
+	//! an unknown "to" is initialized from "from" by T
+	void addEdge(int from, int to, const Eigen::Isometry3d& T, const Eigen::Matrix<double,6,6>& information);
+	//! latest solved pose, false if id is not solved yet
+	bool pose(int id, Eigen::Isometry3d& Twc);
+	int solvedNum();
+	//! stop the thread after the queued edges are solved
+	void finish();
+
+private:
+	struct PoseEdge
+	{
+		int 						from, to;
+		Eigen::Isometry3d 			T;
+		Eigen::Matrix<double,6,6> 	info;
+		EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+	};
+	typedef std::vector<PoseEdge, Eigen::aligned_allocator<PoseEdge> > PoseEdgeVector;
+	typedef std::map<int, Eigen::Isometry3d, std::less<int>,
+			 Eigen::aligned_allocator<std::pair<const int, Eigen::Isometry3d> > > PoseMap;
+
+	void run();
+	bool update(const PoseEdgeVector& edges);
+
+	g2o::SparseOptimizerIncremental* optimizer;	// only touched by the solver thread
+	int 			batchEveryN;
+	int 			lastBatchStep;
+	bool 			firstOptimization;
+
+	std::thread 	solverThread;
+	std::mutex 		mtx;			// guards pending and finishFlag
+	std::condition_variable cv_newEdge;
+	PoseEdgeVector 	pending;
+	bool 			finishFlag;
+
+	std::mutex 		poseMutex;		// guards poses
+	PoseMap 		poses;
+};
+
+#endif
@@ -0,0 +1,144 @@
+#include "profiler.h"
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+bool 		Profiler::on = false;
+std::string Profiler::traceFile;
+
+namespace
+{
+const size_t RING_SIZE = 1<<16;	// events per thread, power of 2
+
+struct Ring
+{
+	std::vector<Profiler::Event> events;
+	std::atomic<size_t> 	n;		// events recorded so far, the ring holds the last RING_SIZE
+	int 					tid;
+};
+
+std::mutex 	ringsMutex;		// guards rings, only taken when a thread records its first event
+std::vector<std::shared_ptr<Ring> > rings;	// kept after their threads end
+int64_t 	origin = 0;		// ns at start(), trace timestamps are relative to it
+
+Ring& localRing()
+{
+	static thread_local std::shared_ptr<Ring> ring;
+	if(!ring)
+	{
+		ring = std::make_shared<Ring>();
+		ring->events.resize(RING_SIZE);
+		ring->n = 0;
+		std::lock_guard<std::mutex> lock(ringsMutex);
+		ring->tid = rings.size();
+		rings.push_back(ring);
+	}
+	return *ring;
+}
+
+//! the events held by all rings
+void collect(std::vector<Profiler::Event>& events, std::vector<int>& tids)
+{
+	std::lock_guard<std::mutex> lock(ringsMutex);
+	for(size_t i=0; i<rings.size(); i++)
+	{
+		const size_t n = rings[i]->n.load(std::memory_order_acquire);
+		for(size_t k = n > RING_SIZE ? n-RING_SIZE : 0; k<n; k++)
+		{
+			events.push_back(rings[i]->events[k&(RING_SIZE-1)]);
+			tids.push_back(rings[i]->tid);
+		}
+	}
+}
+
+//! nearest rank, sorted input
+double percentile(const std::vector<double>& sorted, double p)
+{
+	size_t k = (size_t)(p*sorted.size() + 0.5);
+	return sorted[std::min(std::max(k, (size_t)1), sorted.size()) - 1];
+}
+}
+
+void Profiler::start(const std::string& traceFile_)
+{
+	if(on) return;
+	traceFile = traceFile_;
+	origin = now();
+	on = true;
+	atexit(&Profiler::report);
+}
+
+void Profiler::record(int stage, int64_t t0, int64_t t1)
+{
+	Ring& r = localRing();
+	const size_t n = r.n.load(std::memory_order_relaxed);
+	Event& e = r.events[n&(RING_SIZE-1)];
+	e.t0 = t0;
+	e.t1 = t1;
+	e.stage = stage;
+	r.n.store(n+1, std::memory_order_release);
+}
+
+const char* Profiler::stageName(int stage)
+{
+	static const char* names[PROF_STAGE_NUM] = {"decode", "line detect", "MSLD", "line lift", "ORB", "match",
+						    "GMS", "RANSAC", "g2o", "ICP", "plane fit", "map integrate"};
+	return stage >= 0 && stage < PROF_STAGE_NUM ? names[stage] : "unknown";
+}
+
+void Profiler::printSummary()
+{
+	std::vector<Event> events;
+	std::vector<int> tids;
+	collect(events, tids);
+	std::vector<std::vector<double> > ms(PROF_STAGE_NUM);
+	for(size_t i=0; i<events.size(); i++)
+		if(events[i].stage >= 0 && events[i].stage < PROF_STAGE_NUM)
+			ms[events[i].stage].push_back((events[i].t1 - events[i].t0)/1e6);
+
+	char line[160];
+	snprintf(line, sizeof(line), "%-14s %8s %9s %9s %9s %9s %11s", "stage (ms)", "count", "mean", "p50", "p95", "p99", "total");
+	std::cout<<line<<std::endl;
+	for(int s=0; s<PROF_STAGE_NUM; s++)
+	{
+		std::vector<double>& v = ms[s];
+		if(v.empty()) continue;
+		std::sort(v.begin(), v.end());
+		double total = 0;
+		for(size_t i=0; i<v.size(); i++) total += v[i];
+		snprintf(line, sizeof(line), "%-14s %8zu %9.3f %9.3f %9.3f %9.3f %11.1f", stageName(s), v.size(), total/v.size(),
+			 percentile(v, 0.5), percentile(v, 0.95), percentile(v, 0.99), total);
+		std::cout<<line<<std::endl;
+	}
+}
+
+bool Profiler::saveTrace(const std::string& filename)
+{
+	FILE* f = fopen(filename.c_str(), "w");
+	if(!f)
+	{
+		std::cout<<"Cannot write trace "<<filename<<std::endl;
+		return false;
+	}
+	std::vector<Event> events;
+	std::vector<int> tids;
+	collect(events, tids);
+	fprintf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	for(size_t i=0; i<events.size(); i++)
+		fprintf(f, "%s\n{\"name\":\"%s\",\"cat\":\"slam\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+			i ? "," : "", stageName(events[i].stage), tids[i], (events[i].t0 - origin)/1e3, (events[i].t1 - events[i].t0)/1e3);
+	fprintf(f, "\n]}\n");
+	return fclose(f) == 0;
+}
+
+void Profiler::report()
+{
+	printSummary();
+	if(!traceFile.empty())
+		saveTrace(traceFile);
+}
@@ -0,0 +1,84 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <string>
+#include <stdint.h>
+#include <time.h>
+
+//! pipeline stages timed by PROF_SCOPE
+enum ProfStage
+{
+	PROF_DECODE = 0,
+	PROF_LINE_DETECT,
+	PROF_MSLD,
+	PROF_LINE_LIFT,
+	PROF_ORB,
+	PROF_MATCH,
+	PROF_GMS,
+	PROF_RANSAC,
+	PROF_G2O,
+	PROF_ICP,
+	PROF_PLANE_FIT,
+	PROF_MAP_INTEGRATE,
+	PROF_STAGE_NUM
+};
+
+//! per stage latency profiler
+//! every thread records into its own ring buffer, no lock and no allocation once the buffer exists;
+//! a full ring overwrites its oldest events, the statistics are over the events still held
+//! nothing is recorded until start()
+class Profiler
+{
+public:
+	struct Event
+	{
+		int64_t 	t0, t1;		// ns, monotonic clock
+		int 		stage;
+	};
+
+	//! enable recording, before the threads to profile start
+	//! the summary is printed and traceFile (if not empty) written at exit
+	static void start(const std::string& traceFile = "");
+	static bool enabled() { return on; }
+	static int64_t now()
+	{
+		timespec t;
+		clock_gettime(CLOCK_MONOTONIC, &t);
+		return (int64_t)t.tv_sec*1000000000 + t.tv_nsec;
+	}
+	static void record(int stage, int64_t t0, int64_t t1);
+
+	//! count, mean, p50/p95/p99 and total per stage
+	//! the other threads should be done recording, their rings are read without a lock
+	static void printSummary();
+	//! Chrome trace event format (chrome://tracing, Perfetto), one row per thread
+	static bool saveTrace(const std::string& filename);
+	static const char* stageName(int stage);
+
+private:
+	static void report();
+
+	static bool 		on;
+	static std::string 	traceFile;
+};
+
+//! times the enclosing scope as one event of stage
+class ProfScope
+{
+public:
+	explicit ProfScope(ProfStage s) : stage(s), t0(Profiler::enabled() ? Profiler::now() : 0) {}
+	~ProfScope() { if(t0) Profiler::record(stage, t0, Profiler::now()); }
+
+private:
+	ProfScope(const ProfScope&);
+	ProfScope& operator=(const ProfScope&);
+
+	int 		stage;
+	int64_t 	t0;
+};
+
+#define PROF_CAT_(a, b) a##b
+#define PROF_CAT(a, b) PROF_CAT_(a, b)
+#define PROF_SCOPE(stage) ProfScope PROF_CAT(profScope_, __LINE__)(stage)
+
+#endif
@@ -0,0 +1,229 @@
+//! end-to-end benchmark: runs lineslam / naive_slam headless over a list of TUM sequences and reports
+//! accuracy (ATE, RPE against groundtruth.txt), tracking latency, throughput, peak RSS and keyframes
+//! usage: slam_bench sequences [report] [baseline] [tolerance]
+//!   sequences: "name binary dataset_path settings" per line, '#' comments, see sequences.txt
+//!   report:    prefix of report.txt (one line per sequence, a baseline for a later run) and report.json
+//!   baseline:  report.txt of an earlier run; a sequence whose ATE or RPE got worse by more than
+//!              tolerance (default 0.1 = 10%, plus 2 mm / 0.1 deg of noise) fails the run
+//! the output of each run goes to bench_<name>/, exit status 1 if a run failed or regressed
+//! ATE and RPE are over every tracked frame of traject_all.txt (lineslam: the keyframes and the frames in between
+//! relative to them, the frames lost at a keyframe step have no pose), over the keyframes of traject.txt if a
+//! binary writes no traject_all.txt (naive_slam); the RPE pairs are the poses 1 s apart.
+//! The runs are headless, so the whole sequence is used
+#include "evaluation.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <cstdio>
+#include <cstdlib>
+#include <climits>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+
+using namespace std;
+
+struct SequenceResult
+{
+	string 		name, binary;
+	bool 		ok;
+	int 		frames, keyframes;
+	double 		wall_s, fps_tracking, fps_wall;
+	double 		latency_mean, latency_p50, latency_p95, latency_max;	// ms
+	double 		peak_rss_mb;
+	ErrorStats 	ate, rpe_trans, rpe_rot;
+	SequenceResult() : ok(false), frames(0), keyframes(0), wall_s(0), fps_tracking(0), fps_wall(0),
+		latency_mean(0), latency_p50(0), latency_p95(0), latency_max(0), peak_rss_mb(0) {}
+};
+
+static string absolutePath(const string& path)
+{
+	char buf[PATH_MAX];
+	if(!realpath(path.c_str(), buf)) return path;
+	return buf;
+}
+
+//! runs binary in dir with its output in dir/log.txt, returns the exit status
+static int runHeadless(const string& dir, const string& binary, const string& dataset, const string& settings,
+		       double& wall_s, double& peak_rss_mb)
+{
+	struct timeval t0, t1;
+	gettimeofday(&t0, NULL);
+	pid_t pid = fork();
+	if(pid < 0) return -1;
+	if(pid == 0)
+	{
+		if(chdir(dir.c_str()) != 0) _exit(127);
+		int fd = open("log.txt", O_WRONLY|O_CREAT|O_TRUNC, 0644);
+		if(fd >= 0)
+		{
+			dup2(fd, 1);
+			dup2(fd, 2);
+			close(fd);
+		}
+		execl(binary.c_str(), binary.c_str(), "--headless", dataset.c_str(), settings.c_str(), (char*)0);
+		_exit(127);
+	}
+	int status = 0;
+	struct rusage usage;
+	if(wait4(pid, &status, 0, &usage) < 0) return -1;
+	gettimeofday(&t1, NULL);
+	wall_s = (t1.tv_sec-t0.tv_sec) + (t1.tv_usec-t0.tv_usec)/1e6;
+	peak_rss_mb = usage.ru_maxrss/1024.0;	// KB on Linux
+	return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+static SequenceResult runSequence(const string& name, const string& binary, string dataset, const string& settings)
+{
+	SequenceResult r;
+	r.name = name;
+	r.binary = binary;
+	if(!dataset.empty() && dataset[dataset.size()-1] != '/') dataset += "/";
+	const string dir = "bench_" + name;
+	mkdir(dir.c_str(), 0755);
+
+	cout<<"Running "<<name<<" ("<<binary<<")"<<endl;
+	remove((dir + "/traject_all.txt").c_str());	// not from an earlier run of another binary
+	int status = runHeadless(dir, absolutePath(binary), absolutePath(dataset) + "/", absolutePath(settings),
+				 r.wall_s, r.peak_rss_mb);
+	if(status != 0)
+	{
+		cout<<name<<": exit status "<<status<<", see "<<dir<<"/log.txt"<<endl;
+		return r;
+	}
+
+	FrameLog log;
+	if(log.load(dir + "/frames.txt") && log.size() > 0)
+	{
+		r.frames = log.size();
+		r.keyframes = log.keyFrameNum();
+		r.fps_tracking = log.fps();
+		r.fps_wall = r.frames/r.wall_s;
+		double sum = 0;
+		for(int i=0; i<log.size(); i++) sum += log.latencies[i];
+		r.latency_mean = sum/log.size();
+		r.latency_p50 = log.percentile(0.5);
+		r.latency_p95 = log.percentile(0.95);
+		r.latency_max = log.percentile(1);
+	}
+
+	Trajectory est, gt, estA, gtA;
+	const bool allFrames = loadTUMTrajectory(dir + "/traject_all.txt", est) && !est.empty();
+	if(!allFrames) loadTUMTrajectory(dir + "/traject.txt", est);
+	if(est.empty() || !loadTUMTrajectory(dataset + "groundtruth.txt", gt))
+	{
+		cout<<name<<": trajectory or ground truth missing"<<endl;
+		return r;
+	}
+	associate(est, gt, 0.02, estA, gtA);
+	if(estA.size() < 3)
+	{
+		cout<<name<<": "<<estA.size()<<" poses associated with the ground truth"<<endl;
+		return r;
+	}
+	if(!r.keyframes && !allFrames) r.keyframes = est.size();
+	r.ate = computeATE(estA, gtA);
+	computeRPE(estA, gtA, 1.0, r.rpe_trans, r.rpe_rot);
+	r.ok = true;
+	return r;
+}
+
+//! report.txt: name ok ate_rmse rpe_trans_rmse rpe_rot_rmse fps_tracking fps_wall peak_rss_mb keyframes
+static void saveReport(const string& prefix, const vector<SequenceResult>& results)
+{
+	ofstream txt((prefix + ".txt").c_str());
+	txt<<"# name ok ate_rmse_m rpe_trans_rmse_m rpe_rot_rmse_deg fps_tracking fps_wall peak_rss_mb keyframes\n";
+	for(size_t i=0; i<results.size(); i++)
+	{
+		const SequenceResult& r = results[i];
+		txt<<r.name<<" "<<r.ok<<" "<<r.ate.rmse<<" "<<r.rpe_trans.rmse<<" "<<r.rpe_rot.rmse<<" "<<r.fps_tracking
+		   <<" "<<r.fps_wall<<" "<<r.peak_rss_mb<<" "<<r.keyframes<<"\n";
+	}
+
+	ofstream json((prefix + ".json").c_str());
+	json<<"{\n\"sequences\": [";
+	for(size_t i=0; i<results.size(); i++)
+	{
+		const SequenceResult& r = results[i];
+		json<<(i ? "," : "")<<"\n{\"name\": \""<<r.name<<"\", \"binary\": \""<<r.binary<<"\", \"ok\": "<<(r.ok ? "true" : "false")
+		    <<", \"frames\": "<<r.frames<<", \"keyframes\": "<<r.keyframes
+		    <<", \"wall_s\": "<<r.wall_s<<", \"fps_tracking\": "<<r.fps_tracking<<", \"fps_wall\": "<<r.fps_wall
+		    <<", \"latency_ms\": {\"mean\": "<<r.latency_mean<<", \"p50\": "<<r.latency_p50<<", \"p95\": "<<r.latency_p95
+		    <<", \"max\": "<<r.latency_max<<"}, \"peak_rss_mb\": "<<r.peak_rss_mb
+		    <<", \"ate_m\": {\"n\": "<<r.ate.n<<", \"rmse\": "<<r.ate.rmse<<", \"mean\": "<<r.ate.mean<<", \"median\": "<<r.ate.median<<", \"max\": "<<r.ate.max<<"}"
+		    <<", \"rpe_trans_m\": {\"n\": "<<r.rpe_trans.n<<", \"rmse\": "<<r.rpe_trans.rmse<<", \"mean\": "<<r.rpe_trans.mean<<", \"max\": "<<r.rpe_trans.max<<"}"
+		    <<", \"rpe_rot_deg\": {\"n\": "<<r.rpe_rot.n<<", \"rmse\": "<<r.rpe_rot.rmse<<", \"mean\": "<<r.rpe_rot.mean<<", \"max\": "<<r.rpe_rot.max<<"}}";
+	}
+	json<<"\n]\n}\n";
+}
+
+int main(int argc, char** argv)
+{
+	if(argc < 2)
+	{
+		cout<<"Usage: slam_bench sequences [report] [baseline] [tolerance]"<<endl;
+		return 2;
+	}
+	const string prefix = argc > 2 ? argv[2] : "report";
+	const string baseline = argc > 3 ? argv[3] : "";
+	const double tolerance = argc > 4 ? atof(argv[4]) : 0.1;
+
+	ifstream list(argv[1]);
+	if(!list)
+	{
+		cout<<"Cannot read "<<argv[1]<<endl;
+		return 2;
+	}
+	vector<SequenceResult> results;
+	string line;
+	while(getline(list, line))
+	{
+		istringstream ss(line);
+		string name, binary, dataset, settings;
+		if(line.empty() || line[0] == '#' || !(ss>>name>>binary>>dataset>>settings)) continue;
+		results.push_back(runSequence(name, binary, dataset, settings));
+	}
+	saveReport(prefix, results);
+
+	//baseline: name ok ate rpe_t rpe_r ...
+	map<string, pair<double, pair<double, double> > > base;
+	if(!baseline.empty())
+	{
+		ifstream in(baseline.c_str());
+		if(!in) cout<<"Cannot read baseline "<<baseline<<endl;
+		while(getline(in, line))
+		{
+			istringstream ss(line);
+			string name;
+			int ok;
+			double ate, rpe_t, rpe_r;
+			if(line.empty() || line[0] == '#' || !(ss>>name>>ok>>ate>>rpe_t>>rpe_r) || !ok) continue;
+			base[name] = make_pair(ate, make_pair(rpe_t, rpe_r));
+		}
+	}
+
+	bool pass = true;
+	printf("%-24s %9s %9s %9s %8s %8s %8s %9s %5s\n", "sequence", "ATE(m)", "RPEt(m)", "RPEr(deg)", "fps", "p95(ms)", "RSS(MB)", "keyframes", "");
+	for(size_t i=0; i<results.size(); i++)
+	{
+		const SequenceResult& r = results[i];
+		string verdict = r.ok ? "ok" : "FAIL";
+		if(r.ok && base.count(r.name))
+		{
+			const pair<double, pair<double, double> >& b = base[r.name];
+			if(r.ate.rmse > b.first*(1+tolerance) + 0.002 ||
+			   r.rpe_trans.rmse > b.second.first*(1+tolerance) + 0.002 ||
+			   r.rpe_rot.rmse > b.second.second*(1+tolerance) + 0.1)
+				verdict = "WORSE";
+		}
+		pass = pass && verdict == "ok";
+		printf("%-24s %9.4f %9.4f %9.3f %8.2f %8.1f %8.0f %9d %5s\n", r.name.c_str(), r.ate.rmse, r.rpe_trans.rmse,
+		       r.rpe_rot.rmse, r.fps_tracking, r.latency_p95, r.peak_rss_mb, r.keyframes, verdict.c_str());
+	}
+	cout<<"Report: "<<prefix<<".txt, "<<prefix<<".json"<<endl;
+	return pass ? 0 : 1;
+}
@@ -1,1245 +1,2020 @@
-#include <pangolin/pangolin.h>
-#include "utils.h"
-#include "base.h"
-#include "PnPsolver.h"
-#include "gms_matcher.h"
-#include <cmath>
-#include <map>
-#include <iomanip>
-#include <opencv2/core/eigen.hpp>
-
-using namespace std;
-
-Eigen::Isometry3d cvMat2Eigen(Mat& rvec,Mat& tvec)
-{
-      Mat R;
-      cv::Rodrigues(rvec,R);
-      Eigen::Matrix3d r;
-      cv::cv2eigen(R,r);
-
-      Eigen::Isometry3d T=Eigen::Isometry3d::Identity();
-      Eigen::AngleAxisd angle(r);
-      T=angle;
-
-      T(0,3)=tvec.at<float>(0,0);
-      T(1,3)=tvec.at<float>(1,0);
-      T(2,3)=tvec.at<float>(2,0); 
-       
-      //Eigen::Quaterniond q(r);
-      //cout<<"Quaterniond"<<q.x()<<" "<<q.y()<<" "<<q.z()<<" "<<q.w()<<endl;
-      
-      return T;
-}
-
-Eigen::Matrix4f cvMat2EigenMatrix4f(Mat& rvec,Mat& tvec)
-{
-      Eigen::Matrix4f T = Eigen::Matrix4f::Identity();
-      
-      
-      Mat R;
-      Rodrigues(rvec,R);
-      Mat t = (Mat_<double>(3,1)<<tvec.at<double>(0,0),tvec.at<double>(1,0),tvec.at<double>(2,0));
-     
-      Mat Tcw = cv::Mat::eye(4,4,CV_32F);
-      R.copyTo(Tcw.rowRange(0,3).colRange(0,3));
-      t.copyTo(Tcw.rowRange(0,3).col(3));
-      cv::cv2eigen(Tcw,T);
-
-      return T;
-}
-
-PointCloud::Ptr joinPointCloud(PointCloud::Ptr cloud,Frame frame,Eigen::Isometry3d& T)
-{
-      PointCloud::Ptr newcloud=frame.img2cloud();
-      
-      //cout<<"Join PointCloud."<<endl;
-      PointCloud::Ptr output(new PointCloud);
-      pcl::transformPointCloud(*cloud,*output,T.matrix());
-      *newcloud+=*output;
-      return newcloud;
-      //pcl::io::savePCDFile("1.pcd",*output);
-
-}
-
-cv::Mat drawInlier(Frame &f1, Frame &f2, vector<vector<int>>& matches)
-{
-    cv::Mat src1,src2;
-    f1.rgb.copyTo(src1);
-    f2.rgb.copyTo(src2);
-    const int height = max(src1.rows, src2.rows);
-    const int width = src1.cols + src2.cols;
-    cv::Mat output(height, width, CV_8UC3,cv::Scalar(0,0,0));
-    src1.copyTo(output(cv::Rect(0,0,src1.cols, src1.rows)));
-    src2.copyTo(output(cv::Rect(src1.cols,0,src2.cols, src2.rows)));
-
-    return output;
-}
-
-
-int testline()
-{
-    Camera tum1;
-    tum1.fx = 517.306408;
-    tum1.fy = 516.469215;
-    tum1.cx = 318.643040;
-    tum1.cy = 255.313989;
-    tum1.scale = 5000.0;
-    
-    Camera camera1;
-    camera1.fx = 525;
-    camera1.fy = 525;
-    camera1.cx = 319.5;
-    camera1.cy = 239.5;
-    camera1.scale = 5000.0;
-    
-    Camera tum3;
-    tum3.fx = 535.4;
-    tum3.fy = 539.2;
-    tum3.cx = 320.1;
-    tum3.cy = 247.6;
-    tum3.scale = 5000.0;
-    
-    SystemParameters sysPara;
-
-    //Frame f1(0.0, "../data/1.png","../data/d1.png",tum3);
-    //Frame f2(0.0, "../data/3.png","../data/d3.png",tum3);
-    
-    Frame f1(0.0, "../data/img1.png","../data/depth1.png",tum1);
-    Frame f2(0.0, "../data/img3.png","../data/depth3.png",tum1);
-
-    //Frame f1(0.0, "../pairs/pair1-scn2/normal_rgb.png","../pairs/pair1-scn2/normal_depth.png",camera1);
-    //Frame f2(0.0, "../pairs/pair1-scn2/dark_1_rgb.png","../pairs/pair1-scn2/dark_1_depth.png",camera1);
-    
-    
-    vector<DMatch> bf_matches;
-    BruteForceMatcher<HammingLUT> matcher;
-    matcher.match(f1.mDescriptors,f2.mDescriptors,bf_matches);
-    vector<DMatch> pt_matches = GmsMatch(f1,f2, bf_matches);
-    //vector<DMatch> pt_matches = FilterMatch(f1,f2, bf_matches);
-    
-    Mat img;
-    img = f2.rgb.clone();
-    for(int i=0; i<pt_matches.size();i++)
-    {
-		circle(img,f1.mvKeypoints[pt_matches[i].queryIdx].pt,1,Scalar(255,0,0),2);
-		circle(img,f2.mvKeypoints[pt_matches[i].trainIdx].pt,1,Scalar(0,0,255),2);
-    }
-    drawMatches(f1.rgb,f1.mvKeypoints,f2.rgb,f2.mvKeypoints,pt_matches,img);
-    imshow("matchShow",img);
-	imwrite("1111.png",img);
-    waitKey(0);
-    
-
-
-    vector<vector<int>> matches;
-    matchLine(f1.lines,f2.lines,matches);
-    vector<DMatch> ln_matches;
-    for(int i=0; i<matches.size(); i++)
-    {
-		int p1 = matches[i][0];
-		int p2 = matches[i][1];
-		if(!f1.lines[p1].haveDepth || !f2.lines[p2].haveDepth)continue;
-		double len1 = cv::norm(f1.lines[p1].line3d.A - f1.lines[p1].line3d.B);
-		double len2 = cv::norm(f2.lines[p2].line3d.A - f2.lines[p2].line3d.B);
-		//if(abs(len1-len2)>0.03)continue;
-		DMatch tmp(matches[i][0],matches[i][1],0);
-		ln_matches.push_back(tmp);
-    }
-   
-   cv::Mat   t1,t2;
-   t1=f1.rgb.clone();
-   t2=f2.rgb.clone();
-   cout<<"f1 Lines:"<<f1.lines.size()<<"  f2 Lines: "<<f2.lines.size()<<"  Original Match: "<<matches.size()<<"  Line Match: "<<ln_matches.size()<<endl;
-   for(int i=0; i<f1.lines.size();i++)
-   {
-       cv::Point2f left1 = f1.lines[i].p;
-       cv::Point2f left2 = f1.lines[i].q;
-       cv::line(t1,left1,left2,cv::Scalar(0,0,255),3);
-   }
-   cvNamedWindow("output1");
-   cv::imshow("output1", t1);
-   
-   for(int i=0; i<f2.lines.size();i++)
-   {
-       cv::Point2f right1 = f2.lines[i].p ;
-       cv::Point2f right2 = f2.lines[i].q ;
-       cv::line(t2,right1,right2,cv::Scalar(0,0,255),3);
-   }
-   cvNamedWindow("output2");
-   cv::imshow("output2", t2);
-    
-    cv::Mat output = drawInlier(f1,f2,matches);
-    cv::Mat src1,src2;
-    f1.rgb.copyTo(src1);
-    f2.rgb.copyTo(src2);
-    srand((unsigned int)time(NULL));
-    for(int i=0; i<ln_matches.size();i++)
-    {
-		int p = ln_matches[i].queryIdx;
-		int q = ln_matches[i].trainIdx;
-		cv::Point2f left1 = f1.lines[p].p;
-		cv::Point2f left2 = f1.lines[p].q;
-		cv::Point2f right1 = f2.lines[q].p + cv::Point2d((double)src1.cols,0.f);
-		cv::Point2f right2 = f2.lines[q].q + cv::Point2d((double)src1.cols,0.f);
-		cv::line(output,left1,left2,cv::Scalar(0,0,255),2);
-		cv::line(output,right1,right2,cv::Scalar(0,0,255),2);
-		int r = rand()%255;
-		int g = rand()%255;
-		int b = rand()%255;
-		cv::line(output,left1,right1,cv::Scalar(b,g,r),2);
- 	
-    }
-    cv::imshow("output", output);
-    cvWaitKey();
-    
-    //PnPsolver pnpsolver;
-    //pnpsolver.calculateParameter(f1,f2);   
-    
-    //double norm = fabs(min(cv::norm(pnpsolver.rvec), 2*M_PI-cv::norm(pnpsolver.rvec)))+ fabs(cv::norm(pnpsolver.tvec));
-    //cout<<"norm:"<<norm<<endl;
-    
-    
-    Eigen::Matrix4f T ;//= cvMat2EigenMatrix4f(pnpsolver.rvec,pnpsolver.tvec);
-    //cvMat2Eigen(pnpsolver.rvec,pnpsolver.tvec);
-    
-    vector<DMatch> tmp;
-    pt_matches = tmp;
-    getTransformFromHybridMatchesG2O(&f1,&f2,pt_matches,ln_matches,T,10,sysPara);
-    //getTransformFromMatchesG2O(&f1,&f2,pt_matches,T,10);
-    
-    //bool valid;
-    //T = getTransform_Lns_Pts_pcl(&f1,&f2,pt_matches,ln_matches,valid);
-    
-    //vector<DMatch> out_pt_matches;
-    //vector<DMatch> out_ln_matches;
-    //float inlier_rmse;
-    //getTransform_PtsLines_ransac(&f1,&f2,pt_matches,ln_matches,
-    //			 out_pt_matches,out_ln_matches,T, inlier_rmse, sysPara);
-	
-
-    cout<<"Result:"<<T<<endl;
-
-    return 0;
-}
-
-
-
-Point2d pixel2cam ( const Point2d& p, const Mat& K )
-{
-    return Point2d(
-      ( p.x - K.at<float> ( 0,2 ) ) / K.at<float> ( 0,0 ),
-      ( p.y - K.at<float> ( 1,2 ) ) / K.at<float> ( 1,1 ));
-}
-
-
-int testPnPsolver()
-{    
-    Camera camera;
-    camera.fx = 517.306408;
-    camera.fy = 516.469215;
-    camera.cx = 318.643040;
-    camera.cy = 255.313989;
-    camera.scale = 5000.0;
-    
-    camera.k1=0.262383;
-    camera.k2=-0.953104;
-    camera.p1=-0.005358;
-    camera.p2= 0.002628;
-    camera.k3= 1.163314;
-
-
-    Frame f1(0.0,"../data/img1.png","../data/depth1.png",camera);
-    Frame f2(0.0,"../data/img2.png","../data/depth2.png",camera);
-    
-    PointCloud::Ptr cloud11=f1.img2cloud(); 
-    pcl::visualization::CloudViewer viewer1("viewer");
-    viewer1.showCloud(cloud11);
-    while(!viewer1.wasStopped()){}
-    return 0;
-    
-    PnPsolver pnpsolver;
-    vector<DMatch> matches = pnpsolver.calculateParameter(f1,f2);   
-    
-    Eigen::Isometry3d T = cvMat2Eigen(pnpsolver.rvec,pnpsolver.tvec);
-    cout<<"Rotation:"<<T.rotation()<<endl<<"Translation:"<<""<<T.translation()<<endl;
-    //cout<<pnpsolver.rvec<<endl;
-
-    Mat R;
-    cv::Rodrigues(pnpsolver.rvec,R);
-    Mat t = (Mat_<double>(3,1)<<pnpsolver.tvec.at<double>(0,0),pnpsolver.tvec.at<double>(1,0),pnpsolver.tvec.at<double>(2,0));
-    cout<<"t:"<<t<<endl;
-	
-	
-    Mat t_x = (Mat_<double>(3,3) << 
-      0, 		-t.at<double>(2.0), t.at<double>(1,0),
-      t.at<double>(2,0),0,		    -t.at<double>(0,0),
-      -t.at<double>(1,0),t.at<double>(0,0), 0);
-    
-   // cout<<"t_R:"<<t_x*R<<endl;
-    
-    Mat K = f1.K;
-    for(DMatch m: matches)
-    {
-      Point2d pt1 = pixel2cam(f1.mvKeypoints[m.queryIdx].pt,K);
-      Mat y1 = (Mat_<double>(3,1)<<pt1.x,pt1.y,1);
-      //cout<<y1<<endl;
-      
-      Point2d pt2 = pixel2cam(f2.mvKeypoints[m.trainIdx].pt,K);
-      Mat y2 = (Mat_<double>(3,1)<<pt2.x,pt2.y,1);
-      
-      Mat d = y2.t()*t_x*R*y1;
-      if(d.at<double>(0,0)>0.01)      
-	cout<<"Epiploar Constraint:"<<d<<endl;
-      
-    }
-    
-    PointCloud::Ptr cloud1 ( new PointCloud() ); 
-    PointCloud::Ptr output(new PointCloud());
-    PointCloud::Ptr tmp(new PointCloud());
-    pcl::VoxelGrid<PointT> voxel;
-    double gridsize = 0.05; 
-    voxel.setLeafSize( gridsize, gridsize, gridsize );
-    
-    cloud1 = f1.img2cloud();
-    output = joinPointCloud(cloud1,f2,T);
-
-    pcl::visualization::CloudViewer viewer("viewer");
-    viewer.showCloud(output);
-    while(!viewer.wasStopped()){}
-    
-    return 0;
-}
-
-vector<DMatch> doMatch(Frame frame1, Frame frame2)
-{
-    vector<DMatch> matches;
-    BruteForceMatcher<HammingLUT> matcher;
-    matcher.match(frame1.mDescriptors,frame2.mDescriptors,matches);
-    
-    cout<<"Original matches:" << matches.size()<<endl;
-
-    double minDist = 1e5, maxDist = 0;
-    for(size_t i=0;i<matches.size();i++)
-    {
-	  double dist = matches[i].distance;
-	  minDist = dist < minDist ? dist: minDist;
-	  maxDist = dist > maxDist ? dist: maxDist;
-    }
-    cout<<"MinDist:"<<minDist<<endl;
-    cout<<"MaxDist:"<<maxDist<<endl;
-    
-    vector<DMatch> goodMatches;
-    for(size_t i=0;i<matches.size();i++)
-    {
-	    //if(matches[i].distance<0.6*maxDist&&matches[i].distance < 15*minDist)
-	    if ( matches[i].distance <= max ( 2*minDist, 20.0 ) )
-	    {
-		    goodMatches.push_back(matches[i]);
-	    }
-    }   
-    cout<<"Good Matches:"<<goodMatches.size()<<endl;
-    return goodMatches;
-}
-
-//Each time pick up eight points
-vector<vector<int>> generateRandomSets(int mMaxIterations, int N)
-{
-  vector<int> vAvaliableIndices(N);
-  for(int i=0; i<N; i++)
-  {
-    vAvaliableIndices[i]=i;
-  }
-  vector<vector<int>> mvSets = vector<vector<int>>(mMaxIterations, vector<int>(8,0));
-  srand(time(NULL));
-  
-  for(int i=0; i< mMaxIterations; i++)
-  {
-    for(int j=0; j<8; j++)
-    {
-      int randi = random()%(vAvaliableIndices.size());
-      int idx = vAvaliableIndices[randi];
-      mvSets[i][j] = idx;
-      vAvaliableIndices[randi]=vAvaliableIndices.back();
-      vAvaliableIndices.pop_back();
-    }
-  }
-  return mvSets;
-}
-
-
-cv::Mat computeF21(const vector<Point2f> &vP1, const vector<Point2f> &vP2)
-{
-    vector<int> vAvaliableIndices(vP1.size());
-    for(int i=0; i<vP1.size(); i++)
-    {
-      vAvaliableIndices[i]=i;
-    }
-    vector<int> mvSets;
-    mvSets.resize(8);
-    srand(time(NULL));
-
-    for(int i=0; i<8; i++)
-    {
-      int randi = random()%(vP1.size());
-      int idx = vAvaliableIndices[randi];
-      mvSets[i] = idx;
-      vAvaliableIndices[randi]=vAvaliableIndices.back();
-      vAvaliableIndices.pop_back();
-    }
-  
-    int N = vP1.size();
-    cv::Mat A(N,9,CV_32F);
-    for(int i=0; i<8; i++)
-    {
-	int t = mvSets[i];
-	const float u1 = vP1[t].x;
-	const float v1 = vP1[t].y;
-	const float u2 = vP2[t].x;
-	const float v2 = vP2[t].y;
-	
-	A.at<float>(i,0) = u2*u1;
-	A.at<float>(i,1) = u2*v1;
-	A.at<float>(i,2) = u2;
-	A.at<float>(i,3) = v2*u1;
-	A.at<float>(i,4) = v2*v1;
-	A.at<float>(i,5) = v2;
-	A.at<float>(i,6) = u1;
-	A.at<float>(i,7) = v1;
-	A.at<float>(i,8) = 1;
-    }
-    
-    cv::Mat u,w,vt;
-    //cout<<"A:"<<A<<endl;
-    cv::SVDecomp(A,w,u,vt,cv::SVD::MODIFY_A | cv::SVD::FULL_UV);
-    //cout<<"u:"<<u<<endl;
-    //cout<<"w:"<<w<<endl;
-    //cout<<"vt:"<<vt<<endl;
-    cv::Mat Fpre = vt.row(8).reshape(0,3);
-    cv::SVDecomp(Fpre,w,u,vt,cv::SVD::MODIFY_A | cv::SVD::FULL_UV);  
-    //w.at<float>(2)=0;
-    cv::Mat F21 = u*cv::Mat::diag(w)*vt;
-    return F21;
-}
-
-
-void findFundamental(float &score, Mat& F21)
-{
-    return;
-}
-
-void pose_estimate_2d2d()
-{
-    Camera camera;
-    camera.fx = 517.306408;
-    camera.fy = 516.469215;
-    camera.cx = 318.643040;
-    camera.cy = 255.313989;
-    camera.scale = 5000.0;
-    
-    camera.k1=0.262383;
-    camera.k2=-0.953104;
-    camera.p1=-0.005358;
-    camera.p2= 0.002628;
-    camera.k3= 1.163314;
-
-
-    Frame f1(0.0,"../data/img1.png","../data/depth1.png",camera);
-    Frame f2(0.0,"../data/img2.png","../data/depth2.png",camera);
-    
-    BruteForceMatcher<HammingLUT> matcher;
-    //FlannBasedMatcher  matcher;
-    vector<DMatch> matches;
-    matcher.match(f1.mDescriptors,f2.mDescriptors,matches);
-    
-    vector<DMatch> goodMatches = doMatch(f1,f2);
-     
-    vector<Point2f> points1;
-    vector<Point2f> points2;
-    vector<vector<int>> vmatches;
-    //cv::Mat output = drawInlier(f1,f2,vmatches);
-    
-    Mat res;
-    drawMatches(f1.rgb,f1.mvKeypoints,f2.rgb,f2.mvKeypoints,goodMatches,res,Scalar::all(-1),Scalar::all(-1),
-      vector<char>(),DrawMatchesFlags::NOT_DRAW_SINGLE_POINTS);
-    cv::imshow("result", res);
-    cvWaitKey(); 
-    
-    for(int i=0; i< goodMatches.size(); i++)
-    {
-	 points1.push_back(f1.mvKeypoints[goodMatches[i].queryIdx].pt);
-	 points2.push_back(f2.mvKeypoints[goodMatches[i].trainIdx].pt);
-    }
-    
-    Mat F = findFundamentalMat(points1,points2,CV_FM_8POINT);
-    cout<<"Fundamental: "<<F<<endl;
-    
-    //cv::Mat  F1 = computeF21(points1,points2);
-    //cout<<"ComputeF21:"<<F1<<endl;
-    
-    //cv::Mat H = findHomography(points1, points2,RANSAC,3,noArray());
-    //cout<<"H:"<<H<<endl;
-}
-
-void test()
-{
-	SysParams sysparams("/home/jpl/lines/TUM2.yaml");
- 	SystemParameters sysPara;   //line parameters
- 	Camera camera(sysparams);
- 	
- 	Frame f1(0.0,"../data/img1.png","../data/depth1.png",camera);
- 	cout<<Frame::mnMinX<<" "<<Frame::mnMaxX<<" "<<Frame::mnMinY<<" "<<Frame::mnMaxY<<endl;
-	return;
-}
-
-void testDBoW()
-{
-	
-	SysParams sysparams("/home/jpl/lines/TUM2.yaml");
- 	SystemParameters sysPara;   //line parameters
- 	Camera camera(sysparams);
- 	
- 	Frame f1(0.0,"../data/img1.png","../data/depth1.png",camera);
-	
-	ORBVocabulary *mpORBVocabulary= new ORBVocabulary();
-    mpORBVocabulary->loadFromTextFile("../Vocabulary/ORBvoc.txt");
-	cout<<*mpORBVocabulary<<endl;
-	
-	
-	DBoW2::BowVector  			mBowVec;
-    DBoW2::FeatureVector		mFeatureVec;
-	vector<cv::Mat> 			vDescTmp;
-	vDescTmp.reserve(f1.mDescriptors.rows);
-	for(int i=0; i<f1.mDescriptors.rows;i++)
-	{
-		vDescTmp.push_back(f1.mDescriptors.row(i));
-	}
-	
-	mpORBVocabulary->transform(vDescTmp,mBowVec,mFeatureVec,4);
-	cout<<mBowVec.size()<<endl;
-	cout<<mFeatureVec.size()<<endl;
-	cout<<mBowVec.begin()->first<<endl;
-	
-	for(int i=140 ;i<165; i++)
-		cout<<i<<" "<<mBowVec[i]<<endl;
-	return;
-}
-
-void test1()
-{
-	cv::Mat rgb = cv::imread("sample.png",-1);
-	cv::Mat rgb1 = cv::imread("sample-1.png",-1);
-	cv::Mat gray;
-	cv::cvtColor(rgb,gray,CV_BGR2GRAY);
-	
-	int n;
-	LS* ls = callEDLines(gray, &n);
-	for(int i=0; i<n; i++) 
-	{
-		// store output to lineSegments 
-		if ((ls[i].sx-ls[i].ex)*(ls[i].sx-ls[i].ex) +(ls[i].sy-ls[i].ey)*(ls[i].sy-ls[i].ey) 
-			> 900) {
-			cv::Point2f p1 = cv::Point2d(ls[i].sx,ls[i].sy);
-			cv::Point2f p2 = cv::Point2d(ls[i].ex,ls[i].ey);
-			cv::line(rgb1,p1,p2,cv::Scalar(0,255,0),2);
-		}
-	}
-	imshow("1",rgb1);
-	imwrite("sample-2.png",rgb1);
-	waitKey();
-	
-	return;
-}
-
-
-void getEquation(PointCloud::Ptr cloud, vector<double>& c)
-{
-	//cout<<cloud->size()<<endl;
-	pcl::ModelCoefficients::Ptr coefficients (new pcl::ModelCoefficients ());
-	pcl::PointIndices::Ptr inliers (new pcl::PointIndices ());
-	pcl::SACSegmentation<PointT> seg;
-	seg.setOptimizeCoefficients (true);
-	seg.setModelType (pcl::SACMODEL_PLANE);
-	seg.setMethodType (pcl::SAC_RANSAC);
-	seg.setMaxIterations (1000);
-	seg.setDistanceThreshold (0.01);
-	seg.setInputCloud (cloud);
-	seg.segment (*inliers, *coefficients);
-	//cout<<cloud->size()<<endl;
-	c.reserve(4);
-	for(size_t i=0; i<4; i++) 
-	{	
-		c[i]=coefficients->values[i];
-		cout<<c[i]<<" ";
-	}
-	cout<<endl;
-	return;
-}
-
-
-void test2(string rgbname, string depthname, int id)
-{
-	Camera tum[4];
-	tum[0].fx = 517.306408;
-	tum[0].fy = 516.469215;
-	tum[0].cx = 318.643040;
-	tum[0].cy = 255.313989;
-	tum[0].scale = 5000.0;
-	
-	tum[1].fx = 520.908620;
-	tum[1].fy = 521.007327;
-	tum[1].cx = 325.141442;
-	tum[1].cy = 249.701764;
-	tum[1].scale = 5208.0;
-
-    tum[2].fx = 535.4;
-    tum[2].fy = 539.2;
-    tum[2].cx = 320.1;
-    tum[2].cy = 247.6;
-    tum[2].scale = 5000.0;
-	
-    tum[3].fx = 525;
-    tum[3].fy = 525;
-	tum[3].cx = 319.5;
-	tum[3].cy = 239.5;
-	tum[3].scale = 5000.0;
-	
-    SystemParameters sysPara;
-	
-    //Frame frame(0.0, "data/1rgb.png","data/1depth.png",tum[id]);
-	Frame frame(0.0, "data/"+rgbname,"data/"+depthname,tum[id-1]);
-	
-	Camera myTum = frame.camera;
-
-	PointCloud::Ptr cloud=frame.img2cloud();	
-	cout<<"size:"<<cloud->size()<<endl;
-	
-// 	pcl::VoxelGrid<PointT> voxel;
-// 	double gridsize = 0.03; 
-// 	voxel.setLeafSize( gridsize, gridsize, gridsize );
-// 	PointCloud::Ptr tmp(new PointCloud());
-// 	voxel.setInputCloud( cloud );
-//     voxel.filter( *tmp );
-//     cloud.swap(tmp);
-// 	cout<<"size:"<<cloud->size()<<endl;
-	
-// 	pcl::visualization::CloudViewer viewer("viewer");
-//     viewer.showCloud(cloud);
-// 	pcl::io::savePCDFile("tmp.pcd",*cloud);
-//     while(!viewer.wasStopped()){}
-	
-	
-	//segmentation
-	MyTimer mytimer;
-	mytimer.start();
-	pcl::search::Search<pcl::PointXYZRGBA>::Ptr tree = 
-		boost::shared_ptr<pcl::search::Search<pcl::PointXYZRGBA> > (new pcl::search::KdTree<pcl::PointXYZRGBA>);
-	pcl::PointCloud <pcl::Normal>::Ptr normals (new pcl::PointCloud <pcl::Normal>);
-	pcl::NormalEstimation<pcl::PointXYZRGBA, pcl::Normal> normal_estimator;
-	normal_estimator.setSearchMethod (tree);
-	normal_estimator.setInputCloud (cloud);
-	normal_estimator.setKSearch (100);
-	//normal_estimator.setRadiusSearch (0.05);
-	normal_estimator.compute (*normals);
-	{
-			pcl::visualization::PCLVisualizer viewer("PCL Viewer");
-			//viewer.setBackgroundColor (0.0, 0.0, 0.5);
-			viewer.addPointCloudNormals<pcl::PointXYZRGBA,pcl::Normal>(cloud, normals);
-			while (!viewer.wasStopped ())
-			{
-				viewer.spinOnce ();
-			}
-	}
-
-	pcl::IndicesPtr indices (new std::vector <int>);
-	pcl::PassThrough<pcl::PointXYZRGBA> pass;
-	pass.setInputCloud (cloud);
-	pass.setFilterFieldName ("z");
-	pass.setFilterLimits (0.0, 10.0);
-	pass.filter (*indices);
-	//cout<<"size2:"<<cloud->size()<<endl;;
-
-	pcl::RegionGrowing<pcl::PointXYZRGBA, pcl::Normal> reg;
-	reg.setMinClusterSize (1000);
-	reg.setMaxClusterSize (1000000);
-	reg.setSearchMethod (tree);
-	reg.setNumberOfNeighbours (30);
-	reg.setInputCloud (cloud);
-	reg.setIndices (indices);
-	reg.setInputNormals (normals);
-	reg.setSmoothnessThreshold (3.0 / 180.0 * M_PI);
-	reg.setCurvatureThreshold (0.10);
-
-	std::vector <pcl::PointIndices> clusters;
-	reg.extract(clusters);
-	mytimer.end();
-
-	std::cout << "Number of clusters is equal to " << clusters.size () << std::endl;
-	pcl::PointCloud<pcl::PointXYZRGBA>::Ptr cloud_plane(new pcl::PointCloud<pcl::PointXYZRGBA>);
-	vector<double> c;
-	srand(unsigned(time(NULL)));
-	Mat rs= frame.rgb.clone();
-	for(int i=0; i<clusters.size(); i++)
-	{
-		//std::cout << "Cluster " <<i<<" "<<clusters[i].indices.size () << " points." << endl;
-		pcl::PointCloud<pcl::PointXYZRGBA>::Ptr each_plane(new pcl::PointCloud<pcl::PointXYZRGBA>);
-		//each_plane->resize(clusters[i].indices.size ());
-		int r = rand()%255;
-		int g = rand()%255;
-		int b = 200;
-		for (size_t j = 0; j < clusters[i].indices.size (); ++j)
-		{
-
-			pcl::PointXYZRGBA point;
-			point.x = cloud->points[clusters[i].indices[j]].x;
-	  		point.y = cloud->points[clusters[i].indices[j]].y;
-	 		point.z = cloud->points[clusters[i].indices[j]].z;
-			point.r = r;
-			point.g = g;
-			point.b = b;
-			point.a = 0.0;
-			each_plane->push_back(point);
-			cloud_plane->push_back(point);
-			
-			int u= (int)(point.y * myTum.fy / point.z + myTum.cy);
-			int v= (int)(point.x * myTum.fx / point.z + myTum.cx);
-				
-			rs.ptr<uchar>(u)[v*3]=r;
-			rs.ptr<uchar>(u)[v*3+1]=g;
-			rs.ptr<uchar>(u)[v*3+2]=b;
-			
-			//cloud->points[clusters[i].indices[j]].r = r;
-			//cloud->points[clusters[i].indices[j]].g = g;
-			//cloud->points[clusters[i].indices[j]].b = b;
-			//cloud->points[clusters[i].indices[j]].a = 0.0;
-			//cloud->erase(index+inliers->indices[i]);
-		}
-		getEquation(each_plane,c);
-
-// 		for(size_t j=0; j<cloud->points.size(); j++)
-// 		{
-// 			double x = cloud->points[j].x;
-// 			double y = cloud->points[j].y;
-// 			double z = cloud->points[j].z;
-// 			//cout<<x<<" "<<y<<" "<<z<<endl;
-// 			if(abs(c[0]*x + c[1]*y + c[2]*z + c[3])<=0.05)
-// 			{
-// 				pcl::PointXYZRGBA p;
-// 				p.x = x;
-// 				p.y = y;
-// 				p.z = z;
-// 				p.r = r;
-// 				p.g = g;
-// 				p.b = b;
-// 				p.a = 0.0;
-// 				each_plane->push_back(p);
-// 				cloud_plane->push_back(p);
-// 				int u= (int)(pointT->y * fy / pointT->z + cy);
-// 				int v= (int)(pointT->x * fx / pointT->z + cx);
-// 				
-// 				rs.ptr<uchar>(u)[v*3]=255;
-// 			}
-// 		}
-		//pcl::visualization::CloudViewer viewer("viewer");
-		//viewer.showCloud(each_plane);
-		//while(!viewer.wasStopped()){}
-	}
-	
-	
-	//pcl::PointCloud <pcl::PointXYZRGB>::Ptr colored_cloud = reg.getColoredCloud ();
-	pcl::visualization::CloudViewer viewer ("Cluster viewer");
-	viewer.showCloud(cloud_plane);
-	viewer.runOnVisualizationThread(setPCLBackGround);
-	while (!viewer.wasStopped ()){}
-	
-	//pcl::visualization::PCLVisualizer viewer("viewer");
-	//viewer.setBackgroundColor(1.0,1.0,1.0);
-	//viewer.showCloud(cloud_plane,"viewer");
-	
-	
-	//cv::imshow("res",rs);
-	//cv::waitKey();
-	//cv:imwrite("plane.png",rs);
-	
-	/**/
-	return;
-}
-
-Eigen::Matrix4d toTransformation(double tx,double ty, double tz,double qx,double qy, double qz, double qw)
-{
-	// 1 - 2*qy2 - 2*qz2	2*qx*qy - 2*qz*qw	2*qx*qz + 2*qy*qw
-	// 2*qx*qy + 2*qz*qw	1 - 2*qx2 - 2*qz2	2*qy*qz - 2*qx*qw
-	// 2*qx*qz - 2*qy*qw	2*qy*qz + 2*qx*qw	1 - 2*qx2 - 2*qy2
-	Eigen::Matrix4d trans;
-	trans<< 	1-2*qy*qy-2*qz*qz,	2*qx*qy - 2*qz*qw,	2*qx*qz + 2*qy*qw, tx,
-			2*qx*qy + 2*qz*qw,	1-2*qx*qx-2*qz*qz,	2*qy*qz - 2*qx*qw, ty,
-			2*qx*qz - 2*qy*qw,	2*qy*qz + 2*qx*qw,	1-2*qx*qx-2*qy*qy, tz,
-			0,                  0,                  0,                 1.0;
-	return trans;
-}
-
-PointCloud::Ptr img2cloud(Mat rgb, Mat depth, Camera camera)
-{
-    PointCloud::Ptr cloud(new PointCloud);
-    for(int i=0;i<depth.rows;i+=3)
-    {
-		for(int j=0;j<depth.cols;j+=3)
-		{
-			double d=(double)depth.ptr<unsigned short>(i)[j]/camera.scale;
-			//cout<<d<<endl;
-			if(d <= 1e-2||d>=10)continue;
-			PointT p;
-			p.z= d;
-			p.x=(j-camera.cx)*p.z/camera.fx;
-			p.y=(i-camera.cy)*p.z/camera.fy;
-			
-			p.b=rgb.ptr<uchar>(i)[j*3];
-			p.g=rgb.ptr<uchar>(i)[j*3+1];
-			p.r=rgb.ptr<uchar>(i)[j*3+2];
-			
-
-			cloud->points.push_back(p);
-		}
-    }
-   
-    cloud->width=cloud->points.size();
-    cloud->height=1;
-    cloud->is_dense=false;
-    
-    return cloud;
-}
- 
-int reconstruction(string dir)
-{
-	
-	pcl::visualization::CloudViewer viewer("viewer");
-	cv::namedWindow("rgb");
-	cv::namedWindow("depth");
-	cv::Mat img1=imread("0.png",-1);
-	cv::imshow("rgb",img1);
-    cv::imshow("depth",img1);
-	Camera tum3;
-    tum3.fx = 535.4;
-    tum3.fy = 539.2;
-    tum3.cx = 320.1;
-    tum3.cy = 247.6;
-    tum3.scale = 5000.0;
-	
-	PointCloud::Ptr globalMap ( new PointCloud() ); 
-	PointCloud::Ptr tmp(new PointCloud());
-	
-	waitKey();
-	
-	vector<Eigen::Matrix4d> poses;
-	//ifstream fin(dir+"/res/CameraTrajectory.txt");
-	ifstream fin(dir+"jpl.txt");
-	pcl::VoxelGrid<PointT> voxel;
-	double gridsize = 0.02; 
-	voxel.setLeafSize( gridsize, gridsize, gridsize );
-	while(!fin.eof())
-	{
-		string s;
-		getline(fin,s);
-		//if(s[0]=='#')continue;
-		if(!s.empty())
-		{
-			stringstream ss(s.c_str());
-			double t,tx,ty,tz,qx,qy,qz,qw;
-			double t1,t2;
-			string s1,s2;
-			fin>>t>>tx>>ty>>tz>>qx>>qy>>qz>>qw;
-			fin>>t1>>s1>>t2>>s2;
-			Eigen::Matrix4d pose=toTransformation(tx,ty,tz,qx,qy,qz,qw);
-			poses.push_back(pose);
-			Mat rgb=cv::imread(dir+s1, CV_LOAD_IMAGE_UNCHANGED);
-			Mat depth=cv::imread(dir+s2,CV_LOAD_IMAGE_ANYDEPTH);
-			
-			Mat rs=rgb.clone();
-			Frame frame(0,rgb,depth,tum3);
-			for(int k=0; k<frame.lines.size();k++)
-			{
-				cv::Point2f left1 = frame.lines[k].p;
-				cv::Point2f left2 = frame.lines[k].q;
-				cv::line(rs,left1,left2,cv::Scalar(0,255,0),3);
-			}
-			for(int k=0; k<frame.mvKeypoints.size();k++)
-			{
-				circle(rs,frame.mvKeypoints[k].pt,1,Scalar(0,0,255),2);
-			}
-			//frame.planeExtraction();
-			cv::imshow("rgb",rs);
-			cv::imshow("depth",depth);
-			cv::waitKey(20);
-			
-			PointCloud::Ptr cloud = img2cloud(rgb,depth,tum3);
-		
-			pcl::transformPointCloud( *cloud, *tmp, pose); //pose = Twc
-			*globalMap += *tmp;
-			voxel.setInputCloud( globalMap );
-			voxel.filter( *tmp );
-			globalMap.swap(tmp);
-			viewer.showCloud(globalMap);
-			cloud->clear();
-			tmp->clear();
-		}
-	}
-	pcl::io::savePCDFile("global.pcd",*globalMap);
-	
-
-    
-	//viewer.runOnVisualizationThread(setPCLBackGround);
-    while(!viewer.wasStopped()){}
-	
-	fin.close();
-	
-	return 0;
-}
-
-
-int reconstruction_pangolin(string dir)
-{
-	
-	float mImageWidth = 640;
-	float mImageHeight = 480;
-	float mViewpointX = 5;
-	float mViewpointY = 5;
-	float mViewpointZ = 5;
-	float mViewpointF = 500;
-	
-	pangolin::CreateWindowAndBind("AR demo",640,480);
-	glEnable(GL_DEPTH_TEST);
-	glEnable(GL_BLEND);
-	
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-	
-	
-	pangolin::OpenGlRenderState s_cam(
-			pangolin::ProjectionMatrix(1024,768,535.4,539.2,320.1,247.6,0.01,1000),
-			pangolin::ModelViewLookAt(mViewpointX,mViewpointY,mViewpointZ, 0,0,0,0.0,1.0, 0.0)
-			);
-			
-	pangolin::View& d_cam = pangolin::CreateDisplay()
-            .SetBounds(0.0, 1.0, pangolin::Attach::Pix(0), 1.0, -640.0f/480.0f)
-            .SetHandler(new pangolin::Handler3D(s_cam));			
-			//.SetLock(pangolin::LockLeft, pangolin::LockTop);
-			
-	pangolin::View& d_image = pangolin::Display("image")
-		.SetBounds(0,1.0f,pangolin::Attach::Pix(0),1.0f,(float)640/480)
-		.SetLock(pangolin::LockLeft, pangolin::LockTop);
-		
-	pangolin::GlTexture imageTexture(640,480,GL_RGB,false,0,GL_RGB,GL_UNSIGNED_BYTE);
-	pangolin::OpenGlMatrixSpec P = pangolin::ProjectionMatrixRDF_TopLeft(640,480,535.4,539.2,320.1,247.6,0.001,1000);
-	
-	pangolin::OpenGlMatrix Twc;
-    Twc.SetIdentity();
-	
-
-	cv::namedWindow("rgb");
-	cv::namedWindow("depth");
-	Camera tum3;
-    tum3.fx = 535.4;
-    tum3.fy = 539.2;
-    tum3.cx = 320.1;
-    tum3.cy = 247.6;
-    tum3.scale = 5000.0;
-	
-	PointCloud::Ptr globalMap ( new PointCloud() ); 
-	PointCloud::Ptr tmp(new PointCloud());
-	
-	waitKey();
-	
-	vector<Eigen::Matrix4d> poses;
-	//ifstream fin(dir+"/res/CameraTrajectory.txt");
-	ifstream fin(dir+"jpl.txt");
-	int count=0;
-	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-	while(!pangolin::ShouldQuit())
-	{
-		cout<<count<<endl;
-		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-
-		
-		//d_cam.Activate(s_cam);
-		d_image.Activate();
-		glColor3f(1.0,1.0,1.0);
-				
-		while(!fin.eof())
-		{
-			count++;
-			//cout<<count++<<endl;
-			string s;
-			getline(fin,s);
-			//if(s[0]=='#')continue;
-			if(!s.empty())
-			{
-				stringstream ss(s.c_str());
-				double t,tx,ty,tz,qx,qy,qz,qw;
-				double t1,t2;
-				string s1,s2;
-				fin>>t>>tx>>ty>>tz>>qx>>qy>>qz>>qw;
-				fin>>t1>>s1>>t2>>s2;
-				Eigen::Matrix4d pose1=toTransformation(tx,ty,tz,qx,qy,qz,qw);
-				
-				Eigen::Matrix4d pose=pose1.inverse();
-				
-				std::vector<GLfloat> Twc = {
-					(float)pose(0,0),(float)pose(1,0),(float)pose(2,0),0,
-					(float)pose(0,1),(float)pose(1,1),(float)pose(2,1),0,
-					(float)pose(0,2),(float)pose(1,2),(float)pose(2,2),0,
-					(float)pose(0,3),(float)pose(1,3),(float)pose(2,3),1};
-					
-				pangolin::OpenGlMatrix M;
-
-				M.m[0] = pose(0,0);
-				M.m[1] = pose(1,0);
-				M.m[2] = pose(2,0);
-				M.m[3]  = 0.0;
-
-				M.m[4] = pose(0,1);
-				M.m[5] = pose(1,1);
-				M.m[6] = pose(2,1);
-				M.m[7]  = 0.0;
-
-				M.m[8] = pose(0,2);
-				M.m[9] = pose(1,2);
-				M.m[10] = pose(2,2);
-				M.m[11] = 0.0;
-
-				M.m[12] = pose(0,3);
-				M.m[13] = pose(1,3);
-				M.m[14] = pose(2,3);
-				M.m[15]  = 1.0;
-					
-				//poses.push_back(pose);
-				Mat rgb=cv::imread(dir+s1, CV_LOAD_IMAGE_UNCHANGED);
-				Mat depth=cv::imread(dir+s2,CV_LOAD_IMAGE_ANYDEPTH);
-
-				imageTexture.Upload(rgb.data,GL_RGB,GL_UNSIGNED_BYTE);
-				imageTexture.RenderToViewportFlipY();
-				
-				glClear(GL_DEPTH_BUFFER_BIT);
-
-				// Load camera projection
-				glMatrixMode(GL_PROJECTION);
-				P.Load();
-				
-				glMatrixMode(GL_MODELVIEW);
-				M.Load();
-					
-				
-				//std::vector<GLfloat> Twc = {1,0,0,0, 0,1,0,0 , 0,0,1,0 ,2,0,0,1};//frame.mTwc;
-				//glMultMatrixf(Twc.data());
-				
-			
-// 	
-// 				
-// 				const float w = 0.02;
-// 				const float h = w*0.75;
-// 				const float z = w*0.6;
-// 				glLineWidth(2);
-// 				glColor3f(0.0,1.0,0.0);
-// 				glBegin(GL_LINES);
-// 				glVertex3f(0,0,0);
-// 				glVertex3f(w,h,z);
-// 				glVertex3f(0,0,0);
-// 				glVertex3f(w,-h,z);
-// 				glVertex3f(0,0,0);
-// 				glVertex3f(-w,-h,z);
-// 				glVertex3f(0,0,0);
-// 				glVertex3f(-w,h,z);
-// 				glVertex3f(w,h,z);
-// 				glVertex3f(w,-h,z);
-// 				glVertex3f(-w,h,z);
-// 				glVertex3f(-w,-h,z);
-// 				glVertex3f(-w,h,z);
-// 				glVertex3f(w,h,z);
-// 				glVertex3f(-w,-h,z);
-// 				glVertex3f(w,-h,z);
-// 				glEnd();
-				
-				{
-					pangolin::OpenGlMatrix M = pangolin::OpenGlMatrix::Translate(-2,0,-0.1);
-					glPushMatrix();
-					M.Multiply();
-					pangolin::glDrawColouredCube(-0.1,0.1);
-					glPopMatrix();
-					
-// 					M = pangolin::OpenGlMatrix::Translate(-1.5,0.5,-0.1);
-// 					glPushMatrix();
-// 					M.Multiply();
-// 					pangolin::glDrawColouredCube(-0.1,0.1);
-// 					glPopMatrix();
-				}
-				
- 				Mat rs=rgb.clone();
- 				Frame frame(0,rgb,depth,tum3);
-// 				{
-// 					glLineWidth(10);
-// 					glColor3f(1.0,0.0,0.0);
-// 					glBegin(GL_LINES);
-// 					for(int i=0 ;i< frame.lines.size(); i++)
-// 					{
-// 						cv::Point3d A = frame.lines[i].line3d.A;
-// 						cv::Point3d B = frame.lines[i].line3d.B;
-// 						
-// 						if(cv::norm(A-B)<0.3)continue;
-// 						
-// 						glVertex3f(A.x,A.y,A.z);
-// 						glVertex3f(B.x,B.y,B.z);
-// 						
-// 					}
-// 					glEnd();
-// 				}
-// 				
-// 				
-// 				{
-// 					glPointSize(1);
-// 					glBegin(GL_POINTS);
-// 					
-// 					PointCloud::Ptr cloud = img2cloud(rgb,depth,tum3);
-// 					for(int k=0; k<cloud->points.size(); k++)
-// 					{
-// 						PointT p = cloud->points[k];
-// 						
-// 						uint32_t x = p.rgba;
-// 						
-// 						uint32_t alpha = (x & 0xff000000) >> 24;
-// 						uint32_t red = (x & 0x00ff0000) >> 16;
-// 						uint32_t green = (x & 0x0000ff00) >> 8;
-// 						uint32_t blue = (x & 0x000000ff);
-// 						
-// 						glColor3f(red/255.0,green/255.0,blue/255.0);
-// 						glVertex3f(p.x,p.y,p.z);
-// 					}
-// 					glEnd();
-// 					cloud->clear();
-// 				}
-				
-				
-				for(int k=0; k<frame.lines.size();k++)
-				{
-					cv::Point2f left1 = frame.lines[k].p;
-					cv::Point2f left2 = frame.lines[k].q;
-					cv::line(rs,left1,left2,cv::Scalar(0,255,0),3);
-				}
-				for(int k=0; k<frame.mvKeypoints.size();k++)
-				{
-					circle(rs,frame.mvKeypoints[k].pt,1,Scalar(0,0,255),2);
-				}
-				//frame.planeExtraction();
-			
-				
-				cv::imshow("rgb",rs);
-				cv::imshow("depth",depth);
-				cv::waitKey(50);
-				
-				//glPopMatrix();
-				break;
-			}
-			
-		}
-		
-		pangolin::FinishFrame();
-		
-	}
-	//pcl::io::savePCDFile("global.pcd",*globalMap);
-	fin.close();
-	
-	return 0;
-}
-
-
-PointCloud::Ptr img2cloud_test(Mat rgb, Mat depth, Camera camera)
-{
-    PointCloud::Ptr cloud(new PointCloud);
-    for(int i=0;i<depth.rows;i+=3)
-    {
-		for(int j=0;j<depth.cols;j+=3)
-		{
-			double d=(uchar)depth.ptr<uchar>(i)[j]/camera.scale;
-			//cout<<d<<endl;
-			if(d <= 1||d>=10)continue;
-			PointT p;
-			p.z= d;
-			p.x=(j-camera.cx)*p.z/camera.fx;
-			p.y=(i-camera.cy)*p.z/camera.fy;
-			
-			p.b=rgb.ptr<uchar>(i)[j*3];
-			p.g=rgb.ptr<uchar>(i)[j*3+1];
-			p.r=rgb.ptr<uchar>(i)[j*3+2];
-			cloud->points.push_back(p);
-		}
-    }
-   
-    cloud->width=cloud->points.size();
-    cloud->height=1;
-    cloud->is_dense=false;
-    
-    return cloud;
-}
-
-int drawPointCloud(int idx)
-{
-	//int idx=2;
-	string dir = "/home/jpl/programming/zjh/data"+to_string(idx)+"/";
-	Mat rgb=cv::imread(dir+"im1.png", 	CV_LOAD_IMAGE_UNCHANGED);
-	Mat depth=cv::imread(dir+"fuse.png",CV_LOAD_IMAGE_ANYDEPTH);
-	//cv::imshow("rgb",rgb);
-    //cv::imshow("depth",depth);
-	//waitKey();
-	
-	Camera tum[4];
-    tum[1].fx = 713.189;
-    tum[1].fy = 713.189;
-    tum[1].cx = 387.361;
-    tum[1].cy = 238.263;
-    tum[1].scale = 25.5;
-	
-    tum[2].fx = 1500;
-    tum[2].fy = 1500;
-    tum[2].cx = 251;
-    tum[2].cy = 187;
-    tum[2].scale = 25.5;
-	
-    tum[3].fx = 585.489;
-    tum[3].fy = 585.489;
-    tum[3].cx = 312.353;
-    tum[3].cy = 234.124;
-    tum[3].scale = 25.5;
-	
-    tum[4].fx = 1038.018;
-    tum[4].fy = 1038.018;
-    tum[4].cx = 375.308;
-    tum[4].cy = 243.393;
-    tum[4].scale = 25.5;
-	
-	pcl::visualization::CloudViewer viewer("viewer");
-	PointCloud::Ptr cloud = img2cloud_test(rgb,depth,tum[idx]);
-	
-	
-// 	pcl::VoxelGrid<PointT> voxel;
-// 	double gridsize = 0.01; 
-// 	voxel.setLeafSize( gridsize, gridsize, gridsize );
-// 	voxel.setInputCloud( cloud );
-// 	voxel.filter( *cloud );
-	
-	
-	viewer.showCloud(cloud);
-	//viewer.runOnVisualizationThread(setPCLBackGround);
-    while(!viewer.wasStopped()){}
-	
-	return 0;
-}
-
-int main(int argc, char** argv)
-{
-	//reconstruction_pangolin("/home/jpl/TUM_Datasets/4Structure_vs_Texture/f3_structure_notexture_far/");
-	//reconstruction("/home/jpl/TUM_Datasets/6Reconstruction/f3_large_cabinet/");
-	//testline();
-	//test2(argv[1],argv[2],atoi(argv[3]));
-	//test();
-	//testDBoW();
-	int idx=atoi(argv[1]);
-	drawPointCloud(idx);
-	
-	return 0;
-}
+#include <pangolin/pangolin.h>
+#include "utils.h"
+#include "base.h"
+#include "PnPsolver.h"
+#include "gms_matcher.h"
+#include <cmath>
+#include <map>
+#include <algorithm>
+#include <iomanip>
+#include <opencv2/core/eigen.hpp>
+#include <g2o/core/jacobian_workspace.h>
+#include "point_error.h"
+#include "map_io.h"
+#include "voxel_map.h"
+#include "tsdf_volume.h"
+#include "debug_sink.h"
+#include "evaluation.h"
+
+using namespace std;
+
+Eigen::Isometry3d cvMat2Eigen(Mat& rvec,Mat& tvec)
+{
+      Mat R;
+      cv::Rodrigues(rvec,R);
+      Eigen::Matrix3d r;
+      cv::cv2eigen(R,r);
+
+      Eigen::Isometry3d T=Eigen::Isometry3d::Identity();
+      Eigen::AngleAxisd angle(r);
+      T=angle;
+
+      T(0,3)=tvec.at<float>(0,0);
+      T(1,3)=tvec.at<float>(1,0);
+      T(2,3)=tvec.at<float>(2,0); 
+       
+      //Eigen::Quaterniond q(r);
+      //cout<<"Quaterniond"<<q.x()<<" "<<q.y()<<" "<<q.z()<<" "<<q.w()<<endl;
+      
+      return T;
+}
+
+Eigen::Matrix4f cvMat2EigenMatrix4f(Mat& rvec,Mat& tvec)
+{
+      Eigen::Matrix4f T = Eigen::Matrix4f::Identity();
+      
+      
+      Mat R;
+      Rodrigues(rvec,R);
+      Mat t = (Mat_<double>(3,1)<<tvec.at<double>(0,0),tvec.at<double>(1,0),tvec.at<double>(2,0));
+     
+      Mat Tcw = cv::Mat::eye(4,4,CV_32F);
+      R.copyTo(Tcw.rowRange(0,3).colRange(0,3));
+      t.copyTo(Tcw.rowRange(0,3).col(3));
+      cv::cv2eigen(Tcw,T);
+
+      return T;
+}
+
+PointCloud::Ptr joinPointCloud(PointCloud::Ptr cloud,Frame frame,Eigen::Isometry3d& T)
+{
+      PointCloud::Ptr newcloud=frame.img2cloud();
+      
+      //cout<<"Join PointCloud."<<endl;
+      PointCloud::Ptr output(new PointCloud);
+      pcl::transformPointCloud(*cloud,*output,T.matrix());
+      *newcloud+=*output;
+      return newcloud;
+      //pcl::io::savePCDFile("1.pcd",*output);
+
+}
+
+cv::Mat drawInlier(Frame &f1, Frame &f2, vector<vector<int>>& matches)
+{
+    cv::Mat src1,src2;
+    f1.rgb.copyTo(src1);
+    f2.rgb.copyTo(src2);
+    const int height = max(src1.rows, src2.rows);
+    const int width = src1.cols + src2.cols;
+    cv::Mat output(height, width, CV_8UC3,cv::Scalar(0,0,0));
+    src1.copyTo(output(cv::Rect(0,0,src1.cols, src1.rows)));
+    src2.copyTo(output(cv::Rect(src1.cols,0,src2.cols, src2.rows)));
+
+    return output;
+}
+
+
+int testline()
+{
+    Camera tum1;
+    tum1.fx = 517.306408;
+    tum1.fy = 516.469215;
+    tum1.cx = 318.643040;
+    tum1.cy = 255.313989;
+    tum1.scale = 5000.0;
+    
+    Camera camera1;
+    camera1.fx = 525;
+    camera1.fy = 525;
+    camera1.cx = 319.5;
+    camera1.cy = 239.5;
+    camera1.scale = 5000.0;
+    
+    Camera tum3;
+    tum3.fx = 535.4;
+    tum3.fy = 539.2;
+    tum3.cx = 320.1;
+    tum3.cy = 247.6;
+    tum3.scale = 5000.0;
+    
+    SystemParameters sysPara;
+
+    //Frame f1(0.0, "../data/1.png","../data/d1.png",tum3);
+    //Frame f2(0.0, "../data/3.png","../data/d3.png",tum3);
+    
+    Frame f1(0.0, "../data/img1.png","../data/depth1.png",tum1);
+    Frame f2(0.0, "../data/img3.png","../data/depth3.png",tum1);
+
+    //Frame f1(0.0, "../pairs/pair1-scn2/normal_rgb.png","../pairs/pair1-scn2/normal_depth.png",camera1);
+    //Frame f2(0.0, "../pairs/pair1-scn2/dark_1_rgb.png","../pairs/pair1-scn2/dark_1_depth.png",camera1);
+    
+    
+    vector<DMatch> bf_matches;
+    BruteForceMatcher<HammingLUT> matcher;
+    matcher.match(f1.mDescriptors,f2.mDescriptors,bf_matches);
+    vector<DMatch> pt_matches = GmsMatch(f1,f2, bf_matches);
+    //vector<DMatch> pt_matches = FilterMatch(f1,f2, bf_matches);
+    
+    Mat img;
+    img = f2.rgb.clone();
+    for(int i=0; i<pt_matches.size();i++)
+    {
+		circle(img,f1.mvKeypoints[pt_matches[i].queryIdx].pt,1,Scalar(255,0,0),2);
+		circle(img,f2.mvKeypoints[pt_matches[i].trainIdx].pt,1,Scalar(0,0,255),2);
+    }
+    drawMatches(f1.rgb,f1.mvKeypoints,f2.rgb,f2.mvKeypoints,pt_matches,img);
+    imshow("matchShow",img);
+	imwrite("1111.png",img);
+    waitKey(0);
+    
+
+
+    vector<vector<int>> matches;
+    matchLine(f1.lines,f2.lines,matches);
+    vector<DMatch> ln_matches;
+    for(int i=0; i<matches.size(); i++)
+    {
+		int p1 = matches[i][0];
+		int p2 = matches[i][1];
+		if(!f1.lines[p1].haveDepth || !f2.lines[p2].haveDepth)continue;
+		double len1 = cv::norm(f1.lines[p1].line3d.A - f1.lines[p1].line3d.B);
+		double len2 = cv::norm(f2.lines[p2].line3d.A - f2.lines[p2].line3d.B);
+		//if(abs(len1-len2)>0.03)continue;
+		DMatch tmp(matches[i][0],matches[i][1],0);
+		ln_matches.push_back(tmp);
+    }
+   
+   cv::Mat   t1,t2;
+   t1=f1.rgb.clone();
+   t2=f2.rgb.clone();
+   cout<<"f1 Lines:"<<f1.lines.size()<<"  f2 Lines: "<<f2.lines.size()<<"  Original Match: "<<matches.size()<<"  Line Match: "<<ln_matches.size()<<endl;
+   for(int i=0; i<f1.lines.size();i++)
+   {
+       cv::Point2f left1 = f1.lines[i].p;
+       cv::Point2f left2 = f1.lines[i].q;
+       cv::line(t1,left1,left2,cv::Scalar(0,0,255),3);
+   }
+   cvNamedWindow("output1");
+   cv::imshow("output1", t1);
+   
+   for(int i=0; i<f2.lines.size();i++)
+   {
+       cv::Point2f right1 = f2.lines[i].p ;
+       cv::Point2f right2 = f2.lines[i].q ;
+       cv::line(t2,right1,right2,cv::Scalar(0,0,255),3);
+   }
+   cvNamedWindow("output2");
+   cv::imshow("output2", t2);
+    
+    cv::Mat output = drawInlier(f1,f2,matches);
+    cv::Mat src1,src2;
+    f1.rgb.copyTo(src1);
+    f2.rgb.copyTo(src2);
+    srand((unsigned int)time(NULL));
+    for(int i=0; i<ln_matches.size();i++)
+    {
+		int p = ln_matches[i].queryIdx;
+		int q = ln_matches[i].trainIdx;
+		cv::Point2f left1 = f1.lines[p].p;
+		cv::Point2f left2 = f1.lines[p].q;
+		cv::Point2f right1 = f2.lines[q].p + cv::Point2d((double)src1.cols,0.f);
+		cv::Point2f right2 = f2.lines[q].q + cv::Point2d((double)src1.cols,0.f);
+		cv::line(output,left1,left2,cv::Scalar(0,0,255),2);
+		cv::line(output,right1,right2,cv::Scalar(0,0,255),2);
+		int r = rand()%255;
+		int g = rand()%255;
+		int b = rand()%255;
+		cv::line(output,left1,right1,cv::Scalar(b,g,r),2);
+ 	
+    }
+    cv::imshow("output", output);
+    cvWaitKey();
+    
+    //PnPsolver pnpsolver;
+    //pnpsolver.calculateParameter(f1,f2);   
+    
+    //double norm = fabs(min(cv::norm(pnpsolver.rvec), 2*M_PI-cv::norm(pnpsolver.rvec)))+ fabs(cv::norm(pnpsolver.tvec));
+    //cout<<"norm:"<<norm<<endl;
+    
+    
+    Eigen::Matrix4f T ;//= cvMat2EigenMatrix4f(pnpsolver.rvec,pnpsolver.tvec);
+    //cvMat2Eigen(pnpsolver.rvec,pnpsolver.tvec);
+    
+    vector<DMatch> tmp;
+    pt_matches = tmp;
+    getTransformFromHybridMatchesG2O(&f1,&f2,pt_matches,ln_matches,T,10,sysPara);
+    //getTransformFromMatchesG2O(&f1,&f2,pt_matches,T,10);
+    
+    //bool valid;
+    //T = getTransform_Lns_Pts_pcl(&f1,&f2,pt_matches,ln_matches,valid);
+    
+    //vector<DMatch> out_pt_matches;
+    //vector<DMatch> out_ln_matches;
+    //float inlier_rmse;
+    //getTransform_PtsLines_ransac(&f1,&f2,pt_matches,ln_matches,
+    //			 out_pt_matches,out_ln_matches,T, inlier_rmse, sysPara);
+	
+
+    cout<<"Result:"<<T<<endl;
+
+    return 0;
+}
+
+
+
+Point2d pixel2cam ( const Point2d& p, const Mat& K )
+{
+    return Point2d(
+      ( p.x - K.at<float> ( 0,2 ) ) / K.at<float> ( 0,0 ),
+      ( p.y - K.at<float> ( 1,2 ) ) / K.at<float> ( 1,1 ));
+}
+
+
+int testPnPsolver()
+{    
+    Camera camera;
+    camera.fx = 517.306408;
+    camera.fy = 516.469215;
+    camera.cx = 318.643040;
+    camera.cy = 255.313989;
+    camera.scale = 5000.0;
+    
+    camera.k1=0.262383;
+    camera.k2=-0.953104;
+    camera.p1=-0.005358;
+    camera.p2= 0.002628;
+    camera.k3= 1.163314;
+
+
+    Frame f1(0.0,"../data/img1.png","../data/depth1.png",camera);
+    Frame f2(0.0,"../data/img2.png","../data/depth2.png",camera);
+    
+    PointCloud::Ptr cloud11=f1.img2cloud(); 
+    pcl::visualization::CloudViewer viewer1("viewer");
+    viewer1.showCloud(cloud11);
+    while(!viewer1.wasStopped()){}
+    return 0;
+    
+    PnPsolver pnpsolver;
+    vector<DMatch> matches = pnpsolver.calculateParameter(f1,f2);   
+    
+    Eigen::Isometry3d T = cvMat2Eigen(pnpsolver.rvec,pnpsolver.tvec);
+    cout<<"Rotation:"<<T.rotation()<<endl<<"Translation:"<<""<<T.translation()<<endl;
+    //cout<<pnpsolver.rvec<<endl;
+
+    Mat R;
+    cv::Rodrigues(pnpsolver.rvec,R);
+    Mat t = (Mat_<double>(3,1)<<pnpsolver.tvec.at<double>(0,0),pnpsolver.tvec.at<double>(1,0),pnpsolver.tvec.at<double>(2,0));
+    cout<<"t:"<<t<<endl;
+	
+	
+    Mat t_x = (Mat_<double>(3,3) << 
+      0, 		-t.at<double>(2.0), t.at<double>(1,0),
+      t.at<double>(2,0),0,		    -t.at<double>(0,0),
+      -t.at<double>(1,0),t.at<double>(0,0), 0);
+    
+   // cout<<"t_R:"<<t_x*R<<endl;
+    
+    Mat K = f1.K;
+    for(DMatch m: matches)
+    {
+      Point2d pt1 = pixel2cam(f1.mvKeypoints[m.queryIdx].pt,K);
+      Mat y1 = (Mat_<double>(3,1)<<pt1.x,pt1.y,1);
+      //cout<<y1<<endl;
+      
+      Point2d pt2 = pixel2cam(f2.mvKeypoints[m.trainIdx].pt,K);
+      Mat y2 = (Mat_<double>(3,1)<<pt2.x,pt2.y,1);
+      
+      Mat d = y2.t()*t_x*R*y1;
+      if(d.at<double>(0,0)>0.01)      
+	cout<<"Epiploar Constraint:"<<d<<endl;
+      
+    }
+    
+    PointCloud::Ptr cloud1 ( new PointCloud() ); 
+    PointCloud::Ptr output(new PointCloud());
+    PointCloud::Ptr tmp(new PointCloud());
+    pcl::VoxelGrid<PointT> voxel;
+    double gridsize = 0.05; 
+    voxel.setLeafSize( gridsize, gridsize, gridsize );
+    
+    cloud1 = f1.img2cloud();
+    output = joinPointCloud(cloud1,f2,T);
+
+    pcl::visualization::CloudViewer viewer("viewer");
+    viewer.showCloud(output);
+    while(!viewer.wasStopped()){}
+    
+    return 0;
+}
+
+vector<DMatch> doMatch(Frame frame1, Frame frame2)
+{
+    vector<DMatch> matches;
+    BruteForceMatcher<HammingLUT> matcher;
+    matcher.match(frame1.mDescriptors,frame2.mDescriptors,matches);
+    
+    cout<<"Original matches:" << matches.size()<<endl;
+
+    double minDist = 1e5, maxDist = 0;
+    for(size_t i=0;i<matches.size();i++)
+    {
+	  double dist = matches[i].distance;
+	  minDist = dist < minDist ? dist: minDist;
+	  maxDist = dist > maxDist ? dist: maxDist;
+    }
+    cout<<"MinDist:"<<minDist<<endl;
+    cout<<"MaxDist:"<<maxDist<<endl;
+    
+    vector<DMatch> goodMatches;
+    for(size_t i=0;i<matches.size();i++)
+    {
+	    //if(matches[i].distance<0.6*maxDist&&matches[i].distance < 15*minDist)
+	    if ( matches[i].distance <= max ( 2*minDist, 20.0 ) )
+	    {
+		    goodMatches.push_back(matches[i]);
+	    }
+    }   
+    cout<<"Good Matches:"<<goodMatches.size()<<endl;
+    return goodMatches;
+}
+
+//Each time pick up eight points
+vector<vector<int>> generateRandomSets(int mMaxIterations, int N)
+{
+  vector<int> vAvaliableIndices(N);
+  for(int i=0; i<N; i++)
+  {
+    vAvaliableIndices[i]=i;
+  }
+  vector<vector<int>> mvSets = vector<vector<int>>(mMaxIterations, vector<int>(8,0));
+  srand(time(NULL));
+  
+  for(int i=0; i< mMaxIterations; i++)
+  {
+    for(int j=0; j<8; j++)
+    {
+      int randi = random()%(vAvaliableIndices.size());
+      int idx = vAvaliableIndices[randi];
+      mvSets[i][j] = idx;
+      vAvaliableIndices[randi]=vAvaliableIndices.back();
+      vAvaliableIndices.pop_back();
+    }
+  }
+  return mvSets;
+}
+
+
+cv::Mat computeF21(const vector<Point2f> &vP1, const vector<Point2f> &vP2)
+{
+    vector<int> vAvaliableIndices(vP1.size());
+    for(int i=0; i<vP1.size(); i++)
+    {
+      vAvaliableIndices[i]=i;
+    }
+    vector<int> mvSets;
+    mvSets.resize(8);
+    srand(time(NULL));
+
+    for(int i=0; i<8; i++)
+    {
+      int randi = random()%(vP1.size());
+      int idx = vAvaliableIndices[randi];
+      mvSets[i] = idx;
+      vAvaliableIndices[randi]=vAvaliableIndices.back();
+      vAvaliableIndices.pop_back();
+    }
+  
+    int N = vP1.size();
+    cv::Mat A(N,9,CV_32F);
+    for(int i=0; i<8; i++)
+    {
+	int t = mvSets[i];
+	const float u1 = vP1[t].x;
+	const float v1 = vP1[t].y;
+	const float u2 = vP2[t].x;
+	const float v2 = vP2[t].y;
+	
+	A.at<float>(i,0) = u2*u1;
+	A.at<float>(i,1) = u2*v1;
+	A.at<float>(i,2) = u2;
+	A.at<float>(i,3) = v2*u1;
+	A.at<float>(i,4) = v2*v1;
+	A.at<float>(i,5) = v2;
+	A.at<float>(i,6) = u1;
+	A.at<float>(i,7) = v1;
+	A.at<float>(i,8) = 1;
+    }
+    
+    cv::Mat u,w,vt;
+    //cout<<"A:"<<A<<endl;
+    cv::SVDecomp(A,w,u,vt,cv::SVD::MODIFY_A | cv::SVD::FULL_UV);
+    //cout<<"u:"<<u<<endl;
+    //cout<<"w:"<<w<<endl;
+    //cout<<"vt:"<<vt<<endl;
+    cv::Mat Fpre = vt.row(8).reshape(0,3);
+    cv::SVDecomp(Fpre,w,u,vt,cv::SVD::MODIFY_A | cv::SVD::FULL_UV);  
+    //w.at<float>(2)=0;
+    cv::Mat F21 = u*cv::Mat::diag(w)*vt;
+    return F21;
+}
+
+
+void findFundamental(float &score, Mat& F21)
+{
+    return;
+}
+
+void pose_estimate_2d2d()
+{
+    Camera camera;
+    camera.fx = 517.306408;
+    camera.fy = 516.469215;
+    camera.cx = 318.643040;
+    camera.cy = 255.313989;
+    camera.scale = 5000.0;
+    
+    camera.k1=0.262383;
+    camera.k2=-0.953104;
+    camera.p1=-0.005358;
+    camera.p2= 0.002628;
+    camera.k3= 1.163314;
+
+
+    Frame f1(0.0,"../data/img1.png","../data/depth1.png",camera);
+    Frame f2(0.0,"../data/img2.png","../data/depth2.png",camera);
+    
+    BruteForceMatcher<HammingLUT> matcher;
+    //FlannBasedMatcher  matcher;
+    vector<DMatch> matches;
+    matcher.match(f1.mDescriptors,f2.mDescriptors,matches);
+    
+    vector<DMatch> goodMatches = doMatch(f1,f2);
+     
+    vector<Point2f> points1;
+    vector<Point2f> points2;
+    vector<vector<int>> vmatches;
+    //cv::Mat output = drawInlier(f1,f2,vmatches);
+    
+    Mat res;
+    drawMatches(f1.rgb,f1.mvKeypoints,f2.rgb,f2.mvKeypoints,goodMatches,res,Scalar::all(-1),Scalar::all(-1),
+      vector<char>(),DrawMatchesFlags::NOT_DRAW_SINGLE_POINTS);
+    cv::imshow("result", res);
+    cvWaitKey(); 
+    
+    for(int i=0; i< goodMatches.size(); i++)
+    {
+	 points1.push_back(f1.mvKeypoints[goodMatches[i].queryIdx].pt);
+	 points2.push_back(f2.mvKeypoints[goodMatches[i].trainIdx].pt);
+    }
+    
+    Mat F = findFundamentalMat(points1,points2,CV_FM_8POINT);
+    cout<<"Fundamental: "<<F<<endl;
+    
+    //cv::Mat  F1 = computeF21(points1,points2);
+    //cout<<"ComputeF21:"<<F1<<endl;
+    
+    //cv::Mat H = findHomography(points1, points2,RANSAC,3,noArray());
+    //cout<<"H:"<<H<<endl;
+}
+
+void test()
+{
+	SysParams sysparams("/home/jpl/lines/TUM2.yaml");
+ 	SystemParameters sysPara;   //line parameters
+ 	Camera camera(sysparams);
+ 	
+ 	Frame f1(0.0,"../data/img1.png","../data/depth1.png",camera);
+ 	cout<<Frame::mnMinX<<" "<<Frame::mnMaxX<<" "<<Frame::mnMinY<<" "<<Frame::mnMaxY<<endl;
+	return;
+}
+
+void testDBoW()
+{
+	
+	SysParams sysparams("/home/jpl/lines/TUM2.yaml");
+ 	SystemParameters sysPara;   //line parameters
+ 	Camera camera(sysparams);
+ 	
+ 	Frame f1(0.0,"../data/img1.png","../data/depth1.png",camera);
+	
+	ORBVocabulary *mpORBVocabulary= new ORBVocabulary();
+    mpORBVocabulary->loadFromTextFile("../Vocabulary/ORBvoc.txt");
+	cout<<*mpORBVocabulary<<endl;
+	
+	
+	DBoW2::BowVector  			mBowVec;
+    DBoW2::FeatureVector		mFeatureVec;
+	vector<cv::Mat> 			vDescTmp;
+	vDescTmp.reserve(f1.mDescriptors.rows);
+	for(int i=0; i<f1.mDescriptors.rows;i++)
+	{
+		vDescTmp.push_back(f1.mDescriptors.row(i));
+	}
+	
+	mpORBVocabulary->transform(vDescTmp,mBowVec,mFeatureVec,4);
+	cout<<mBowVec.size()<<endl;
+	cout<<mFeatureVec.size()<<endl;
+	cout<<mBowVec.begin()->first<<endl;
+	
+	for(int i=140 ;i<165; i++)
+		cout<<i<<" "<<mBowVec[i]<<endl;
+	return;
+}
+
+void test1()
+{
+	cv::Mat rgb = cv::imread("sample.png",-1);
+	cv::Mat rgb1 = cv::imread("sample-1.png",-1);
+	cv::Mat gray;
+	cv::cvtColor(rgb,gray,CV_BGR2GRAY);
+	
+	int n;
+	LS* ls = callEDLines(gray, &n);
+	for(int i=0; i<n; i++) 
+	{
+		// store output to lineSegments 
+		if ((ls[i].sx-ls[i].ex)*(ls[i].sx-ls[i].ex) +(ls[i].sy-ls[i].ey)*(ls[i].sy-ls[i].ey) 
+			> 900) {
+			cv::Point2f p1 = cv::Point2d(ls[i].sx,ls[i].sy);
+			cv::Point2f p2 = cv::Point2d(ls[i].ex,ls[i].ey);
+			cv::line(rgb1,p1,p2,cv::Scalar(0,255,0),2);
+		}
+	}
+	delete[] ls;
+	imshow("1",rgb1);
+	imwrite("sample-2.png",rgb1);
+	waitKey();
+	
+	return;
+}
+
+
+void getEquation(PointCloud::Ptr cloud, vector<double>& c)
+{
+	//cout<<cloud->size()<<endl;
+	pcl::ModelCoefficients::Ptr coefficients (new pcl::ModelCoefficients ());
+	pcl::PointIndices::Ptr inliers (new pcl::PointIndices ());
+	pcl::SACSegmentation<PointT> seg;
+	seg.setOptimizeCoefficients (true);
+	seg.setModelType (pcl::SACMODEL_PLANE);
+	seg.setMethodType (pcl::SAC_RANSAC);
+	seg.setMaxIterations (1000);
+	seg.setDistanceThreshold (0.01);
+	seg.setInputCloud (cloud);
+	seg.segment (*inliers, *coefficients);
+	//cout<<cloud->size()<<endl;
+	c.reserve(4);
+	for(size_t i=0; i<4; i++) 
+	{	
+		c[i]=coefficients->values[i];
+		cout<<c[i]<<" ";
+	}
+	cout<<endl;
+	return;
+}
+
+
+void test2(string rgbname, string depthname, int id)
+{
+	Camera tum[4];
+	tum[0].fx = 517.306408;
+	tum[0].fy = 516.469215;
+	tum[0].cx = 318.643040;
+	tum[0].cy = 255.313989;
+	tum[0].scale = 5000.0;
+	
+	tum[1].fx = 520.908620;
+	tum[1].fy = 521.007327;
+	tum[1].cx = 325.141442;
+	tum[1].cy = 249.701764;
+	tum[1].scale = 5208.0;
+
+    tum[2].fx = 535.4;
+    tum[2].fy = 539.2;
+    tum[2].cx = 320.1;
+    tum[2].cy = 247.6;
+    tum[2].scale = 5000.0;
+	
+    tum[3].fx = 525;
+    tum[3].fy = 525;
+	tum[3].cx = 319.5;
+	tum[3].cy = 239.5;
+	tum[3].scale = 5000.0;
+	
+    SystemParameters sysPara;
+	
+    //Frame frame(0.0, "data/1rgb.png","data/1depth.png",tum[id]);
+	Frame frame(0.0, "data/"+rgbname,"data/"+depthname,tum[id-1]);
+	
+	Camera myTum = frame.camera;
+
+	PointCloud::Ptr cloud=frame.img2cloud();	
+	cout<<"size:"<<cloud->size()<<endl;
+	
+// 	pcl::VoxelGrid<PointT> voxel;
+// 	double gridsize = 0.03; 
+// 	voxel.setLeafSize( gridsize, gridsize, gridsize );
+// 	PointCloud::Ptr tmp(new PointCloud());
+// 	voxel.setInputCloud( cloud );
+//     voxel.filter( *tmp );
+//     cloud.swap(tmp);
+// 	cout<<"size:"<<cloud->size()<<endl;
+	
+// 	pcl::visualization::CloudViewer viewer("viewer");
+//     viewer.showCloud(cloud);
+// 	pcl::io::savePCDFile("tmp.pcd",*cloud);
+//     while(!viewer.wasStopped()){}
+	
+	
+	//segmentation
+	MyTimer mytimer;
+	mytimer.start();
+	pcl::search::Search<pcl::PointXYZRGBA>::Ptr tree = 
+		boost::shared_ptr<pcl::search::Search<pcl::PointXYZRGBA> > (new pcl::search::KdTree<pcl::PointXYZRGBA>);
+	pcl::PointCloud <pcl::Normal>::Ptr normals (new pcl::PointCloud <pcl::Normal>);
+	pcl::NormalEstimation<pcl::PointXYZRGBA, pcl::Normal> normal_estimator;
+	normal_estimator.setSearchMethod (tree);
+	normal_estimator.setInputCloud (cloud);
+	normal_estimator.setKSearch (100);
+	//normal_estimator.setRadiusSearch (0.05);
+	normal_estimator.compute (*normals);
+	{
+			pcl::visualization::PCLVisualizer viewer("PCL Viewer");
+			//viewer.setBackgroundColor (0.0, 0.0, 0.5);
+			viewer.addPointCloudNormals<pcl::PointXYZRGBA,pcl::Normal>(cloud, normals);
+			while (!viewer.wasStopped ())
+			{
+				viewer.spinOnce ();
+			}
+	}
+
+	pcl::IndicesPtr indices (new std::vector <int>);
+	pcl::PassThrough<pcl::PointXYZRGBA> pass;
+	pass.setInputCloud (cloud);
+	pass.setFilterFieldName ("z");
+	pass.setFilterLimits (0.0, 10.0);
+	pass.filter (*indices);
+	//cout<<"size2:"<<cloud->size()<<endl;;
+
+	pcl::RegionGrowing<pcl::PointXYZRGBA, pcl::Normal> reg;
+	reg.setMinClusterSize (1000);
+	reg.setMaxClusterSize (1000000);
+	reg.setSearchMethod (tree);
+	reg.setNumberOfNeighbours (30);
+	reg.setInputCloud (cloud);
+	reg.setIndices (indices);
+	reg.setInputNormals (normals);
+	reg.setSmoothnessThreshold (3.0 / 180.0 * M_PI);
+	reg.setCurvatureThreshold (0.10);
+
+	std::vector <pcl::PointIndices> clusters;
+	reg.extract(clusters);
+	mytimer.end();
+	cout<<"Time: "<<mytimer.time_ms<<" ms"<<endl;
+
+	std::cout << "Number of clusters is equal to " << clusters.size () << std::endl;
+	pcl::PointCloud<pcl::PointXYZRGBA>::Ptr cloud_plane(new pcl::PointCloud<pcl::PointXYZRGBA>);
+	vector<double> c;
+	srand(unsigned(time(NULL)));
+	Mat rs= frame.rgb.clone();
+	for(int i=0; i<clusters.size(); i++)
+	{
+		//std::cout << "Cluster " <<i<<" "<<clusters[i].indices.size () << " points." << endl;
+		pcl::PointCloud<pcl::PointXYZRGBA>::Ptr each_plane(new pcl::PointCloud<pcl::PointXYZRGBA>);
+		//each_plane->resize(clusters[i].indices.size ());
+		int r = rand()%255;
+		int g = rand()%255;
+		int b = 200;
+		for (size_t j = 0; j < clusters[i].indices.size (); ++j)
+		{
+
+			pcl::PointXYZRGBA point;
+			point.x = cloud->points[clusters[i].indices[j]].x;
+	  		point.y = cloud->points[clusters[i].indices[j]].y;
+	 		point.z = cloud->points[clusters[i].indices[j]].z;
+			point.r = r;
+			point.g = g;
+			point.b = b;
+			point.a = 0.0;
+			each_plane->push_back(point);
+			cloud_plane->push_back(point);
+			
+			int u= (int)(point.y * myTum.fy / point.z + myTum.cy);
+			int v= (int)(point.x * myTum.fx / point.z + myTum.cx);
+				
+			rs.ptr<uchar>(u)[v*3]=r;
+			rs.ptr<uchar>(u)[v*3+1]=g;
+			rs.ptr<uchar>(u)[v*3+2]=b;
+			
+			//cloud->points[clusters[i].indices[j]].r = r;
+			//cloud->points[clusters[i].indices[j]].g = g;
+			//cloud->points[clusters[i].indices[j]].b = b;
+			//cloud->points[clusters[i].indices[j]].a = 0.0;
+			//cloud->erase(index+inliers->indices[i]);
+		}
+		getEquation(each_plane,c);
+
+// 		for(size_t j=0; j<cloud->points.size(); j++)
+// 		{
+// 			double x = cloud->points[j].x;
+// 			double y = cloud->points[j].y;
+// 			double z = cloud->points[j].z;
+// 			//cout<<x<<" "<<y<<" "<<z<<endl;
+// 			if(abs(c[0]*x + c[1]*y + c[2]*z + c[3])<=0.05)
+// 			{
+// 				pcl::PointXYZRGBA p;
+// 				p.x = x;
+// 				p.y = y;
+// 				p.z = z;
+// 				p.r = r;
+// 				p.g = g;
+// 				p.b = b;
+// 				p.a = 0.0;
+// 				each_plane->push_back(p);
+// 				cloud_plane->push_back(p);
+// 				int u= (int)(pointT->y * fy / pointT->z + cy);
+// 				int v= (int)(pointT->x * fx / pointT->z + cx);
+// 				
+// 				rs.ptr<uchar>(u)[v*3]=255;
+// 			}
+// 		}
+		//pcl::visualization::CloudViewer viewer("viewer");
+		//viewer.showCloud(each_plane);
+		//while(!viewer.wasStopped()){}
+	}
+	
+	
+	//pcl::PointCloud <pcl::PointXYZRGB>::Ptr colored_cloud = reg.getColoredCloud ();
+	pcl::visualization::CloudViewer viewer ("Cluster viewer");
+	viewer.showCloud(cloud_plane);
+	viewer.runOnVisualizationThread(setPCLBackGround);
+	while (!viewer.wasStopped ()){}
+	
+	//pcl::visualization::PCLVisualizer viewer("viewer");
+	//viewer.setBackgroundColor(1.0,1.0,1.0);
+	//viewer.showCloud(cloud_plane,"viewer");
+	
+	
+	//cv::imshow("res",rs);
+	//cv::waitKey();
+	//cv:imwrite("plane.png",rs);
+	
+	/**/
+	return;
+}
+
+Eigen::Matrix4d toTransformation(double tx,double ty, double tz,double qx,double qy, double qz, double qw)
+{
+	// 1 - 2*qy2 - 2*qz2	2*qx*qy - 2*qz*qw	2*qx*qz + 2*qy*qw
+	// 2*qx*qy + 2*qz*qw	1 - 2*qx2 - 2*qz2	2*qy*qz - 2*qx*qw
+	// 2*qx*qz - 2*qy*qw	2*qy*qz + 2*qx*qw	1 - 2*qx2 - 2*qy2
+	Eigen::Matrix4d trans;
+	trans<< 	1-2*qy*qy-2*qz*qz,	2*qx*qy - 2*qz*qw,	2*qx*qz + 2*qy*qw, tx,
+			2*qx*qy + 2*qz*qw,	1-2*qx*qx-2*qz*qz,	2*qy*qz - 2*qx*qw, ty,
+			2*qx*qz - 2*qy*qw,	2*qy*qz + 2*qx*qw,	1-2*qx*qx-2*qy*qy, tz,
+			0,                  0,                  0,                 1.0;
+	return trans;
+}
+
+PointCloud::Ptr img2cloud(Mat rgb, Mat depth, Camera camera)
+{
+    PointCloud::Ptr cloud(new PointCloud);
+    for(int i=0;i<depth.rows;i+=3)
+    {
+		for(int j=0;j<depth.cols;j+=3)
+		{
+			double d=(double)depth.ptr<unsigned short>(i)[j]/camera.scale;
+			//cout<<d<<endl;
+			if(d <= 1e-2||d>=10)continue;
+			PointT p;
+			p.z= d;
+			p.x=(j-camera.cx)*p.z/camera.fx;
+			p.y=(i-camera.cy)*p.z/camera.fy;
+			
+			p.b=rgb.ptr<uchar>(i)[j*3];
+			p.g=rgb.ptr<uchar>(i)[j*3+1];
+			p.r=rgb.ptr<uchar>(i)[j*3+2];
+			
+
+			cloud->points.push_back(p);
+		}
+    }
+   
+    cloud->width=cloud->points.size();
+    cloud->height=1;
+    cloud->is_dense=false;
+    
+    return cloud;
+}
+ 
+int reconstruction(string dir)
+{
+	
+	pcl::visualization::CloudViewer viewer("viewer");
+	cv::namedWindow("rgb");
+	cv::namedWindow("depth");
+	cv::Mat img1=imread("0.png",-1);
+	cv::imshow("rgb",img1);
+    cv::imshow("depth",img1);
+	Camera tum3;
+    tum3.fx = 535.4;
+    tum3.fy = 539.2;
+    tum3.cx = 320.1;
+    tum3.cy = 247.6;
+    tum3.scale = 5000.0;
+	
+	PointCloud::Ptr globalMap ( new PointCloud() ); 
+	
+	waitKey();
+	
+	vector<Eigen::Matrix4d> poses;
+	//ifstream fin(dir+"/res/CameraTrajectory.txt");
+	ifstream fin(dir+"jpl.txt");
+	double gridsize = 0.02; 
+	VoxelMap voxelMap(gridsize);
+	while(!fin.eof())
+	{
+		string s;
+		getline(fin,s);
+		//if(s[0]=='#')continue;
+		if(!s.empty())
+		{
+			stringstream ss(s.c_str());
+			double t,tx,ty,tz,qx,qy,qz,qw;
+			double t1,t2;
+			string s1,s2;
+			fin>>t>>tx>>ty>>tz>>qx>>qy>>qz>>qw;
+			fin>>t1>>s1>>t2>>s2;
+			Eigen::Matrix4d pose=toTransformation(tx,ty,tz,qx,qy,qz,qw);
+			poses.push_back(pose);
+			Mat rgb=cv::imread(dir+s1, CV_LOAD_IMAGE_UNCHANGED);
+			Mat depth=cv::imread(dir+s2,CV_LOAD_IMAGE_ANYDEPTH);
+			
+			Mat rs=rgb.clone();
+			Frame frame(0,rgb,depth,tum3);
+			for(int k=0; k<frame.lines.size();k++)
+			{
+				cv::Point2f left1 = frame.lines[k].p;
+				cv::Point2f left2 = frame.lines[k].q;
+				cv::line(rs,left1,left2,cv::Scalar(0,255,0),3);
+			}
+			for(int k=0; k<frame.mvKeypoints.size();k++)
+			{
+				circle(rs,frame.mvKeypoints[k].pt,1,Scalar(0,0,255),2);
+			}
+			//frame.planeExtraction();
+			cv::imshow("rgb",rs);
+			cv::imshow("depth",depth);
+			cv::waitKey(20);
+			
+			PointCloud::Ptr cloud = img2cloud(rgb,depth,tum3);
+		
+			voxelMap.integrate(poses.size()-1, *cloud, Eigen::Isometry3d(pose)); //pose = Twc
+			voxelMap.toCloud(*globalMap);
+			viewer.showCloud(globalMap);
+		}
+	}
+	pcl::io::savePCDFile("global.pcd",*globalMap);
+	
+
+    
+	//viewer.runOnVisualizationThread(setPCLBackGround);
+    while(!viewer.wasStopped()){}
+	
+	fin.close();
+	
+	return 0;
+}
+
+
+int reconstruction_pangolin(string dir)
+{
+	
+	float mImageWidth = 640;
+	float mImageHeight = 480;
+	float mViewpointX = 5;
+	float mViewpointY = 5;
+	float mViewpointZ = 5;
+	float mViewpointF = 500;
+	
+	pangolin::CreateWindowAndBind("AR demo",640,480);
+	glEnable(GL_DEPTH_TEST);
+	glEnable(GL_BLEND);
+	
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	
+	
+	pangolin::OpenGlRenderState s_cam(
+			pangolin::ProjectionMatrix(1024,768,535.4,539.2,320.1,247.6,0.01,1000),
+			pangolin::ModelViewLookAt(mViewpointX,mViewpointY,mViewpointZ, 0,0,0,0.0,1.0, 0.0)
+			);
+			
+	pangolin::View& d_cam = pangolin::CreateDisplay()
+            .SetBounds(0.0, 1.0, pangolin::Attach::Pix(0), 1.0, -640.0f/480.0f)
+            .SetHandler(new pangolin::Handler3D(s_cam));			
+			//.SetLock(pangolin::LockLeft, pangolin::LockTop);
+			
+	pangolin::View& d_image = pangolin::Display("image")
+		.SetBounds(0,1.0f,pangolin::Attach::Pix(0),1.0f,(float)640/480)
+		.SetLock(pangolin::LockLeft, pangolin::LockTop);
+		
+	pangolin::GlTexture imageTexture(640,480,GL_RGB,false,0,GL_RGB,GL_UNSIGNED_BYTE);
+	pangolin::OpenGlMatrixSpec P = pangolin::ProjectionMatrixRDF_TopLeft(640,480,535.4,539.2,320.1,247.6,0.001,1000);
+	
+	pangolin::OpenGlMatrix Twc;
+    Twc.SetIdentity();
+	
+
+	cv::namedWindow("rgb");
+	cv::namedWindow("depth");
+	Camera tum3;
+    tum3.fx = 535.4;
+    tum3.fy = 539.2;
+    tum3.cx = 320.1;
+    tum3.cy = 247.6;
+    tum3.scale = 5000.0;
+	
+	PointCloud::Ptr globalMap ( new PointCloud() ); 
+	PointCloud::Ptr tmp(new PointCloud());
+	
+	waitKey();
+	
+	vector<Eigen::Matrix4d> poses;
+	//ifstream fin(dir+"/res/CameraTrajectory.txt");
+	ifstream fin(dir+"jpl.txt");
+	int count=0;
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	while(!pangolin::ShouldQuit())
+	{
+		cout<<count<<endl;
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+		
+		//d_cam.Activate(s_cam);
+		d_image.Activate();
+		glColor3f(1.0,1.0,1.0);
+				
+		while(!fin.eof())
+		{
+			count++;
+			//cout<<count++<<endl;
+			string s;
+			getline(fin,s);
+			//if(s[0]=='#')continue;
+			if(!s.empty())
+			{
+				stringstream ss(s.c_str());
+				double t,tx,ty,tz,qx,qy,qz,qw;
+				double t1,t2;
+				string s1,s2;
+				fin>>t>>tx>>ty>>tz>>qx>>qy>>qz>>qw;
+				fin>>t1>>s1>>t2>>s2;
+				Eigen::Matrix4d pose1=toTransformation(tx,ty,tz,qx,qy,qz,qw);
+				
+				Eigen::Matrix4d pose=pose1.inverse();
+				
+				std::vector<GLfloat> Twc = {
+					(float)pose(0,0),(float)pose(1,0),(float)pose(2,0),0,
+					(float)pose(0,1),(float)pose(1,1),(float)pose(2,1),0,
+					(float)pose(0,2),(float)pose(1,2),(float)pose(2,2),0,
+					(float)pose(0,3),(float)pose(1,3),(float)pose(2,3),1};
+					
+				pangolin::OpenGlMatrix M;
+
+				M.m[0] = pose(0,0);
+				M.m[1] = pose(1,0);
+				M.m[2] = pose(2,0);
+				M.m[3]  = 0.0;
+
+				M.m[4] = pose(0,1);
+				M.m[5] = pose(1,1);
+				M.m[6] = pose(2,1);
+				M.m[7]  = 0.0;
+
+				M.m[8] = pose(0,2);
+				M.m[9] = pose(1,2);
+				M.m[10] = pose(2,2);
+				M.m[11] = 0.0;
+
+				M.m[12] = pose(0,3);
+				M.m[13] = pose(1,3);
+				M.m[14] = pose(2,3);
+				M.m[15]  = 1.0;
+					
+				//poses.push_back(pose);
+				Mat rgb=cv::imread(dir+s1, CV_LOAD_IMAGE_UNCHANGED);
+				Mat depth=cv::imread(dir+s2,CV_LOAD_IMAGE_ANYDEPTH);
+
+				imageTexture.Upload(rgb.data,GL_RGB,GL_UNSIGNED_BYTE);
+				imageTexture.RenderToViewportFlipY();
+				
+				glClear(GL_DEPTH_BUFFER_BIT);
+
+				// Load camera projection
+				glMatrixMode(GL_PROJECTION);
+				P.Load();
+				
+				glMatrixMode(GL_MODELVIEW);
+				M.Load();
+					
+				
+				//std::vector<GLfloat> Twc = {1,0,0,0, 0,1,0,0 , 0,0,1,0 ,2,0,0,1};//frame.mTwc;
+				//glMultMatrixf(Twc.data());
+				
+			
+// 	
+// 				
+// 				const float w = 0.02;
+// 				const float h = w*0.75;
+// 				const float z = w*0.6;
+// 				glLineWidth(2);
+// 				glColor3f(0.0,1.0,0.0);
+// 				glBegin(GL_LINES);
+// 				glVertex3f(0,0,0);
+// 				glVertex3f(w,h,z);
+// 				glVertex3f(0,0,0);
+// 				glVertex3f(w,-h,z);
+// 				glVertex3f(0,0,0);
+// 				glVertex3f(-w,-h,z);
+// 				glVertex3f(0,0,0);
+// 				glVertex3f(-w,h,z);
+// 				glVertex3f(w,h,z);
+// 				glVertex3f(w,-h,z);
+// 				glVertex3f(-w,h,z);
+// 				glVertex3f(-w,-h,z);
+// 				glVertex3f(-w,h,z);
+// 				glVertex3f(w,h,z);
+// 				glVertex3f(-w,-h,z);
+// 				glVertex3f(w,-h,z);
+// 				glEnd();
+				
+				{
+					pangolin::OpenGlMatrix M = pangolin::OpenGlMatrix::Translate(-2,0,-0.1);
+					glPushMatrix();
+					M.Multiply();
+					pangolin::glDrawColouredCube(-0.1,0.1);
+					glPopMatrix();
+					
+// 					M = pangolin::OpenGlMatrix::Translate(-1.5,0.5,-0.1);
+// 					glPushMatrix();
+// 					M.Multiply();
+// 					pangolin::glDrawColouredCube(-0.1,0.1);
+// 					glPopMatrix();
+				}
+				
+ 				Mat rs=rgb.clone();
+ 				Frame frame(0,rgb,depth,tum3);
+// 				{
+// 					glLineWidth(10);
+// 					glColor3f(1.0,0.0,0.0);
+// 					glBegin(GL_LINES);
+// 					for(int i=0 ;i< frame.lines.size(); i++)
+// 					{
+// 						cv::Point3d A = frame.lines[i].line3d.A;
+// 						cv::Point3d B = frame.lines[i].line3d.B;
+// 						
+// 						if(cv::norm(A-B)<0.3)continue;
+// 						
+// 						glVertex3f(A.x,A.y,A.z);
+// 						glVertex3f(B.x,B.y,B.z);
+// 						
+// 					}
+// 					glEnd();
+// 				}
+// 				
+// 				
+// 				{
+// 					glPointSize(1);
+// 					glBegin(GL_POINTS);
+// 					
+// 					PointCloud::Ptr cloud = img2cloud(rgb,depth,tum3);
+// 					for(int k=0; k<cloud->points.size(); k++)
+// 					{
+// 						PointT p = cloud->points[k];
+// 						
+// 						uint32_t x = p.rgba;
+// 						
+// 						uint32_t alpha = (x & 0xff000000) >> 24;
+// 						uint32_t red = (x & 0x00ff0000) >> 16;
+// 						uint32_t green = (x & 0x0000ff00) >> 8;
+// 						uint32_t blue = (x & 0x000000ff);
+// 						
+// 						glColor3f(red/255.0,green/255.0,blue/255.0);
+// 						glVertex3f(p.x,p.y,p.z);
+// 					}
+// 					glEnd();
+// 					cloud->clear();
+// 				}
+				
+				
+				for(int k=0; k<frame.lines.size();k++)
+				{
+					cv::Point2f left1 = frame.lines[k].p;
+					cv::Point2f left2 = frame.lines[k].q;
+					cv::line(rs,left1,left2,cv::Scalar(0,255,0),3);
+				}
+				for(int k=0; k<frame.mvKeypoints.size();k++)
+				{
+					circle(rs,frame.mvKeypoints[k].pt,1,Scalar(0,0,255),2);
+				}
+				//frame.planeExtraction();
+			
+				
+				cv::imshow("rgb",rs);
+				cv::imshow("depth",depth);
+				cv::waitKey(50);
+				
+				//glPopMatrix();
+				break;
+			}
+			
+		}
+		
+		pangolin::FinishFrame();
+		
+	}
+	//pcl::io::savePCDFile("global.pcd",*globalMap);
+	fin.close();
+	
+	return 0;
+}
+
+
+PointCloud::Ptr img2cloud_test(Mat rgb, Mat depth, Camera camera)
+{
+    PointCloud::Ptr cloud(new PointCloud);
+    for(int i=0;i<depth.rows;i+=3)
+    {
+		for(int j=0;j<depth.cols;j+=3)
+		{
+			double d=(uchar)depth.ptr<uchar>(i)[j]/camera.scale;
+			//cout<<d<<endl;
+			if(d <= 1||d>=10)continue;
+			PointT p;
+			p.z= d;
+			p.x=(j-camera.cx)*p.z/camera.fx;
+			p.y=(i-camera.cy)*p.z/camera.fy;
+			
+			p.b=rgb.ptr<uchar>(i)[j*3];
+			p.g=rgb.ptr<uchar>(i)[j*3+1];
+			p.r=rgb.ptr<uchar>(i)[j*3+2];
+			cloud->points.push_back(p);
+		}
+    }
+   
+    cloud->width=cloud->points.size();
+    cloud->height=1;
+    cloud->is_dense=false;
+    
+    return cloud;
+}
+
+int drawPointCloud(int idx)
+{
+	//int idx=2;
+	string dir = "/home/jpl/programming/zjh/data"+to_string(idx)+"/";
+	Mat rgb=cv::imread(dir+"im1.png", 	CV_LOAD_IMAGE_UNCHANGED);
+	Mat depth=cv::imread(dir+"fuse.png",CV_LOAD_IMAGE_ANYDEPTH);
+	//cv::imshow("rgb",rgb);
+    //cv::imshow("depth",depth);
+	//waitKey();
+	
+	Camera tum[4];
+    tum[1].fx = 713.189;
+    tum[1].fy = 713.189;
+    tum[1].cx = 387.361;
+    tum[1].cy = 238.263;
+    tum[1].scale = 25.5;
+	
+    tum[2].fx = 1500;
+    tum[2].fy = 1500;
+    tum[2].cx = 251;
+    tum[2].cy = 187;
+    tum[2].scale = 25.5;
+	
+    tum[3].fx = 585.489;
+    tum[3].fy = 585.489;
+    tum[3].cx = 312.353;
+    tum[3].cy = 234.124;
+    tum[3].scale = 25.5;
+	
+    tum[4].fx = 1038.018;
+    tum[4].fy = 1038.018;
+    tum[4].cx = 375.308;
+    tum[4].cy = 243.393;
+    tum[4].scale = 25.5;
+	
+	pcl::visualization::CloudViewer viewer("viewer");
+	PointCloud::Ptr cloud = img2cloud_test(rgb,depth,tum[idx]);
+	
+	
+// 	pcl::VoxelGrid<PointT> voxel;
+// 	double gridsize = 0.01; 
+// 	voxel.setLeafSize( gridsize, gridsize, gridsize );
+// 	voxel.setInputCloud( cloud );
+// 	voxel.filter( *cloud );
+	
+	
+	viewer.showCloud(cloud);
+	//viewer.runOnVisualizationThread(setPCLBackGround);
+    while(!viewer.wasStopped()){}
+	
+	return 0;
+}
+
+//!compare the analytic jacobians of EdgeSE3LineEndpts with numeric differentiation
+int testLineEdgeJacobian()
+{
+	srand(0);
+	double max_diff = 0;
+	for(int k=0; k<100; k++)
+	{
+		g2o::SparseOptimizer optimizer;
+		g2o::ParameterSE3Offset* sensorOffset = new g2o::ParameterSE3Offset;
+		Eigen::Isometry3d offset = Eigen::Isometry3d::Identity();
+		if(k%2)
+		{
+			offset.linear() = Eigen::AngleAxisd(0.3, Eigen::Vector3d::Random().normalized()).toRotationMatrix();
+			offset.translation() = Eigen::Vector3d::Random();
+		}
+		sensorOffset->setOffset(offset);
+		sensorOffset->setId(1);
+		optimizer.addParameter(sensorOffset);
+
+		g2o::VertexSE3* cam = new g2o::VertexSE3();
+		Eigen::Isometry3d pose = Eigen::Isometry3d::Identity();
+		pose.linear() = Eigen::AngleAxisd(M_PI*(rand()%100)/100.0, Eigen::Vector3d::Random().normalized()).toRotationMatrix();
+		pose.translation() = Eigen::Vector3d::Random();
+		cam->setEstimate(pose);
+		cam->setId(0);
+		optimizer.addVertex(cam);
+
+		g2o::VertexLineEndpts* line = new g2o::VertexLineEndpts();
+		line->setEstimate(2*Eigen::Vector6d::Random());
+		line->setId(1);
+		optimizer.addVertex(line);
+
+		g2o::EdgeSE3LineEndpts* e = new g2o::EdgeSE3LineEndpts();
+		e->vertices()[0] = cam;
+		e->vertices()[1] = line;
+		e->setMeasurement(2*Eigen::Vector6d::Random());
+		e->endpt_AffnMat = Eigen::Matrix6d::Identity()*2 + 0.5*Eigen::Matrix6d::Random();
+		e->endpt_AffnMat.block<3,3>(0,3).setZero();
+		e->endpt_AffnMat.block<3,3>(3,0).setZero();
+		e->setParameterId(0,1);
+		optimizer.addEdge(e);
+		optimizer.initializeOptimization();
+
+		g2o::JacobianWorkspace workspace;
+		workspace.updateSize(e);
+		workspace.allocate();
+		e->computeError();
+		static_cast<g2o::OptimizableGraph::Edge*>(e)->linearizeOplus(workspace);
+		Eigen::Matrix6d Ji = e->jacobianOplusXi(), Jj = e->jacobianOplusXj();
+		e->g2o::BaseBinaryEdge<6, Eigen::Vector6d, g2o::VertexSE3, g2o::VertexLineEndpts>::linearizeOplus();
+
+		double scale = std::max(1.0, e->jacobianOplusXi().cwiseAbs().maxCoeff());
+		max_diff = std::max(max_diff, (Ji - e->jacobianOplusXi()).cwiseAbs().maxCoeff()/scale);
+		max_diff = std::max(max_diff, (Jj - e->jacobianOplusXj()).cwiseAbs().maxCoeff()/scale);
+	}
+	cout<<"EdgeSE3LineEndpts jacobian, max relative difference to numeric: "<<max_diff<<endl;
+	return max_diff < 1e-5 ? 0 : -1;
+}
+
+int testPointErrorBatch()
+{
+	srand(0);
+	Eigen::Isometry3d T = Eigen::Isometry3d::Identity();
+	T.linear() = Eigen::AngleAxisd(0.2, Eigen::Vector3d::Random().normalized()).toRotationMatrix();
+	T.translation() = 0.05*Eigen::Vector3d::Random();
+	Eigen::Matrix4d tf_21 = T.matrix().inverse();
+
+	PointErrorBatch batch;
+	vector<Eigen::Vector4f> x1, x2;
+	for(int i=0; i<1000; i++)
+	{
+		Eigen::Vector3d p2 = Eigen::Vector3d::Random() + Eigen::Vector3d(0,0,2);
+		Eigen::Vector3d p1 = T*p2 + (i%3 ? 0.01 : 0.2)*Eigen::Vector3d::Random();
+		x1.push_back(Eigen::Vector4f(p1.x(), p1.y(), i%50 ? p1.z() : NAN, 1));
+		x2.push_back(Eigen::Vector4f(p2.x(), p2.y(), p2.z(), 1));
+		batch.add(x1.back(), x2.back());
+	}
+	vector<double> err(batch.size());
+	batch.evaluate(tf_21, err.data());
+
+	int mismatch = 0;
+	double max_diff = 0;
+	for(size_t i=0; i<x1.size(); i++)
+	{
+		double e = errorFunction(x1[i], x2[i], T.matrix());
+		if((e == std::numeric_limits<double>::max()) != (err[i] == std::numeric_limits<double>::max()))
+			mismatch++;
+		else if(e != std::numeric_limits<double>::max())
+			max_diff = std::max(max_diff, fabs(e-err[i])/std::max(1.0, e));
+	}
+	cout<<"PointErrorBatch: "<<mismatch<<" mismatches, max relative difference to errorFunction: "<<max_diff<<endl;
+	return (mismatch == 0 && max_diff < 1e-6) ? 0 : -1;
+}
+
+int testFlatVocabulary()
+{
+	ORBVocabulary voc;
+	FlatVocabulary flat;
+	if(!voc.loadFromTextFile("../Vocabulary/ORBvoc.txt") || !flat.loadVocabulary("../Vocabulary/ORBvoc.txt"))
+		return -1;
+
+	srand(0);
+	cv::Mat desc(3000, 32, CV_8U);
+	for(int i=0; i<desc.rows; i++)
+	{
+		voc.getWord(rand()%voc.size()).copyTo(desc.row(i));
+		desc.at<uchar>(i, rand()%32) ^= 1<<(rand()%8);
+	}
+	vector<cv::Mat> rows;
+	for(int i=0; i<desc.rows; i++)
+		rows.push_back(desc.row(i));
+
+	DBoW2::BowVector v1, v2;
+	DBoW2::FeatureVector fv1, fv2;
+	MyTimer timer;
+	timer.start();
+	voc.transform(rows, v1, fv1, 4);
+	timer.end();
+	cout<<"TemplatedVocabulary::transform "<<timer.time_ms<<" ms"<<endl;
+	timer.start();
+	flat.transform(desc, v2, fv2, 4);
+	timer.end();
+	cout<<"FlatVocabulary::transform "<<timer.time_ms<<" ms"<<endl;
+	bool same = v1 == v2 && fv1 == fv2;
+	cout<<"FlatVocabulary: "<<(same ? "same" : "different")<<" BoW vectors"<<endl;
+	return same ? 0 : -1;
+}
+
+//! a small graph and keyframe written by saveMap and read back by loadMap
+int testMapIO()
+{
+	g2o::SparseOptimizer opt, opt2;
+	for(int i=0; i<3; i++)
+	{
+		g2o::VertexSE3* v = new g2o::VertexSE3();
+		v->setId(i);
+		Eigen::Isometry3d T = Eigen::Isometry3d::Identity();
+		T.translation() = Eigen::Vector3d(i, 0.5*i, 0);
+		v->setEstimate(T);
+		v->setFixed(i==0);
+		opt.addVertex(v);
+	}
+	g2o::VertexPlane* vp = new g2o::VertexPlane();
+	vp->setId(10);
+	vp->setEstimate(Eigen::Vector4d(0, 0, 1, -1));
+	opt.addVertex(vp);
+	for(int i=0; i<2; i++)
+	{
+		g2o::EdgeSE3* e = new g2o::EdgeSE3();
+		e->vertices()[0] = opt.vertex(i);
+		e->vertices()[1] = opt.vertex(i+1);
+		Eigen::Isometry3d T = Eigen::Isometry3d::Identity();
+		T.translation() = Eigen::Vector3d(1, 0.5, 0);
+		e->setMeasurement(T);
+		e->setInformation(Eigen::Matrix<double,6,6>::Identity()*(i+1));
+		g2o::RobustKernelHuber* rk = new g2o::RobustKernelHuber;
+		rk->setDelta(5.99);
+		e->setRobustKernel(rk);
+		opt.addEdge(e);
+	}
+	g2o::EdgeSE3Norm* en = new g2o::EdgeSE3Norm();
+	en->vertices()[0] = opt.vertex(1);
+	en->vertices()[1] = opt.vertex(10);
+	en->setMeasurement(Eigen::Vector4d(0, 0, 1, -1));
+	en->setInformation(Eigen::Matrix3d::Identity());
+	opt.addEdge(en);
+
+	vector<Frame> kfs(1), kfs2;
+	kfs[0].id = 7;
+	kfs[0].timestamp = 1.5;
+	kfs[0].isKeyFrame = true;
+	kfs[0].mDescriptors = cv::Mat::ones(5, 32, CV_8U);
+	kfs[0].mvKeypoints.resize(5, cv::KeyPoint(10, 20, 7));
+	kfs[0].N = 5;
+	FrameLine l(cv::Point2d(1,2), cv::Point2d(30,40));
+	l.line3d = RandomLine3d(cv::Point3d(0,0,1), cv::Point3d(1,0,1), cv::Mat::eye(3,3,CV_64F), cv::Mat::eye(3,3,CV_64F));
+	kfs[0].lines.push_back(l);
+	FramePlane pl;
+	pl.n = cv::Point3d(0,0,1);
+	pl.cells.push_back(3);
+	kfs[0].planes.push_back(pl);
+	kfs[0].mBowVec.addWeight(12, 0.25);
+
+	PointCloud cloud, cloud2;
+	PointT p;
+	p.x = 1; p.y = 2; p.z = 3; p.rgba = 0xff00ff00;
+	cloud.push_back(p);
+
+	VoxelMap voxels(0.02), voxels2(0.02);
+	voxels.integrate(0, cloud, Eigen::Isometry3d::Identity());
+	PointCloud vcloud, vcloud2;
+	voxels.toCloud(vcloud);
+
+	Frame::nextid = 0;
+	if(!saveMap("test_map.bin", kfs, opt, 0, &cloud, &voxels) || !loadMap("test_map.bin", kfs2, opt2, 0, &cloud2, &voxels2))
+		return -1;
+	voxels2.toCloud(vcloud2);
+
+	bool same = opt2.vertices().size() == opt.vertices().size() && opt2.edges().size() == opt.edges().size()
+		&& kfs2.size() == 1 && kfs2[0].id == 7 && kfs2[0].mvKeypoints.size() == 5
+		&& cv::norm(kfs2[0].mDescriptors, kfs[0].mDescriptors) == 0
+		&& kfs2[0].lines.size() == 1 && kfs2[0].lines[0].line3d.B.x == 1
+		&& kfs2[0].planes.size() == 1 && kfs2[0].planes[0].cells == pl.cells
+		&& kfs2[0].mBowVec == kfs[0].mBowVec
+		&& cloud2.size() == 1 && cloud2.points[0].rgba == p.rgba
+		&& Frame::nextid == 8
+		&& vcloud2.size() == 1 && vcloud2.points[0].getVector3fMap() == vcloud.points[0].getVector3fMap()
+		&& vcloud2.points[0].rgba == vcloud.points[0].rgba;
+	g2o::VertexSE3* v2 = dynamic_cast<g2o::VertexSE3*>(opt2.vertex(2));
+	same = same && v2 && (v2->estimate().matrix() - dynamic_cast<g2o::VertexSE3*>(opt.vertex(2))->estimate().matrix()).norm() == 0;
+
+	// a truncated file and a count past its end are rejected, not allocated
+	vector<char> buf;
+	FILE* f = fopen("test_map.bin", "rb");
+	for(int c; f && (c = fgetc(f)) != EOF; ) buf.push_back(c);
+	if(f) fclose(f);
+	bool rejected = buf.size() > 64;
+	if(rejected) {
+		f = fopen("test_map_cut.bin", "wb");
+		fwrite(&buf[0], 1, buf.size()/2, f);
+		fclose(f);
+		uint64_t huge = ~uint64_t(0)>>1;
+		memcpy(&buf[24], &huge, sizeof(huge));  // keyframe count, after magic, version and the KFRM header
+		f = fopen("test_map_count.bin", "wb");
+		fwrite(&buf[0], 1, buf.size(), f);
+		fclose(f);
+		rejected = !loadMap("test_map_cut.bin", kfs2, opt2) && !loadMap("test_map_count.bin", kfs2, opt2);
+	}
+	same = same && rejected;
+	cout<<"MapIO: "<<(same ? "same" : "different")<<" map after loading"<<endl;
+	return same ? 0 : -1;
+}
+
+static bool lessX(const PointT& a, const PointT& b) { return a.x < b.x; }
+
+//! same points within tol and same colours up to rounding, in any order
+static bool sameCloud(const PointCloud& a, PointCloud b, float tol)
+{
+	if(a.points.size() != b.points.size()) return false;
+	std::sort(b.points.begin(), b.points.end(), lessX);
+	for(size_t i=0; i<a.points.size(); i++)
+	{
+		const PointT& p = a.points[i];
+		PointT lo = p;
+		lo.x -= tol;
+		bool found = false;
+		for(size_t j = std::lower_bound(b.points.begin(), b.points.end(), lo, lessX) - b.points.begin();
+		    !found && j<b.points.size() && b.points[j].x <= p.x + tol; j++)
+		{
+			const PointT& q = b.points[j];
+			found = fabs(q.y - p.y) <= tol && fabs(q.z - p.z) <= tol
+				&& abs(q.r - p.r) <= 1 && abs(q.g - p.g) <= 1 && abs(q.b - p.b) <= 1;
+		}
+		if(!found) return false;
+	}
+	return true;
+}
+
+//! a keyframe integrated again with a new pose gives the map of the new pose only
+int testVoxelMap()
+{
+	PointCloud cloud;
+	srand(0);
+	for(int i=0; i<100000; i++)
+	{
+		PointT p;
+		p.x = rand()/(float)RAND_MAX*2 - 1;
+		p.y = rand()/(float)RAND_MAX*2 - 1;
+		p.z = 1 + rand()/(float)RAND_MAX*3;
+		p.r = rand()%256; p.g = 10; p.b = 200;
+		cloud.points.push_back(p);
+	}
+	Eigen::Isometry3d A = Eigen::Isometry3d::Identity(), B = A;
+	B.rotate(Eigen::AngleAxisd(0.2, Eigen::Vector3d::UnitY()));
+	B.pretranslate(Eigen::Vector3d(0.3, -0.1, 0.05));
+
+	VoxelMap map(0.02), ref(0.02);
+	MyTimer timer;
+	timer.start();
+	map.integrate(1, cloud, A);
+	map.integrate(2, cloud, A);
+	map.integrate(1, cloud, B);
+	timer.end();
+	cout<<"VoxelMap: 3 x "<<cloud.points.size()<<" points integrated in "<<timer.time_ms<<" ms"<<endl;
+	ref.integrate(2, cloud, A);
+	ref.integrate(1, cloud, B);
+
+	PointCloud c1, c2;
+	map.toCloud(c1);
+	ref.toCloud(c2);
+	bool same = sameCloud(c1, c2, 1e-4);
+	map.remove(1, cloud);
+	map.remove(2, cloud);
+	same = same && map.size() == 0;
+	cout<<"VoxelMap: "<<(same ? "same" : "different")<<" map after re-integration"<<endl;
+
+	// a 40 m walk with 4 MB of resident voxels, the chunks behind are written out and read back
+	VoxelMap chunked(0.03), all(0.03);
+	chunked.setStorage("chunks_test", 4<<20, 5.0);
+	for(int k=0; k<40; k++)
+	{
+		Eigen::Isometry3d T = Eigen::Isometry3d::Identity();
+		T.translation() = Eigen::Vector3d(k, 0, 0);
+		chunked.integrate(k, cloud, T);
+		all.integrate(k, cloud, T);
+	}
+	chunked.integrate(0, cloud, B);
+	all.integrate(0, cloud, B);
+	chunked.toCloud(c1);
+	all.toCloud(c2);
+	cout<<"VoxelMap: "<<chunked.residentBytes()/1e6<<" MB resident out of "<<all.residentBytes()/1e6<<" MB"<<endl;
+	same = same && chunked.size() == all.size() && sameCloud(c1, c2, 1e-4);
+	return same ? 0 : -1;
+}
+
+//! a sphere seen from a ring of cameras, the mesh vertices have to lie on it
+int testTsdfVolume()
+{
+	Camera cam;
+	cam.fx = cam.fy = 525;
+	cam.cx = 319.5;
+	cam.cy = 239.5;
+	cam.scale = 5000;
+	const Eigen::Vector3d C(0, 0, 2);
+	const double R = 0.5;
+
+	TsdfVolume tsdf(0.01f, 0.04f);
+	MyTimer timer;
+	double integrate_ms = 0;
+	for(int k=0; k<12; k++)
+	{
+		double a = k*2*M_PI/12;
+		Eigen::Isometry3d Twc = Eigen::Isometry3d::Identity();
+		Twc.translation() = C + Eigen::Vector3d(1.5*sin(a), 0, -1.5*cos(a));
+		Eigen::Vector3d z = (C - Twc.translation()).normalized(), y(0, 1, 0);
+		Twc.linear().col(0) = y.cross(z);
+		Twc.linear().col(1) = y;
+		Twc.linear().col(2) = z;
+
+		cv::Mat depth(480, 640, CV_32F), rgb(480, 640, CV_8UC3, cv::Scalar(10, 100, 200));
+		for(int v=0; v<depth.rows; v++)
+			for(int u=0; u<depth.cols; u++)
+			{
+				Eigen::Vector3d d = Twc.linear()*Eigen::Vector3d((u-cam.cx)/cam.fx, (v-cam.cy)/cam.fy, 1);
+				Eigen::Vector3d oc = Twc.translation() - C;
+				double b = oc.dot(d), disc = b*b - d.squaredNorm()*(oc.squaredNorm() - R*R);
+				double s = disc > 0 ? (-b - sqrt(disc))/d.squaredNorm() : 0;
+				depth.at<float>(v, u) = s > 0 ? s*cam.scale : 0;
+			}
+		timer.start();
+		tsdf.integrate(depth, rgb, cam, Twc);
+		timer.end();
+		integrate_ms += timer.time_ms;
+	}
+	TsdfMesh mesh;
+	tsdf.extractMesh(mesh);
+	cout<<"TsdfVolume: "<<tsdf.blockNum()<<" blocks, "<<integrate_ms/12<<" ms per frame, "
+	    <<mesh.vertices.size()<<" vertices, "<<mesh.triangles.size()<<" triangles"<<endl;
+
+	double maxErr = 0;
+	for(size_t i=0; i<mesh.vertices.size(); i++)
+		maxErr = max(maxErr, fabs((mesh.vertices[i].cast<double>() - C).norm() - R));
+	int inward = 0;
+	for(size_t i=0; i<mesh.triangles.size(); i++)
+	{
+		const Eigen::Vector3f& a = mesh.vertices[mesh.triangles[i][0]];
+		const Eigen::Vector3f& b = mesh.vertices[mesh.triangles[i][1]];
+		const Eigen::Vector3f& c = mesh.vertices[mesh.triangles[i][2]];
+		if((b-a).cross(c-a).dot(a - C.cast<float>()) < 0) inward++;
+	}
+	cout<<"TsdfVolume: max distance to the sphere "<<maxErr<<" m, "<<inward<<" triangles facing inwards"<<endl;
+	mesh.savePLY("sphere.ply");
+	return maxErr < 0.01 && inward == 0 ? 0 : -1;
+}
+
+//! every 3rd frame is written and the last 4 stay in the ring, pushing must not wait for the disk
+int testDebugSink()
+{
+	MyTimer timer;
+	double push_ms = 0;
+	DebugSink sink("debug", 3, 4);
+	for(long unsigned int k=0; k<20; k++)
+	{
+		cv::Mat img(480, 640, CV_8UC3, cv::Scalar(k, 2*k, 3*k));
+		timer.start();
+		sink.push("test", k, img);
+		timer.end();
+		push_ms += timer.time_ms;
+	}
+	sink.finish();
+	vector<DebugSink::DebugImage> ring;
+	sink.recent(ring);
+	cout<<"DebugSink: "<<push_ms/20<<" ms per push, "<<ring.size()<<" in the ring, "<<sink.droppedNum()<<" dropped"<<endl;
+
+	bool ok = ring.size() == 4 && sink.droppedNum() == 0;
+	for(size_t i=0; ok && i<ring.size(); i++)
+		ok = ring[i].frame == 9+3*i;
+	ok = ok && !cv::imread("debug/test_000018.png").empty() && cv::imread("debug/test_000019.png").empty();
+
+	// no window and no dir: nothing is wanted
+	DebugSink none("", 1);
+	ok = ok && !none.wants(0);
+	return ok ? 0 : -1;
+}
+
+//! scopes on two threads, the trace has one event per scope and a scope costs well under a microsecond
+int testProfiler()
+{
+	Profiler::start();
+	{
+		PROF_SCOPE(PROF_MATCH);	// the first one allocates the ring of the thread
+	}
+	int64_t t0 = Profiler::now();
+	for(int k=0; k<1000; k++)
+	{
+		PROF_SCOPE(PROF_MATCH);
+	}
+	double scope_ns = (Profiler::now() - t0)/1000.0;
+	std::thread worker([](){
+		for(int k=0; k<10; k++)
+		{
+			PROF_SCOPE(PROF_MAP_INTEGRATE);
+			usleep(1000);
+		}
+	});
+	worker.join();
+	Profiler::printSummary();
+	Profiler::saveTrace("trace.json");
+
+	ifstream f("trace.json");
+	string line;
+	int events = 0;
+	while(getline(f, line))
+		if(line.find("\"ph\":\"X\"") != string::npos) events++;
+	cout<<"Profiler: "<<scope_ns<<" ns per scope, "<<events<<" events in the trace"<<endl;
+	return events == 1011 && scope_ns < 1000 ? 0 : -1;
+}
+
+//! an estimate that is the ground truth seen from another frame has no ATE/RPE once aligned,
+//! one displaced pose shows up in both
+int testTrajectoryEval()
+{
+	Trajectory gt, est;
+	Eigen::Isometry3d offset = Eigen::Isometry3d::Identity();
+	offset.rotate(Eigen::AngleAxisd(0.7, Eigen::Vector3d(1, 2, 3).normalized()));
+	offset.pretranslate(Eigen::Vector3d(5, -2, 1));
+	for(int i=0; i<300; i++)
+	{
+		StampedPose p;
+		p.t = 1000 + i*0.033;
+		p.Twc = Eigen::Isometry3d::Identity();
+		p.Twc.rotate(Eigen::AngleAxisd(i*0.01, Eigen::Vector3d::UnitY()));
+		p.Twc.pretranslate(Eigen::Vector3d(cos(i*0.02), 0.1*sin(i*0.05), sin(i*0.02)));
+		gt.push_back(p);
+		if(i%10) continue;
+		p.t += 0.005;
+		p.Twc = offset*p.Twc;
+		est.push_back(p);
+	}
+	Trajectory estA, gtA;
+	associate(est, gt, 0.02, estA, gtA);
+	ErrorStats ate = computeATE(estA, gtA), rpe_t, rpe_r;
+	computeRPE(estA, gtA, 1.0, rpe_t, rpe_r);
+	cout<<"Trajectory: "<<estA.size()<<" poses associated, ATE "<<ate.rmse<<" m, RPE "<<rpe_t.rmse<<" m "<<rpe_r.rmse<<" deg"<<endl;
+	bool ok = estA.size() == est.size() && ate.rmse < 1e-6 && rpe_t.rmse < 1e-6 && rpe_r.rmse < 1e-4;
+
+	estA[15].Twc.translation() += Eigen::Vector3d(0.1, 0, 0);
+	ErrorStats ate2 = computeATE(estA, gtA);
+	computeRPE(estA, gtA, 1.0, rpe_t, rpe_r);
+	cout<<"Trajectory: one pose moved by 0.1 m, ATE max "<<ate2.max<<" m, RPE max "<<rpe_t.max<<" m"<<endl;
+	return ok && ate2.max > 0.05 && rpe_t.max > 0.05 ? 0 : -1;
+}
+
+//! a problem solved by the pooled g2o graph of a thread that has solved a larger one before gives the
+//! pose of a fresh thread, whose graph is built from scratch as before the pooling
+int testHybridG2OPool()
+{
+	if(Frame::K.empty())
+		Frame::K = (cv::Mat_<double>(3,3) << 525, 0, 319.5, 0, 525, 239.5, 0, 0, 1);
+	const double fx = Frame::K.at<double>(0,0), cx = Frame::K.at<double>(0,2), cy = Frame::K.at<double>(1,2);
+	srand(0);
+	Eigen::Isometry3d T = Eigen::Isometry3d::Identity();	//newer to older
+	T.rotate(Eigen::AngleAxisd(0.05, Eigen::Vector3d(1, 2, 3).normalized()));
+	T.pretranslate(Eigen::Vector3d(0.03, -0.02, 0.04));
+
+	Frame f1, f2;
+	vector<DMatch> pt_all, pt_few, ln_all, ln_few;
+	for(int i=0; i<1500; i++)
+	{
+		Eigen::Vector3d r = Eigen::Vector3d::Random();
+		Eigen::Vector3d p2(0.8*r.x(), 0.6*r.y(), 2.5 + r.z());
+		Eigen::Vector3d p1 = T*p2 + 0.002*Eigen::Vector3d::Random();
+		f1.feature_locations_2d_.push_back(cv::KeyPoint(fx*p1.x()/p1.z()+cx, fx*p1.y()/p1.z()+cy, 7));
+		f2.feature_locations_2d_.push_back(cv::KeyPoint(fx*p2.x()/p2.z()+cx, fx*p2.y()/p2.z()+cy, 7));
+		f1.feature_locations_3d_.push_back(Eigen::Vector4f(p1.x(), p1.y(), p1.z(), 1));
+		f2.feature_locations_3d_.push_back(Eigen::Vector4f(p2.x(), p2.y(), p2.z(), 1));
+		pt_all.push_back(DMatch(i, i, 0));
+		if(i < 100) pt_few.push_back(DMatch(i, i, 0));
+	}
+	for(int i=0; i<20; i++)
+	{
+		Eigen::Vector3d A2 = Eigen::Vector3d::Random() + Eigen::Vector3d(0, 0, 3), B2 = A2 + 0.5*Eigen::Vector3d::Random();
+		Eigen::Vector3d A1 = T*A2, B1 = T*B2;
+		cv::Mat cov = cv::Mat::eye(3, 3, CV_64F)*1e-4;
+		FrameLine l1, l2;
+		l1.line3d = RandomLine3d(cv::Point3d(A1.x(), A1.y(), A1.z()), cv::Point3d(B1.x(), B1.y(), B1.z()), cov, cov);
+		l2.line3d = RandomLine3d(cv::Point3d(A2.x(), A2.y(), A2.z()), cv::Point3d(B2.x(), B2.y(), B2.z()), cov, cov);
+		l1.line3d.rndA.cov = l1.line3d.rndB.cov = l2.line3d.rndA.cov = l2.line3d.rndB.cov = cov;
+		f1.lines.push_back(l1);
+		f2.lines.push_back(l2);
+		ln_all.push_back(DMatch(i, i, 0));
+		if(i < 10) ln_few.push_back(DMatch(i, i, 0));
+	}
+
+	SystemParameters para;
+	Eigen::Isometry3d fresh, pooled;
+	std::thread([&](){
+		Eigen::Matrix4f tf = Eigen::Matrix4f::Identity();
+		fresh = getTransformFromHybridMatchesG2O(&f1, &f2, pt_few, ln_few, tf, 10, para);
+	}).join();
+	std::thread([&](){
+		Eigen::Matrix4f tf = Eigen::Matrix4f::Identity();
+		getTransformFromHybridMatchesG2O(&f1, &f2, pt_all, ln_all, tf, 10, para);
+		tf = Eigen::Matrix4f::Identity();
+		pooled = getTransformFromHybridMatchesG2O(&f1, &f2, pt_few, ln_few, tf, 10, para);
+	}).join();
+	const double diff = (fresh.matrix() - pooled.matrix()).cwiseAbs().maxCoeff();
+	const double err = (pooled.matrix() - T.matrix()).cwiseAbs().maxCoeff();
+	cout<<"HybridG2OPool: pooled and fresh graph differ by "<<diff<<", error to the true motion "<<err<<endl;
+	return diff < 1e-9 && err < 1e-2 ? 0 : -1;
+}
+
+//! depth image (raw, meter*scale) of the corner of a room, the camera at Twc in the room's CS
+//! back wall z=3, floor y=1, side wall x=-1.5
+static cv::Mat renderRoomDepth(const Camera& cam, const Eigen::Isometry3d& Twc, int rows, int cols)
+{
+	const Eigen::Vector3d n[3] = {Eigen::Vector3d(0,0,1), Eigen::Vector3d(0,1,0), Eigen::Vector3d(1,0,0)};
+	const double c[3] = {3, 1, -1.5};
+	cv::Mat depth(rows, cols, CV_32F);
+	for(int r=0; r<rows; r++)
+		for(int u=0; u<cols; u++)
+		{
+			const Eigen::Vector3d d = Eigen::Vector3d((u-cam.cx)/cam.fx, (r-cam.cy)/cam.fy, 1);
+			const Eigen::Vector3d dw = Twc.linear()*d;
+			double s = std::numeric_limits<double>::max();
+			for(int k=0; k<3; k++)
+			{
+				const double sk = (c[k]-n[k].dot(Twc.translation()))/n[k].dot(dw);
+				if(sk > 0) s = std::min(s, sk);
+			}
+			depth.at<float>(r,u) = s*cam.scale;	// z in the camera is s, d has z=1
+		}
+	return depth;
+}
+
+//! ProjectiveIcp recovers a known motion between two renderings of the same scene
+int testIcpKnownMotion()
+{
+	Camera cam;
+	cam.fx = cam.fy = 525;
+	cam.cx = 319.5;
+	cam.cy = 239.5;
+	cam.scale = 5000;
+	Eigen::Isometry3d T = Eigen::Isometry3d::Identity();	// source CS to target CS
+	T.linear() = Eigen::AngleAxisd(0.04, Eigen::Vector3d(0.3,1,0.2).normalized()).toRotationMatrix();
+	T.translation() = Eigen::Vector3d(0.03, -0.02, 0.05);
+	cv::Mat source = renderRoomDepth(cam, Eigen::Isometry3d::Identity(), 480, 640);
+	cv::Mat target = renderRoomDepth(cam, T.inverse(), 480, 640);
+
+	ProjectiveIcp icp(cam);
+	IcpReport report;
+	Eigen::Isometry3d Test = icp.align(source, target, Eigen::Isometry3d::Identity(), &report);
+	const Eigen::Isometry3d E = Test.inverse()*T;
+	const double rot = Eigen::AngleAxisd(E.linear()).angle(), trans = E.translation().norm();
+	cout<<"IcpKnownMotion: valid "<<report.valid<<", "<<report.iterations<<" iterations, rotation error "
+		<<rot<<" rad, translation error "<<trans<<" m"<<endl;
+	return report.valid && rot < 1e-3 && trans < 1e-3 ? 0 : -1;
+}
+
+//! a corner of a room seen from inside (mm), each pixel on the closest of a back wall, a floor and a side wall
+static cv::Mat_<cv::Vec3f> syntheticRoom(int rows, int cols)
+{
+	cv::Mat_<cv::Vec3f> cloud(rows, cols);
+	const float f = 300, cx = (cols-1)/2.f, cy = (rows-1)/2.f;
+	for(int r=0; r<rows; r++)
+		for(int c=0; c<cols; c++)
+		{
+			const cv::Vec3f d((c-cx)/f, (r-cy)/f, 1);
+			float s = 3000;												// back wall z=3000
+			if(d[1] > 0) s = std::min(s, 1000/d[1]);					// floor y=1000
+			if(d[0] < 0) s = std::min(s, -1200/d[0]);					// side wall x=-1200
+			s += ((r*7 + c*13)%11 - 5)*0.3f;
+			cloud(r,c) = d*s;
+		}
+	return cloud;
+}
+
+//! the threaded plane fitter segments exactly like a serial one, over several frames on the same pool
+int testPlaneFitterThreads()
+{
+	cv::Mat_<cv::Vec3f> cloud = syntheticRoom(240, 320);
+	OrganizedImage3D Ixyz(cloud);
+	PlaneFitter serial, threaded;
+	serial.numThreads = 1;
+	threaded.numThreads = 4;
+	double R[3][3] = {{1,0,0},{0,1,0},{0,0,1}}, t[3] = {0,0,0};
+	bool same = true;
+	size_t nPlanes = 0;
+	for(int frame=0; frame<3; frame++)
+	{
+		vector<vector<int>> m1, m2;
+		serial.runTemporal(&Ixyz, R, t, &m1, 0, 0, false);
+		threaded.runTemporal(&Ixyz, R, t, &m2, 0, 0, false);
+		same = same && m1 == m2
+			&& cv::countNonZero(serial.membershipImg != threaded.membershipImg) == 0;
+		nPlanes = m2.size();
+	}
+	cout<<"PlaneFitterThreads: "<<nPlanes<<" planes, "<<(same ? "same" : "different")<<" segmentation"<<endl;
+	return same && nPlanes == 3 ? 0 : -1;
+}
+
+//! the closed-form solvers recover a known motion from planes, lines and points moved by it
+int testClosedFormMotion()
+{
+	Eigen::Isometry3d T = Eigen::Isometry3d::Identity();	// x_b = T*x_a
+	T.linear() = Eigen::AngleAxisd(0.3, Eigen::Vector3d(0.2,1,-0.4).normalized()).toRotationMatrix();
+	T.translation() = Eigen::Vector3d(0.2, -0.1, 0.3);
+
+	PlaneEqVector pl_a, pl_b;		// n.x+d=0
+	const Eigen::Vector4d planes[3] = {Eigen::Vector4d(0,0,-1,3), Eigen::Vector4d(0,-1,0,1), Eigen::Vector4d(1,0,0,1.5)};
+	for(int i=0; i<3; i++)
+	{
+		Eigen::Vector3d n = T.linear()*planes[i].head<3>();
+		pl_a.push_back(planes[i]);
+		pl_b.push_back(Eigen::Vector4d(n(0), n(1), n(2), planes[i](3)-n.dot(T.translation())));
+	}
+	LineEndptsVector ln_a, ln_b;
+	vector<RandomLine3d> rl_a, rl_b;
+	const double lines[3][6] = {{-1,0.5,2, 1,0.4,2.5}, {0.3,-1,2.2, 0.5,0.8,1.8}, {-0.5,-0.5,1.5, -0.2,0.3,3}};
+	for(int i=0; i<3; i++)
+	{
+		Vector6d a;
+		a << lines[i][0], lines[i][1], lines[i][2], lines[i][3], lines[i][4], lines[i][5];
+		Vector6d b;
+		b << T*Eigen::Vector3d(a.head<3>()), T*Eigen::Vector3d(a.tail<3>());
+		ln_a.push_back(a);
+		ln_b.push_back(b);
+		rl_a.push_back(RandomLine3d(cv::Point3d(a(0),a(1),a(2)), cv::Point3d(a(3),a(4),a(5)), cv::Mat(), cv::Mat()));
+		rl_b.push_back(RandomLine3d(cv::Point3d(b(0),b(1),b(2)), cv::Point3d(b(3),b(4),b(5)), cv::Mat(), cv::Mat()));
+	}
+	vector<Eigen::Vector3d> pt_a, pt_b;
+	const double points[4][3] = {{0.1,0.2,2}, {-0.7,0.3,2.6}, {0.6,-0.4,1.7}, {0.2,0.6,2.9}};
+	for(int i=0; i<4; i++)
+	{
+		pt_a.push_back(Eigen::Vector3d(points[i][0], points[i][1], points[i][2]));
+		pt_b.push_back(T*pt_a.back());
+	}
+
+	const PlaneEqVector no_pl;
+	const LineEndptsVector no_ln;
+	const vector<Eigen::Vector3d> no_pt;
+	struct Case
+	{
+		const char* name;
+		PlaneEqVector pa, pb;
+		LineEndptsVector la, lb;
+		vector<Eigen::Vector3d> qa, qb;
+		bool solvable;
+	};
+	const Case cases[] = {
+		{"3 planes", pl_a, pl_b, no_ln, no_ln, no_pt, no_pt, true},
+		{"3 points", no_pl, no_pl, no_ln, no_ln, vector<Eigen::Vector3d>(pt_a.begin(), pt_a.begin()+3), vector<Eigen::Vector3d>(pt_b.begin(), pt_b.begin()+3), true},
+		{"2 lines", no_pl, no_pl, LineEndptsVector(ln_a.begin(), ln_a.begin()+2), LineEndptsVector(ln_b.begin(), ln_b.begin()+2), no_pt, no_pt, true},
+		{"1 point 1 line", no_pl, no_pl, LineEndptsVector(1, ln_a[0]), LineEndptsVector(1, ln_b[0]), vector<Eigen::Vector3d>(1, pt_a[0]), vector<Eigen::Vector3d>(1, pt_b[0]), true},
+		{"all", pl_a, pl_b, ln_a, ln_b, pt_a, pt_b, true},
+		{"1 line", no_pl, no_pl, LineEndptsVector(1, ln_a[0]), LineEndptsVector(1, ln_b[0]), no_pt, no_pt, false},
+	};
+	bool ok = true;
+	for(size_t k=0; k<sizeof(cases)/sizeof(cases[0]); k++)
+	{
+		const Case& c = cases[k];
+		Eigen::Isometry3d Test = Eigen::Isometry3d::Identity();
+		const bool solved = computeRelativeMotion_PlLnPt(c.pa, c.pb, c.la, c.lb, c.qa, c.qb, Test);
+		const double err = (Test.matrix()-T.matrix()).cwiseAbs().maxCoeff();
+		cout<<"ClosedFormMotion: "<<c.name<<" solved "<<solved<<", error "<<err<<endl;
+		ok = ok && solved == c.solvable && (!solved || err < 1e-9);
+	}
+
+	cv::Mat R, t;
+	Eigen::Matrix3d Re;
+	Eigen::Vector3d te;
+	const bool solved = computeRelativeMotion_svd(rl_a, rl_b, R, t);
+	cv::cv2eigen(R, Re);
+	cv::cv2eigen(t, te);
+	const double err = std::max((Re-T.linear()).cwiseAbs().maxCoeff(), (te-T.translation()).cwiseAbs().maxCoeff());
+	cout<<"ClosedFormMotion: lines svd solved "<<solved<<", error "<<err<<endl;
+	return ok && solved && err < 1e-9 ? 0 : -1;
+}
+
+//! --headless and --frames n are taken out of argv wherever they are, the rest keeps its order
+int testRunFlags()
+{
+	char a0[] = "lineslam", a1[] = "--frames", a2[] = "50", a3[] = "data", a4[] = "--headless", a5[] = "settings.yaml";
+	char* argv[] = {a0, a1, a2, a3, a4, a5, 0};
+	int argc = 6;
+	bool headless = false;
+	int maxFrames = -1;
+	parseRunFlags(argc, argv, headless, maxFrames);
+	bool ok = argc == 3 && headless && maxFrames == 50
+		&& string(argv[1]) == "data" && string(argv[2]) == "settings.yaml";
+
+	char b0[] = "naive_slam", b1[] = "data", b2[] = "settings.yaml", b3[] = "--frames";
+	char* argv2[] = {b0, b1, b2, b3, 0};
+	int argc2 = 4;
+	bool headless2 = false;
+	int maxFrames2 = -1;
+	parseRunFlags(argc2, argv2, headless2, maxFrames2);	// --frames without its count is left alone
+	ok = ok && argc2 == 4 && !headless2 && maxFrames2 == -1;
+	cout<<"RunFlags: "<<(ok ? "parsed" : "wrong")<<endl;
+	return ok ? 0 : -1;
+}
+
+//! the unit tests, 0 on success
+struct UnitTest
+{
+	const char* 	name;
+	int 			(*run)();
+};
+static const UnitTest unitTests[] = {
+	{"LineEdgeJacobian", 	testLineEdgeJacobian},
+	{"HybridG2OPool", 		testHybridG2OPool},
+	{"PointErrorBatch", 	testPointErrorBatch},
+	{"FlatVocabulary", 		testFlatVocabulary},
+	{"MapIO", 				testMapIO},
+	{"VoxelMap", 			testVoxelMap},
+	{"TsdfVolume", 			testTsdfVolume},
+	{"DebugSink", 			testDebugSink},
+	{"Profiler", 			testProfiler},
+	{"TrajectoryEval", 		testTrajectoryEval},
+	{"PlaneFitterThreads", 	testPlaneFitterThreads},
+	{"IcpKnownMotion", 		testIcpKnownMotion},
+	{"ClosedFormMotion", 	testClosedFormMotion},
+	{"RunFlags", 			testRunFlags},
+};
+
+//! usage: test <name> | test --all | test <index of the cloud to draw>
+//! the exit status is nonzero if a test failed, the tests are registered with ctest
+int main(int argc, char** argv)
+{
+	//reconstruction_pangolin("/home/jpl/TUM_Datasets/4Structure_vs_Texture/f3_structure_notexture_far/");
+	//reconstruction("/home/jpl/TUM_Datasets/6Reconstruction/f3_large_cabinet/");
+	//testline();
+	//test2(argv[1],argv[2],atoi(argv[3]));
+	//test();
+	//testDBoW();
+	if(argc < 2)
+	{
+		cout<<"Usage: test <name> | --all | <cloud index>, tests:";
+		for(size_t i=0; i<sizeof(unitTests)/sizeof(unitTests[0]); i++)
+			cout<<" "<<unitTests[i].name;
+		cout<<endl;
+		return 2;
+	}
+	const string name = argv[1];
+	int run = 0, failed = 0;
+	for(size_t i=0; i<sizeof(unitTests)/sizeof(unitTests[0]); i++)
+	{
+		if(name != "--all" && name != unitTests[i].name) continue;
+		run++;
+		const bool ok = unitTests[i].run() == 0;
+		cout<<unitTests[i].name<<(ok ? ": passed" : ": FAILED")<<endl;
+		if(!ok) failed++;
+	}
+	if(run) return failed ? 1 : 0;
+	if(name.find_first_not_of("0123456789") != string::npos)
+	{
+		cout<<"Unknown test "<<name<<endl;
+		return 2;
+	}
+
+	int idx=atoi(argv[1]);
+	drawPointCloud(idx);
+	
+	return 0;
+}
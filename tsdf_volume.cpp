@@ -0,0 +1,306 @@
+#include "tsdf_volume.h"
+#include <thread>
+#include <cstdio>
+
+//! 21 bits per axis, +-2^20 blocks around the origin
+static inline uint64_t blockKey(int x, int y, int z)
+{
+	const uint64_t m = (1<<21) - 1, o = 1<<20;
+	return ((x+o) & m) | (((y+o) & m) << 21) | (((z+o) & m) << 42);
+}
+
+//! the vertex on the edge from voxel (x,y,z) along axis
+static inline uint64_t edgeKey(int x, int y, int z, int axis)
+{
+	const uint64_t m = (1<<20) - 1, o = 1<<19;
+	return ((x+o) & m) | (((y+o) & m) << 20) | (((z+o) & m) << 40) | (uint64_t(axis) << 60);
+}
+
+//! marching cubes cases, corner i of a cube is at (i&1, i>>1&1, i>>2&1), a corner is inside if tsdf < 0
+//! the polygons are traced from the cube faces: on each face a segment joins the edge where the surface
+//! enters the face to the edge where it leaves it, and the segments of the 6 faces chain into loops.
+//! inside corners of an ambiguous face are always separated, the same on both cubes sharing the face,
+//! so that the mesh is watertight
+struct MarchingCubes
+{
+	int 			edge[12][2];	// corners of each edge
+	vector<int> 	tris[256];		// 3 edges per triangle
+
+	MarchingCubes()
+	{
+		int edgeOf[8][8];
+		int n = 0;
+		for(int a=0; a<8; a++)
+			for(int k=0; k<3; k++)
+				if(!(a & (1<<k))) {
+					edge[n][0] = a;
+					edge[n][1] = a | (1<<k);
+					edgeOf[a][a|(1<<k)] = edgeOf[a|(1<<k)][a] = n;
+					n++;
+				}
+
+		// corners of each face, counter clockwise seen from outside the cube
+		int face[6][4];
+		for(int k=0; k<3; k++)
+			for(int s=0; s<2; s++) {
+				int u = 1<<((k+1)%3), v = 1<<((k+2)%3), c = s<<k;
+				int cyc[4] = {c, c|u, c|u|v, c|v};
+				for(int i=0; i<4; i++)
+					face[2*k+s][i] = s ? cyc[i] : cyc[3-i];
+			}
+
+		for(int cfg=1; cfg<255; cfg++)
+		{
+			int succ[12];
+			for(int e=0; e<12; e++) succ[e] = -1;
+			for(int f=0; f<6; f++)
+			{
+				int cross[4], enter[4], nc = 0;
+				for(int i=0; i<4; i++) {
+					int a = face[f][i], b = face[f][(i+1)%4];
+					bool ia = cfg>>a & 1, ib = cfg>>b & 1;
+					if(ia == ib) continue;
+					cross[nc] = edgeOf[a][b];
+					enter[nc] = ib;
+					nc++;
+				}
+				for(int i=0; i<nc; i++)
+					if(enter[i]) succ[cross[i]] = cross[(i+1)%nc];
+			}
+			bool done[12] = {false};
+			for(int e=0; e<12; e++)
+			{
+				if(succ[e] < 0 || done[e]) continue;
+				vector<int> loop;
+				for(int c=e; !done[c]; c=succ[c]) {
+					done[c] = true;
+					loop.push_back(c);
+				}
+				for(size_t i=1; i+1<loop.size(); i++) {
+					tris[cfg].push_back(loop[0]);
+					tris[cfg].push_back(loop[i]);
+					tris[cfg].push_back(loop[i+1]);
+				}
+			}
+		}
+	}
+};
+
+TsdfVolume::TsdfVolume(float _voxelSize, float _truncation, float _maxDepth)
+	: voxelSize(_voxelSize), truncation(_truncation), maxDepth(_maxDepth), maxWeight(100)
+{
+	threads = std::max(1u, std::thread::hardware_concurrency());
+}
+
+void TsdfVolume::integrate(const cv::Mat& depth, const cv::Mat& rgb, const Camera& camera, const Eigen::Isometry3d& Twc)
+{
+	if(depth.empty()) return;
+	PROF_SCOPE(PROF_MAP_INTEGRATE);
+	const Eigen::Matrix3f Rwc = Twc.rotation().cast<float>();
+	const Eigen::Vector3f twc = Twc.translation().cast<float>();
+	const Eigen::Matrix3f Rcw = Rwc.transpose();
+	const Eigen::Vector3f tcw = -Rcw*twc;
+	const float invScale = 1.f/camera.scale;
+	const float blockSize = BLOCK*voxelSize, invBlock = 1.f/blockSize;
+
+	// blocks within the truncation band of the depth pixels, sampled along each ray at half a block
+	// a pixel in two is enough while a block covers a few pixels
+	const int steps = (int)std::ceil(2*truncation/(0.5f*blockSize)) + 1;
+	vector<int> visible;
+	vector<bool> seen(blocks.size(), false);
+	for(int v=0; v<depth.rows; v+=2)
+	{
+		const float* dr = depth.ptr<float>(v);
+		for(int u=0; u<depth.cols; u+=2)
+		{
+			float d = dr[u]*invScale;
+			if(!(d > 0.01f) || d > maxDepth) continue;
+			Eigen::Vector3f ray((u-camera.cx)/camera.fx, (v-camera.cy)/camera.fy, 1);
+			for(int s=0; s<steps; s++)
+			{
+				float z = d - truncation + 2*truncation*s/(steps-1);
+				if(z <= 0) continue;
+				Eigen::Vector3f p = Rwc*(ray*z) + twc;
+				int bx = (int)std::floor(p[0]*invBlock), by = (int)std::floor(p[1]*invBlock), bz = (int)std::floor(p[2]*invBlock);
+				std::pair<std::unordered_map<uint64_t,int>::iterator, bool> ins =
+					blockIndex.insert(std::make_pair(blockKey(bx, by, bz), (int)blocks.size()));
+				int i = ins.first->second;
+				if(ins.second) {
+					blocks.push_back(Block());
+					Block& b = blocks.back();
+					b.x = bx; b.y = by; b.z = bz;
+					for(int k=0; k<BLOCK*BLOCK*BLOCK; k++) {
+						b.v[k].tsdf = 1;
+						b.v[k].weight = 0;
+						b.v[k].r = b.v[k].g = b.v[k].b = b.v[k].pad = 0;
+					}
+					seen.push_back(false);
+				}
+				if(!seen[i]) {
+					seen[i] = true;
+					visible.push_back(i);
+				}
+			}
+		}
+	}
+
+	// blocks do not share voxels, each thread takes one block in nt
+	const int nt = std::min(threads, std::max(1, (int)visible.size()/16));
+	vector<std::thread> pool;
+	for(int t=1; t<nt; t++)
+		pool.push_back(std::thread([&, t]() {
+			for(size_t i=t; i<visible.size(); i+=nt)
+				integrateBlock(blocks[visible[i]], depth, rgb, camera, Rcw, tcw);
+		}));
+	for(size_t i=0; i<visible.size(); i+=nt)
+		integrateBlock(blocks[visible[i]], depth, rgb, camera, Rcw, tcw);
+	for(size_t t=0; t<pool.size(); t++)
+		pool[t].join();
+}
+
+void TsdfVolume::integrateBlock(Block& block, const cv::Mat& depth, const cv::Mat& rgb, const Camera& camera,
+				const Eigen::Matrix3f& Rcw, const Eigen::Vector3f& tcw) const
+{
+	const float invScale = 1.f/camera.scale, invTrunc = 1.f/truncation;
+	const float fx = camera.fx, fy = camera.fy, cx = camera.cx, cy = camera.cy;
+	const bool color = !rgb.empty();
+	// voxel centers in the camera CS, stepped along the block axes
+	const Eigen::Vector3f origin = (Eigen::Vector3f(block.x, block.y, block.z)*BLOCK + Eigen::Vector3f::Constant(0.5f))*voxelSize;
+	const Eigen::Vector3f base = Rcw*origin + tcw;
+	const Eigen::Vector3f ax = Rcw.col(0)*voxelSize, ay = Rcw.col(1)*voxelSize, az = Rcw.col(2)*voxelSize;
+
+	float Z[BLOCK];
+	int U[BLOCK], V[BLOCK];
+	for(int z=0; z<BLOCK; z++)
+		for(int y=0; y<BLOCK; y++)
+		{
+			const Eigen::Vector3f row = base + ay*y + az*z;
+			// a row is projected at once without branches, so that the loop is vectorized
+			for(int x=0; x<BLOCK; x++)
+			{
+				float X = row[0] + ax[0]*x, Y = row[1] + ax[1]*x;
+				Z[x] = row[2] + ax[2]*x;
+				float iz = Z[x] > 1e-3f ? 1.f/Z[x] : 0.f;
+				U[x] = (int)std::floor(fx*X*iz + cx + 0.5f);
+				V[x] = (int)std::floor(fy*Y*iz + cy + 0.5f);
+			}
+			Voxel* vox = &block.v[(z*BLOCK + y)*BLOCK];
+			for(int x=0; x<BLOCK; x++)
+			{
+				if(Z[x] <= 1e-3f || U[x] < 0 || V[x] < 0 || U[x] >= depth.cols || V[x] >= depth.rows) continue;
+				float d = depth.ptr<float>(V[x])[U[x]]*invScale;
+				if(!(d > 0.01f) || d > maxDepth) continue;
+				float sdf = d - Z[x];
+				if(sdf < -truncation) continue;  // occluded
+				Voxel& vx = vox[x];
+				float w = vx.weight, iw = 1.f/(w + 1);
+				vx.tsdf = (vx.tsdf*w + std::min(1.f, sdf*invTrunc))*iw;
+				if(color && sdf < truncation) {
+					const uchar* c = rgb.ptr<uchar>(V[x]) + 3*U[x];
+					vx.r = (uchar)((vx.r*w + c[2])*iw + 0.5f);
+					vx.g = (uchar)((vx.g*w + c[1])*iw + 0.5f);
+					vx.b = (uchar)((vx.b*w + c[0])*iw + 0.5f);
+				}
+				vx.weight = std::min(w + 1, maxWeight);
+			}
+		}
+}
+
+void TsdfVolume::extractMesh(TsdfMesh& mesh) const
+{
+	static const MarchingCubes mc;
+	mesh.vertices.clear();
+	mesh.colors.clear();
+	mesh.triangles.clear();
+	std::unordered_map<uint64_t, int> edgeVertex;  // vertices shared by the cubes around an edge
+
+	for(size_t bi=0; bi<blocks.size(); bi++)
+	{
+		const Block& b = blocks[bi];
+		// the block and its neighbours on the positive sides, for the cubes across the boundary
+		const Block* nb[8];
+		for(int i=0; i<8; i++) {
+			std::unordered_map<uint64_t,int>::const_iterator it = blockIndex.find(blockKey(b.x + (i&1), b.y + (i>>1&1), b.z + (i>>2&1)));
+			nb[i] = it == blockIndex.end() ? 0 : &blocks[it->second];
+		}
+		for(int z=0; z<BLOCK; z++)
+		for(int y=0; y<BLOCK; y++)
+		for(int x=0; x<BLOCK; x++)
+		{
+			const Voxel* c[8];
+			int cfg = 0;
+			bool valid = true;
+			for(int i=0; i<8 && valid; i++)
+			{
+				int cx = x + (i&1), cy = y + (i>>1&1), cz = z + (i>>2&1);
+				const Block* cb = nb[(cx>>3) | (cy>>3)<<1 | (cz>>3)<<2];
+				if(!cb) { valid = false; break; }
+				c[i] = &cb->v[((cz&7)*BLOCK + (cy&7))*BLOCK + (cx&7)];
+				valid = c[i]->weight > 0;
+				if(c[i]->tsdf < 0) cfg |= 1<<i;
+			}
+			if(!valid || cfg == 0 || cfg == 255) continue;
+
+			const int gx = b.x*BLOCK + x, gy = b.y*BLOCK + y, gz = b.z*BLOCK + z;
+			const vector<int>& tris = mc.tris[cfg];
+			for(size_t t=0; t<tris.size(); t+=3)
+			{
+				Eigen::Vector3i tri;
+				for(int k=0; k<3; k++)
+				{
+					int a = mc.edge[tris[t+k]][0], e = mc.edge[tris[t+k]][1];
+					int axis = (a^e)==1 ? 0 : (a^e)==2 ? 1 : 2;
+					uint64_t key = edgeKey(gx + (a&1), gy + (a>>1&1), gz + (a>>2&1), axis);
+					std::pair<std::unordered_map<uint64_t,int>::iterator, bool> ins =
+						edgeVertex.insert(std::make_pair(key, (int)mesh.vertices.size()));
+					if(ins.second)
+					{
+						const Voxel& va = *c[a];
+						const Voxel& ve = *c[e];
+						float s = va.tsdf/(va.tsdf - ve.tsdf);
+						Eigen::Vector3f p(gx + (a&1) + 0.5f, gy + (a>>1&1) + 0.5f, gz + (a>>2&1) + 0.5f);
+						p[axis] += s;
+						mesh.vertices.push_back(p*voxelSize);
+						mesh.colors.push_back(cv::Vec3b(va.r + s*(ve.r - va.r), va.g + s*(ve.g - va.g), va.b + s*(ve.b - va.b)));
+					}
+					tri[k] = ins.first->second;
+				}
+				mesh.triangles.push_back(tri);
+			}
+		}
+	}
+}
+
+void TsdfVolume::clear()
+{
+	blocks.clear();
+	blockIndex.clear();
+}
+
+bool TsdfMesh::savePLY(const string& filename) const
+{
+	FILE* f = fopen(filename.c_str(), "wb");
+	if(!f) {
+		cout<<"TsdfMesh: cannot open "<<filename<<endl;
+		return false;
+	}
+	fprintf(f, "ply\nformat binary_little_endian 1.0\n"
+		"element vertex %d\nproperty float x\nproperty float y\nproperty float z\n"
+		"property uchar red\nproperty uchar green\nproperty uchar blue\n"
+		"element face %d\nproperty list uchar int vertex_indices\nend_header\n",
+		(int)vertices.size(), (int)triangles.size());
+	for(size_t i=0; i<vertices.size(); i++)
+	{
+		fwrite(vertices[i].data(), sizeof(float), 3, f);
+		fwrite(&colors[i][0], 1, 3, f);
+	}
+	const uchar three = 3;
+	for(size_t i=0; i<triangles.size(); i++)
+	{
+		fwrite(&three, 1, 1, f);
+		fwrite(triangles[i].data(), sizeof(int), 3, f);
+	}
+	bool ok = !ferror(f);
+	fclose(f);
+	return ok;
+}
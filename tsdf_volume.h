@@ -0,0 +1,63 @@
+#ifndef TSDF_VOLUME_H
+#define TSDF_VOLUME_H
+
+#include "frame.h"
+#include <deque>
+#include <unordered_map>
+#include <stdint.h>
+
+//! triangle mesh extracted from a TsdfVolume, vertices are shared by the triangles around them
+class TsdfMesh
+{
+public:
+	vector<Eigen::Vector3f> 	vertices;	// world CS
+	vector<cv::Vec3b> 			colors;		// rgb
+	vector<Eigen::Vector3i> 	triangles;	// counter clockwise seen from the free space
+
+	//! binary little endian PLY
+	bool savePLY(const string& filename) const;
+};
+
+//! truncated signed distance field fused from keyframe depth images
+//! voxels are allocated by blocks of 8x8x8 around the observed surface only, found through a hash
+//! table, so memory grows with the surface and not with the bounding box of the scene
+class TsdfVolume
+{
+public:
+	static const int BLOCK = 8;
+
+	//! sizes in meters, depth beyond maxDepth is not integrated
+	TsdfVolume(float voxelSize = 0.01f, float truncation = 0.04f, float maxDepth = 4.0f);
+	//! depth in camera.scale units (CV_32F) and bgr rgb, as Frame::depth and Frame::rgb; Twc camera pose
+	//! the blocks in view are integrated on several threads
+	void integrate(const cv::Mat& depth, const cv::Mat& rgb, const Camera& camera, const Eigen::Isometry3d& Twc);
+	void integrate(const Frame& frame, const Eigen::Isometry3d& Twc) { integrate(frame.depth, frame.rgb, Frame::camera, Twc); }
+	//! marching cubes over the zero crossings of the observed voxels
+	void extractMesh(TsdfMesh& mesh) const;
+	size_t blockNum() const { return blocks.size(); }
+	void setThreads(int n) { threads = n > 0 ? n : 1; }
+	void clear();
+
+private:
+	struct Voxel
+	{
+		float 		tsdf;	// in [-1,1], in units of truncation
+		float 		weight;	// 0 if never observed
+		uchar 		r, g, b, pad;
+	};
+	struct Block
+	{
+		int 		x, y, z;	// block coordinates
+		Voxel 		v[BLOCK*BLOCK*BLOCK];	// x fastest
+	};
+
+	void integrateBlock(Block& block, const cv::Mat& depth, const cv::Mat& rgb, const Camera& camera,
+			    const Eigen::Matrix3f& Rcw, const Eigen::Vector3f& tcw) const;
+
+	float 		voxelSize, truncation, maxDepth, maxWeight;
+	int 		threads;
+	std::deque<Block> 	blocks;
+	std::unordered_map<uint64_t, int> blockIndex;	// block key -> index in blocks
+};
+
+#endif
@@ -0,0 +1,43 @@
+#include "vertex_plane.h"
+
+namespace g2o {
+
+	bool VertexPlane::read(std::istream& is) {
+		Eigen::Vector4d pl;
+		for (int i=0; i<estimateDimension(); i++){
+			is >> pl[i];
+		}
+		setEstimate(pl);
+		normalize();
+		return true;
+	}
+
+	bool VertexPlane::write(std::ostream& os) const {
+		Eigen::Vector4d pl=estimate();
+		for (int i=0; i<estimateDimension(); i++){
+			os << pl[i] << " ";
+		}
+		return os.good();
+	}
+
+	VertexPlaneWriteGnuplotAction:: VertexPlaneWriteGnuplotAction():
+		WriteGnuplotAction(typeid( VertexPlane).name()){}
+
+	HyperGraphElementAction* VertexPlaneWriteGnuplotAction::operator()(HyperGraph::HyperGraphElement* element, HyperGraphElementAction::Parameters* params_ )
+	{
+		if (typeid(*element).name()!=_typeName)
+		return 0;
+		WriteGnuplotAction::Parameters* params=static_cast<WriteGnuplotAction::Parameters*>(params_);
+		if (!params->os){
+			std::cerr << __PRETTY_FUNCTION__ << ": warning, no valid os specified" << std::endl;
+			return 0;
+		}
+
+		// closest point of the plane to the origin
+		VertexPlane* v = static_cast<VertexPlane*>(element);
+		Eigen::Vector3d cp = -v->distance() * v->normal();
+		*(params->os) << cp.x() << " " << cp.y() << " " << cp.z() << " " << std::endl;
+		return this;
+	}
+
+}
@@ -0,0 +1,101 @@
+#ifndef G2O_VERTEX_PLANE_H_
+#define G2O_VERTEX_PLANE_H_
+
+#include "g2o/types/slam3d/g2o_types_slam3d_api.h"
+#include "g2o/core/base_vertex.h"
+#include "g2o/core/hyper_graph_action.h"
+#include "g2o/stuff/opengl_wrapper.h"
+#include <Eigen/Geometry>
+#include <cstdio>
+#include <typeinfo>
+
+namespace g2o {
+  /**
+   * \brief Vertex for an infinite plane n.x+d=0 in space
+   * the estimate is (nx, ny, nz, d) with a unit normal, the update is minimal:
+   * two angles rotating the normal in its tangent plane and the change of d
+   */
+	class VertexPlane : public BaseVertex<3, Eigen::Vector4d>
+	{
+	public:
+		EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+		VertexPlane() {}
+		virtual bool read(std::istream& is);
+		virtual bool write(std::ostream& os) const;
+
+		virtual void setToOriginImpl() { _estimate << 0, 0, 1, 0; }
+
+		virtual void oplusImpl(const double* update_) {
+			Eigen::Map<const Eigen::Vector3d> update(update_);
+			Eigen::Vector3d n = _estimate.head<3>();
+			Eigen::Vector3d w = tangentBasis(n) * update.head<2>();
+			double angle = w.norm();
+			if(angle > 1e-12)
+				n = Eigen::AngleAxisd(angle, w/angle) * n;
+			_estimate.head<3>() = n.normalized();
+			_estimate(3) += update(2);
+		}
+
+		virtual bool setEstimateDataImpl(const double* est){
+			Eigen::Map<const Eigen::Vector4d> _est(est);
+			_estimate = _est;
+			normalize();
+			return true;
+		}
+
+		virtual bool getEstimateData(double* est) const{
+			Eigen::Map<Eigen::Vector4d> _est(est);
+			_est = _estimate;
+			return true;
+		}
+
+		virtual int estimateDimension() const {
+			return 4;
+		}
+
+		Eigen::Vector3d normal() const { return _estimate.head<3>(); }
+		double distance() const { return _estimate(3); }
+
+		//! rescale (n,d) so that n is a unit vector
+		void normalize() {
+			double len = _estimate.head<3>().norm();
+			if(len > 0) _estimate /= len;
+		}
+
+		//! orthonormal basis of the plane orthogonal to n, columns b1, b2 with n x b1 = b2
+		static Eigen::Matrix<double,3,2> tangentBasis(const Eigen::Vector3d& n) {
+			int k = 0;
+			n.cwiseAbs().minCoeff(&k);
+			Eigen::Vector3d b1 = n.cross(Eigen::Vector3d::Unit(k)).normalized();
+			Eigen::Matrix<double,3,2> B;
+			B.col(0) = b1;
+			B.col(1) = n.cross(b1);
+			return B;
+		}
+
+		//! plane seen from a frame posed at T (T maps the frame into the plane's CS)
+		static Eigen::Vector4d transformToFrame(const Eigen::Vector4d& pl, const Eigen::Isometry3d& T) {
+			Eigen::Vector4d res;
+			res.head<3>() = T.linear().transpose() * pl.head<3>();
+			res(3) = pl(3) + pl.head<3>().dot(T.translation());
+			return res;
+		}
+
+		//! plane given in the frame posed at T, expressed in the CS T maps into
+		static Eigen::Vector4d transformFromFrame(const Eigen::Vector4d& pl, const Eigen::Isometry3d& T) {
+			Eigen::Vector4d res;
+			res.head<3>() = T.linear() * pl.head<3>();
+			res(3) = pl(3) - res.head<3>().dot(T.translation());
+			return res;
+		}
+	};
+
+	class VertexPlaneWriteGnuplotAction: public WriteGnuplotAction
+	{
+	public:
+		VertexPlaneWriteGnuplotAction();
+		virtual HyperGraphElementAction* operator()(HyperGraph::HyperGraphElement* element, HyperGraphElementAction::Parameters* params_ );
+	};
+
+}
+#endif
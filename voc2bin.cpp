@@ -0,0 +1,65 @@
+//! converts a text vocabulary (Vocabulary/ORBvoc.txt) to the binary format of
+//! TemplatedVocabulary::loadFromBinaryFile, and checks the result by loading it back
+//! usage: voc2bin ORBvoc.txt ORBvoc.bin
+#include <iostream>
+#include <sys/time.h>
+#include "Thirdparty/DBoW2/DBoW2/FORB.h"
+#include "Thirdparty/DBoW2/DBoW2/TemplatedVocabulary.h"
+
+using namespace std;
+
+typedef DBoW2::TemplatedVocabulary<DBoW2::FORB::TDescriptor, DBoW2::FORB> ORBVocabulary;
+
+static double seconds()
+{
+	struct timeval t;
+	gettimeofday(&t, NULL);
+	return t.tv_sec + t.tv_usec*1e-6;
+}
+
+int main(int argc, char** argv)
+{
+	if(argc!=3){
+		cout<<"Usage: voc2bin vocabulary.txt vocabulary.bin"<<endl;
+		return 0;
+	}
+
+	ORBVocabulary voc;
+	double t = seconds();
+	if(!voc.loadFromTextFile(argv[1]))
+	{
+		cout<<"Failed to load "<<argv[1]<<endl;
+		return 1;
+	}
+	cout<<"Text vocabulary: "<<voc.size()<<" words, loaded in "<<seconds()-t<<" s"<<endl;
+
+	if(!voc.saveToBinaryFile(argv[2]))
+	{
+		cout<<"Failed to write "<<argv[2]<<endl;
+		return 1;
+	}
+
+	ORBVocabulary bin;
+	t = seconds();
+	if(!bin.loadFromBinaryFile(argv[2]))
+	{
+		cout<<"Failed to load "<<argv[2]<<" back"<<endl;
+		return 1;
+	}
+	cout<<"Binary vocabulary: "<<bin.size()<<" words, loaded in "<<seconds()-t<<" s"<<endl;
+
+	bool same = bin.size()==voc.size() && bin.getBranchingFactor()==voc.getBranchingFactor()
+		&& bin.getDepthLevels()==voc.getDepthLevels() && bin.getScoringType()==voc.getScoringType()
+		&& bin.getWeightingType()==voc.getWeightingType();
+	for(unsigned int i=0; same && i<voc.size(); i++)
+	{
+		same = bin.getWordWeight(i)==voc.getWordWeight(i)
+			&& DBoW2::FORB::distance(bin.getWord(i), voc.getWord(i))==0;
+	}
+	if(!same)
+	{
+		cout<<"Binary vocabulary differs from the text one"<<endl;
+		return 1;
+	}
+	return 0;
+}
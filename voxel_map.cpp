@@ -0,0 +1,296 @@
+#include "voxel_map.h"
+#include "map_chunks.h"
+#include <algorithm>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//! 21 bits per axis, +-2^20 voxels around the origin
+static inline uint64_t voxelKey(int x, int y, int z)
+{
+	const uint64_t m = (1<<21) - 1, o = 1<<20;
+	return ((x+o) & m) | (((y+o) & m) << 21) | (((z+o) & m) << 42);
+}
+
+static inline int voxelCoord(uint64_t key, int shift)
+{
+	return int((key >> shift) & ((1<<21) - 1)) - (1<<20);
+}
+
+VoxelMap::VoxelMap(double resolution, double chunkSize)
+	: res(resolution), invRes(1.0/resolution), budget(0), radius(0)
+{
+	chunkShift = std::max(3, (int)std::floor(std::log2(chunkSize/resolution) + 0.5));
+}
+
+VoxelMap::~VoxelMap()
+{
+	clear();
+}
+
+void VoxelMap::setStorage(const string& _dir, size_t _budget, double _radius)
+{
+	dir = _dir;
+	budget = _budget;
+	radius = _radius;
+	if(!dir.empty()) mkdir(dir.c_str(), 0755);
+}
+
+void VoxelMap::add(const PointCloud& cloud, const Eigen::Isometry3d& Twc, int sign)
+{
+	const Eigen::Matrix3f R = Twc.rotation().cast<float>();
+	const Eigen::Vector3f t = Twc.translation().cast<float>();
+	const float fres = res, finv = invRes;
+	// the points of a row fall in the same chunk mostly
+	uint64_t lastKey = ~uint64_t(0);
+	Chunk* c = 0;
+	for(size_t i=0; i<cloud.points.size(); i++)
+	{
+		const PointT& p = cloud.points[i];
+		if(!std::isfinite(p.z)) continue;
+		Eigen::Vector3f w = R*Eigen::Vector3f(p.x, p.y, p.z) + t;
+		int ix = (int)std::floor(w[0]*finv), iy = (int)std::floor(w[1]*finv), iz = (int)std::floor(w[2]*finv);
+		float dx = w[0] - ix*fres, dy = w[1] - iy*fres, dz = w[2] - iz*fres;
+		uint64_t ck = voxelKey(ix>>chunkShift, iy>>chunkShift, iz>>chunkShift);
+		if(ck != lastKey)
+		{
+			lastKey = ck;
+			if(sign > 0) c = &chunks[ck];
+			else {
+				std::unordered_map<uint64_t, Chunk>::iterator it = chunks.find(ck);
+				c = it == chunks.end() ? 0 : &it->second;
+			}
+			if(c && c->onDisk) load(ck, *c);
+		}
+		if(!c) continue;
+
+		uint64_t key = voxelKey(ix, iy, iz);
+		if(sign > 0)
+		{
+			Voxel& v = c->voxels[key];  // zero initialized when new
+			v.x += dx; v.y += dy; v.z += dz;
+			v.r += p.r; v.g += p.g; v.b += p.b;
+			v.n++;
+		}
+		else
+		{
+			VoxelHash::iterator it = c->voxels.find(key);
+			if(it == c->voxels.end()) continue;
+			Voxel& v = it->second;
+			if(--v.n <= 0) {
+				c->voxels.erase(it);
+				continue;
+			}
+			v.x -= dx; v.y -= dy; v.z -= dz;
+			v.r -= p.r; v.g -= p.g; v.b -= p.b;
+		}
+	}
+}
+
+void VoxelMap::integrate(int id, const PointCloud& cloud, const Eigen::Isometry3d& Twc)
+{
+	PoseMap::iterator it = poses.find(id);
+	if(it != poses.end())
+	{
+		if(it->second.isApprox(Twc, 1e-9)) return;
+		add(cloud, it->second, -1);
+	}
+	add(cloud, Twc, 1);
+	poses[id] = Twc;
+	enforceBudget(Twc.translation());
+}
+
+void VoxelMap::remove(int id, const PointCloud& cloud)
+{
+	PoseMap::iterator it = poses.find(id);
+	if(it == poses.end()) return;
+	add(cloud, it->second, -1);
+	poses.erase(it);
+}
+
+bool VoxelMap::pose(int id, Eigen::Isometry3d& Twc) const
+{
+	PoseMap::const_iterator it = poses.find(id);
+	if(it == poses.end()) return false;
+	Twc = it->second;
+	return true;
+}
+
+void VoxelMap::appendPoints(const VoxelHash& voxels, PointCloud& cloud, int minPoints) const
+{
+	for(VoxelHash::const_iterator it = voxels.begin(); it != voxels.end(); ++it)
+	{
+		const Voxel& v = it->second;
+		if(v.n < minPoints) continue;
+		const float inv = 1.f/v.n;
+		PointT p;
+		p.x = voxelCoord(it->first, 0)*res + v.x*inv;
+		p.y = voxelCoord(it->first, 21)*res + v.y*inv;
+		p.z = voxelCoord(it->first, 42)*res + v.z*inv;
+		p.r = std::min(255.f, std::max(0.f, v.r*inv + 0.5f));
+		p.g = std::min(255.f, std::max(0.f, v.g*inv + 0.5f));
+		p.b = std::min(255.f, std::max(0.f, v.b*inv + 0.5f));
+		p.a = 255;
+		cloud.points.push_back(p);
+	}
+}
+
+void VoxelMap::toCloud(PointCloud& cloud, int minPoints, bool residentOnly) const
+{
+	cloud.points.clear();
+	cloud.points.reserve(residentOnly ? 0 : size());
+	for(std::unordered_map<uint64_t, Chunk>::const_iterator it = chunks.begin(); it != chunks.end(); ++it)
+	{
+		if(!it->second.onDisk) {
+			appendPoints(it->second.voxels, cloud, minPoints);
+			continue;
+		}
+		if(residentOnly) continue;
+		VoxelHash voxels;
+		if(readChunk(it->first, voxels))
+			appendPoints(voxels, cloud, minPoints);
+	}
+	cloud.width = cloud.points.size();
+	cloud.height = 1;
+	cloud.is_dense = true;
+}
+
+size_t VoxelMap::size() const
+{
+	size_t n = 0;
+	for(std::unordered_map<uint64_t, Chunk>::const_iterator it = chunks.begin(); it != chunks.end(); ++it)
+		n += it->second.onDisk ? it->second.n : it->second.voxels.size();
+	return n;
+}
+
+size_t VoxelMap::residentBytes() const
+{
+	size_t n = 0;
+	for(std::unordered_map<uint64_t, Chunk>::const_iterator it = chunks.begin(); it != chunks.end(); ++it)
+		if(!it->second.onDisk) n += it->second.voxels.size();
+	return voxelBytes(n);
+}
+
+string VoxelMap::chunkFile(uint64_t key) const
+{
+	char name[64];
+	sprintf(name, "/voxels_%016llx.z", (unsigned long long)key);
+	return dir + name;
+}
+
+bool VoxelMap::writeChunk(uint64_t key, Chunk& c)
+{
+	const size_t item = sizeof(uint64_t) + sizeof(Voxel);
+	vector<char> buf(c.voxels.size()*item);
+	size_t pos = 0;
+	for(VoxelHash::const_iterator it = c.voxels.begin(); it != c.voxels.end(); ++it, pos += item)
+	{
+		memcpy(&buf[pos], &it->first, sizeof(uint64_t));
+		memcpy(&buf[pos + sizeof(uint64_t)], &it->second, sizeof(Voxel));
+	}
+	if(!writeCompressed(chunkFile(key), buf)) {
+		cout<<"VoxelMap: cannot write "<<chunkFile(key)<<endl;
+		return false;
+	}
+	c.n = c.voxels.size();
+	c.onDisk = true;
+	VoxelHash().swap(c.voxels);  // clear() keeps the buckets
+	return true;
+}
+
+bool VoxelMap::readChunk(uint64_t key, VoxelHash& voxels) const
+{
+	vector<char> buf;
+	if(!readCompressed(chunkFile(key), buf)) {
+		cout<<"VoxelMap: cannot read "<<chunkFile(key)<<endl;
+		return false;
+	}
+	const size_t item = sizeof(uint64_t) + sizeof(Voxel);
+	voxels.reserve(buf.size()/item);
+	for(size_t pos=0; pos+item<=buf.size(); pos+=item)
+	{
+		uint64_t k;
+		Voxel v;
+		memcpy(&k, &buf[pos], sizeof(k));
+		memcpy(&v, &buf[pos + sizeof(k)], sizeof(v));
+		voxels.insert(std::make_pair(k, v));
+	}
+	return true;
+}
+
+void VoxelMap::load(uint64_t key, Chunk& c)
+{
+	readChunk(key, c.voxels);
+	unlink(chunkFile(key).c_str());
+	c.onDisk = false;
+	c.n = 0;
+}
+
+void VoxelMap::enforceBudget(const Eigen::Vector3d& cam)
+{
+	if(dir.empty()) return;
+	size_t resident = residentBytes();
+	if(resident <= budget) return;
+
+	// resident chunks out of the working radius, by distance of their center
+	vector<pair<double, uint64_t> > far;
+	const double edge = res*(1<<chunkShift);
+	for(std::unordered_map<uint64_t, Chunk>::iterator it = chunks.begin(); it != chunks.end(); ++it)
+	{
+		if(it->second.onDisk || it->second.voxels.empty()) continue;
+		Eigen::Vector3d center(voxelCoord(it->first, 0) + 0.5, voxelCoord(it->first, 21) + 0.5, voxelCoord(it->first, 42) + 0.5);
+		double d = (center*edge - cam).norm();
+		if(d > radius) far.push_back(make_pair(d, it->first));
+	}
+	sort(far.rbegin(), far.rend());
+	for(size_t i=0; i<far.size() && resident > budget; i++)
+	{
+		Chunk& c = chunks[far[i].second];
+		const size_t bytes = voxelBytes(c.voxels.size());
+		if(writeChunk(far[i].second, c)) resident -= bytes;
+	}
+}
+
+void VoxelMap::clear()
+{
+	for(std::unordered_map<uint64_t, Chunk>::iterator it = chunks.begin(); it != chunks.end(); ++it)
+		if(it->second.onDisk) unlink(chunkFile(it->first).c_str());
+	chunks.clear();
+	poses.clear();
+}
+
+void VoxelMap::exportVoxels(vector<VoxelRecord>& voxels) const
+{
+	voxels.clear();
+	voxels.reserve(size());
+	for(std::unordered_map<uint64_t, Chunk>::const_iterator it = chunks.begin(); it != chunks.end(); ++it)
+	{
+		VoxelHash disk;
+		if(it->second.onDisk && !readChunk(it->first, disk)) continue;
+		const VoxelHash& hash = it->second.onDisk ? disk : it->second.voxels;
+		for(VoxelHash::const_iterator v = hash.begin(); v != hash.end(); ++v)
+		{
+			VoxelRecord r;
+			r.key = v->first;
+			r.x = v->second.x; r.y = v->second.y; r.z = v->second.z;
+			r.r = v->second.r; r.g = v->second.g; r.b = v->second.b;
+			r.n = v->second.n;
+			voxels.push_back(r);
+		}
+	}
+}
+
+void VoxelMap::importVoxels(const vector<VoxelRecord>& voxels)
+{
+	clear();
+	for(size_t i=0; i<voxels.size(); i++)
+	{
+		const VoxelRecord& r = voxels[i];
+		if(r.n <= 0) continue;
+		uint64_t ck = voxelKey(voxelCoord(r.key, 0)>>chunkShift, voxelCoord(r.key, 21)>>chunkShift, voxelCoord(r.key, 42)>>chunkShift);
+		Voxel& v = chunks[ck].voxels[r.key];
+		v.x = r.x; v.y = r.y; v.z = r.z;
+		v.r = r.r; v.g = r.g; v.b = r.b;
+		v.n = r.n;
+	}
+}
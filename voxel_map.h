@@ -0,0 +1,92 @@
+#ifndef VOXEL_MAP_H
+#define VOXEL_MAP_H
+
+#include "base.h"
+#include <map>
+#include <unordered_map>
+#include <stdint.h>
+
+//! global colour point map hashed by voxel, each voxel keeps the mean position and colour of its points
+//! integrating a keyframe costs O(points), memory grows with the occupied voxels and not with the
+//! number of integrated points
+//! a keyframe integrated again with a new pose (after optimization) is first removed with its old one
+//! voxels are grouped in cubic chunks, which can be kept on disk out of a working radius (setStorage)
+class VoxelMap
+{
+public:
+	//! chunkSize in meters, rounded to a power of two voxels
+	VoxelMap(double resolution = 0.02, double chunkSize = 2.0);
+	~VoxelMap();
+	//! chunks farther than radius from the last integrated camera are written to dir, zlib compressed,
+	//! farthest first while the resident voxels take more than budget bytes
+	//! they are read back when a keyframe reaches them again, toCloud of the whole map streams them without keeping them
+	void setStorage(const string& dir, size_t budget, double radius);
+	//! cloud in the camera CS of keyframe id, posed at Twc
+	void integrate(int id, const PointCloud& cloud, const Eigen::Isometry3d& Twc);
+	//! take back the points of keyframe id, cloud has to be the one integrated
+	void remove(int id, const PointCloud& cloud);
+	//! pose keyframe id is integrated with, false if not integrated
+	bool pose(int id, Eigen::Isometry3d& Twc) const;
+	//! one point per voxel observed minPoints times at least, the chunks on disk skipped if residentOnly
+	void toCloud(PointCloud& cloud, int minPoints = 1, bool residentOnly = false) const;
+	//! voxels, on disk included
+	size_t size() const;
+	size_t residentBytes() const;
+	double resolution() const { return res; }
+	void clear();
+
+	//! a voxel as stored in a map file: key of its coordinates and the sums of its points
+	struct VoxelRecord
+	{
+		uint64_t 	key;
+		float 		x, y, z;
+		float 		r, g, b;
+		int32_t 	n;
+	};
+	//! every voxel, the chunks on disk read back
+	void exportVoxels(vector<VoxelRecord>& voxels) const;
+	//! replaces the map by voxels of the same resolution; the integration poses are not restored,
+	//! the clouds of those keyframes are gone and they cannot be re-posed
+	void importVoxels(const vector<VoxelRecord>& voxels);
+
+private:
+	//! sums of the points relative to the voxel corner, so that float keeps the precision far from the origin
+	struct Voxel
+	{
+		float 		x, y, z;
+		float 		r, g, b;
+		int 		n;
+	};
+	typedef std::unordered_map<uint64_t, Voxel> VoxelHash;
+	typedef std::map<int, Eigen::Isometry3d, std::less<int>,
+			 Eigen::aligned_allocator<std::pair<const int, Eigen::Isometry3d> > > PoseMap;
+	struct Chunk
+	{
+		VoxelHash 	voxels;
+		size_t 		n;		// voxels while on disk
+		bool 		onDisk;
+		Chunk() : n(0), onDisk(false) {}
+	};
+
+	//! RAM taken by n voxels, with the hash node and bucket
+	static size_t voxelBytes(size_t n) { return n*(sizeof(VoxelHash::value_type) + 32); }
+	//! sign 1 adds the points, -1 removes them
+	void add(const PointCloud& cloud, const Eigen::Isometry3d& Twc, int sign);
+	void appendPoints(const VoxelHash& voxels, PointCloud& cloud, int minPoints) const;
+	string chunkFile(uint64_t key) const;
+	bool readChunk(uint64_t key, VoxelHash& voxels) const;
+	bool writeChunk(uint64_t key, Chunk& c);
+	//! chunk back in RAM
+	void load(uint64_t key, Chunk& c);
+	void enforceBudget(const Eigen::Vector3d& cam);
+
+	double 		res, invRes;
+	int 		chunkShift;		// chunk edge is 1<<chunkShift voxels
+	std::unordered_map<uint64_t, Chunk> chunks;
+	PoseMap 	poses;			// integration pose of each keyframe
+	string 		dir;			// empty: every chunk stays in RAM
+	size_t 		budget;
+	double 		radius;
+};
+
+#endif